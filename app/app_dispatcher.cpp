@@ -0,0 +1,196 @@
+#include "app_dispatcher.h"
+#include "log.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// type defintions
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// constants
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// module variables
+///////////////////////////////////////////////////////////////////////////////
+
+static LogInstance g_logger("app.dispatcher");
+
+///////////////////////////////////////////////////////////////////////////////
+// private function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// public function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+APPDispatcher::APPDispatcher(struct ev_loop *loop_p) :
+    m_loop_p(loop_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "APPDispatcher::APPDispatcher enter this=%p loop_p=%p", this, loop_p);
+
+    pthread_mutex_init(&m_mutex, NULL);
+
+    // the only watcher another thread is allowed to poke
+    ev_async_init(&m_watcher, async_cb);
+    m_watcher.data = (void *)this;
+    ev_async_start(m_loop_p, &m_watcher);
+
+    LOG_GENERATE_TRACE(g_logger, "APPDispatcher::APPDispatcher exit");
+}
+
+APPDispatcher::~APPDispatcher()
+{
+    LOG_GENERATE_TRACE(g_logger, "APPDispatcher::~APPDispatcher enter this=%p", this);
+
+    ev_async_stop(m_loop_p, &m_watcher);
+
+    // anything that never ran is dropped
+    for (std::deque<Job *>::iterator it = m_jobs.begin();
+            it != m_jobs.end();
+            it++)
+    {
+        delete *it;
+    }
+
+    pthread_mutex_destroy(&m_mutex);
+
+    LOG_GENERATE_TRACE(g_logger, "APPDispatcher::~APPDispatcher exit");
+}
+
+void APPDispatcher::post(Job *job_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "APPDispatcher::post enter this=%p job_p=%p", this, job_p);
+
+    pthread_mutex_lock(&m_mutex);
+    m_jobs.push_back(job_p);
+    pthread_mutex_unlock(&m_mutex);
+
+    // several posts before the loop wakes only cost it the one callback
+    ev_async_send(m_loop_p, &m_watcher);
+
+    LOG_GENERATE_TRACE(g_logger, "APPDispatcher::post exit");
+}
+
+void APPDispatcher::post_and_wait(Job *job_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "APPDispatcher::post_and_wait enter this=%p job_p=%p", this, job_p);
+
+    // the loop signals once the job has run, by then it's done with the completion
+    Completion completion;
+    pthread_mutex_init(&completion.mutex, NULL);
+    pthread_cond_init(&completion.cond, NULL);
+    completion.done = false;
+    job_p->m_completion_p = &completion;
+
+    post(job_p);
+
+    pthread_mutex_lock(&completion.mutex);
+    while (false == completion.done)
+    {
+        pthread_cond_wait(&completion.cond, &completion.mutex);
+    }
+    pthread_mutex_unlock(&completion.mutex);
+
+    pthread_cond_destroy(&completion.cond);
+    pthread_mutex_destroy(&completion.mutex);
+
+    LOG_GENERATE_TRACE(g_logger, "APPDispatcher::post_and_wait exit");
+}
+
+void APPDispatcher::cancel(const void *owner_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "APPDispatcher::cancel enter this=%p owner_p=%p", this, owner_p);
+
+    // deleted outside the lock as a job can own anything
+    std::deque<Job *> cancelled;
+    pthread_mutex_lock(&m_mutex);
+    std::deque<Job *>::iterator it = m_jobs.begin();
+    while (it != m_jobs.end())
+    {
+        if (owner_p == (*it)->get_owner_p())
+        {
+            cancelled.push_back(*it);
+            it = m_jobs.erase(it);
+        }
+        else
+        {
+            it++;
+        }
+    }
+    pthread_mutex_unlock(&m_mutex);
+
+    for (it = cancelled.begin(); it != cancelled.end(); it++)
+    {
+        delete *it;
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "APPDispatcher::cancel exit count=%d", cancelled.size());
+}
+
+APPDispatcher::Job::Job(const void *owner_p) :
+    m_owner_p(owner_p),
+    m_completion_p(NULL)
+{
+    LOG_GENERATE_TRACE(g_logger, "APPDispatcher::Job::Job enter this=%p owner_p=%p", this, owner_p);
+    LOG_GENERATE_TRACE(g_logger, "APPDispatcher::Job::Job exit");
+}
+
+APPDispatcher::Job::~Job()
+{
+    LOG_GENERATE_TRACE(g_logger, "APPDispatcher::Job::~Job enter this=%p", this);
+    LOG_GENERATE_TRACE(g_logger, "APPDispatcher::Job::~Job exit");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// private function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+void APPDispatcher::async_cb(EV_P_ ev_async *w_p, int revents)
+{
+    LOG_GENERATE_TRACE(g_logger, "APPDispatcher::async_cb enter w_p=%p revents=0x%x", w_p, revents);
+
+    // get the object
+    APPDispatcher *dispatcher_p = (APPDispatcher *)w_p->data;
+
+    // one at a time, as a job can cancel the ones queued behind it
+    for (;;)
+    {
+        Job *job_p = NULL;
+        pthread_mutex_lock(&dispatcher_p->m_mutex);
+        if (false == dispatcher_p->m_jobs.empty())
+        {
+            job_p = dispatcher_p->m_jobs.front();
+            dispatcher_p->m_jobs.pop_front();
+        }
+        pthread_mutex_unlock(&dispatcher_p->m_mutex);
+        if (NULL == job_p)
+        {
+            break;
+        }
+
+        job_p->run();
+
+        Completion *completion_p = job_p->m_completion_p;
+        delete job_p;
+
+        // the waiter can't return until we let go of its mutex
+        if (NULL != completion_p)
+        {
+            pthread_mutex_lock(&completion_p->mutex);
+            completion_p->done = true;
+            pthread_cond_signal(&completion_p->cond);
+            pthread_mutex_unlock(&completion_p->mutex);
+        }
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "APPDispatcher::async_cb exit");
+}
+
@@ -0,0 +1,110 @@
+#ifndef _APP_DISPATCHER_H_
+#define _APP_DISPATCHER_H_
+
+#include "common.h"
+
+#include <ev.h>
+#include <pthread.h>
+#include <deque>
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// forward declarations
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// class definition
+///////////////////////////////////////////////////////////////////////////////
+
+class APPDispatcher
+{
+
+///////////////////////////////////////////////////////////////////////////////
+// type definitions
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+
+    // how post_and_wait hears that its job has run
+    typedef struct
+    {
+        pthread_mutex_t mutex;
+        pthread_cond_t cond;
+        bool done;
+    } Completion;
+
+public:
+
+    class Job
+    {
+        friend class APPDispatcher;
+    public:
+        // owner_p is whatever the job works on, so its jobs can be dropped when it goes
+        Job(const void *owner_p);
+        virtual ~Job();
+        // called on the dispatcher's loop
+        virtual void run() = 0;
+        inline const void *get_owner_p() const;
+    private:
+        const void *m_owner_p;
+        // set while someone is blocked in post_and_wait on it
+        Completion *m_completion_p;
+    };
+
+///////////////////////////////////////////////////////////////////////////////
+// public function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+    // created before loop_p runs, or on its thread
+    APPDispatcher(struct ev_loop *loop_p);
+    virtual ~APPDispatcher();
+
+    // these can be called from any thread, the dispatcher owns the job from then on
+    void post(Job *job_p);
+    // never from the dispatcher's own loop
+    void post_and_wait(Job *job_p);
+    // only from the dispatcher's own loop
+    void cancel(const void *owner_p);
+
+    inline struct ev_loop *get_loop_p() const;
+
+///////////////////////////////////////////////////////////////////////////////
+// private function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+    static void async_cb(EV_P_ ev_async *w_p, int revents);
+
+///////////////////////////////////////////////////////////////////////////////
+// private variable definitions
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+    struct ev_loop *m_loop_p;
+    ev_async m_watcher;
+    pthread_mutex_t m_mutex;
+    std::deque<Job *> m_jobs;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// inline function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+inline const void *APPDispatcher::Job::get_owner_p() const
+{
+    return m_owner_p;
+}
+
+inline struct ev_loop *APPDispatcher::get_loop_p() const
+{
+    return m_loop_p;
+}
+
+#endif
+
@@ -1,6 +1,9 @@
 
 #include "app_mgr.h"
 #include "app_sppconnector.h"
+#include "app_shardconnector.h"
+#include "app_shardsupervisor.h"
+#include "app_dispatcher.h"
 #include "log.h"
 
 #include <stdlib.h>
@@ -26,6 +29,9 @@
 
 static LogInstance g_logger("app.mgr");
 
+APPDispatcher *APPManager::g_transport_dispatcher_p = NULL;
+APPDispatcher *APPManager::g_processing_dispatcher_p = NULL;
+
 ///////////////////////////////////////////////////////////////////////////////
 // private function declarations
 ///////////////////////////////////////////////////////////////////////////////
@@ -35,11 +41,31 @@ static LogInstance g_logger("app.mgr");
 // public function implementations
 ///////////////////////////////////////////////////////////////////////////////
 
+void APPManager::init(struct ev_loop *transport_loop_p, struct ev_loop *processing_loop_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "APPManager::init enter transport_loop_p=%p processing_loop_p=%p", transport_loop_p, processing_loop_p);
+
+    // called before either loop runs, one dispatcher does for both when they're the same
+    g_transport_dispatcher_p = new APPDispatcher(transport_loop_p);
+    g_processing_dispatcher_p = (transport_loop_p == processing_loop_p) ? g_transport_dispatcher_p : new APPDispatcher(processing_loop_p);
+
+    LOG_GENERATE_TRACE(g_logger, "APPManager::init exit");
+}
+
 APPManager::RequestHandler *APPManager::createSPPConnector(NotificationHandler *handler_p)
 {
     LOG_GENERATE_TRACE(g_logger, "APPManager::createSPPConnector enter handler_p=%p", handler_p);
 
-    SPPConnector *connector_p = new SPPConnector(handler_p);
+    // a sharded front has no audio of its own, the shards do the metering
+    RequestHandler *connector_p = NULL;
+    if (NULL != APPShardSupervisor::get_instance())
+    {
+        connector_p = new APPShardConnector(handler_p);
+    }
+    else
+    {
+        connector_p = new SPPConnector(handler_p);
+    }
 
     LOG_GENERATE_TRACE(g_logger, "APPManager::createSPPConnector exit connector_p=%p", connector_p);
     return connector_p;
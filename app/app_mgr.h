@@ -3,6 +3,8 @@
 
 #include "common.h"
 
+#include <ev.h>
+
 ///////////////////////////////////////////////////////////////////////////////
 // macros
 ///////////////////////////////////////////////////////////////////////////////
@@ -12,6 +14,7 @@
 // forward declarations
 ///////////////////////////////////////////////////////////////////////////////
 
+class APPDispatcher;
 
 ///////////////////////////////////////////////////////////////////////////////
 // type definitions
@@ -49,6 +52,8 @@ public:
     {
     public:
         virtual ResultCode send_notification(Message **notification_pp) = 0;
+        // the outcome of a request the handler returned RESULT_CODE_PENDING for
+        virtual ResultCode send_response(ResultCode result_code, Message **response_pp) = 0;
     };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -57,17 +62,34 @@ public:
 
 public:
 
+    // the clients are served on the transport loop, the audio is metered on the processing loop
+    static void init(struct ev_loop *transport_loop_p, struct ev_loop *processing_loop_p);
     static RequestHandler *createSPPConnector(NotificationHandler *handler_p);
 
+    static inline APPDispatcher *get_transport_dispatcher_p();
+    static inline APPDispatcher *get_processing_dispatcher_p();
+
 
 ///////////////////////////////////////////////////////////////////////////////
 // private variable definitions
 ///////////////////////////////////////////////////////////////////////////////
 
 private:
+    static APPDispatcher *g_transport_dispatcher_p;
+    static APPDispatcher *g_processing_dispatcher_p;
 
 };
 
+APPDispatcher *APPManager::get_transport_dispatcher_p()
+{
+    return g_transport_dispatcher_p;
+}
+
+APPDispatcher *APPManager::get_processing_dispatcher_p()
+{
+    return g_processing_dispatcher_p;
+}
+
 const size_t APPManager::Message::get_length() const
 {
     return m_length;
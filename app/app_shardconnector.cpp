@@ -0,0 +1,614 @@
+///////////////////////////////////////////////////////////////////////////////
+// includes
+///////////////////////////////////////////////////////////////////////////////
+
+#include "app_shardconnector.h"
+#include "audio/audio_capturemgr.h"
+#include "log.h"
+
+#include "proto/v1.pb.h"
+
+#include <string.h>
+#include <algorithm>
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+// twice the rate the shards update their tables at, so no shard's tick is missed
+#define SHARD_POLL_FREQUENCY    (1.0f/48)
+// how long a shard that's behind can hold back the others' levels
+#define SHARD_MAXIMUM_HELD_POLLS    (2)
+
+///////////////////////////////////////////////////////////////////////////////
+// type defintions
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// constants
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// module variables
+///////////////////////////////////////////////////////////////////////////////
+
+static LogInstance g_logger("app.shardconnector");
+
+///////////////////////////////////////////////////////////////////////////////
+// private function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+static APPManager::Message *populate_response(::google::protobuf::MessageLite& message);
+static APPManager::Message *copy_message(const APPManager::Message *message_p);
+
+///////////////////////////////////////////////////////////////////////////////
+// public function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+APPShardConnector::APPShardConnector(APPManager::NotificationHandler *handler_p) :
+    m_handler_p(handler_p),
+    m_supervisor_p(APPShardSupervisor::get_instance()),
+    m_next_id(SHARD_REPLAY_REQUEST_ID + 1),
+    m_request_id(SHARD_REPLAY_REQUEST_ID),
+    m_request_type(v1::ECHO),
+    m_request_channel(0),
+    m_merging(false),
+    m_result_code(RESULT_CODE_OK),
+    m_response_p(NULL),
+    m_held_polls(0)
+{
+    LOG_GENERATE_TRACE(g_logger, "APPShardConnector::APPShardConnector enter this=%p handler_p=%p", this, handler_p);
+
+    m_supervisor_p->set_listener(this);
+
+    // the levels already in the tables are from before this client
+    for (unsigned int shard = 0; shard < m_supervisor_p->get_shard_count(); shard++)
+    {
+        m_sequences.push_back(m_supervisor_p->get_sequence(shard));
+        m_shard_levels.push_back(std::vector<uint8_t>());
+        m_fresh.push_back(false);
+        m_supervisor_p->send(shard, APPShardLink::FRAME_TYPE_OPEN, SHARD_REPLAY_REQUEST_ID, NULL);
+    }
+
+    ev_timer_init(&m_poll_timer, poll_cb, SHARD_POLL_FREQUENCY, SHARD_POLL_FREQUENCY);
+    m_poll_timer.data = (void *)this;
+    ev_timer_start(APPManager::get_transport_dispatcher_p()->get_loop_p(), &m_poll_timer);
+
+    LOG_GENERATE_TRACE(g_logger, "APPShardConnector::APPShardConnector exit");
+}
+
+APPShardConnector::~APPShardConnector()
+{
+    LOG_GENERATE_TRACE(g_logger, "APPShardConnector::~APPShardConnector enter this=%p", this);
+
+    ev_timer_stop(APPManager::get_transport_dispatcher_p()->get_loop_p(), &m_poll_timer);
+
+    // the shards stop metering until the next client
+    m_supervisor_p->set_listener(NULL);
+    for (unsigned int shard = 0; shard < m_supervisor_p->get_shard_count(); shard++)
+    {
+        m_supervisor_p->send(shard, APPShardLink::FRAME_TYPE_CLOSE, SHARD_REPLAY_REQUEST_ID, NULL);
+    }
+    APPManager::get_transport_dispatcher_p()->cancel(this);
+
+    for (std::deque<APPManager::Message *>::iterator it = m_requests.begin();
+            it != m_requests.end();
+            it++)
+    {
+        delete *it;
+    }
+    delete m_response_p;
+
+    LOG_GENERATE_TRACE(g_logger, "APPShardConnector::~APPShardConnector exit");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// APPManager::RequestHandler implementations
+///////////////////////////////////////////////////////////////////////////////
+
+ResultCode APPShardConnector::handle_request(APPManager::Message *request_p, APPManager::Message **response_pp)
+{
+    LOG_GENERATE_TRACE(g_logger, "APPShardConnector::handle_request enter this=%p request_p=%p response_pp=%p", this, request_p, response_pp);
+
+    // the caller reuses its buffer so the request is kept as a copy, it's started once the ones ahead of it are answered
+    m_requests.push_back(copy_message(request_p));
+    if (1 == m_requests.size())
+    {
+        APPManager::get_transport_dispatcher_p()->post(new Job(this));
+    }
+    *response_pp = NULL;
+
+    LOG_GENERATE_TRACE(g_logger, "APPShardConnector::handle_request exit");
+    return RESULT_CODE_PENDING;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// APPShardSupervisor::Listener implementations
+///////////////////////////////////////////////////////////////////////////////
+
+void APPShardConnector::handle_shard_up(unsigned int shard)
+{
+    LOG_GENERATE_TRACE(g_logger, "APPShardConnector::handle_shard_up enter this=%p shard=%d", this, shard);
+
+    // the table was reset for the new process
+    m_sequences[shard] = m_supervisor_p->get_sequence(shard);
+    m_supervisor_p->send(shard, APPShardLink::FRAME_TYPE_OPEN, SHARD_REPLAY_REQUEST_ID, NULL);
+    replay(shard);
+
+    LOG_GENERATE_TRACE(g_logger, "APPShardConnector::handle_shard_up exit");
+}
+
+void APPShardConnector::handle_shard_down(unsigned int shard)
+{
+    LOG_GENERATE_TRACE(g_logger, "APPShardConnector::handle_shard_down enter this=%p shard=%d", this, shard);
+
+    // a merged request gets by without it, the rest are answered as failed
+    if (0 != m_outstanding.erase(shard))
+    {
+        if (false == m_merging)
+        {
+            m_result_code = RESULT_CODE_ERROR;
+        }
+        if (true == m_outstanding.empty())
+        {
+            // the connection may close + take us with it, so nothing is touched after this
+            finish_request();
+        }
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "APPShardConnector::handle_shard_down exit");
+}
+
+void APPShardConnector::handle_shard_frame(unsigned int shard, const APPShardLink::Header &header, APPManager::Message **message_pp)
+{
+    LOG_GENERATE_TRACE(g_logger, "APPShardConnector::handle_shard_frame enter this=%p shard=%d type=%d id=%d", this, shard, header.type, header.id);
+
+    switch (header.type)
+    {
+        case APPShardLink::FRAME_TYPE_RESPONSE:
+        {
+            // the replays + anything from before a shard went down aren't waited on
+            if ((m_request_id != header.id) || (0 == m_outstanding.count(shard)))
+            {
+                LOG_GENERATE_DEBUG(g_logger, "dropping response id=%d from shard=%d result=%d", header.id, shard, header.result);
+                break;
+            }
+            merge_response(shard, (ResultCode)header.result, message_pp);
+            if (true == m_outstanding.empty())
+            {
+                // the connection may close + take us with it, so nothing is touched after this
+                finish_request();
+            }
+            break;
+        }
+        case APPShardLink::FRAME_TYPE_NOTIFICATION:
+        {
+            // alarms + faults go straight out
+            if (NULL != *message_pp)
+            {
+                m_handler_p->send_notification(message_pp);
+            }
+            break;
+        }
+        default:
+        {
+            LOG_GENERATE_ERROR(g_logger, "unexpected frame type=%d from shard=%d", header.type, shard);
+            break;
+        }
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "APPShardConnector::handle_shard_frame exit");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// APPShardConnector::Job implementations
+///////////////////////////////////////////////////////////////////////////////
+
+APPShardConnector::Job::Job(APPShardConnector *connector_p) :
+    APPDispatcher::Job(connector_p),
+    m_connector_p(connector_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "APPShardConnector::Job::Job enter this=%p connector_p=%p", this, connector_p);
+    LOG_GENERATE_TRACE(g_logger, "APPShardConnector::Job::Job exit");
+}
+
+APPShardConnector::Job::~Job()
+{
+    LOG_GENERATE_TRACE(g_logger, "APPShardConnector::Job::~Job enter this=%p", this);
+    LOG_GENERATE_TRACE(g_logger, "APPShardConnector::Job::~Job exit");
+}
+
+void APPShardConnector::Job::run()
+{
+    LOG_GENERATE_TRACE(g_logger, "APPShardConnector::Job::run enter this=%p", this);
+
+    if ((true == m_connector_p->m_outstanding.empty()) && (false == m_connector_p->m_requests.empty()))
+    {
+        m_connector_p->start_request();
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "APPShardConnector::Job::run exit");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// private function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+void APPShardConnector::start_request()
+{
+    LOG_GENERATE_TRACE(g_logger, "APPShardConnector::start_request enter this=%p", this);
+
+    m_request_id = m_next_id++;
+    if (SHARD_REPLAY_REQUEST_ID == m_next_id)
+    {
+        m_next_id++;
+    }
+    m_result_code = RESULT_CODE_OK;
+    m_merging = false;
+    m_channels.clear();
+
+    const unsigned int shard_count = m_supervisor_p->get_shard_count();
+    APPManager::Message *request_p = m_requests.front();
+    std::vector<unsigned int> shards;
+
+    // decode the message
+    v1::Request request;
+    if (false == request.ParseFromArray(request_p->get_data_p(), request_p->get_length()))
+    {
+        // like control, a request that can't be read gets no response
+        LOG_GENERATE_ERROR(g_logger, "unable to parse request protocol buffer len=%d", request_p->get_length());
+        m_requests.pop_front();
+        delete request_p;
+        // the connection closes + takes us with it
+        complete(RESULT_CODE_ERROR, NULL);
+    }
+    else
+    {
+        m_request_type = request.type();
+        switch (request.type())
+        {
+            case v1::ECHO:
+            {
+                // it's the link to the front being checked, so the front answers it
+                m_merging = true;
+                break;
+            }
+            case v1::SETLEVEL:
+            {
+                // a meter can only link the channels its own shard has
+                const ::v1::SetLevelRequest &setlevel = request.setlevel();
+                m_request_channel = setlevel.channel();
+                unsigned int shard = find_shard(setlevel.channel());
+                for (int counter = 0; counter < setlevel.linkedchannels_size(); counter++)
+                {
+                    if (shard != find_shard(setlevel.linkedchannels(counter)))
+                    {
+                        LOG_GENERATE_ERROR(g_logger, "linked channel=%d is on a different shard to channel=%d", setlevel.linkedchannels(counter), setlevel.channel());
+                        shard = shard_count;
+                        break;
+                    }
+                }
+                shards.push_back(shard);
+                break;
+            }
+            case v1::QUERYHISTOGRAM:
+            {
+                shards.push_back(find_shard(request.queryhistogram().channel()));
+                break;
+            }
+            case v1::QUERYOVERS:
+            {
+                shards.push_back(find_shard(request.queryovers().channel()));
+                break;
+            }
+            case v1::QUERYAUDIOCHANNELS:
+            case v1::SETALARMS:
+            {
+                // every shard that's up, the ones that aren't are given the alarms when they're back
+                m_merging = true;
+                for (unsigned int shard = 0; shard < shard_count; shard++)
+                {
+                    if (true == m_supervisor_p->is_up(shard))
+                    {
+                        shards.push_back(shard);
+                    }
+                }
+                break;
+            }
+            default:
+            {
+                // every shard has the same meters, + any of them can turn down what it doesn't know
+                shards.push_back(find_any_shard());
+                break;
+            }
+        }
+
+        for (std::vector<unsigned int>::iterator it = shards.begin();
+                it != shards.end();
+                it++)
+        {
+            APPManager::Message *message_p = copy_message(request_p);
+            if (RESULT_CODE_OK == m_supervisor_p->send(*it, APPShardLink::FRAME_TYPE_REQUEST, m_request_id, &message_p))
+            {
+                m_outstanding.insert(*it);
+            }
+            else
+            {
+                LOG_GENERATE_ERROR(g_logger, "unable to send request type=%d to shard=%d", m_request_type, *it);
+                m_result_code = RESULT_CODE_ERROR;
+            }
+        }
+
+        // nothing to wait for, the connection may close + take us with it
+        if (true == m_outstanding.empty())
+        {
+            finish_request();
+        }
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "APPShardConnector::start_request exit");
+}
+
+void APPShardConnector::merge_response(unsigned int shard, ResultCode result_code, APPManager::Message **response_pp)
+{
+    LOG_GENERATE_TRACE(g_logger, "APPShardConnector::merge_response enter this=%p shard=%d result_code=%d response_pp=%p", this, shard, result_code, response_pp);
+
+    m_outstanding.erase(shard);
+    if (RESULT_CODE_OK != result_code)
+    {
+        m_result_code = result_code;
+    }
+
+    if (false == m_merging)
+    {
+        // the only shard asked, so its response goes back as it is
+        delete m_response_p;
+        m_response_p = *response_pp;
+        *response_pp = NULL;
+    }
+    else if (NULL != *response_pp)
+    {
+        v1::ResponseOrNotification responseornotification;
+        APPManager::Message *response_p = *response_pp;
+        if ((false == responseornotification.ParseFromArray(response_p->get_data_p(), response_p->get_length())) ||
+                (false == responseornotification.response().success()))
+        {
+            m_result_code = RESULT_CODE_ERROR;
+        }
+        else
+        {
+            const ::v1::QueryAudioChannelsResponse &qac = responseornotification.response().queryaudiochannels();
+            for (int counter = 0; counter < qac.channels_size(); counter++)
+            {
+                m_channels.push_back(qac.channels(counter));
+            }
+        }
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "APPShardConnector::merge_response exit result_code=%d", m_result_code);
+}
+
+void APPShardConnector::finish_request()
+{
+    LOG_GENERATE_TRACE(g_logger, "APPShardConnector::finish_request enter this=%p", this);
+
+    ResultCode result_code = m_result_code;
+    APPManager::Message *response_p = m_response_p;
+    m_response_p = NULL;
+
+    // a merged response is put together here, as is the failure for a shard that isn't there
+    if ((true == m_merging) || (NULL == response_p))
+    {
+        v1::ResponseOrNotification responseornotification;
+        v1::Response *merged_p = responseornotification.mutable_response();
+        responseornotification.set_type(v1::ResponseOrNotification_ResponseOrNotificationType_RESPONSE);
+        merged_p->set_type((v1::RequestType)m_request_type);
+        merged_p->set_success(RESULT_CODE_OK == result_code);
+        if ((true == m_merging) && (RESULT_CODE_OK == result_code))
+        {
+            switch (m_request_type)
+            {
+                case v1::ECHO:
+                    merged_p->mutable_echo();
+                    break;
+
+                case v1::QUERYAUDIOCHANNELS:
+                {
+                    // in the same order a single process lists them
+                    std::sort(m_channels.begin(), m_channels.end());
+                    v1::QueryAudioChannelsResponse *qac_p = merged_p->mutable_queryaudiochannels();
+                    for (std::vector<uint32_t>::iterator it = m_channels.begin();
+                            it != m_channels.end();
+                            it++)
+                    {
+                        qac_p->add_channels(*it);
+                    }
+                    break;
+                }
+                case v1::SETALARMS:
+                    merged_p->mutable_setalarms();
+                    break;
+            }
+        }
+        delete response_p;
+        response_p = populate_response(responseornotification);
+    }
+
+    // what the shards have accepted is kept for when one of them restarts
+    APPManager::Message *request_p = m_requests.front();
+    m_requests.pop_front();
+    if (RESULT_CODE_OK == result_code)
+    {
+        if (v1::SETLEVEL == m_request_type)
+        {
+            m_levels[m_request_channel].assign(request_p->get_data_p(), request_p->get_data_p() + request_p->get_length());
+        }
+        else if (v1::SETALARMS == m_request_type)
+        {
+            m_alarms.assign(request_p->get_data_p(), request_p->get_data_p() + request_p->get_length());
+        }
+    }
+    delete request_p;
+
+    // the connection may close + take us with it, so nothing is touched after this
+    complete(result_code, &response_p);
+
+    LOG_GENERATE_TRACE(g_logger, "APPShardConnector::finish_request exit");
+}
+
+void APPShardConnector::complete(ResultCode result_code, APPManager::Message **response_pp)
+{
+    LOG_GENERATE_TRACE(g_logger, "APPShardConnector::complete enter this=%p result_code=%d response_pp=%p", this, result_code, response_pp);
+
+    // the next one is started from the loop, it's cancelled if the connection goes
+    if (false == m_requests.empty())
+    {
+        APPManager::get_transport_dispatcher_p()->post(new Job(this));
+    }
+
+    APPManager::Message *response_p = NULL;
+    if (NULL == response_pp)
+    {
+        response_pp = &response_p;
+    }
+    m_handler_p->send_response(result_code, response_pp);
+
+    LOG_GENERATE_TRACE(g_logger, "APPShardConnector::complete exit");
+}
+
+void APPShardConnector::replay(unsigned int shard)
+{
+    LOG_GENERATE_TRACE(g_logger, "APPShardConnector::replay enter this=%p shard=%d", this, shard);
+
+    // the meters the client set on the shard's channels, then the alarms, which need them running
+    for (std::map<uint32_t, std::vector<uint8_t> >::iterator it = m_levels.begin();
+            it != m_levels.end();
+            it++)
+    {
+        if (shard == find_shard(it->first))
+        {
+            APPManager::Message *message_p = new APPManager::Message(it->second.size());
+            memcpy(message_p->get_data_p(), &it->second[0], it->second.size());
+            m_supervisor_p->send(shard, APPShardLink::FRAME_TYPE_REQUEST, SHARD_REPLAY_REQUEST_ID, &message_p);
+        }
+    }
+    if (false == m_alarms.empty())
+    {
+        APPManager::Message *message_p = new APPManager::Message(m_alarms.size());
+        memcpy(message_p->get_data_p(), &m_alarms[0], m_alarms.size());
+        m_supervisor_p->send(shard, APPShardLink::FRAME_TYPE_REQUEST, SHARD_REPLAY_REQUEST_ID, &message_p);
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "APPShardConnector::replay exit levels=%d", m_levels.size());
+}
+
+unsigned int APPShardConnector::find_shard(uint32_t channel) const
+{
+    // channels are numbered from one in blocks per shard, anything outside them is the shard count
+    unsigned int shard = m_supervisor_p->get_shard_count();
+    if ((0 < channel) && ((channel - 1) / CAPTURE_SHARD_CHANNEL_STRIDE < shard))
+    {
+        shard = (channel - 1) / CAPTURE_SHARD_CHANNEL_STRIDE;
+    }
+    return shard;
+}
+
+unsigned int APPShardConnector::find_any_shard() const
+{
+    unsigned int shard = 0;
+    while ((shard < m_supervisor_p->get_shard_count()) && (false == m_supervisor_p->is_up(shard)))
+    {
+        shard++;
+    }
+    return shard;
+}
+
+void APPShardConnector::poll_cb(EV_P_ ev_timer *w_p, int revents)
+{
+    LOG_GENERATE_TRACE(g_logger, "APPShardConnector::poll_cb enter w_p=%p revents=0x%x", w_p, revents);
+
+    APPShardConnector *connector_p = (APPShardConnector *)(w_p->data);
+    APPShardSupervisor *supervisor_p = connector_p->m_supervisor_p;
+
+    // each table is a shard's whole tick, so the newest one replaces what we had
+    bool fresh = false;
+    bool waiting = false;
+    for (unsigned int shard = 0; shard < supervisor_p->get_shard_count(); shard++)
+    {
+        std::vector<uint8_t> &levels = connector_p->m_shard_levels[shard];
+        if (false == supervisor_p->is_up(shard))
+        {
+            // a dead shard's levels would only go stale
+            levels.clear();
+            connector_p->m_fresh[shard] = false;
+            continue;
+        }
+        if (true == supervisor_p->read_levels(shard, &connector_p->m_sequences[shard], levels))
+        {
+            connector_p->m_fresh[shard] = true;
+        }
+        fresh = fresh || connector_p->m_fresh[shard];
+        // a shard with nothing to meter never holds the others back
+        waiting = waiting || ((false == connector_p->m_fresh[shard]) && (false == levels.empty()));
+    }
+
+    // the notification goes once every metering shard has ticked, or a slow one has had long enough
+    if ((true == fresh) && ((false == waiting) || (SHARD_MAXIMUM_HELD_POLLS <= connector_p->m_held_polls)))
+    {
+        // encoded messages of the same type merge when they're joined end to end, so the shards' level
+        // notifications become one with every shard's records without being decoded
+        std::vector<uint8_t> merged;
+        for (unsigned int shard = 0; shard < supervisor_p->get_shard_count(); shard++)
+        {
+            merged.insert(merged.end(), connector_p->m_shard_levels[shard].begin(), connector_p->m_shard_levels[shard].end());
+            connector_p->m_fresh[shard] = false;
+        }
+        connector_p->m_held_polls = 0;
+
+        if (false == merged.empty())
+        {
+            APPManager::Message *message_p = new APPManager::Message(merged.size());
+            memcpy(message_p->get_data_p(), &merged[0], merged.size());
+            connector_p->m_handler_p->send_notification(&message_p);
+            delete message_p;
+        }
+    }
+    else if (true == fresh)
+    {
+        connector_p->m_held_polls++;
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "APPShardConnector::poll_cb exit");
+}
+
+APPManager::Message *populate_response(::google::protobuf::MessageLite& message)
+{
+    LOG_GENERATE_TRACE(g_logger, "APPShardConnector::populate_response enter message=%p", &message);
+
+    // allocate the memory for the response
+    APPManager::Message *response_p = new APPManager::Message(message.ByteSize());
+    // serialize the response
+    if (false == message.SerializeToArray((void *)(response_p->get_data_p()), response_p->get_length()))
+    {
+        LOG_GENERATE_ERROR(g_logger, "unable to serialize response to protocol buffer");
+        delete response_p;
+        return NULL;
+    }
+    // done
+    LOG_GENERATE_TRACE(g_logger, "APPShardConnector::populate_response exit response_p=%p", response_p);
+    return response_p;
+}
+
+APPManager::Message *copy_message(const APPManager::Message *message_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "APPShardConnector::copy_message enter message_p=%p", message_p);
+
+    APPManager::Message *copy_p = new APPManager::Message(message_p->get_length());
+    memcpy(copy_p->get_data_p(), ((APPManager::Message *)message_p)->get_data_p(), message_p->get_length());
+
+    LOG_GENERATE_TRACE(g_logger, "APPShardConnector::copy_message exit copy_p=%p", copy_p);
+    return copy_p;
+}
+
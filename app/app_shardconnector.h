@@ -0,0 +1,128 @@
+#ifndef _APP_SHARDCONNECTOR_H_
+#define _APP_SHARDCONNECTOR_H_
+
+#include "common.h"
+#include "app_mgr.h"
+#include "app_dispatcher.h"
+#include "app_shardsupervisor.h"
+
+#include <ev.h>
+#include <deque>
+#include <map>
+#include <set>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+// the responses to what's sent again after a restart have nobody waiting on them
+#define SHARD_REPLAY_REQUEST_ID     (0)
+
+///////////////////////////////////////////////////////////////////////////////
+// forward declarations
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// class definition
+///////////////////////////////////////////////////////////////////////////////
+
+// the client's session in a sharded front, each request goes to the shards with its channels + the answers are put back together
+class APPShardConnector : public APPManager::RequestHandler, public APPShardSupervisor::Listener
+{
+
+///////////////////////////////////////////////////////////////////////////////
+// type definitions
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+
+    // moves the next request on outside of whatever call finished the last one
+    class Job : public APPDispatcher::Job
+    {
+    public:
+        Job(APPShardConnector *connector_p);
+        virtual ~Job();
+        void run();
+
+    private:
+        APPShardConnector *m_connector_p;
+    };
+
+///////////////////////////////////////////////////////////////////////////////
+// public function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+    APPShardConnector(APPManager::NotificationHandler *handler_p);
+    virtual ~APPShardConnector();
+
+///////////////////////////////////////////////////////////////////////////////
+// APPManager::RequestHandler declarations
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+    ResultCode handle_request(APPManager::Message *request_p, APPManager::Message **response_pp);
+
+///////////////////////////////////////////////////////////////////////////////
+// APPShardSupervisor::Listener declarations
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+    void handle_shard_up(unsigned int shard);
+    void handle_shard_down(unsigned int shard);
+    void handle_shard_frame(unsigned int shard, const APPShardLink::Header &header, APPManager::Message **message_pp);
+
+///////////////////////////////////////////////////////////////////////////////
+// private function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+    void start_request();
+    void merge_response(unsigned int shard, ResultCode result_code, APPManager::Message **response_pp);
+    void finish_request();
+    void complete(ResultCode result_code, APPManager::Message **response_pp);
+    void replay(unsigned int shard);
+    unsigned int find_shard(uint32_t channel) const;
+    unsigned int find_any_shard() const;
+
+    static void poll_cb(EV_P_ ev_timer *w_p, int revents);
+
+///////////////////////////////////////////////////////////////////////////////
+// private variable definitions
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+    APPManager::NotificationHandler *m_handler_p;
+    APPShardSupervisor *m_supervisor_p;
+    ev_timer m_poll_timer;
+    // the last levels seen from each shard
+    std::vector<uint32_t> m_sequences;
+    // every notification carries each shard's newest table, fresh until it has been sent
+    std::vector<std::vector<uint8_t> > m_shard_levels;
+    std::vector<bool> m_fresh;
+    // polls the fresh levels have waited on a shard that hasn't ticked
+    unsigned int m_held_polls;
+
+    // the requests are answered in order, the front one is in hand
+    std::deque<APPManager::Message *> m_requests;
+    uint32_t m_next_id;
+    uint32_t m_request_id;
+    int m_request_type;
+    uint32_t m_request_channel;
+    // the shards yet to answer the request in hand
+    std::set<unsigned int> m_outstanding;
+    // a request for one shard is answered with its response as is, the rest are merged
+    bool m_merging;
+    ResultCode m_result_code;
+    APPManager::Message *m_response_p;
+    std::vector<uint32_t> m_channels;
+
+    // what the client has set, so a restarted shard can be put back how it was
+    std::map<uint32_t, std::vector<uint8_t> > m_levels;
+    std::vector<uint8_t> m_alarms;
+};
+
+#endif
+
@@ -0,0 +1,256 @@
+#include "app_shardlink.h"
+#include "log.h"
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// type defintions
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// constants
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// module variables
+///////////////////////////////////////////////////////////////////////////////
+
+static LogInstance g_logger("app.shardlink");
+
+///////////////////////////////////////////////////////////////////////////////
+// private function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// public function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+APPShardLink::APPShardLink(struct ev_loop *loop_p, int socket, Handler *handler_p) :
+    m_loop_p(loop_p),
+    m_handler_p(handler_p),
+    m_socket(socket),
+    m_transmit_offset(0)
+{
+    LOG_GENERATE_TRACE(g_logger, "APPShardLink::APPShardLink enter this=%p loop_p=%p socket=%d handler_p=%p", this, loop_p, socket, handler_p);
+
+    // neither end can be allowed to block the other's loop
+    int flags = fcntl(m_socket, F_GETFL, 0);
+    if ((0 > flags) || (0 > fcntl(m_socket, F_SETFL, flags | O_NONBLOCK)))
+    {
+        LOG_GENERATE_ERROR(g_logger, "unable to set non-blocking i/o on socket=%d", m_socket);
+    }
+
+    ev_io_init(&m_receive_watcher, receive_cb, m_socket, EV_READ);
+    m_receive_watcher.data = (void *)this;
+    ev_io_init(&m_transmit_watcher, transmit_cb, m_socket, EV_WRITE);
+    m_transmit_watcher.data = (void *)this;
+
+    // the transmit side only runs while there's something queued
+    ev_io_start(m_loop_p, &m_receive_watcher);
+
+    LOG_GENERATE_TRACE(g_logger, "APPShardLink::APPShardLink exit");
+}
+
+APPShardLink::~APPShardLink()
+{
+    LOG_GENERATE_TRACE(g_logger, "APPShardLink::~APPShardLink enter this=%p", this);
+
+    ev_io_stop(m_loop_p, &m_receive_watcher);
+    ev_io_stop(m_loop_p, &m_transmit_watcher);
+    close(m_socket);
+
+    LOG_GENERATE_TRACE(g_logger, "APPShardLink::~APPShardLink exit");
+}
+
+ResultCode APPShardLink::send(FrameType type, uint32_t id, ResultCode result_code, APPManager::Message **message_pp)
+{
+    LOG_GENERATE_TRACE(g_logger, "APPShardLink::send enter this=%p type=%d id=%d result_code=%d message_pp=%p", this, type, id, result_code, message_pp);
+
+    ResultCode rc = RESULT_CODE_OK;
+
+    do
+    {
+        Header header;
+        header.type = type;
+        header.id = id;
+        header.result = result_code;
+        header.length = ((NULL != message_pp) && (NULL != *message_pp)) ? (*message_pp)->get_length() : 0;
+
+        if (SHARD_LINK_MAX_QUEUED < (m_transmit.size() - m_transmit_offset) + sizeof(header) + header.length)
+        {
+            LOG_GENERATE_ERROR(g_logger, "dropping frame type=%d id=%d, the other end isn't reading", type, id);
+            rc = RESULT_CODE_ERROR;
+            break;
+        }
+
+        // the frame goes in whole, so the other end never sees a header without its payload
+        const uint8_t *header_p = (const uint8_t *)&header;
+        m_transmit.insert(m_transmit.end(), header_p, header_p + sizeof(header));
+        if (0 < header.length)
+        {
+            const uint8_t *data_p = (*message_pp)->get_data_p();
+            m_transmit.insert(m_transmit.end(), data_p, data_p + header.length);
+        }
+
+        ev_io_start(m_loop_p, &m_transmit_watcher);
+    }
+    while (false);
+
+    // the copy is queued, or it's been dropped
+    if (NULL != message_pp)
+    {
+        delete *message_pp;
+        *message_pp = NULL;
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "APPShardLink::send exit rc=%d", rc);
+    return rc;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// private function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+void APPShardLink::receive_cb(EV_P_ ev_io *w_p, int revents)
+{
+    LOG_GENERATE_TRACE(g_logger, "APPShardLink::receive_cb enter w_p=%p revents=0x%x", w_p, revents);
+
+    do
+    {
+        APPShardLink *link_p = (APPShardLink *)(w_p->data);
+
+        if (0 != (revents & EV_ERROR))
+        {
+            LOG_GENERATE_ERROR(g_logger, "error on socket=%d", link_p->m_socket);
+            link_p->close_link();
+            break;
+        }
+
+        uint8_t buffer[SHARD_LINK_READ_SIZE];
+        ssize_t rc = recv(link_p->m_socket, buffer, sizeof(buffer), 0);
+        if (0 > rc)
+        {
+            if ((EAGAIN != errno) && (EWOULDBLOCK != errno) && (EINTR != errno))
+            {
+                LOG_GENERATE_ERROR(g_logger, "closing link for reason=%s", strerror(errno));
+                link_p->close_link();
+            }
+            break;
+        }
+        if (0 == rc)
+        {
+            LOG_GENERATE_INFO(g_logger, "link socket=%d closed by the other end", link_p->m_socket);
+            link_p->close_link();
+            break;
+        }
+
+        link_p->m_receive.insert(link_p->m_receive.end(), buffer, buffer + rc);
+        link_p->dispatch_frames();
+    }
+    while (false);
+
+    LOG_GENERATE_TRACE(g_logger, "APPShardLink::receive_cb exit");
+}
+
+void APPShardLink::transmit_cb(EV_P_ ev_io *w_p, int revents)
+{
+    LOG_GENERATE_TRACE(g_logger, "APPShardLink::transmit_cb enter w_p=%p revents=0x%x", w_p, revents);
+
+    do
+    {
+        APPShardLink *link_p = (APPShardLink *)(w_p->data);
+
+        if (0 != (revents & EV_ERROR))
+        {
+            LOG_GENERATE_ERROR(g_logger, "error on socket=%d", link_p->m_socket);
+            link_p->close_link();
+            break;
+        }
+
+        // a dead shard mustn't take the front with it through SIGPIPE
+        const size_t remaining = link_p->m_transmit.size() - link_p->m_transmit_offset;
+        ssize_t rc = ::send(link_p->m_socket, &link_p->m_transmit[link_p->m_transmit_offset], remaining, MSG_NOSIGNAL);
+        if (0 > rc)
+        {
+            if ((EAGAIN != errno) && (EWOULDBLOCK != errno) && (EINTR != errno))
+            {
+                LOG_GENERATE_ERROR(g_logger, "closing link for reason=%s", strerror(errno));
+                link_p->close_link();
+            }
+            break;
+        }
+
+        link_p->m_transmit_offset += rc;
+        if (link_p->m_transmit.size() == link_p->m_transmit_offset)
+        {
+            link_p->m_transmit.clear();
+            link_p->m_transmit_offset = 0;
+            ev_io_stop(EV_A_ w_p);
+        }
+    }
+    while (false);
+
+    LOG_GENERATE_TRACE(g_logger, "APPShardLink::transmit_cb exit");
+}
+
+void APPShardLink::dispatch_frames()
+{
+    LOG_GENERATE_TRACE(g_logger, "APPShardLink::dispatch_frames enter this=%p length=%d", this, m_receive.size());
+
+    size_t offset = 0;
+    while (sizeof(Header) <= m_receive.size() - offset)
+    {
+        Header header;
+        memcpy(&header, &m_receive[offset], sizeof(header));
+        if (SHARD_LINK_MAX_FRAME < header.length)
+        {
+            LOG_GENERATE_ERROR(g_logger, "frame type=%d length=%d too big, closing link", header.type, header.length);
+            close_link();
+            return;
+        }
+        if (sizeof(Header) + header.length > m_receive.size() - offset)
+        {
+            break;
+        }
+
+        APPManager::Message *message_p = NULL;
+        if (0 < header.length)
+        {
+            message_p = new APPManager::Message(header.length);
+            memcpy(message_p->get_data_p(), &m_receive[offset + sizeof(Header)], header.length);
+        }
+        offset += sizeof(Header) + header.length;
+
+        m_handler_p->handle_frame(this, header, &message_p);
+        delete message_p;
+    }
+    m_receive.erase(m_receive.begin(), m_receive.begin() + offset);
+
+    LOG_GENERATE_TRACE(g_logger, "APPShardLink::dispatch_frames exit remaining=%d", m_receive.size());
+}
+
+void APPShardLink::close_link()
+{
+    LOG_GENERATE_TRACE(g_logger, "APPShardLink::close_link enter this=%p", this);
+
+    ev_io_stop(m_loop_p, &m_receive_watcher);
+    ev_io_stop(m_loop_p, &m_transmit_watcher);
+
+    // this can delete us so it goes last
+    m_handler_p->handle_close(this);
+
+    LOG_GENERATE_TRACE(g_logger, "APPShardLink::close_link exit");
+}
+
@@ -0,0 +1,112 @@
+#ifndef _APP_SHARDLINK_H_
+#define _APP_SHARDLINK_H_
+
+#include "common.h"
+#include "app_mgr.h"
+
+#include <ev.h>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+// where a shard finds its end of the link once it has been exec'd
+#define SHARD_LINK_FD               (3)
+// a frame bigger than this means the other end has lost its place
+#define SHARD_LINK_MAX_FRAME        (1024 * 1024)
+// a shard that stops reading isn't allowed to take the front's memory with it
+#define SHARD_LINK_MAX_QUEUED       (4 * 1024 * 1024)
+#define SHARD_LINK_READ_SIZE        (4096)
+
+///////////////////////////////////////////////////////////////////////////////
+// forward declarations
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// class definition
+///////////////////////////////////////////////////////////////////////////////
+
+// the control side of a shard, framed messages over a local socket in both directions
+class APPShardLink
+{
+
+///////////////////////////////////////////////////////////////////////////////
+// type definitions
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+
+    typedef enum
+    {
+        // front to shard
+        FRAME_TYPE_OPEN,
+        FRAME_TYPE_CLOSE,
+        FRAME_TYPE_REQUEST,
+        // shard to front
+        FRAME_TYPE_RESPONSE,
+        FRAME_TYPE_NOTIFICATION,
+    } FrameType;
+
+    // both ends are on the same machine so it's sent as is
+    typedef struct
+    {
+        uint32_t type;
+        // matches a response to its request
+        uint32_t id;
+        int32_t result;
+        uint32_t length;
+    } Header;
+
+    class Handler
+    {
+    public:
+        // the handler can take the message by clearing the pointer, it mustn't delete the link
+        virtual void handle_frame(APPShardLink *link_p, const Header &header, APPManager::Message **message_pp) = 0;
+        // the other end has gone, the handler can delete the link from here
+        virtual void handle_close(APPShardLink *link_p) = 0;
+    };
+
+///////////////////////////////////////////////////////////////////////////////
+// public function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+    // takes ownership of the socket
+    APPShardLink(struct ev_loop *loop_p, int socket, Handler *handler_p);
+    virtual ~APPShardLink();
+
+    // the message can be NULL for frames with nothing to carry, the link owns it from then on
+    ResultCode send(FrameType type, uint32_t id, ResultCode result_code, APPManager::Message **message_pp);
+
+///////////////////////////////////////////////////////////////////////////////
+// private function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+    static void receive_cb(EV_P_ ev_io *w_p, int revents);
+    static void transmit_cb(EV_P_ ev_io *w_p, int revents);
+
+    void dispatch_frames();
+    void close_link();
+
+///////////////////////////////////////////////////////////////////////////////
+// private variable definitions
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+    struct ev_loop *m_loop_p;
+    Handler *m_handler_p;
+    int m_socket;
+    ev_io m_receive_watcher;
+    ev_io m_transmit_watcher;
+    // whole frames are appended, the offset is how much has gone out
+    std::vector<uint8_t> m_transmit;
+    size_t m_transmit_offset;
+    // whatever has arrived that isn't a whole frame yet
+    std::vector<uint8_t> m_receive;
+};
+
+#endif
+
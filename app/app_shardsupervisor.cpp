@@ -0,0 +1,437 @@
+#include "app_shardsupervisor.h"
+#include "app_shardtable.h"
+#include "config.h"
+#include "log.h"
+
+#include <stdio.h>
+#include <errno.h>
+#include <limits.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+#define SHARDS_CONFIG_SECTION               "shards"
+#define RESTART_DELAY_CONFIG_ITEM           "restart-delay"
+#define WATCHDOG_CONFIG_ITEM                "watchdog"
+
+#define DEFAULT_RESTART_DELAY               (2.0f)
+#define DEFAULT_WATCHDOG                    (5.0f)
+
+#define SELF_EXECUTABLE_PATH                "/proc/self/exe"
+
+///////////////////////////////////////////////////////////////////////////////
+// type defintions
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// constants
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// module variables
+///////////////////////////////////////////////////////////////////////////////
+
+static LogInstance g_logger("app.shardsupervisor");
+
+// singleton pointer
+APPShardSupervisor *APPShardSupervisor::g_instance_p = NULL;
+
+///////////////////////////////////////////////////////////////////////////////
+// private function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// public function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+APPShardSupervisor *APPShardSupervisor::create_instance(struct ev_loop *loop_p, unsigned int shard_count, const char *app_config_p, const char *log_config_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "APPShardSupervisor::create_instance enter loop_p=%p shard_count=%d app_config_p=%s log_config_p=%s", loop_p, shard_count, app_config_p, log_config_p);
+
+    // the child watchers only work on the default loop, which is where the clients are
+    ASSERT(NULL == g_instance_p);
+    g_instance_p = new APPShardSupervisor(loop_p, shard_count, app_config_p, log_config_p);
+
+    LOG_GENERATE_TRACE(g_logger, "APPShardSupervisor::create_instance exit g_instance=%p", g_instance_p);
+    return g_instance_p;
+}
+
+APPShardSupervisor *APPShardSupervisor::get_instance()
+{
+    return g_instance_p;
+}
+
+void APPShardSupervisor::set_listener(Listener *listener_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "APPShardSupervisor::set_listener enter this=%p listener_p=%p", this, listener_p);
+
+    ASSERT((NULL == m_listener_p) || (NULL == listener_p));
+    m_listener_p = listener_p;
+
+    LOG_GENERATE_TRACE(g_logger, "APPShardSupervisor::set_listener exit");
+}
+
+ResultCode APPShardSupervisor::send(unsigned int shard, APPShardLink::FrameType type, uint32_t id, APPManager::Message **message_pp)
+{
+    LOG_GENERATE_TRACE(g_logger, "APPShardSupervisor::send enter this=%p shard=%d type=%d id=%d message_pp=%p", this, shard, type, id, message_pp);
+
+    ResultCode result_code = RESULT_CODE_ERROR;
+
+    if (true == is_up(shard))
+    {
+        result_code = m_shards[shard]->link_p->send(type, id, RESULT_CODE_OK, message_pp);
+    }
+    else if ((NULL != message_pp) && (NULL != *message_pp))
+    {
+        // nobody to take it
+        delete *message_pp;
+        *message_pp = NULL;
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "APPShardSupervisor::send exit result_code=%d", result_code);
+    return result_code;
+}
+
+bool APPShardSupervisor::is_up(unsigned int shard) const
+{
+    return (shard < m_shards.size()) && (NULL != m_shards[shard]->link_p);
+}
+
+bool APPShardSupervisor::read_levels(unsigned int shard, uint32_t *sequence_p, std::vector<uint8_t> &levels) const
+{
+    LOG_GENERATE_TRACE(g_logger, "APPShardSupervisor::read_levels enter this=%p shard=%d", this, shard);
+
+    // the table is still there while the shard is down, there's just nothing new in it
+    bool updated = false;
+    if (shard < m_shards.size())
+    {
+        updated = m_shards[shard]->table_p->read(sequence_p, levels);
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "APPShardSupervisor::read_levels exit updated=%d", updated);
+    return updated;
+}
+
+uint32_t APPShardSupervisor::get_sequence(unsigned int shard) const
+{
+    return (shard < m_shards.size()) ? m_shards[shard]->table_p->get_sequence() : 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// APPShardLink::Handler implementations
+///////////////////////////////////////////////////////////////////////////////
+
+void APPShardSupervisor::handle_frame(APPShardLink *link_p, const APPShardLink::Header &header, APPManager::Message **message_pp)
+{
+    LOG_GENERATE_TRACE(g_logger, "APPShardSupervisor::handle_frame enter this=%p link_p=%p type=%d id=%d", this, link_p, header.type, header.id);
+
+    // with no client there's nobody to tell
+    Shard *shard_p = find_shard(link_p);
+    if ((NULL != shard_p) && (NULL != m_listener_p))
+    {
+        m_listener_p->handle_shard_frame(shard_p->index, header, message_pp);
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "APPShardSupervisor::handle_frame exit");
+}
+
+void APPShardSupervisor::handle_close(APPShardLink *link_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "APPShardSupervisor::handle_close enter this=%p link_p=%p", this, link_p);
+
+    // a shard without its link is no use, the child watcher starts another once it has gone
+    Shard *shard_p = find_shard(link_p);
+    if (NULL != shard_p)
+    {
+        LOG_GENERATE_ERROR(g_logger, "shard=%d pid=%d closed its link, killing it", shard_p->index, shard_p->pid);
+        delete shard_p->link_p;
+        shard_p->link_p = NULL;
+        if (0 != shard_p->pid)
+        {
+            kill(shard_p->pid, SIGKILL);
+        }
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "APPShardSupervisor::handle_close exit");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// private function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+APPShardSupervisor::APPShardSupervisor(struct ev_loop *loop_p, unsigned int shard_count, const char *app_config_p, const char *log_config_p) :
+    m_loop_p(loop_p),
+    m_listener_p(NULL),
+    m_restart_delay(DEFAULT_RESTART_DELAY),
+    m_watchdog(DEFAULT_WATCHDOG),
+    m_executable(SELF_EXECUTABLE_PATH),
+    m_app_config(app_config_p),
+    m_log_config(log_config_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "APPShardSupervisor::APPShardSupervisor enter this=%p loop_p=%p shard_count=%d", this, loop_p, shard_count);
+
+    Config::get_instance_p()->get_float_with_default(SHARDS_CONFIG_SECTION, RESTART_DELAY_CONFIG_ITEM, DEFAULT_RESTART_DELAY, &m_restart_delay);
+    Config::get_instance_p()->get_float_with_default(SHARDS_CONFIG_SECTION, WATCHDOG_CONFIG_ITEM, DEFAULT_WATCHDOG, &m_watchdog);
+
+    // resolved now, in case the binary is replaced while we're running
+    char executable[PATH_MAX + 1];
+    ssize_t length = readlink(SELF_EXECUTABLE_PATH, executable, PATH_MAX);
+    if (0 < length)
+    {
+        executable[length] = '\0';
+        m_executable = executable;
+    }
+
+    for (unsigned int counter = 0; counter < shard_count; counter++)
+    {
+        Shard *shard_p = new Shard;
+        shard_p->supervisor_p = this;
+        shard_p->index = counter;
+        shard_p->pid = 0;
+        shard_p->table_p = APPShardTable::create_p();
+        shard_p->link_p = NULL;
+        shard_p->heartbeat = 0;
+        shard_p->heartbeat_time = 0;
+        ev_timer_init(&shard_p->restart_timer, restart_cb, m_restart_delay, 0);
+        shard_p->restart_timer.data = (void *)shard_p;
+        m_shards.push_back(shard_p);
+
+        // without a table the front could never see its levels
+        if (NULL == shard_p->table_p)
+        {
+            LOG_GENERATE_ERROR(g_logger, "no table for shard=%d, it won't be started", counter);
+            continue;
+        }
+        start_shard(shard_p);
+    }
+
+    ev_timer_init(&m_watchdog_timer, watchdog_cb, m_watchdog, m_watchdog);
+    m_watchdog_timer.data = (void *)this;
+    ev_timer_start(m_loop_p, &m_watchdog_timer);
+
+    LOG_GENERATE_INFO(g_logger, "supervising shards=%d executable=%s", shard_count, m_executable.c_str());
+
+    LOG_GENERATE_TRACE(g_logger, "APPShardSupervisor::APPShardSupervisor exit");
+}
+
+APPShardSupervisor::~APPShardSupervisor()
+{
+    LOG_GENERATE_TRACE(g_logger, "APPShardSupervisor::~APPShardSupervisor enter this=%p", this);
+
+    ev_timer_stop(m_loop_p, &m_watchdog_timer);
+    for (std::vector<Shard *>::iterator it = m_shards.begin();
+            it != m_shards.end();
+            it++)
+    {
+        Shard *shard_p = *it;
+        ev_timer_stop(m_loop_p, &shard_p->restart_timer);
+        if (0 != shard_p->pid)
+        {
+            ev_child_stop(m_loop_p, &shard_p->child_watcher);
+            kill(shard_p->pid, SIGTERM);
+        }
+        delete shard_p->link_p;
+        delete shard_p->table_p;
+        delete shard_p;
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "APPShardSupervisor::~APPShardSupervisor exit");
+}
+
+void APPShardSupervisor::start_shard(Shard *shard_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "APPShardSupervisor::start_shard enter this=%p shard=%d", this, shard_p->index);
+
+    do
+    {
+        int sockets[2];
+        if (0 != socketpair(AF_UNIX, SOCK_STREAM, 0, sockets))
+        {
+            LOG_GENERATE_ERROR(g_logger, "unable to create link for shard=%d reason=%s", shard_p->index, strerror(errno));
+            ev_timer_start(m_loop_p, &shard_p->restart_timer);
+            break;
+        }
+
+        // nothing is mapping it, so whatever the last process left half written goes
+        shard_p->table_p->reset();
+
+        // everything the child needs is made up front, between the fork + the exec it can only make system calls
+        char shard[16];
+        snprintf(shard, sizeof(shard), "%d", shard_p->index);
+        std::string app_config = "--config=" + m_app_config;
+        std::string log_config = "--log=" + m_log_config;
+        std::string shard_option = std::string("--shard=") + shard;
+        char *argv[] = {(char *)m_executable.c_str(), (char *)app_config.c_str(), (char *)log_config.c_str(), (char *)shard_option.c_str(), NULL};
+        const int table_fd = shard_p->table_p->get_fd();
+        const long max_fd = sysconf(_SC_OPEN_MAX);
+        const pid_t parent = getpid();
+
+        pid_t pid = fork();
+        if (0 > pid)
+        {
+            LOG_GENERATE_ERROR(g_logger, "unable to fork shard=%d reason=%s", shard_p->index, strerror(errno));
+            close(sockets[0]);
+            close(sockets[1]);
+            ev_timer_start(m_loop_p, &shard_p->restart_timer);
+            break;
+        }
+        if (0 == pid)
+        {
+            // the shard goes with the front, even if the front is killed outright
+            prctl(PR_SET_PDEATHSIG, SIGTERM);
+            if (parent != getppid())
+            {
+                _exit(1);
+            }
+
+            // the link + table go where the shard looks for them, out of the way first so neither lands on the other
+            int link_fd = fcntl(sockets[1], F_DUPFD, SHARD_TABLE_FD + 1);
+            int shared_fd = fcntl(table_fd, F_DUPFD, SHARD_TABLE_FD + 1);
+            dup2(link_fd, SHARD_LINK_FD);
+            dup2(shared_fd, SHARD_TABLE_FD);
+
+            // the client socket + the other shards' links mustn't be held open by this one
+            for (long fd = SHARD_TABLE_FD + 1; fd < max_fd; fd++)
+            {
+                close(fd);
+            }
+
+            // the loop's signal handling blocks some, the shard's own loop sets up what it needs
+            sigset_t mask;
+            sigemptyset(&mask);
+            sigprocmask(SIG_SETMASK, &mask, NULL);
+
+            execv(argv[0], argv);
+            _exit(127);
+        }
+
+        close(sockets[1]);
+        shard_p->pid = pid;
+        shard_p->link_p = new APPShardLink(m_loop_p, sockets[0], this);
+        ev_child_init(&shard_p->child_watcher, child_cb, pid, 0);
+        shard_p->child_watcher.data = (void *)shard_p;
+        ev_child_start(m_loop_p, &shard_p->child_watcher);
+
+        // the first heartbeat can be a while coming
+        shard_p->heartbeat = 0;
+        shard_p->heartbeat_time = ev_now(m_loop_p) + SHARD_STARTUP_GRACE;
+
+        LOG_GENERATE_INFO(g_logger, "started shard=%d pid=%d", shard_p->index, pid);
+
+        if (NULL != m_listener_p)
+        {
+            m_listener_p->handle_shard_up(shard_p->index);
+        }
+    }
+    while (false);
+
+    LOG_GENERATE_TRACE(g_logger, "APPShardSupervisor::start_shard exit");
+}
+
+APPShardSupervisor::Shard *APPShardSupervisor::find_shard(const APPShardLink *link_p) const
+{
+    LOG_GENERATE_TRACE(g_logger, "APPShardSupervisor::find_shard enter this=%p link_p=%p", this, link_p);
+
+    Shard *shard_p = NULL;
+    for (std::vector<Shard *>::const_iterator it = m_shards.begin();
+            it != m_shards.end();
+            it++)
+    {
+        if (link_p == (*it)->link_p)
+        {
+            shard_p = *it;
+            break;
+        }
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "APPShardSupervisor::find_shard exit shard_p=%p", shard_p);
+    return shard_p;
+}
+
+void APPShardSupervisor::child_cb(EV_P_ ev_child *w_p, int revents)
+{
+    LOG_GENERATE_TRACE(g_logger, "APPShardSupervisor::child_cb enter w_p=%p revents=0x%x", w_p, revents);
+
+    Shard *shard_p = (Shard *)(w_p->data);
+    APPShardSupervisor *supervisor_p = shard_p->supervisor_p;
+    ev_child_stop(EV_A_ w_p);
+
+    if (WIFSIGNALED(w_p->rstatus))
+    {
+        LOG_GENERATE_ERROR(g_logger, "shard=%d pid=%d killed by signal=%d", shard_p->index, w_p->rpid, WTERMSIG(w_p->rstatus));
+    }
+    else
+    {
+        LOG_GENERATE_ERROR(g_logger, "shard=%d pid=%d exited status=%d", shard_p->index, w_p->rpid, WEXITSTATUS(w_p->rstatus));
+    }
+
+    // the link may already have closed, but anything still queued on it has nowhere to go
+    delete shard_p->link_p;
+    shard_p->link_p = NULL;
+    shard_p->pid = 0;
+
+    // the client stays connected, it just hears nothing from these channels until the shard is back
+    if (NULL != supervisor_p->m_listener_p)
+    {
+        supervisor_p->m_listener_p->handle_shard_down(shard_p->index);
+    }
+    ev_timer_start(EV_A_ &shard_p->restart_timer);
+
+    LOG_GENERATE_TRACE(g_logger, "APPShardSupervisor::child_cb exit");
+}
+
+void APPShardSupervisor::restart_cb(EV_P_ ev_timer *w_p, int revents)
+{
+    LOG_GENERATE_TRACE(g_logger, "APPShardSupervisor::restart_cb enter w_p=%p revents=0x%x", w_p, revents);
+
+    Shard *shard_p = (Shard *)(w_p->data);
+    LOG_GENERATE_INFO(g_logger, "restarting shard=%d", shard_p->index);
+    shard_p->supervisor_p->start_shard(shard_p);
+
+    LOG_GENERATE_TRACE(g_logger, "APPShardSupervisor::restart_cb exit");
+}
+
+void APPShardSupervisor::watchdog_cb(EV_P_ ev_timer *w_p, int revents)
+{
+    LOG_GENERATE_TRACE(g_logger, "APPShardSupervisor::watchdog_cb enter w_p=%p revents=0x%x", w_p, revents);
+
+    APPShardSupervisor *supervisor_p = (APPShardSupervisor *)(w_p->data);
+    const ev_tstamp now = ev_now(EV_A);
+    for (std::vector<Shard *>::iterator it = supervisor_p->m_shards.begin();
+            it != supervisor_p->m_shards.end();
+            it++)
+    {
+        Shard *shard_p = *it;
+        if (0 == shard_p->pid)
+        {
+            continue;
+        }
+
+        // a shard that's alive but not turning its loop is killed, the child watcher takes it from there
+        const uint32_t heartbeat = shard_p->table_p->get_heartbeat();
+        if (heartbeat != shard_p->heartbeat)
+        {
+            shard_p->heartbeat = heartbeat;
+            shard_p->heartbeat_time = now;
+        }
+        else if (supervisor_p->m_watchdog < now - shard_p->heartbeat_time)
+        {
+            LOG_GENERATE_ERROR(g_logger, "shard=%d pid=%d has stopped, killing it", shard_p->index, shard_p->pid);
+            kill(shard_p->pid, SIGKILL);
+        }
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "APPShardSupervisor::watchdog_cb exit");
+}
+
@@ -0,0 +1,139 @@
+#ifndef _APP_SHARDSUPERVISOR_H_
+#define _APP_SHARDSUPERVISOR_H_
+
+#include "common.h"
+#include "app_mgr.h"
+#include "app_shardlink.h"
+
+#include <sys/types.h>
+#include <ev.h>
+#include <string>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+// opening the cards + loading the plugins can take a while before the first heartbeat
+#define SHARD_STARTUP_GRACE         (30.0f)
+
+///////////////////////////////////////////////////////////////////////////////
+// forward declarations
+///////////////////////////////////////////////////////////////////////////////
+
+class APPShardTable;
+
+///////////////////////////////////////////////////////////////////////////////
+// class definition
+///////////////////////////////////////////////////////////////////////////////
+
+// runs in the front, starts a process per shard + starts it again whenever it dies or hangs
+class APPShardSupervisor : public APPShardLink::Handler
+{
+
+///////////////////////////////////////////////////////////////////////////////
+// type definitions
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+
+    // the front's client session, there's only ever one
+    class Listener
+    {
+    public:
+        virtual void handle_shard_up(unsigned int shard) = 0;
+        virtual void handle_shard_down(unsigned int shard) = 0;
+        virtual void handle_shard_frame(unsigned int shard, const APPShardLink::Header &header, APPManager::Message **message_pp) = 0;
+    };
+
+private:
+
+    typedef struct
+    {
+        APPShardSupervisor *supervisor_p;
+        unsigned int index;
+        // 0 while there's no process
+        pid_t pid;
+        // made once, each process gets the same one
+        APPShardTable *table_p;
+        // NULL once the link has closed
+        APPShardLink *link_p;
+        ev_child child_watcher;
+        ev_timer restart_timer;
+        // the last heartbeat seen + when it changed
+        uint32_t heartbeat;
+        ev_tstamp heartbeat_time;
+    } Shard;
+
+///////////////////////////////////////////////////////////////////////////////
+// public function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+    // the shards are the same executable, started with the same config
+    static APPShardSupervisor *create_instance(struct ev_loop *loop_p, unsigned int shard_count, const char *app_config_p, const char *log_config_p);
+    // NULL unless the front is sharded
+    static APPShardSupervisor *get_instance();
+
+    void set_listener(Listener *listener_p);
+
+    ResultCode send(unsigned int shard, APPShardLink::FrameType type, uint32_t id, APPManager::Message **message_pp);
+    bool is_up(unsigned int shard) const;
+    bool read_levels(unsigned int shard, uint32_t *sequence_p, std::vector<uint8_t> &levels) const;
+    uint32_t get_sequence(unsigned int shard) const;
+
+    inline unsigned int get_shard_count() const;
+
+///////////////////////////////////////////////////////////////////////////////
+// APPShardLink::Handler declarations
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+    void handle_frame(APPShardLink *link_p, const APPShardLink::Header &header, APPManager::Message **message_pp);
+    void handle_close(APPShardLink *link_p);
+
+///////////////////////////////////////////////////////////////////////////////
+// private function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+    APPShardSupervisor(struct ev_loop *loop_p, unsigned int shard_count, const char *app_config_p, const char *log_config_p);
+    virtual ~APPShardSupervisor();
+
+    void start_shard(Shard *shard_p);
+    Shard *find_shard(const APPShardLink *link_p) const;
+
+    static void child_cb(EV_P_ ev_child *w_p, int revents);
+    static void restart_cb(EV_P_ ev_timer *w_p, int revents);
+    static void watchdog_cb(EV_P_ ev_timer *w_p, int revents);
+
+///////////////////////////////////////////////////////////////////////////////
+// private variable definitions
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+    static APPShardSupervisor *g_instance_p;
+
+    struct ev_loop *m_loop_p;
+    std::vector<Shard *> m_shards;
+    Listener *m_listener_p;
+    ev_timer m_watchdog_timer;
+    float m_restart_delay;
+    float m_watchdog;
+    // what each shard is exec'd with
+    std::string m_executable;
+    std::string m_app_config;
+    std::string m_log_config;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// inline function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+inline unsigned int APPShardSupervisor::get_shard_count() const
+{
+    return m_shards.size();
+}
+
+#endif
+
@@ -0,0 +1,253 @@
+#include "app_shardtable.h"
+#include "log.h"
+
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+#define SHARD_TABLE_NAME_FORMAT     "/leveling-glass-%d-%d"
+
+///////////////////////////////////////////////////////////////////////////////
+// type defintions
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// constants
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// module variables
+///////////////////////////////////////////////////////////////////////////////
+
+static LogInstance g_logger("app.shardtable");
+
+// keeps the names unique within the front
+static int g_table_count = 0;
+
+///////////////////////////////////////////////////////////////////////////////
+// private function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// public function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+APPShardTable *APPShardTable::create_p()
+{
+    LOG_GENERATE_TRACE(g_logger, "APPShardTable::create_p enter");
+
+    APPShardTable *table_p = NULL;
+
+    do
+    {
+        // the name is only needed until the fd is open, after that nothing else can find it
+        char name[64];
+        snprintf(name, sizeof(name), SHARD_TABLE_NAME_FORMAT, getpid(), g_table_count++);
+        int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (0 > fd)
+        {
+            LOG_GENERATE_ERROR(g_logger, "unable to create shard table=%s reason=%s", name, strerror(errno));
+            break;
+        }
+        shm_unlink(name);
+
+        if (0 != ftruncate(fd, sizeof(Region)))
+        {
+            LOG_GENERATE_ERROR(g_logger, "unable to size shard table=%s reason=%s", name, strerror(errno));
+            close(fd);
+            break;
+        }
+
+        // new memory reads as zero, so the levels start out empty
+        table_p = map_p(fd);
+        if (NULL == table_p)
+        {
+            close(fd);
+            break;
+        }
+        __atomic_store_n(&table_p->m_region_p->magic, SHARD_TABLE_MAGIC, __ATOMIC_RELEASE);
+    }
+    while (false);
+
+    LOG_GENERATE_TRACE(g_logger, "APPShardTable::create_p exit table_p=%p", table_p);
+    return table_p;
+}
+
+APPShardTable *APPShardTable::attach_p(int fd)
+{
+    LOG_GENERATE_TRACE(g_logger, "APPShardTable::attach_p enter fd=%d", fd);
+
+    // anything else on the fd means we weren't started by the front
+    APPShardTable *table_p = map_p(fd);
+    if ((NULL != table_p) && (SHARD_TABLE_MAGIC != __atomic_load_n(&table_p->m_region_p->magic, __ATOMIC_ACQUIRE)))
+    {
+        LOG_GENERATE_ERROR(g_logger, "fd=%d is not a shard table", fd);
+        delete table_p;
+        table_p = NULL;
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "APPShardTable::attach_p exit table_p=%p", table_p);
+    return table_p;
+}
+
+APPShardTable::~APPShardTable()
+{
+    LOG_GENERATE_TRACE(g_logger, "APPShardTable::~APPShardTable enter this=%p", this);
+
+    munmap(m_region_p, sizeof(Region));
+    close(m_fd);
+
+    LOG_GENERATE_TRACE(g_logger, "APPShardTable::~APPShardTable exit");
+}
+
+void APPShardTable::reset()
+{
+    LOG_GENERATE_TRACE(g_logger, "APPShardTable::reset enter this=%p", this);
+
+    // a shard that died mid publish could have left the sequence odd
+    __atomic_store_n(&m_region_p->length, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&m_region_p->sequence, 0, __ATOMIC_RELEASE);
+    __atomic_store_n(&m_region_p->heartbeat, 0, __ATOMIC_RELEASE);
+
+    LOG_GENERATE_TRACE(g_logger, "APPShardTable::reset exit");
+}
+
+ResultCode APPShardTable::publish(const uint8_t *levels_p, size_t length)
+{
+    LOG_GENERATE_TRACE(g_logger, "APPShardTable::publish enter this=%p levels_p=%p length=%d", this, levels_p, length);
+
+    ResultCode result_code = RESULT_CODE_OK;
+
+    do
+    {
+        if (SHARD_TABLE_LEVELS_SIZE < length)
+        {
+            LOG_GENERATE_ERROR(g_logger, "levels length=%d too big for the shard table", length);
+            result_code = RESULT_CODE_ERROR;
+            break;
+        }
+
+        // odd first, so a reader that overlaps the copy sees the sequence move + tries again
+        const uint32_t sequence = __atomic_load_n(&m_region_p->sequence, __ATOMIC_RELAXED);
+        __atomic_store_n(&m_region_p->sequence, sequence + 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+
+        if (0 < length)
+        {
+            memcpy(m_region_p->levels, levels_p, length);
+        }
+        __atomic_store_n(&m_region_p->length, (uint32_t)length, __ATOMIC_RELAXED);
+
+        __atomic_store_n(&m_region_p->sequence, sequence + 2, __ATOMIC_RELEASE);
+    }
+    while (false);
+
+    LOG_GENERATE_TRACE(g_logger, "APPShardTable::publish exit result_code=%d", result_code);
+    return result_code;
+}
+
+void APPShardTable::beat()
+{
+    LOG_GENERATE_TRACE(g_logger, "APPShardTable::beat enter this=%p", this);
+
+    __atomic_fetch_add(&m_region_p->heartbeat, 1, __ATOMIC_RELEASE);
+
+    LOG_GENERATE_TRACE(g_logger, "APPShardTable::beat exit");
+}
+
+bool APPShardTable::read(uint32_t *sequence_p, std::vector<uint8_t> &levels) const
+{
+    LOG_GENERATE_TRACE(g_logger, "APPShardTable::read enter this=%p sequence=%d", this, *sequence_p);
+
+    bool updated = false;
+
+    for (int attempt = 0; attempt < SHARD_TABLE_READ_ATTEMPTS; attempt++)
+    {
+        const uint32_t before = __atomic_load_n(&m_region_p->sequence, __ATOMIC_ACQUIRE);
+        if (before == *sequence_p)
+        {
+            break;
+        }
+        if (0 != (before & 1))
+        {
+            continue;
+        }
+
+        // the length can be torn like the rest, the sequence check below throws the copy away if it was
+        uint32_t length = __atomic_load_n(&m_region_p->length, __ATOMIC_RELAXED);
+        if (SHARD_TABLE_LEVELS_SIZE < length)
+        {
+            continue;
+        }
+        levels.resize(length);
+        if (0 < length)
+        {
+            memcpy(&levels[0], m_region_p->levels, length);
+        }
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        const uint32_t after = __atomic_load_n(&m_region_p->sequence, __ATOMIC_RELAXED);
+        if (before == after)
+        {
+            *sequence_p = before;
+            updated = true;
+            break;
+        }
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "APPShardTable::read exit updated=%d sequence=%d", updated, *sequence_p);
+    return updated;
+}
+
+uint32_t APPShardTable::get_sequence() const
+{
+    return __atomic_load_n(&m_region_p->sequence, __ATOMIC_ACQUIRE);
+}
+
+uint32_t APPShardTable::get_heartbeat() const
+{
+    return __atomic_load_n(&m_region_p->heartbeat, __ATOMIC_ACQUIRE);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// private function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+APPShardTable *APPShardTable::map_p(int fd)
+{
+    LOG_GENERATE_TRACE(g_logger, "APPShardTable::map_p enter fd=%d", fd);
+
+    APPShardTable *table_p = NULL;
+
+    void *region_p = mmap(NULL, sizeof(Region), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (MAP_FAILED == region_p)
+    {
+        LOG_GENERATE_ERROR(g_logger, "unable to map shard table fd=%d reason=%s", fd, strerror(errno));
+    }
+    else
+    {
+        table_p = new APPShardTable(fd, (Region *)region_p);
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "APPShardTable::map_p exit table_p=%p", table_p);
+    return table_p;
+}
+
+APPShardTable::APPShardTable(int fd, Region *region_p) :
+    m_fd(fd),
+    m_region_p(region_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "APPShardTable::APPShardTable enter this=%p fd=%d region_p=%p", this, fd, region_p);
+    LOG_GENERATE_TRACE(g_logger, "APPShardTable::APPShardTable exit");
+}
+
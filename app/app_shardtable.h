@@ -0,0 +1,102 @@
+#ifndef _APP_SHARDTABLE_H_
+#define _APP_SHARDTABLE_H_
+
+#include "common.h"
+
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+// where a shard finds its table once it has been exec'd
+#define SHARD_TABLE_FD              (4)
+// room for the encoded level notification of every channel on a card
+#define SHARD_TABLE_LEVELS_SIZE     (64 * 1024)
+#define SHARD_TABLE_MAGIC           (0x4c475354)
+// a shard that died mid publish leaves the sequence odd, so the reader gives up rather than spin
+#define SHARD_TABLE_READ_ATTEMPTS   (16)
+
+///////////////////////////////////////////////////////////////////////////////
+// forward declarations
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// class definition
+///////////////////////////////////////////////////////////////////////////////
+
+// shared memory written by one shard + read by the front, the levels are seqlocked so neither side waits
+class APPShardTable
+{
+
+///////////////////////////////////////////////////////////////////////////////
+// type definitions
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+
+    typedef struct
+    {
+        uint32_t magic;
+        // bumped by the shard's timer, the front restarts a shard that stops
+        uint32_t heartbeat;
+        // odd while the shard is writing the levels
+        uint32_t sequence;
+        uint32_t length;
+        uint8_t levels[SHARD_TABLE_LEVELS_SIZE];
+    } Region;
+
+///////////////////////////////////////////////////////////////////////////////
+// public function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+    // the front makes one per shard, the shard maps the same memory through the fd it inherits
+    static APPShardTable *create_p();
+    static APPShardTable *attach_p(int fd);
+    virtual ~APPShardTable();
+
+    // only while no shard has it mapped
+    void reset();
+
+    // the shard's side, each publish is the whole of one tick's levels
+    ResultCode publish(const uint8_t *levels_p, size_t length);
+    void beat();
+
+    // the front's side, false unless there's something newer than sequence
+    bool read(uint32_t *sequence_p, std::vector<uint8_t> &levels) const;
+    uint32_t get_sequence() const;
+    uint32_t get_heartbeat() const;
+
+    inline int get_fd() const;
+
+///////////////////////////////////////////////////////////////////////////////
+// private function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+    APPShardTable(int fd, Region *region_p);
+
+    static APPShardTable *map_p(int fd);
+
+///////////////////////////////////////////////////////////////////////////////
+// private variable definitions
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+    int m_fd;
+    Region *m_region_p;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// inline function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+inline int APPShardTable::get_fd() const
+{
+    return m_fd;
+}
+
+#endif
+
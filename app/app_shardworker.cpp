@@ -0,0 +1,227 @@
+#include "app_shardworker.h"
+#include "app_shardtable.h"
+#include "control/control.h"
+#include "audio/audio_processor.h"
+#include "audio/audio_capturemgr.h"
+#include "log.h"
+
+#include "proto/v1.pb.h"
+
+#include <stdlib.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// type defintions
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// constants
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// module variables
+///////////////////////////////////////////////////////////////////////////////
+
+static LogInstance g_logger("app.shardworker");
+
+// singleton pointer
+APPShardWorker *APPShardWorker::g_instance_p = NULL;
+
+///////////////////////////////////////////////////////////////////////////////
+// private function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// public function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+APPShardWorker *APPShardWorker::create_instance(struct ev_loop *loop_p, unsigned int shard)
+{
+    LOG_GENERATE_TRACE(g_logger, "APPShardWorker::create_instance enter loop_p=%p shard=%d", loop_p, shard);
+
+    ASSERT(NULL == g_instance_p);
+    APPShardTable *table_p = APPShardTable::attach_p(SHARD_TABLE_FD);
+    if (NULL != table_p)
+    {
+        g_instance_p = new APPShardWorker(loop_p, shard, table_p);
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "APPShardWorker::create_instance exit g_instance=%p", g_instance_p);
+    return g_instance_p;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// APPManager::NotificationHandler implementations
+///////////////////////////////////////////////////////////////////////////////
+
+ResultCode APPShardWorker::send_notification(APPManager::Message **notification_pp)
+{
+    LOG_GENERATE_TRACE(g_logger, "APPShardWorker::send_notification enter this=%p notification_pp=%p", this, notification_pp);
+
+    ResultCode result_code = RESULT_CODE_OK;
+
+    // the levels go in the table for the front to pick up on its tick, alarms + faults are sent as they happen
+    v1::ResponseOrNotification responseornotification;
+    APPManager::Message *message_p = *notification_pp;
+    if ((true == responseornotification.ParseFromArray(message_p->get_data_p(), message_p->get_length())) &&
+            (v1::ResponseOrNotification_ResponseOrNotificationType_NOTIFICATION == responseornotification.type()) &&
+            (v1::LEVEL == responseornotification.notification().type()))
+    {
+        result_code = m_table_p->publish(message_p->get_data_p(), message_p->get_length());
+        m_published = true;
+        m_table_filled = true;
+        delete message_p;
+        *notification_pp = NULL;
+    }
+    else
+    {
+        result_code = m_link_p->send(APPShardLink::FRAME_TYPE_NOTIFICATION, 0, RESULT_CODE_OK, notification_pp);
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "APPShardWorker::send_notification exit result_code=%d", result_code);
+    return result_code;
+}
+
+ResultCode APPShardWorker::send_response(ResultCode result_code, APPManager::Message **response_pp)
+{
+    LOG_GENERATE_TRACE(g_logger, "APPShardWorker::send_response enter this=%p result_code=%d response_pp=%p", this, result_code, response_pp);
+
+    ResultCode rc = m_link_p->send(APPShardLink::FRAME_TYPE_RESPONSE, m_request_id, result_code, response_pp);
+
+    LOG_GENERATE_TRACE(g_logger, "APPShardWorker::send_response exit rc=%d", rc);
+    return rc;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// APPShardLink::Handler implementations
+///////////////////////////////////////////////////////////////////////////////
+
+void APPShardWorker::handle_frame(APPShardLink *link_p, const APPShardLink::Header &header, APPManager::Message **message_pp)
+{
+    LOG_GENERATE_TRACE(g_logger, "APPShardWorker::handle_frame enter this=%p link_p=%p type=%d id=%d message_pp=%p", this, link_p, header.type, header.id, message_pp);
+
+    switch (header.type)
+    {
+        case APPShardLink::FRAME_TYPE_OPEN:
+        {
+            // the front has a client, so the metering starts
+            if (NULL == m_control_p)
+            {
+                LOG_GENERATE_INFO(g_logger, "shard=%d opened", m_shard);
+                m_processor_p = new AUDIOProcessor(AUDIOCaptureManager::get_instance()->get_loop_p());
+                m_control_p = new Control(m_processor_p, this);
+            }
+            break;
+        }
+        case APPShardLink::FRAME_TYPE_CLOSE:
+        {
+            LOG_GENERATE_INFO(g_logger, "shard=%d closed", m_shard);
+            delete m_control_p;
+            m_control_p = NULL;
+            delete m_processor_p;
+            m_processor_p = NULL;
+            break;
+        }
+        case APPShardLink::FRAME_TYPE_REQUEST:
+        {
+            m_request_id = header.id;
+            APPManager::Message *response_p = NULL;
+            ResultCode result_code = RESULT_CODE_ERROR;
+            if ((NULL == m_control_p) || (NULL == *message_pp))
+            {
+                LOG_GENERATE_ERROR(g_logger, "request id=%d on shard=%d with no client", header.id, m_shard);
+            }
+            else
+            {
+                // pass thru the request to the control object
+                result_code = m_control_p->handle_request(*message_pp, &response_p);
+            }
+            send_response(result_code, &response_p);
+            break;
+        }
+        default:
+        {
+            LOG_GENERATE_ERROR(g_logger, "unknown frame type=%d", header.type);
+            break;
+        }
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "APPShardWorker::handle_frame exit");
+}
+
+void APPShardWorker::handle_close(APPShardLink *link_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "APPShardWorker::handle_close enter this=%p link_p=%p", this, link_p);
+
+    // the front has gone, a new one starts its own shards
+    LOG_GENERATE_INFO(g_logger, "shard=%d lost the front, exiting", m_shard);
+    exit(0);
+
+    LOG_GENERATE_TRACE(g_logger, "APPShardWorker::handle_close exit");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// private function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+APPShardWorker::APPShardWorker(struct ev_loop *loop_p, unsigned int shard, APPShardTable *table_p) :
+    m_loop_p(loop_p),
+    m_shard(shard),
+    m_table_p(table_p),
+    m_link_p(NULL),
+    m_processor_p(NULL),
+    m_control_p(NULL),
+    m_request_id(0),
+    m_published(false),
+    m_table_filled(false)
+{
+    LOG_GENERATE_TRACE(g_logger, "APPShardWorker::APPShardWorker enter this=%p loop_p=%p shard=%d table_p=%p", this, loop_p, shard, table_p);
+
+    m_link_p = new APPShardLink(m_loop_p, SHARD_LINK_FD, this);
+
+    ev_timer_init(&m_heartbeat_timer, heartbeat_cb, SHARD_HEARTBEAT_INTERVAL, SHARD_HEARTBEAT_INTERVAL);
+    m_heartbeat_timer.data = (void *)this;
+    ev_timer_start(m_loop_p, &m_heartbeat_timer);
+
+    LOG_GENERATE_TRACE(g_logger, "APPShardWorker::APPShardWorker exit");
+}
+
+APPShardWorker::~APPShardWorker()
+{
+    LOG_GENERATE_TRACE(g_logger, "APPShardWorker::~APPShardWorker enter this=%p", this);
+
+    ev_timer_stop(m_loop_p, &m_heartbeat_timer);
+    delete m_control_p;
+    delete m_processor_p;
+    delete m_link_p;
+    delete m_table_p;
+
+    LOG_GENERATE_TRACE(g_logger, "APPShardWorker::~APPShardWorker exit");
+}
+
+void APPShardWorker::heartbeat_cb(EV_P_ ev_timer *w_p, int revents)
+{
+    LOG_GENERATE_TRACE(g_logger, "APPShardWorker::heartbeat_cb enter w_p=%p revents=0x%x", w_p, revents);
+
+    // a loop stuck behind a wedged capture thread stops this, + the front restarts us
+    APPShardWorker *worker_p = (APPShardWorker *)(w_p->data);
+    worker_p->m_table_p->beat();
+
+    // the processor stops sending levels when there's nothing to meter, so the table is emptied for it
+    if ((false == worker_p->m_published) && (true == worker_p->m_table_filled))
+    {
+        worker_p->m_table_p->publish(NULL, 0);
+        worker_p->m_table_filled = false;
+    }
+    worker_p->m_published = false;
+
+    LOG_GENERATE_TRACE(g_logger, "APPShardWorker::heartbeat_cb exit");
+}
+
@@ -0,0 +1,91 @@
+#ifndef _APP_SHARDWORKER_H_
+#define _APP_SHARDWORKER_H_
+
+#include "common.h"
+#include "app_mgr.h"
+#include "app_shardlink.h"
+
+#include <ev.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+// how often the shard shows the front its loop is still turning
+#define SHARD_HEARTBEAT_INTERVAL    (0.5f)
+
+///////////////////////////////////////////////////////////////////////////////
+// forward declarations
+///////////////////////////////////////////////////////////////////////////////
+
+class APPShardTable;
+class AUDIOProcessor;
+class Control;
+
+///////////////////////////////////////////////////////////////////////////////
+// class definition
+///////////////////////////////////////////////////////////////////////////////
+
+// the front's stand in inside a shard process, it runs a control for the client while one is connected
+class APPShardWorker : public APPManager::NotificationHandler, public APPShardLink::Handler
+{
+
+///////////////////////////////////////////////////////////////////////////////
+// public function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+    // the link + table are the fds the front left us, NULL if either isn't there
+    static APPShardWorker *create_instance(struct ev_loop *loop_p, unsigned int shard);
+
+///////////////////////////////////////////////////////////////////////////////
+// APPManager::NotificationHandler declarations
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+    ResultCode send_notification(APPManager::Message **notification_pp);
+    ResultCode send_response(ResultCode result_code, APPManager::Message **response_pp);
+
+///////////////////////////////////////////////////////////////////////////////
+// APPShardLink::Handler declarations
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+    void handle_frame(APPShardLink *link_p, const APPShardLink::Header &header, APPManager::Message **message_pp);
+    void handle_close(APPShardLink *link_p);
+
+///////////////////////////////////////////////////////////////////////////////
+// private function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+    APPShardWorker(struct ev_loop *loop_p, unsigned int shard, APPShardTable *table_p);
+    virtual ~APPShardWorker();
+
+    static void heartbeat_cb(EV_P_ ev_timer *w_p, int revents);
+
+///////////////////////////////////////////////////////////////////////////////
+// private variable definitions
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+    static APPShardWorker *g_instance_p;
+
+    struct ev_loop *m_loop_p;
+    unsigned int m_shard;
+    APPShardTable *m_table_p;
+    APPShardLink *m_link_p;
+    ev_timer m_heartbeat_timer;
+    // only while the front has a client
+    AUDIOProcessor *m_processor_p;
+    Control *m_control_p;
+    // the request control is answering
+    uint32_t m_request_id;
+    // levels went in the table since the last heartbeat
+    bool m_published;
+    // the table holds levels rather than nothing
+    bool m_table_filled;
+};
+
+#endif
+
@@ -5,8 +5,11 @@
 #include "app_sppconnector.h"
 #include "control/control.h"
 #include "audio/audio_processor.h"
+#include "audio/audio_capturemgr.h"
 #include "log.h"
 
+#include <string.h>
+
 ///////////////////////////////////////////////////////////////////////////////
 // macros
 ///////////////////////////////////////////////////////////////////////////////
@@ -38,18 +41,40 @@ static LogInstance g_logger("app.sppconnector");
 ///////////////////////////////////////////////////////////////////////////////
 
 SPPConnector::SPPConnector(APPManager::NotificationHandler *handler_p) :
-    m_processor_p(new AUDIOProcessor()),
-    m_control_p(new Control(m_processor_p, handler_p))
+    m_handler_p(handler_p),
+    m_processor_p(NULL),
+    m_control_p(NULL)
 {
     LOG_GENERATE_TRACE(g_logger, "SPPConnector::SPPConnector enter this=%p handler_p=%p", this, handler_p);
+
+    // the processor's timer goes on the processing loop so it has to be created there, any requests queue up behind it
+    APPManager::get_processing_dispatcher_p()->post(new Job(this, Job::JOB_TYPE_CREATE));
+
     LOG_GENERATE_TRACE(g_logger, "SPPConnector::SPPConnector exit");
 }
 
 SPPConnector::~SPPConnector()
 {
     LOG_GENERATE_TRACE(g_logger, "SPPConnector::~SPPConnector enter this=%p", this);
-    delete m_control_p;
-    delete m_processor_p;
+
+    APPDispatcher *processing_p = APPManager::get_processing_dispatcher_p();
+    APPDispatcher *transport_p = APPManager::get_transport_dispatcher_p();
+    if (processing_p == transport_p)
+    {
+        // one loop, so nothing else can be running them right now
+        processing_p->cancel(this);
+        delete m_control_p;
+        delete m_processor_p;
+    }
+    else
+    {
+        // the requests ahead of it still run, nothing is sent to us once it has
+        processing_p->post_and_wait(new Job(this, Job::JOB_TYPE_DESTROY));
+    }
+
+    // drop the responses + notifications that didn't make it out
+    transport_p->cancel(this);
+
     LOG_GENERATE_TRACE(g_logger, "SPPConnector::~SPPConnector exit");
 }
 
@@ -61,12 +86,114 @@ ResultCode SPPConnector::handle_request(APPManager::Message *request_p, APPManag
 {
     LOG_GENERATE_TRACE(g_logger, "SPPConnector::handle_request enter this=%p request_p=%p response_pp=%p", this, request_p, response_pp);
 
-    // pass thru the request to the control object
-    ResultCode result = m_control_p->handle_request(request_p, response_pp);
+    // the caller reuses its buffer so the request goes over as a copy, the response comes back through send_response
+    APPManager::Message *message_p = new APPManager::Message(request_p->get_length());
+    memcpy(message_p->get_data_p(), request_p->get_data_p(), request_p->get_length());
+    APPManager::get_processing_dispatcher_p()->post(new Job(this, Job::JOB_TYPE_REQUEST, message_p));
+    *response_pp = NULL;
 
-    LOG_GENERATE_TRACE(g_logger, "SPPConnector::handle_request exit result=%d", result);
-    return result;
+    LOG_GENERATE_TRACE(g_logger, "SPPConnector::handle_request exit");
+    return RESULT_CODE_PENDING;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// APPManager::NotificationHandler implementations
+///////////////////////////////////////////////////////////////////////////////
 
+ResultCode SPPConnector::send_notification(APPManager::Message **notification_pp)
+{
+    LOG_GENERATE_TRACE(g_logger, "SPPConnector::send_notification enter this=%p notification_pp=%p", this, notification_pp);
 
+    // the connection writes it out on the transport loop, we take ownership like it would
+    APPManager::get_transport_dispatcher_p()->post(new Job(this, Job::JOB_TYPE_NOTIFICATION, *notification_pp));
+    *notification_pp = NULL;
+
+    LOG_GENERATE_TRACE(g_logger, "SPPConnector::send_notification exit");
+    return RESULT_CODE_OK;
+}
+
+ResultCode SPPConnector::send_response(ResultCode result_code, APPManager::Message **response_pp)
+{
+    LOG_GENERATE_TRACE(g_logger, "SPPConnector::send_response enter this=%p result_code=%d response_pp=%p", this, result_code, response_pp);
+
+    APPManager::get_transport_dispatcher_p()->post(new Job(this, Job::JOB_TYPE_RESPONSE, *response_pp, result_code));
+    *response_pp = NULL;
+
+    LOG_GENERATE_TRACE(g_logger, "SPPConnector::send_response exit");
+    return RESULT_CODE_OK;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// SPPConnector::Job implementations
+///////////////////////////////////////////////////////////////////////////////
+
+SPPConnector::Job::Job(SPPConnector *connector_p, Type type, APPManager::Message *message_p, ResultCode result_code) :
+    APPDispatcher::Job(connector_p),
+    m_connector_p(connector_p),
+    m_type(type),
+    m_message_p(message_p),
+    m_result_code(result_code)
+{
+    LOG_GENERATE_TRACE(g_logger, "SPPConnector::Job::Job enter this=%p connector_p=%p type=%d message_p=%p result_code=%d", this, connector_p, type, message_p, result_code);
+    LOG_GENERATE_TRACE(g_logger, "SPPConnector::Job::Job exit");
+}
+
+SPPConnector::Job::~Job()
+{
+    LOG_GENERATE_TRACE(g_logger, "SPPConnector::Job::~Job enter this=%p", this);
+
+    // still set if it was cancelled or nobody took it
+    delete m_message_p;
+
+    LOG_GENERATE_TRACE(g_logger, "SPPConnector::Job::~Job exit");
+}
+
+void SPPConnector::Job::run()
+{
+    LOG_GENERATE_TRACE(g_logger, "SPPConnector::Job::run enter this=%p type=%d", this, m_type);
+
+    SPPConnector *connector_p = m_connector_p;
+    switch (m_type)
+    {
+        case JOB_TYPE_CREATE:
+        {
+            connector_p->m_processor_p = new AUDIOProcessor(AUDIOCaptureManager::get_instance()->get_loop_p());
+            connector_p->m_control_p = new Control(connector_p->m_processor_p, connector_p);
+            break;
+        }
+        case JOB_TYPE_DESTROY:
+        {
+            delete connector_p->m_control_p;
+            connector_p->m_control_p = NULL;
+            delete connector_p->m_processor_p;
+            connector_p->m_processor_p = NULL;
+            break;
+        }
+        case JOB_TYPE_REQUEST:
+        {
+            // pass thru the request to the control object
+            APPManager::Message *response_p = NULL;
+            ResultCode result_code = connector_p->m_control_p->handle_request(m_message_p, &response_p);
+            connector_p->send_response(result_code, &response_p);
+            break;
+        }
+        case JOB_TYPE_RESPONSE:
+        {
+            // the connection may close + take us with it, so nothing is touched after this
+            connector_p->m_handler_p->send_response(m_result_code, &m_message_p);
+            break;
+        }
+        case JOB_TYPE_NOTIFICATION:
+        {
+            connector_p->m_handler_p->send_notification(&m_message_p);
+            break;
+        }
+        default:
+        {
+            LOG_GENERATE_ERROR(g_logger, "unknown job type=%d", m_type);
+            break;
+        }
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "SPPConnector::Job::run exit");
+}
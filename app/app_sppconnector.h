@@ -3,6 +3,7 @@
 
 #include "common.h"
 #include "app_mgr.h"
+#include "app_dispatcher.h"
 
 ///////////////////////////////////////////////////////////////////////////////
 // macros
@@ -21,13 +22,41 @@ class AUDIOProcessor;
 // class definition
 ///////////////////////////////////////////////////////////////////////////////
 
-class SPPConnector : public APPManager::RequestHandler
+// lives on the transport loop, the processor + control it fronts live on the processing loop
+class SPPConnector : public APPManager::RequestHandler, public APPManager::NotificationHandler
 {
 
 ///////////////////////////////////////////////////////////////////////////////
 // type definitions
 ///////////////////////////////////////////////////////////////////////////////
 
+private:
+
+    // everything crossing between the loops for this connector
+    class Job : public APPDispatcher::Job
+    {
+    public:
+        typedef enum
+        {
+            // run on the processing loop
+            JOB_TYPE_CREATE,
+            JOB_TYPE_DESTROY,
+            JOB_TYPE_REQUEST,
+            // run on the transport loop
+            JOB_TYPE_RESPONSE,
+            JOB_TYPE_NOTIFICATION,
+        } Type;
+
+        Job(SPPConnector *connector_p, Type type, APPManager::Message *message_p = NULL, ResultCode result_code = RESULT_CODE_OK);
+        virtual ~Job();
+        void run();
+
+    private:
+        SPPConnector *m_connector_p;
+        Type m_type;
+        APPManager::Message *m_message_p;
+        ResultCode m_result_code;
+    };
 
 ///////////////////////////////////////////////////////////////////////////////
 // public function declarations
@@ -44,12 +73,22 @@ public:
 public:
     ResultCode handle_request(APPManager::Message *request_p, APPManager::Message **response_pp);
 
+///////////////////////////////////////////////////////////////////////////////
+// APPManager::NotificationHandler declarations
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+    // called by control on the processing loop
+    ResultCode send_notification(APPManager::Message **notification_pp);
+    ResultCode send_response(ResultCode result_code, APPManager::Message **response_pp);
 
 ///////////////////////////////////////////////////////////////////////////////
 // private variable declarations
 ///////////////////////////////////////////////////////////////////////////////
 
 private:
+    APPManager::NotificationHandler *m_handler_p;
+    // only touched on the processing loop
     AUDIOProcessor *m_processor_p;
     Control *m_control_p;
 
@@ -0,0 +1,383 @@
+#include "audio_alarmengine.h"
+#include "audio_capturemgr.h"
+#include "config.h"
+#include "log.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+#define ALARM_CONFIG_SECTION                "alarm-%d"
+#define ALARM_CHANNEL_CONFIG_ITEM           "channel"
+#define ALARM_TYPE_CONFIG_ITEM              "type"
+#define ALARM_COMPARISON_CONFIG_ITEM        "comparison"
+#define ALARM_THRESHOLD_CONFIG_ITEM         "threshold"
+#define ALARM_HYSTERESIS_CONFIG_ITEM        "hysteresis"
+#define ALARM_DURATION_CONFIG_ITEM          "duration"
+
+// in the units of each meter's main reading
+#define ALARM_LEVEL_HYSTERESIS_IN_DB        (1.0f)
+
+///////////////////////////////////////////////////////////////////////////////
+// type defintions
+///////////////////////////////////////////////////////////////////////////////
+
+typedef struct
+{
+    const char *name_p;
+    AUDIOProcessor::LevelType type;
+    float hysteresis;
+} LevelTypeName;
+
+///////////////////////////////////////////////////////////////////////////////
+// constants
+///////////////////////////////////////////////////////////////////////////////
+
+// only the meters with a single main reading that can run off the rule's one channel can have rules
+static const LevelTypeName c_level_type_names[] =
+{
+    { "digitalpeak", AUDIOProcessor::LEVEL_TYPE_DIGITALPEAK, ALARM_LEVEL_HYSTERESIS_IN_DB },
+    { "ppm", AUDIOProcessor::LEVEL_TYPE_PPM, ALARM_LEVEL_HYSTERESIS_IN_DB },
+    { "vu", AUDIOProcessor::LEVEL_TYPE_VU, ALARM_LEVEL_HYSTERESIS_IN_DB },
+    { "loudness", AUDIOProcessor::LEVEL_TYPE_LOUDNESS, ALARM_LEVEL_HYSTERESIS_IN_DB },
+    { "crest", AUDIOProcessor::LEVEL_TYPE_CREST, ALARM_LEVEL_HYSTERESIS_IN_DB },
+    { "distortion", AUDIOProcessor::LEVEL_TYPE_DISTORTION, ALARM_LEVEL_HYSTERESIS_IN_DB },
+    { "noisefloor", AUDIOProcessor::LEVEL_TYPE_NOISEFLOOR, ALARM_LEVEL_HYSTERESIS_IN_DB },
+    { "group", AUDIOProcessor::LEVEL_TYPE_GROUP, ALARM_LEVEL_HYSTERESIS_IN_DB },
+    { "histogram", AUDIOProcessor::LEVEL_TYPE_HISTOGRAM, ALARM_LEVEL_HYSTERESIS_IN_DB }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// module variables
+///////////////////////////////////////////////////////////////////////////////
+
+static LogInstance g_logger("audio.alarmengine");
+
+///////////////////////////////////////////////////////////////////////////////
+// private function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+static bool extract_value(const AUDIOProcessor::ResultData &data, float *value_p);
+static bool is_supported_type(AUDIOProcessor::LevelType type);
+
+///////////////////////////////////////////////////////////////////////////////
+// public function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+AUDIOAlarmEngine::AUDIOAlarmEngine(float tick_in_secs) :
+    m_tick_in_secs(tick_in_secs)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOAlarmEngine::AUDIOAlarmEngine enter this=%p tick_in_secs=%f", this, tick_in_secs);
+
+    fetch_configured_rules();
+    compile();
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOAlarmEngine::AUDIOAlarmEngine exit");
+}
+
+AUDIOAlarmEngine::~AUDIOAlarmEngine()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOAlarmEngine::~AUDIOAlarmEngine enter this=%p", this);
+    LOG_GENERATE_TRACE(g_logger, "AUDIOAlarmEngine::~AUDIOAlarmEngine exit");
+}
+
+ResultCode AUDIOAlarmEngine::set_rules(const std::vector<AUDIOProcessor::AlarmRule> &rules)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOAlarmEngine::set_rules enter this=%p count=%d", this, rules.size());
+
+    ResultCode result_code = RESULT_CODE_OK;
+
+    // the whole set is rejected rather than half applied
+    if ((m_configured_rules.size() + rules.size()) > ALARM_MAXIMUM_RULES)
+    {
+        LOG_GENERATE_ERROR(g_logger, "too many alarm rules count=%d", m_configured_rules.size() + rules.size());
+        result_code = RESULT_CODE_ERROR;
+    }
+    for (std::vector<AUDIOProcessor::AlarmRule>::const_iterator it = rules.begin();
+            (RESULT_CODE_OK == result_code) && (it != rules.end());
+            it++)
+    {
+        if (false == is_supported_type(it->type))
+        {
+            LOG_GENERATE_ERROR(g_logger, "alarm rule id=%d can't be metered with type=%d", it->id, it->type);
+            result_code = RESULT_CODE_ERROR;
+        }
+        else if (0 != (it->id & ALARM_CONFIGURED_ID_BASE))
+        {
+            LOG_GENERATE_ERROR(g_logger, "alarm rule id=%u is reserved for the configured rules", it->id);
+            result_code = RESULT_CODE_ERROR;
+        }
+    }
+
+    // replacing the rules starts them all from clear
+    if (RESULT_CODE_OK == result_code)
+    {
+        m_client_rules = rules;
+        compile();
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOAlarmEngine::set_rules exit result_code=%d", result_code);
+    return result_code;
+}
+
+void AUDIOAlarmEngine::evaluate(const size_t num_results, const AUDIOProcessor::ResultData results[], std::vector<AUDIOProcessor::AlarmData> &alarms)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOAlarmEngine::evaluate enter this=%p num_results=%d results=%p", this, num_results, results);
+
+    // the results come out of the alarm meters in channel order, so one walk down both lists does it
+    size_t result = 0;
+    for (std::vector<Predicate>::iterator it = m_predicates.begin();
+            it != m_predicates.end();
+            it++)
+    {
+        Predicate &predicate = *it;
+        while ((result < num_results) && (results[result].channel < predicate.channel))
+        {
+            result++;
+        }
+
+        // a channel watched by rules of different types has a result for each
+        size_t match = result;
+        while ((match < num_results) && (results[match].channel == predicate.channel) && (results[match].type != predicate.type))
+        {
+            match++;
+        }
+
+        float value = 0.0f;
+        bool present = (match < num_results) && (results[match].channel == predicate.channel);
+        if (true == present)
+        {
+            present = extract_value(results[match], &value);
+        }
+
+        // a meter that's gone away can't hold an alarm up
+        bool changed = false;
+        if (false == present)
+        {
+            predicate.ticks = 0;
+            changed = predicate.active;
+            predicate.active = false;
+        }
+        else if (false == predicate.active)
+        {
+            predicate.ticks = ((predicate.sign * value) > predicate.trigger) ? (predicate.ticks + 1) : 0;
+            if (predicate.ticks >= predicate.ticks_needed)
+            {
+                predicate.active = true;
+                changed = true;
+            }
+        }
+        else if ((predicate.sign * value) <= predicate.release)
+        {
+            predicate.ticks = 0;
+            predicate.active = false;
+            changed = true;
+        }
+
+        if (true == changed)
+        {
+            AUDIOProcessor::AlarmData alarm;
+            alarm.id = predicate.id;
+            alarm.channel = predicate.channel;
+            alarm.active = predicate.active;
+            alarm.value = value;
+            alarms.push_back(alarm);
+            LOG_GENERATE_DEBUG(g_logger, "alarm id=%d channel=%d active=%d value=%f", alarm.id, alarm.channel, alarm.active, alarm.value);
+        }
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOAlarmEngine::evaluate exit count=%d", alarms.size());
+}
+
+float AUDIOAlarmEngine::get_default_hysteresis(AUDIOProcessor::LevelType type)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOAlarmEngine::get_default_hysteresis enter type=%d", type);
+
+    float hysteresis = ALARM_LEVEL_HYSTERESIS_IN_DB;
+    for (size_t name = 0; name < (sizeof(c_level_type_names) / sizeof(c_level_type_names[0])); name++)
+    {
+        if (type == c_level_type_names[name].type)
+        {
+            hysteresis = c_level_type_names[name].hysteresis;
+            break;
+        }
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOAlarmEngine::get_default_hysteresis exit hysteresis=%f", hysteresis);
+    return hysteresis;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// private function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+void AUDIOAlarmEngine::fetch_configured_rules()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOAlarmEngine::fetch_configured_rules enter this=%p", this);
+
+    // sections are numbered from one, the first one missing ends the list
+    const Config *config_p = Config::get_instance_p();
+    for (int counter = 1; ALARM_MAXIMUM_RULES >= counter; counter++)
+    {
+        char section[128];
+        snprintf(section, sizeof(section), ALARM_CONFIG_SECTION, counter);
+        const char *type_p = NULL;
+        config_p->get_string_with_default(section, ALARM_TYPE_CONFIG_ITEM, NULL, &type_p);
+        if (NULL == type_p)
+        {
+            break;
+        }
+
+        AUDIOProcessor::AlarmRule rule;
+        memset(&rule, 0, sizeof(rule));
+        rule.id = ALARM_CONFIGURED_ID_BASE | counter;
+        rule.type = AUDIOProcessor::LEVEL_TYPE_NONE;
+        for (size_t name = 0; name < (sizeof(c_level_type_names) / sizeof(c_level_type_names[0])); name++)
+        {
+            if (0 == strcmp(type_p, c_level_type_names[name].name_p))
+            {
+                rule.type = c_level_type_names[name].type;
+                break;
+            }
+        }
+        const char *comparison_p = NULL;
+        config_p->get_string_with_default(section, ALARM_COMPARISON_CONFIG_ITEM, "above", &comparison_p);
+        rule.comparison = (0 == strcmp(comparison_p, "below")) ? AUDIOProcessor::ALARM_COMPARISON_BELOW : AUDIOProcessor::ALARM_COMPARISON_ABOVE;
+
+        float channel = 0.0f;
+        float duration = 0.0f;
+        config_p->get_float_with_default(section, ALARM_CHANNEL_CONFIG_ITEM, 0.0f, &channel);
+        config_p->get_float_with_default(section, ALARM_THRESHOLD_CONFIG_ITEM, 0.0f, &rule.threshold);
+        config_p->get_float_with_default(section, ALARM_HYSTERESIS_CONFIG_ITEM, get_default_hysteresis(rule.type), &rule.hysteresis);
+        config_p->get_float_with_default(section, ALARM_DURATION_CONFIG_ITEM, 0.0f, &duration);
+        rule.channel = (AUDIOChannel::Index)channel;
+        rule.durationInMs = (uint32_t)std::max(duration, 0.0f);
+
+        // with shards the rule is only watched by the shard that has the channel
+        if (false == AUDIOCaptureManager::get_instance()->owns_index(rule.channel))
+        {
+            LOG_GENERATE_DEBUG(g_logger, "leaving section=%s to the shard with channel=%d", section, rule.channel);
+            continue;
+        }
+
+        // a bad rule is skipped rather than stopping the rest
+        if (false == is_supported_type(rule.type))
+        {
+            LOG_GENERATE_ERROR(g_logger, "ignoring section=%s with type=%s", section, type_p);
+            continue;
+        }
+        m_configured_rules.push_back(rule);
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOAlarmEngine::fetch_configured_rules exit count=%d", m_configured_rules.size());
+}
+
+void AUDIOAlarmEngine::compile()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOAlarmEngine::compile enter this=%p", this);
+
+    m_predicates.clear();
+    for (int set = 0; set < 2; set++)
+    {
+        const std::vector<AUDIOProcessor::AlarmRule> &rules = (0 == set) ? m_configured_rules : m_client_rules;
+        for (std::vector<AUDIOProcessor::AlarmRule>::const_iterator it = rules.begin();
+                it != rules.end();
+                it++)
+        {
+            // below is above with the sign flipped, the release point sits the hysteresis back from the trigger
+            Predicate predicate;
+            predicate.id = it->id;
+            predicate.channel = it->channel;
+            predicate.type = it->type;
+            predicate.sign = (AUDIOProcessor::ALARM_COMPARISON_BELOW == it->comparison) ? -1.0f : 1.0f;
+            predicate.trigger = predicate.sign * it->threshold;
+            predicate.release = predicate.trigger - fabsf(it->hysteresis);
+            predicate.ticks_needed = std::max((uint32_t)ceilf((it->durationInMs / 1000.0f) / m_tick_in_secs), (uint32_t)1);
+            predicate.ticks = 0;
+            predicate.active = false;
+            m_predicates.push_back(predicate);
+        }
+    }
+    std::stable_sort(m_predicates.begin(), m_predicates.end(), compare_predicates);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOAlarmEngine::compile exit count=%d", m_predicates.size());
+}
+
+bool AUDIOAlarmEngine::compare_predicates(const Predicate &first, const Predicate &second)
+{
+    return first.channel < second.channel;
+}
+
+static bool extract_value(const AUDIOProcessor::ResultData &data, float *value_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "extract_value enter data=%p type=%d value_p=%p", &data, data.type, value_p);
+
+    bool present = true;
+    switch (data.type)
+    {
+        case AUDIOProcessor::LEVEL_TYPE_DIGITALPEAK:
+        case AUDIOProcessor::LEVEL_TYPE_PPM:
+            *value_p = data.values.peak.peakInDB;
+            break;
+
+        case AUDIOProcessor::LEVEL_TYPE_VU:
+            *value_p = data.values.vuInUnits;
+            break;
+
+        case AUDIOProcessor::LEVEL_TYPE_LOUDNESS:
+            *value_p = data.values.loudness.shorttermInLUFS;
+            break;
+
+        case AUDIOProcessor::LEVEL_TYPE_CREST:
+            *value_p = data.values.crest.crestInDB;
+            break;
+
+        case AUDIOProcessor::LEVEL_TYPE_DISTORTION:
+            // nothing to compare until the measurement has settled
+            *value_p = data.values.distortion.thdnInDB;
+            present = (0.0f != data.values.distortion.frequency);
+            break;
+
+        case AUDIOProcessor::LEVEL_TYPE_NOISEFLOOR:
+            *value_p = data.values.noisefloor.floorInDB;
+            break;
+
+        case AUDIOProcessor::LEVEL_TYPE_GROUP:
+            *value_p = data.values.group.peakInDB;
+            break;
+
+        case AUDIOProcessor::LEVEL_TYPE_HISTOGRAM:
+            *value_p = data.values.histogram.levelInDB;
+            break;
+
+        default:
+            present = false;
+            break;
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "extract_value exit present=%d", present);
+    return present;
+}
+
+static bool is_supported_type(AUDIOProcessor::LevelType type)
+{
+    LOG_GENERATE_TRACE(g_logger, "is_supported_type enter type=%d", type);
+
+    bool supported = false;
+    for (size_t name = 0; name < (sizeof(c_level_type_names) / sizeof(c_level_type_names[0])); name++)
+    {
+        if (type == c_level_type_names[name].type)
+        {
+            supported = true;
+            break;
+        }
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "is_supported_type exit supported=%d", supported);
+    return supported;
+}
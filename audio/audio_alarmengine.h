@@ -0,0 +1,100 @@
+#ifndef _AUDIO_ALARMENGINE_H_
+#define _AUDIO_ALARMENGINE_H_
+
+#include "common.h"
+#include "audio_channel.h"
+#include "audio_processor.h"
+
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+#define ALARM_MAXIMUM_RULES                 (64)
+// the configured rules are sent with this bit set so they can't clash with a client's ids
+#define ALARM_CONFIGURED_ID_BASE            (0x80000000)
+
+///////////////////////////////////////////////////////////////////////////////
+// forward declarations
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// class definition
+///////////////////////////////////////////////////////////////////////////////
+
+class AUDIOAlarmEngine
+{
+
+///////////////////////////////////////////////////////////////////////////////
+// type definitions
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+
+    // a rule folded down so above and below are the same test, kept sorted by channel
+    typedef struct
+    {
+        uint32_t id;
+        AUDIOChannel::Index channel;
+        AUDIOProcessor::LevelType type;
+        float sign;
+        float trigger;
+        float release;
+        uint32_t ticks_needed;
+        uint32_t ticks;
+        bool active;
+    } Predicate;
+
+///////////////////////////////////////////////////////////////////////////////
+// public function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+    AUDIOAlarmEngine(float tick_in_secs);
+    virtual ~AUDIOAlarmEngine();
+
+    ResultCode set_rules(const std::vector<AUDIOProcessor::AlarmRule> &rules);
+    void evaluate(const size_t num_results, const AUDIOProcessor::ResultData results[], std::vector<AUDIOProcessor::AlarmData> &alarms);
+    inline const std::vector<AUDIOProcessor::AlarmRule> &get_configured_rules() const;
+    inline const std::vector<AUDIOProcessor::AlarmRule> &get_client_rules() const;
+
+    static float get_default_hysteresis(AUDIOProcessor::LevelType type);
+
+///////////////////////////////////////////////////////////////////////////////
+// private function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+    void fetch_configured_rules();
+    void compile();
+    static bool compare_predicates(const Predicate &first, const Predicate &second);
+
+///////////////////////////////////////////////////////////////////////////////
+// private variable definitions
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+    float m_tick_in_secs;
+    std::vector<AUDIOProcessor::AlarmRule> m_configured_rules;
+    std::vector<AUDIOProcessor::AlarmRule> m_client_rules;
+    std::vector<Predicate> m_predicates;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// inline function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+inline const std::vector<AUDIOProcessor::AlarmRule> &AUDIOAlarmEngine::get_configured_rules() const
+{
+    return m_configured_rules;
+}
+
+inline const std::vector<AUDIOProcessor::AlarmRule> &AUDIOAlarmEngine::get_client_rules() const
+{
+    return m_client_rules;
+}
+
+#endif
+
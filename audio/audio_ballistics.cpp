@@ -0,0 +1,78 @@
+#include "audio_ballistics.h"
+#include "log.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// type defintions
+///////////////////////////////////////////////////////////////////////////////
+
+// the rise is how far short of the tone a burst of the given length leaves the meter,
+// the return is the drop in dB over the given time once the signal stops
+typedef struct
+{
+    float riseLevel;
+    float riseTimeInSecs;
+    float dropInDB;
+    float dropTimeInSecs;
+} StandardTimes;
+
+///////////////////////////////////////////////////////////////////////////////
+// constants
+///////////////////////////////////////////////////////////////////////////////
+
+// reference: IEC 60268-10 (1991) "integration time" + "return time" of the quasi-peak programme meters,
+// a 5ms burst reads -2dB (80%) on the 5ms meters -> 40% in 2.5ms, the 10ms meters take twice as long
+static const StandardTimes c_standard_times[BALLISTICS_STANDARD_COUNT] =
+{
+    // STANDARD_IEC_TYPE_I, IEC 60268-10 type I: 5ms integration, 20dB return in 1.7s
+    { 0.4f, 0.0025f, -20.0f, 1.7f },
+    // STANDARD_IEC_TYPE_IIA, IEC 60268-10 type IIa (the BBC meter): 10ms integration, 24dB return in 2.8s
+    { 0.4f, 0.005f, -24.0f, 2.8f },
+    // STANDARD_NORDIC, NRK N9 which IEC 60268-10 adopts as type I: 5ms integration, 20dB return in 1.7s
+    { 0.4f, 0.0025f, -20.0f, 1.7f },
+    // STANDARD_EBU, IEC 60268-10 type IIb (EBU Tech 3205): 10ms integration, 24dB return in 2.8s
+    { 0.4f, 0.005f, -24.0f, 2.8f },
+    // STANDARD_DIN, DIN 45406: 5ms integration, 20dB return in 1.5s
+    { 0.4f, 0.0025f, -20.0f, 1.5f },
+    // STANDARD_LEGACY, the type I integration with the type II return the PPM shipped with
+    { 0.4f, 0.0025f, -24.0f, 2.8f }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// module variables
+///////////////////////////////////////////////////////////////////////////////
+
+static LogInstance g_logger("audio.ballistics");
+
+///////////////////////////////////////////////////////////////////////////////
+// private function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// public function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+void AUDIOBallistics::calculate_coefficients(Standard standard, unsigned int sample_rate, Coefficients *coefficients_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOBallistics::calculate_coefficients enter standard=%d sample_rate=%d coefficients_p=%p", standard, sample_rate, coefficients_p);
+
+    ASSERT(true == is_valid_standard(standard));
+
+    const StandardTimes &times = c_standard_times[standard];
+    coefficients_p->rise = 1.0f - powf(times.riseLevel, 1.0f / ((float)sample_rate * times.riseTimeInSecs));
+    coefficients_p->fall = powf(powf(10.0f, times.dropInDB / 20.0f), 1.0f / ((float)sample_rate * times.dropTimeInSecs));
+    coefficients_p->fixedRise = AUDIOChannel::to_fixed(coefficients_p->rise);
+    coefficients_p->fixedFall = AUDIOChannel::to_fixed(coefficients_p->fall);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOBallistics::calculate_coefficients exit rise=%f fall=%f", coefficients_p->rise, coefficients_p->fall);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// private function implementations
+///////////////////////////////////////////////////////////////////////////////
+
@@ -0,0 +1,208 @@
+#ifndef _AUDIO_BALLISTICS_H_
+#define _AUDIO_BALLISTICS_H_
+
+#include "common.h"
+#include "audio_channel.h"
+
+#include <math.h>
+#include <algorithm>
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+#define BALLISTICS_STANDARD_COUNT      (6)
+
+///////////////////////////////////////////////////////////////////////////////
+// forward declarations
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// class definition
+///////////////////////////////////////////////////////////////////////////////
+
+class AUDIOBallistics
+{
+
+///////////////////////////////////////////////////////////////////////////////
+// type definitions
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+
+    typedef enum
+    {
+        STANDARD_IEC_TYPE_I = 0,
+        STANDARD_IEC_TYPE_IIA = 1,
+        STANDARD_NORDIC = 2,
+        STANDARD_EBU = 3,
+        STANDARD_DIN = 4,
+        // the integration + return times the PPMs have always used, what a client that names no standard gets
+        STANDARD_LEGACY = 5
+    } Standard;
+
+    // the per sample factors, worked out once for the channel's rate
+    typedef struct
+    {
+        float rise;
+        float fall;
+        AUDIOChannel::Fixed fixedRise;
+        AUDIOChannel::Fixed fixedFall;
+    } Coefficients;
+
+    // the attack policies, both sides of each step are cheap so the loop can select rather than branch
+    class InstantAttack
+    {
+    public:
+        static inline AUDIOChannel::Sample attack(AUDIOChannel::Sample peak, AUDIOChannel::Sample amplitude, const Coefficients &coefficients);
+        static inline AUDIOChannel::Fixed attack(AUDIOChannel::Fixed peak, AUDIOChannel::Fixed amplitude, const Coefficients &coefficients);
+    };
+
+    class IntegratingAttack
+    {
+    public:
+        static inline AUDIOChannel::Sample attack(AUDIOChannel::Sample peak, AUDIOChannel::Sample amplitude, const Coefficients &coefficients);
+        static inline AUDIOChannel::Fixed attack(AUDIOChannel::Fixed peak, AUDIOChannel::Fixed amplitude, const Coefficients &coefficients);
+    };
+
+    // the release policies, a digital peak holds until it's read
+    class NoRelease
+    {
+    public:
+        static inline AUDIOChannel::Sample release(AUDIOChannel::Sample peak, const Coefficients &coefficients);
+        static inline AUDIOChannel::Fixed release(AUDIOChannel::Fixed peak, const Coefficients &coefficients);
+    };
+
+    class ExponentialRelease
+    {
+    public:
+        static inline AUDIOChannel::Sample release(AUDIOChannel::Sample peak, const Coefficients &coefficients);
+        static inline AUDIOChannel::Fixed release(AUDIOChannel::Fixed peak, const Coefficients &coefficients);
+    };
+
+    // the hold policies, the highest point of the block only matters when a hold is shown
+    class NoHold
+    {
+    public:
+        template <typename Value> static inline Value track(Value highest, Value peak);
+    };
+
+    class TrackHold
+    {
+    public:
+        template <typename Value> static inline Value track(Value highest, Value peak);
+    };
+
+///////////////////////////////////////////////////////////////////////////////
+// public function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+
+    static void calculate_coefficients(Standard standard, unsigned int sample_rate, Coefficients *coefficients_p);
+    static inline bool is_valid_standard(Standard standard);
+
+    template <class Attack, class Release, class Hold, typename Value>
+    static inline Value process(Value peak, const size_t buffer_length, const Value *buffer_p, const Coefficients &coefficients, Value *highest_p);
+
+///////////////////////////////////////////////////////////////////////////////
+// private function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+
+    static inline AUDIOChannel::Sample magnitude(AUDIOChannel::Sample sample);
+    static inline AUDIOChannel::Fixed magnitude(AUDIOChannel::Fixed sample);
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// inline function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+inline bool AUDIOBallistics::is_valid_standard(Standard standard)
+{
+    return ((int)standard >= 0) && ((int)standard < BALLISTICS_STANDARD_COUNT);
+}
+
+template <class Attack, class Release, class Hold, typename Value>
+inline Value AUDIOBallistics::process(Value peak, const size_t buffer_length, const Value *buffer_p, const Coefficients &coefficients, Value *highest_p)
+{
+    // each policy combination gets its own loop with nothing left to decide per sample
+    Value highest = *highest_p;
+    for (size_t counter = 0; counter < buffer_length; counter++)
+    {
+        const Value amplitude = magnitude(buffer_p[counter]);
+        const Value risen = Attack::attack(peak, amplitude, coefficients);
+        const Value fallen = Release::release(peak, coefficients);
+        peak = (amplitude > peak) ? risen : fallen;
+        highest = Hold::track(highest, peak);
+    }
+    *highest_p = highest;
+    return peak;
+}
+
+inline AUDIOChannel::Sample AUDIOBallistics::magnitude(AUDIOChannel::Sample sample)
+{
+    return fabsf(sample);
+}
+
+inline AUDIOChannel::Fixed AUDIOBallistics::magnitude(AUDIOChannel::Fixed sample)
+{
+    return AUDIOChannel::fixed_abs(sample);
+}
+
+inline AUDIOChannel::Sample AUDIOBallistics::InstantAttack::attack(AUDIOChannel::Sample peak, AUDIOChannel::Sample amplitude, const Coefficients &coefficients)
+{
+    return amplitude;
+}
+
+inline AUDIOChannel::Fixed AUDIOBallistics::InstantAttack::attack(AUDIOChannel::Fixed peak, AUDIOChannel::Fixed amplitude, const Coefficients &coefficients)
+{
+    return amplitude;
+}
+
+inline AUDIOChannel::Sample AUDIOBallistics::IntegratingAttack::attack(AUDIOChannel::Sample peak, AUDIOChannel::Sample amplitude, const Coefficients &coefficients)
+{
+    return peak + coefficients.rise * (amplitude - peak);
+}
+
+inline AUDIOChannel::Fixed AUDIOBallistics::IntegratingAttack::attack(AUDIOChannel::Fixed peak, AUDIOChannel::Fixed amplitude, const Coefficients &coefficients)
+{
+    return peak + AUDIOChannel::fixed_multiply(coefficients.fixedRise, amplitude - peak);
+}
+
+inline AUDIOChannel::Sample AUDIOBallistics::NoRelease::release(AUDIOChannel::Sample peak, const Coefficients &coefficients)
+{
+    return peak;
+}
+
+inline AUDIOChannel::Fixed AUDIOBallistics::NoRelease::release(AUDIOChannel::Fixed peak, const Coefficients &coefficients)
+{
+    return peak;
+}
+
+inline AUDIOChannel::Sample AUDIOBallistics::ExponentialRelease::release(AUDIOChannel::Sample peak, const Coefficients &coefficients)
+{
+    return peak * coefficients.fall;
+}
+
+inline AUDIOChannel::Fixed AUDIOBallistics::ExponentialRelease::release(AUDIOChannel::Fixed peak, const Coefficients &coefficients)
+{
+    return AUDIOChannel::fixed_multiply(peak, coefficients.fixedFall);
+}
+
+template <typename Value>
+inline Value AUDIOBallistics::NoHold::track(Value highest, Value peak)
+{
+    return highest;
+}
+
+template <typename Value>
+inline Value AUDIOBallistics::TrackHold::track(Value highest, Value peak)
+{
+    return std::max(highest, peak);
+}
+
+#endif
+
@@ -0,0 +1,242 @@
+
+#include "audio_biquad.h"
+#include "log.h"
+
+#include <math.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+// reference: ITU-R BS.1770-4 K-weighting, re-derived for arbitrary sample rates
+#define KWEIGHTING_SHELF_FREQUENCY      (1681.974450955533)
+#define KWEIGHTING_SHELF_GAIN_IN_DB     (3.999843853973347)
+#define KWEIGHTING_SHELF_Q              (0.7071752369554196)
+#define KWEIGHTING_HIGHPASS_FREQUENCY   (38.13547087602444)
+#define KWEIGHTING_HIGHPASS_Q           (0.5003270373238773)
+
+///////////////////////////////////////////////////////////////////////////////
+// type defintions
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// constants
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// module variables
+///////////////////////////////////////////////////////////////////////////////
+
+static LogInstance g_logger("audio.biquad");
+
+///////////////////////////////////////////////////////////////////////////////
+// private function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+static void design_common(unsigned int sample_rate, double frequency, double q, double *cos_w0_p, double *alpha_p, AUDIOBiquad::PreciseCoefficients *coefficients_p);
+
+
+///////////////////////////////////////////////////////////////////////////////
+// public function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+AUDIOBiquad::AUDIOBiquad() :
+    m_z1(0.0f),
+    m_z2(0.0f)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOBiquad::AUDIOBiquad enter this=%p", this);
+
+    // start out as a pass-thru filter
+    m_coefficients.b0 = 1.0f;
+    m_coefficients.b1 = 0.0f;
+    m_coefficients.b2 = 0.0f;
+    m_coefficients.a1 = 0.0f;
+    m_coefficients.a2 = 0.0f;
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOBiquad::AUDIOBiquad exit");
+}
+
+AUDIOBiquad::~AUDIOBiquad()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOBiquad::~AUDIOBiquad enter this=%p", this);
+    LOG_GENERATE_TRACE(g_logger, "AUDIOBiquad::~AUDIOBiquad exit");
+}
+
+void AUDIOBiquad::set_coefficients(const Coefficients &coefficients)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOBiquad::set_coefficients enter this=%p b0=%f b1=%f b2=%f a1=%f a2=%f", this, coefficients.b0, coefficients.b1, coefficients.b2, coefficients.a1, coefficients.a2);
+
+    m_coefficients = coefficients;
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOBiquad::set_coefficients exit");
+}
+
+void AUDIOBiquad::reset()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOBiquad::reset enter this=%p", this);
+
+    // clear the filter history
+    m_z1 = 0.0f;
+    m_z2 = 0.0f;
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOBiquad::reset exit");
+}
+
+AUDIOBiquad::Coefficients AUDIOBiquad::create_kweighting_shelf(unsigned int sample_rate)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOBiquad::create_kweighting_shelf enter sample_rate=%d", sample_rate);
+
+    // do the design in double precision, the filter itself runs in float
+    const double k = tan(M_PI * KWEIGHTING_SHELF_FREQUENCY / (double)sample_rate);
+    const double vh = pow(10.0, KWEIGHTING_SHELF_GAIN_IN_DB / 20.0);
+    const double vb = pow(vh, 0.4996667741545416);
+    const double a0 = 1.0 + (k / KWEIGHTING_SHELF_Q) + (k * k);
+
+    Coefficients coefficients;
+    coefficients.b0 = (float)((vh + (vb * k / KWEIGHTING_SHELF_Q) + (k * k)) / a0);
+    coefficients.b1 = (float)((2.0 * ((k * k) - vh)) / a0);
+    coefficients.b2 = (float)((vh - (vb * k / KWEIGHTING_SHELF_Q) + (k * k)) / a0);
+    coefficients.a1 = (float)((2.0 * ((k * k) - 1.0)) / a0);
+    coefficients.a2 = (float)((1.0 - (k / KWEIGHTING_SHELF_Q) + (k * k)) / a0);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOBiquad::create_kweighting_shelf exit");
+    return coefficients;
+}
+
+AUDIOBiquad::Coefficients AUDIOBiquad::create_kweighting_highpass(unsigned int sample_rate)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOBiquad::create_kweighting_highpass enter sample_rate=%d", sample_rate);
+
+    const double k = tan(M_PI * KWEIGHTING_HIGHPASS_FREQUENCY / (double)sample_rate);
+    const double a0 = 1.0 + (k / KWEIGHTING_HIGHPASS_Q) + (k * k);
+
+    Coefficients coefficients;
+    coefficients.b0 = 1.0f;
+    coefficients.b1 = -2.0f;
+    coefficients.b2 = 1.0f;
+    coefficients.a1 = (float)((2.0 * ((k * k) - 1.0)) / a0);
+    coefficients.a2 = (float)((1.0 - (k / KWEIGHTING_HIGHPASS_Q) + (k * k)) / a0);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOBiquad::create_kweighting_highpass exit");
+    return coefficients;
+}
+
+AUDIOBiquad::PreciseCoefficients AUDIOBiquad::create_highpass(unsigned int sample_rate, double frequency, double q)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOBiquad::create_highpass enter sample_rate=%d frequency=%f q=%f", sample_rate, frequency, q);
+
+    PreciseCoefficients coefficients;
+    double cos_w0 = 0.0;
+    double alpha = 0.0;
+    design_common(sample_rate, frequency, q, &cos_w0, &alpha, &coefficients);
+    const double a0 = 1.0 + alpha;
+    coefficients.b0 = ((1.0 + cos_w0) / 2.0) / a0;
+    coefficients.b1 = -(1.0 + cos_w0) / a0;
+    coefficients.b2 = coefficients.b0;
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOBiquad::create_highpass exit");
+    return coefficients;
+}
+
+AUDIOBiquad::PreciseCoefficients AUDIOBiquad::create_lowpass(unsigned int sample_rate, double frequency, double q)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOBiquad::create_lowpass enter sample_rate=%d frequency=%f q=%f", sample_rate, frequency, q);
+
+    PreciseCoefficients coefficients;
+    double cos_w0 = 0.0;
+    double alpha = 0.0;
+    design_common(sample_rate, frequency, q, &cos_w0, &alpha, &coefficients);
+    const double a0 = 1.0 + alpha;
+    coefficients.b0 = ((1.0 - cos_w0) / 2.0) / a0;
+    coefficients.b1 = (1.0 - cos_w0) / a0;
+    coefficients.b2 = coefficients.b0;
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOBiquad::create_lowpass exit");
+    return coefficients;
+}
+
+AUDIOBiquad::PreciseCoefficients AUDIOBiquad::create_notch(unsigned int sample_rate, double frequency, double q)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOBiquad::create_notch enter sample_rate=%d frequency=%f q=%f", sample_rate, frequency, q);
+
+    PreciseCoefficients coefficients;
+    double cos_w0 = 0.0;
+    double alpha = 0.0;
+    design_common(sample_rate, frequency, q, &cos_w0, &alpha, &coefficients);
+    const double a0 = 1.0 + alpha;
+    coefficients.b0 = 1.0 / a0;
+    coefficients.b1 = (-2.0 * cos_w0) / a0;
+    coefficients.b2 = coefficients.b0;
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOBiquad::create_notch exit");
+    return coefficients;
+}
+
+AUDIOBiquad::Coefficients AUDIOBiquad::to_coefficients(const PreciseCoefficients &precise)
+{
+    Coefficients coefficients;
+    coefficients.b0 = (float)precise.b0;
+    coefficients.b1 = (float)precise.b1;
+    coefficients.b2 = (float)precise.b2;
+    coefficients.a1 = (float)precise.a1;
+    coefficients.a2 = (float)precise.a2;
+    return coefficients;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// AUDIOBiquad::Precise implementation
+///////////////////////////////////////////////////////////////////////////////
+
+AUDIOBiquad::Precise::Precise() :
+    m_z1(0.0),
+    m_z2(0.0)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOBiquad::Precise::Precise enter this=%p", this);
+
+    // start out as a pass-thru filter
+    m_coefficients.b0 = 1.0;
+    m_coefficients.b1 = 0.0;
+    m_coefficients.b2 = 0.0;
+    m_coefficients.a1 = 0.0;
+    m_coefficients.a2 = 0.0;
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOBiquad::Precise::Precise exit");
+}
+
+void AUDIOBiquad::Precise::set_coefficients(const PreciseCoefficients &coefficients)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOBiquad::Precise::set_coefficients enter this=%p b0=%f b1=%f b2=%f a1=%f a2=%f", this, coefficients.b0, coefficients.b1, coefficients.b2, coefficients.a1, coefficients.a2);
+
+    m_coefficients = coefficients;
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOBiquad::Precise::set_coefficients exit");
+}
+
+void AUDIOBiquad::Precise::reset()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOBiquad::Precise::reset enter this=%p", this);
+
+    // clear the filter history
+    m_z1 = 0.0;
+    m_z2 = 0.0;
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOBiquad::Precise::reset exit");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// private function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+void design_common(unsigned int sample_rate, double frequency, double q, double *cos_w0_p, double *alpha_p, AUDIOBiquad::PreciseCoefficients *coefficients_p)
+{
+    // reference: RBJ audio EQ cookbook, the poles are shared and only the zeros differ per type
+    const double w0 = (2.0 * M_PI * frequency) / sample_rate;
+    *cos_w0_p = cos(w0);
+    *alpha_p = sin(w0) / (2.0 * q);
+    const double a0 = 1.0 + *alpha_p;
+    coefficients_p->a1 = (-2.0 * *cos_w0_p) / a0;
+    coefficients_p->a2 = (1.0 - *alpha_p) / a0;
+}
+
@@ -0,0 +1,125 @@
+#ifndef _AUDIO_BIQUAD_H_
+#define _AUDIO_BIQUAD_H_
+
+#include "common.h"
+#include "audio_channel.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// forward declarations
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// class definition
+///////////////////////////////////////////////////////////////////////////////
+
+class AUDIOBiquad
+{
+
+///////////////////////////////////////////////////////////////////////////////
+// type definitions
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+
+    // normalized coefficients (a0 == 1)
+    typedef struct
+    {
+        float b0;
+        float b1;
+        float b2;
+        float a1;
+        float a2;
+    } Coefficients;
+
+    // the same in double, for filters whose float rounding would set a measurement floor
+    typedef struct
+    {
+        double b0;
+        double b1;
+        double b2;
+        double a1;
+        double a2;
+    } PreciseCoefficients;
+
+    // runs the double coefficients with double history
+    class Precise
+    {
+    public:
+        Precise();
+
+        // the history is kept so a retuned filter carries on rather than restarting
+        void set_coefficients(const PreciseCoefficients &coefficients);
+        void reset();
+
+        inline double process(double input);
+
+    private:
+        PreciseCoefficients m_coefficients;
+        double m_z1;
+        double m_z2;
+    };
+
+///////////////////////////////////////////////////////////////////////////////
+// public function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+
+    AUDIOBiquad();
+    virtual ~AUDIOBiquad();
+
+    void set_coefficients(const Coefficients &coefficients);
+    void reset();
+
+    inline AUDIOChannel::Sample process(AUDIOChannel::Sample input);
+
+    static Coefficients create_kweighting_shelf(unsigned int sample_rate);
+    static Coefficients create_kweighting_highpass(unsigned int sample_rate);
+
+    // second order sections from the RBJ audio EQ cookbook, designed in double
+    static PreciseCoefficients create_highpass(unsigned int sample_rate, double frequency, double q);
+    static PreciseCoefficients create_lowpass(unsigned int sample_rate, double frequency, double q);
+    static PreciseCoefficients create_notch(unsigned int sample_rate, double frequency, double q);
+    static Coefficients to_coefficients(const PreciseCoefficients &precise);
+
+///////////////////////////////////////////////////////////////////////////////
+// private variable definitions
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+    Coefficients m_coefficients;
+    float m_z1;
+    float m_z2;
+
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// inline function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+inline AUDIOChannel::Sample AUDIOBiquad::process(AUDIOChannel::Sample input)
+{
+    // transposed direct form II
+    float output = (m_coefficients.b0 * input) + m_z1;
+    m_z1 = (m_coefficients.b1 * input) - (m_coefficients.a1 * output) + m_z2;
+    m_z2 = (m_coefficients.b2 * input) - (m_coefficients.a2 * output);
+    return output;
+}
+
+inline double AUDIOBiquad::Precise::process(double input)
+{
+    // transposed direct form II
+    double output = (m_coefficients.b0 * input) + m_z1;
+    m_z1 = (m_coefficients.b1 * input) - (m_coefficients.a1 * output) + m_z2;
+    m_z2 = (m_coefficients.b2 * input) - (m_coefficients.a2 * output);
+    return output;
+}
+
+#endif
+
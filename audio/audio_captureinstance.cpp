@@ -13,6 +13,7 @@
 
 #define DEFAULT_FULL_SCALE_VOLTAGE      (3.3f)
 #define FULLSCALE_VOLTAGE_CONFIG_ITEM   "fullscale-voltage"
+#define ROLE_CONFIG_ITEM                "role"
 
 ///////////////////////////////////////////////////////////////////////////////
 // type defintions
@@ -47,7 +48,8 @@ AUDIOCaptureInstance::AUDIOCaptureInstance(AUDIOCaptureManager *manager_p, const
     m_handle_p(handle_p),
     m_formatter_p(AUDIOFormatterFactory::create_audio_formatter_p(format)),
     m_channel_count(channel_count),
-    m_abort(false)
+    m_abort(false),
+    m_inline_epoch(0)
 {
     LOG_GENERATE_TRACE(g_logger, "AUDIOCaptureInstance::AUDIOCaptureInstance enter this=%p manager_p=%p device=%s channel_count=%d format=%d rate=%d handle_p=%p", this, device, channel_count, format, rate, handle_p);
 
@@ -69,7 +71,23 @@ AUDIOCaptureInstance::AUDIOCaptureInstance(AUDIOCaptureManager *manager_p, const
         LOG_GENERATE_INFO(g_logger, "using peak voltage=%fV for channel=%d", voltage, index);
 
         // create the channel object
-        AUDIOChannel *channel_p = new AUDIOChannel(index, rate, voltage);
+        AUDIOChannel *channel_p = new AUDIOChannel(index, rate, voltage, true, manager_p->get_loop_p());
+        // the over detector needs to know where this format clips
+        channel_p->set_fullscale_level(m_formatter_p->fullscale_level());
+        // where it sits on the bus, if anyone told us
+        const char *role_p = NULL;
+        if (RESULT_CODE_OK == Config::get_instance_p()->get_string(channel_section, ROLE_CONFIG_ITEM, &role_p))
+        {
+            AUDIOChannel::Role role = AUDIOChannel::ROLE_UNKNOWN;
+            if (RESULT_CODE_OK == AUDIOChannel::find_role(role_p, &role))
+            {
+                channel_p->set_role(role);
+            }
+            else
+            {
+                LOG_GENERATE_WARN(g_logger, "ignoring unknown role=%s for channel=%d", role_p, index);
+            }
+        }
         // store it in our list
         m_channels[counter] = channel_p;
         // register it with the manager
@@ -132,14 +150,21 @@ void *AUDIOCaptureInstance::thread_handler(void *arg)
     const size_t channel_count = instance_p->m_channel_count;
 
     // calculate the number of samples in 50ms of samples 
-    const unsigned int num_samples = CALC_NUM_SAMPLES_FOR_MILLIS(50, instance_p->m_rate);
+    const unsigned int num_samples = CALC_NUM_SAMPLES_FOR_MILLIS(AUDIO_CHANNEL_BLOCK_TIME_IN_MS, instance_p->m_rate);
 
     // allocate a buffer to hold raw audio data
     const snd_pcm_uframes_t buffer_length = num_samples * channel_count * instance_p->m_formatter_p->sample_sizeof();
     uint8_t *raw_buffer_p = (uint8_t *)malloc(buffer_length);
 
+#ifdef AUDIO_FIXED_POINT
+    // allocate buffer to hold the Q31 data
+    AUDIOChannel::Fixed *channel_buffer_p = (AUDIOChannel::Fixed *)malloc(num_samples * sizeof(AUDIOChannel::Fixed));
+    // the inline meters that can't take Q31 get a float copy
+    AUDIOChannel::Sample *sample_buffer_p = (AUDIOChannel::Sample *)malloc(num_samples * sizeof(AUDIOChannel::Sample));
+#else
     // allocate buffer to hold the normalized data
     AUDIOChannel::Sample *channel_buffer_p = (AUDIOChannel::Sample *)malloc(num_samples * sizeof(AUDIOChannel::Sample));
+#endif
 
     // tell the audio device we want some data now please
     int rc = snd_pcm_prepare(instance_p->m_handle_p);
@@ -154,6 +179,9 @@ void *AUDIOCaptureInstance::thread_handler(void *arg)
     // debug counter to see how many samples we've captured
     int samples = 0;
 
+    // every channel on the card shares one sample position
+    uint64_t position = 0;
+
     // loop until signalled
     while (false == instance_p->m_abort)
     {
@@ -187,18 +215,37 @@ void *AUDIOCaptureInstance::thread_handler(void *arg)
         for (int counter = 0; counter < channel_count; counter++)
         {
             // let the formatter de-interlace convert the samples for us
+#ifdef AUDIO_FIXED_POINT
+            instance_p->m_formatter_p->format_fixed_samples(raw_buffer_p, counter, channel_buffer_p, num_samples);
+#else
             instance_p->m_formatter_p->format_samples(raw_buffer_p, counter, channel_buffer_p, num_samples);
+#endif
 
             // now feed the samples to our consumer e.g. the channel
             AUDIOChannel *channel_p = instance_p->m_channels[counter];
+
+            // the epoch goes odd before the handler is looked at, so once it's even again the loop knows we're clear of it
+            __atomic_fetch_add(&instance_p->m_inline_epoch, 1, __ATOMIC_SEQ_CST);
+            AUDIOCaptureManager::InlineHandler *inline_handler_p = __atomic_load_n(&AUDIOCaptureManager::get_instance()->m_inline_handler_p, __ATOMIC_SEQ_CST);
+            if (NULL != inline_handler_p)
+            {
+#ifdef AUDIO_FIXED_POINT
+                inline_handler_p->handle_inline_samples(channel_p, position, num_samples, sample_buffer_p, channel_buffer_p);
+#else
+                inline_handler_p->handle_inline_samples(channel_p, position, num_samples, channel_buffer_p, NULL);
+#endif
+            }
+            __atomic_fetch_add(&instance_p->m_inline_epoch, 1, __ATOMIC_RELEASE);
+
             // write the data to the pipe
-            rc = write(channel_p->get_write_fd(), channel_buffer_p, num_samples * sizeof(AUDIOChannel::Sample));
+            rc = write(channel_p->get_write_fd(), channel_buffer_p, num_samples * sizeof(*channel_buffer_p));
             if (rc < 0)
             {
                 LOG_GENERATE_ERROR(g_logger, "write returned error=%d", rc)
                 goto error;
             }
         }
+        position += num_samples;
     }
 
 error:
@@ -207,6 +254,9 @@ error:
 
     // free the channel buffer
     free(channel_buffer_p);
+#ifdef AUDIO_FIXED_POINT
+    free(sample_buffer_p);
+#endif
 
     LOG_GENERATE_TRACE(g_logger, "AUDIOCaptureInstance::thread_handler exit");
 
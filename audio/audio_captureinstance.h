@@ -48,6 +48,8 @@ public:
     AUDIOCaptureInstance(AUDIOCaptureManager *manager_p, const char* device, size_t channel_count, snd_pcm_format_t format, unsigned int rate, snd_pcm_t *handle_p);
     virtual ~AUDIOCaptureInstance();
 
+    inline uint32_t get_inline_epoch() const;
+
 ///////////////////////////////////////////////////////////////////////////////
 // inner class declarations
 ///////////////////////////////////////////////////////////////////////////////
@@ -74,6 +76,18 @@ private:
     unsigned int m_rate;
     size_t m_channel_count;
     bool m_abort;
+    // odd while the capture thread is inside the inline handler
+    uint32_t m_inline_epoch;
 
 };
+
+///////////////////////////////////////////////////////////////////////////////
+// inline function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+inline uint32_t AUDIOCaptureInstance::get_inline_epoch() const
+{
+    return __atomic_load_n(&m_inline_epoch, __ATOMIC_SEQ_CST);
+}
+
 #endif
@@ -3,7 +3,12 @@
 #include "audio_capturemgr.h"
 #include "audio_captureinstance.h"
 #include "audio_channel.h"
+#include "audio_faultdetector.h"
 #include "audio_formatter.h"
+#include "audio_graph.h"
+#include "audio_overdetector.h"
+#include "audio_virtualchannel.h"
+#include "config.h"
 #include "log.h"
 
 #include <ev.h>
@@ -14,6 +19,8 @@
 // macros
 ///////////////////////////////////////////////////////////////////////////////
 
+#define VIRTUAL_CHANNEL_CONFIG_SECTION      "virtual-channel-%d"
+#define VIRTUAL_CHANNEL_SOURCES_CONFIG_ITEM "sources"
 
 ///////////////////////////////////////////////////////////////////////////////
 // type defintions
@@ -43,13 +50,27 @@ AUDIOCaptureManager *AUDIOCaptureManager::g_instance_p = NULL;
 // public function implementations
 ///////////////////////////////////////////////////////////////////////////////
 
+AUDIOCaptureManager *AUDIOCaptureManager::create_instance(struct ev_loop *loop_p, unsigned int shard, unsigned int shard_count)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOCaptureManager::create_instance enter loop_p=%p shard=%d shard_count=%d", loop_p, shard, shard_count);
+
+    // the channels + everything metering them run on this loop, so it has to be picked before any of them exist
+    ASSERT(NULL == g_instance_p);
+    ASSERT(shard < shard_count);
+    g_instance_p = new AUDIOCaptureManager(loop_p, shard, shard_count);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOCaptureManager::create_instance exit g_instance=%p", g_instance_p);
+
+    return g_instance_p;
+}
+
 AUDIOCaptureManager *AUDIOCaptureManager::get_instance()
 {
     LOG_GENERATE_TRACE(g_logger, "AUDIOCaptureManager::get_instance enter");
 
     if (NULL == g_instance_p)
     {
-        g_instance_p = new AUDIOCaptureManager();
+        g_instance_p = new AUDIOCaptureManager(ev_default_loop(0), 0, 1);
     }
 
     LOG_GENERATE_TRACE(g_logger, "AUDIOCaptureManager::get_instance exit g_instance=%p", g_instance_p);
@@ -61,6 +82,19 @@ AUDIOCaptureManager::~AUDIOCaptureManager()
 {
     LOG_GENERATE_TRACE(g_logger, "AUDIOCaptureManager::~AUDIOCaptureManager enter this=%p", this);
 
+    remove_handler(m_over_detector_p);
+    delete m_over_detector_p;
+    remove_handler(m_fault_detector_p);
+    delete m_fault_detector_p;
+
+    // the mixers go first, then the virtual channels they feed
+    delete m_graph_p;
+    for (std::list<AUDIOVirtualChannel *>::iterator it = m_virtual_channels.begin();
+            it != m_virtual_channels.end();
+            it++)
+    {
+        delete *it;
+    }
     for (std::list<AUDIOCaptureInstance *>::iterator it = m_instances.begin();
             it != m_instances.end();
             it++)
@@ -90,6 +124,70 @@ void AUDIOCaptureManager::remove_handler(Handler *handler_p)
     LOG_GENERATE_TRACE(g_logger, "AUDIOCaptureManager::remove_handler exit");
 }
 
+void AUDIOCaptureManager::set_inline_handler(InlineHandler *handler_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOCaptureManager::set_inline_handler enter this=%p handler_p=%p", this, handler_p);
+
+    // the capture threads pick the new one up on their next block, the old one is left alone once we return
+    __atomic_store_n(&m_inline_handler_p, handler_p, __ATOMIC_SEQ_CST);
+    synchronize_inline();
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOCaptureManager::set_inline_handler exit");
+}
+
+void AUDIOCaptureManager::read_inline_epochs(std::vector<uint32_t> &epochs) const
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOCaptureManager::read_inline_epochs enter this=%p", this);
+
+    // anything published before this is all a thread can see once its epoch moves on, the epochs are read in order with it
+    epochs.clear();
+    for (std::list<AUDIOCaptureInstance *>::const_iterator it = m_instances.begin();
+            it != m_instances.end();
+            it++)
+    {
+        epochs.push_back((*it)->get_inline_epoch());
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOCaptureManager::read_inline_epochs exit count=%d", epochs.size());
+}
+
+bool AUDIOCaptureManager::has_inline_grace_passed(const std::vector<uint32_t> &epochs) const
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOCaptureManager::has_inline_grace_passed enter this=%p count=%d", this, epochs.size());
+
+    // an even epoch was outside the handler, an odd one only has to have left since
+    bool passed = true;
+    std::vector<uint32_t>::const_iterator epoch_it = epochs.begin();
+    for (std::list<AUDIOCaptureInstance *>::const_iterator it = m_instances.begin();
+            (it != m_instances.end()) && (epoch_it != epochs.end());
+            it++, epoch_it++)
+    {
+        if ((0 != (*epoch_it & 1)) && (*epoch_it == (*it)->get_inline_epoch()))
+        {
+            passed = false;
+            break;
+        }
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOCaptureManager::has_inline_grace_passed exit passed=%d", passed);
+    return passed;
+}
+
+void AUDIOCaptureManager::synchronize_inline() const
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOCaptureManager::synchronize_inline enter this=%p", this);
+
+    // a block takes far less than a capture period to meter so this is never long
+    std::vector<uint32_t> epochs;
+    read_inline_epochs(epochs);
+    while (false == has_inline_grace_passed(epochs))
+    {
+        usleep(INLINE_GRACE_POLL_IN_US);
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOCaptureManager::synchronize_inline exit");
+}
+
 AUDIOChannel *AUDIOCaptureManager::find_channel(const AUDIOChannel::Index index)
 {
     LOG_GENERATE_TRACE(g_logger, "AUDIOCaptureManager::find_channel enter this=%p index=%d", this, index);
@@ -106,6 +204,37 @@ AUDIOChannel *AUDIOCaptureManager::find_channel(const AUDIOChannel::Index index)
     return channel_p;
 }
 
+bool AUDIOCaptureManager::owns_index(const AUDIOChannel::Index index) const
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOCaptureManager::owns_index enter this=%p index=%d", this, index);
+
+    bool owned = (index > m_index_base) && (index <= (m_index_base + m_index_limit));
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOCaptureManager::owns_index exit owned=%d", owned);
+    return owned;
+}
+
+void AUDIOCaptureManager::build_graph()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOCaptureManager::build_graph enter this=%p", this);
+
+    // each virtual channel is a mixer over its sources + a sink that dispatches the mix, in the order they were numbered
+    AUDIOGraph::Description description;
+    for (std::list<AUDIOVirtualChannel *>::const_iterator it = m_virtual_channels.begin();
+            it != m_virtual_channels.end();
+            it++)
+    {
+        AUDIOGraph::MixerDescription mixer;
+        (*it)->describe_mixer(mixer);
+        description.mixers.push_back(mixer);
+        AUDIOGraph::SinkDescription sink = { *it, *it };
+        description.sinks.push_back(sink);
+    }
+    m_graph_p->build(description);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOCaptureManager::build_graph exit");
+}
+
 void AUDIOCaptureManager::add_channel(AUDIOChannel *channel_p)
 {
     LOG_GENERATE_TRACE(g_logger, "AUDIOCaptureManager::add_channel enter this=%p channel_p=%p", this, channel_p);
@@ -116,16 +245,39 @@ void AUDIOCaptureManager::add_channel(AUDIOChannel *channel_p)
 
 }
 
+ResultCode AUDIOCaptureManager::Handler::handle_fixed_samples(AUDIOChannel *channel_p, const size_t buffer_length, const AUDIOChannel::Fixed *fixed_p, AUDIOChannel::Sample *buffer_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOCaptureManager::Handler::handle_fixed_samples enter this=%p channel_p=%p buffer_length=%d fixed_p=%p buffer_p=%p", this, channel_p, buffer_length, fixed_p, buffer_p);
+    // handlers with no integer path just take the float copy
+    ResultCode result_code = handle_samples(channel_p, buffer_length, buffer_p);
+    LOG_GENERATE_TRACE(g_logger, "AUDIOCaptureManager::Handler::handle_fixed_samples exit result_code=%d", result_code);
+    return result_code;
+}
+
+bool AUDIOCaptureManager::Handler::needs_samples(const AUDIOChannel *channel_p) const
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOCaptureManager::Handler::needs_samples enter this=%p channel_p=%p", this, channel_p);
+    // handlers with no integer path always read the float copy
+    LOG_GENERATE_TRACE(g_logger, "AUDIOCaptureManager::Handler::needs_samples exit needs=1");
+    return true;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // private function implementations
 ///////////////////////////////////////////////////////////////////////////////
 
-AUDIOCaptureManager::AUDIOCaptureManager() :
+AUDIOCaptureManager::AUDIOCaptureManager(struct ev_loop *loop_p, unsigned int shard, unsigned int shard_count) :
     m_channel_count(0),
-    m_loop_p(ev_default_loop(0))
+    m_index_base(shard * CAPTURE_SHARD_CHANNEL_STRIDE),
+    m_index_limit((1 < shard_count) ? CAPTURE_SHARD_CHANNEL_STRIDE : (size_t)((AUDIOChannel::Index)-1)),
+    m_loop_p(loop_p),
+    m_inline_handler_p(NULL),
+    m_over_detector_p(NULL),
+    m_fault_detector_p(NULL),
+    m_graph_p(NULL)
 
 {
-    LOG_GENERATE_TRACE(g_logger, "AUDIOCaptureManager::AUDIOCaptureManager enter this=%p", this);
+    LOG_GENERATE_TRACE(g_logger, "AUDIOCaptureManager::AUDIOCaptureManager enter this=%p loop_p=%p shard=%d shard_count=%d", this, loop_p, shard, shard_count);
 
     // query the list of formats we support
     std::list<snd_pcm_format_t> format_list = AUDIOFormatterFactory::fetch_audio_format_list();
@@ -138,6 +290,12 @@ AUDIOCaptureManager::AUDIOCaptureManager() :
     {
         LOG_GENERATE_TRACE(g_logger, "found card=%d", card_index);
 
+        // the other shards have the rest of the cards
+        if (shard != ((unsigned int)card_index % shard_count))
+        {
+            continue;
+        }
+
         char card[3 + 10 + 1];
         sprintf(card, "hw:%d", card_index);
 
@@ -268,6 +426,18 @@ AUDIOCaptureManager::AUDIOCaptureManager() :
                 continue;
             }
 
+            // the front finds a channel's shard from its index, so a shard can't spill into the next block
+            if ((m_channel_count + channel_count) > m_index_limit)
+            {
+                LOG_GENERATE_ERROR(g_logger, "device=%s with channels=%d would take the shard past %d channels, ignoring", device, channel_count, m_index_limit);
+                // close the device
+                snd_pcm_close(device_handle_p);
+                // release the memory
+                snd_pcm_hw_params_free(hw_params_p);
+                // go to the next device
+                continue;
+            }
+
             // allocate the capture instance
             AUDIOCaptureInstance *instance_p = new AUDIOCaptureInstance(this, device, channel_count, format, rate, device_handle_p);
             // store it 
@@ -279,6 +449,18 @@ AUDIOCaptureManager::AUDIOCaptureManager() :
         snd_ctl_close(card_handle_p);
     }
 
+    // the derived channels are numbered after every captured one
+    create_virtual_channels();
+    m_graph_p = new AUDIOGraph();
+    build_graph();
+
+    // overs and faults are watched whether or not anyone is metering, handlers run newest first so
+    // these see each block before anything added later, the mixers see it once every handler has
+    m_over_detector_p = new AUDIOOverDetector();
+    add_handler(m_over_detector_p);
+    m_fault_detector_p = new AUDIOFaultDetector();
+    add_handler(m_fault_detector_p);
+
     LOG_GENERATE_TRACE(g_logger, "AUDIOCaptureManager:AUDIOCaptureManager exit");
 }
 
@@ -286,11 +468,102 @@ AUDIOChannel::Index AUDIOCaptureManager::allocate_index()
 {
     LOG_GENERATE_TRACE(g_logger, "AUDIOCaptureManager::allocate_index enter this=%p", this);
 
-    m_channel_count++;
-    AUDIOChannel::Index index = (AUDIOChannel::Index)m_channel_count;
+    AUDIOChannel::Index index = CAPTURE_NO_CHANNEL_INDEX;
+    if (m_channel_count < m_index_limit)
+    {
+        m_channel_count++;
+        index = (AUDIOChannel::Index)(m_index_base + m_channel_count);
+    }
+    else
+    {
+        LOG_GENERATE_ERROR(g_logger, "no channel indexes left after channels=%d", m_channel_count);
+    }
 
     LOG_GENERATE_TRACE(g_logger, "AUDIOCaptureManager::allocate_index exit index=%d", index);
     return index;
 }
 
+void AUDIOCaptureManager::create_virtual_channels()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOCaptureManager::create_virtual_channels enter this=%p", this);
+
+    // sections are numbered from one, the first one missing ends the list
+    for (int counter = 1; ; counter++)
+    {
+        char section[128];
+        snprintf(section, sizeof(section), VIRTUAL_CHANNEL_CONFIG_SECTION, counter);
+        const char *sources_p = NULL;
+        Config::get_instance_p()->get_string_with_default(section, VIRTUAL_CHANNEL_SOURCES_CONFIG_ITEM, NULL, &sources_p);
+        if (NULL == sources_p)
+        {
+            break;
+        }
+
+        // a bad definition is skipped rather than stopping the rest
+        AUDIOVirtualChannel *channel_p = AUDIOVirtualChannel::create_p(this, section);
+        if (NULL == channel_p)
+        {
+            continue;
+        }
+        m_virtual_channels.push_back(channel_p);
+        add_channel(channel_p);
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOCaptureManager::create_virtual_channels exit");
+}
+
+ResultCode AUDIOCaptureManager::dispatch_samples(AUDIOChannel *channel_p, const size_t buffer_length, AUDIOChannel::Sample *buffer_p, const AUDIOChannel::Fixed *fixed_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOCaptureManager::dispatch_samples enter this=%p channel_p=%p buffer_length=%d buffer_p=%p fixed_p=%p", this, channel_p, buffer_length, buffer_p, fixed_p);
+
+    ResultCode result_code = RESULT_CODE_OK;
+
+    // with a Q31 block the float one is only converted once the first handler asks for it
+    bool converted = (NULL == fixed_p);
+
+    // iterate through all handlers
+    for (std::list<Handler *>::iterator iter = m_handlers.begin();
+            iter != m_handlers.end();
+            ++iter)
+    {
+        if ((false == converted) && (true == (*iter)->needs_samples(channel_p)))
+        {
+            AUDIOChannel::to_samples(buffer_length, fixed_p, buffer_p);
+            converted = true;
+        }
+
+        // call the handler to do something useful with this audio frame
+        if (NULL != fixed_p)
+        {
+            result_code = (*iter)->handle_fixed_samples(channel_p, buffer_length, fixed_p, buffer_p);
+        }
+        else
+        {
+            result_code = (*iter)->handle_samples(channel_p, buffer_length, buffer_p);
+        }
+        if (RESULT_CODE_OK != result_code)
+        {
+            LOG_GENERATE_ERROR(g_logger, "handle_samples returned error=%d", result_code);
+            break;
+        }
+    }
+
+    // a captured block goes on into the mixers, the mixes come back through here from their sinks
+    if ((RESULT_CODE_OK == result_code) && (true == channel_p->is_captured()) && (NULL != m_graph_p))
+    {
+        if ((false == converted) && (true == m_graph_p->needs_samples(channel_p)))
+        {
+            AUDIOChannel::to_samples(buffer_length, fixed_p, buffer_p);
+            converted = true;
+        }
+        m_graph_p->run(channel_p, channel_p->get_position(), buffer_length, buffer_p, fixed_p);
+    }
+
+    // every handler saw the block at the same position
+    channel_p->m_position += buffer_length;
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOCaptureManager::dispatch_samples exit result_code=%d", result_code);
+    return result_code;
+}
+
 
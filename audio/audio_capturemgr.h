@@ -7,12 +7,20 @@
 
 #include <list>
 #include <map>
+#include <vector>
 #include <ev.h>
 
 ///////////////////////////////////////////////////////////////////////////////
 // macros
 ///////////////////////////////////////////////////////////////////////////////
 
+// how often a grace period is checked while something waits on one
+#define INLINE_GRACE_POLL_IN_US     (1000)
+
+// each shard numbers its channels from its own block, so an index says which shard has it
+#define CAPTURE_SHARD_CHANNEL_STRIDE    (256)
+// what allocate_index hands back once the block is used up
+#define CAPTURE_NO_CHANNEL_INDEX        (0)
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -21,6 +29,10 @@
 
 class AUDIOCaptureInstance;
 class AUDIOChannel;
+class AUDIOVirtualChannel;
+class AUDIOOverDetector;
+class AUDIOFaultDetector;
+class AUDIOGraph;
 
 ///////////////////////////////////////////////////////////////////////////////
 // class defition
@@ -30,6 +42,7 @@ class AUDIOCaptureManager
 {
     friend class AUDIOCaptureInstance;
     friend class AUDIOChannel;
+    friend class AUDIOVirtualChannel;
 
 ///////////////////////////////////////////////////////////////////////////////
 // type defitions
@@ -41,6 +54,18 @@ public:
     {
     public:
         virtual ResultCode handle_samples(AUDIOChannel *channel_p, const size_t buffer_length, AUDIOChannel::Sample *buffer_p) = 0;
+        virtual ResultCode handle_fixed_samples(AUDIOChannel *channel_p, const size_t buffer_length, const AUDIOChannel::Fixed *fixed_p, AUDIOChannel::Sample *buffer_p);
+        // whether the float block has to be filled in for this channel before the handler sees a Q31 one
+        virtual bool needs_samples(const AUDIOChannel *channel_p) const;
+    };
+
+    // called on the capture thread with each block before it goes down the pipe, so it mustn't block or allocate,
+    // position is the one the block will have when the loop dispatches it,
+    // with fixed_p set buffer_p is scratch space the handler converts into if it wants float
+    class InlineHandler
+    {
+    public:
+        virtual void handle_inline_samples(AUDIOChannel *channel_p, uint64_t position, const size_t buffer_length, AUDIOChannel::Sample *buffer_p, const AUDIOChannel::Fixed *fixed_p) = 0;
     };
 
     typedef std::map<AUDIOChannel::Index, AUDIOChannel *>::iterator ChannelIterator;
@@ -51,28 +76,46 @@ public:
 
 public:
 
+    // a shard only opens the cards numbered shard modulo shard_count
+    static AUDIOCaptureManager *create_instance(struct ev_loop *loop_p, unsigned int shard = 0, unsigned int shard_count = 1);
     static AUDIOCaptureManager *get_instance();
 
     void add_handler(Handler *handler_p);
     void remove_handler(Handler *handler_p);
+    void set_inline_handler(InlineHandler *handler_p);
+
+    void read_inline_epochs(std::vector<uint32_t> &epochs) const;
+    bool has_inline_grace_passed(const std::vector<uint32_t> &epochs) const;
+    void synchronize_inline() const;
 
     AUDIOChannel *find_channel(const AUDIOChannel::Index index);
+    // whether the index is in this shard's block, always true with only the one process
+    bool owns_index(const AUDIOChannel::Index index) const;
     inline const size_t channel_count() const;
 
     inline ChannelIterator begin();
     inline ChannelIterator end();
 
+    inline AUDIOOverDetector *get_over_detector() const;
+    inline AUDIOFaultDetector *get_fault_detector() const;
+    inline struct ev_loop *get_loop_p() const;
+
+    // the virtual channels are mixed by a graph built from their sections at startup, this builds it again from them
+    void build_graph();
+
 ///////////////////////////////////////////////////////////////////////////////
 // private function declarations
 ///////////////////////////////////////////////////////////////////////////////
 
 private:
 
-    AUDIOCaptureManager();
+    AUDIOCaptureManager(struct ev_loop *loop_p, unsigned int shard, unsigned int shard_count);
     virtual ~AUDIOCaptureManager();
 
     AUDIOChannel::Index allocate_index();
     void add_channel(AUDIOChannel *channel_p);
+    void create_virtual_channels();
+    ResultCode dispatch_samples(AUDIOChannel *channel_p, const size_t buffer_length, AUDIOChannel::Sample *buffer_p, const AUDIOChannel::Fixed *fixed_p = NULL);
 
 ///////////////////////////////////////////////////////////////////////////////
 // private variable definitions
@@ -83,9 +126,20 @@ private:
 
     struct ev_loop *m_loop_p;
     std::list<Handler *> m_handlers;
+    // read by every capture thread, only swapped through set_inline_handler
+    InlineHandler *m_inline_handler_p;
     std::list<AUDIOCaptureInstance *> m_instances;
+    std::list<AUDIOVirtualChannel *> m_virtual_channels;
+    AUDIOOverDetector *m_over_detector_p;
+    AUDIOFaultDetector *m_fault_detector_p;
+    // runs the mixers on the loop, fed with every captured block once the handlers have seen it
+    AUDIOGraph *m_graph_p;
     std::map<AUDIOChannel::Index, AUDIOChannel *> m_channels_map;
     size_t m_channel_count;
+    // the index the first channel comes after
+    size_t m_index_base;
+    // the most channels we can number without running into the next shard's block
+    size_t m_index_limit;
 
 };
 
@@ -108,4 +162,19 @@ AUDIOCaptureManager::ChannelIterator AUDIOCaptureManager::end()
     return m_channels_map.end();
 }
 
+AUDIOOverDetector *AUDIOCaptureManager::get_over_detector() const
+{
+    return m_over_detector_p;
+}
+
+AUDIOFaultDetector *AUDIOCaptureManager::get_fault_detector() const
+{
+    return m_fault_detector_p;
+}
+
+struct ev_loop *AUDIOCaptureManager::get_loop_p() const
+{
+    return m_loop_p;
+}
+
 #endif
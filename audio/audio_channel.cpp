@@ -6,6 +6,7 @@
 
 #include <unistd.h>
 #include <stdlib.h>
+#include <strings.h>
 
 ///////////////////////////////////////////////////////////////////////////////
 // macros
@@ -15,11 +16,29 @@
 // type defintions
 ///////////////////////////////////////////////////////////////////////////////
 
+typedef struct
+{
+    const char *name_p;
+    AUDIOChannel::Role role;
+} RoleName;
 
 ///////////////////////////////////////////////////////////////////////////////
 // constants
 ///////////////////////////////////////////////////////////////////////////////
 
+// the usual ITU-R BS.775 labels
+static const RoleName c_role_names[] =
+{
+    { "L", AUDIOChannel::ROLE_LEFT },
+    { "R", AUDIOChannel::ROLE_RIGHT },
+    { "C", AUDIOChannel::ROLE_CENTRE },
+    { "LFE", AUDIOChannel::ROLE_LFE },
+    { "Ls", AUDIOChannel::ROLE_LEFT_SURROUND },
+    { "Rs", AUDIOChannel::ROLE_RIGHT_SURROUND },
+    { "Lrs", AUDIOChannel::ROLE_LEFT_REAR_SURROUND },
+    { "Rrs", AUDIOChannel::ROLE_RIGHT_REAR_SURROUND }
+};
+
 
 ///////////////////////////////////////////////////////////////////////////////
 // module variables
@@ -36,13 +55,26 @@ static LogInstance g_logger("audio.channel");
 // public function implementations
 ///////////////////////////////////////////////////////////////////////////////
 
-AUDIOChannel::AUDIOChannel(Index index, unsigned int sample_rate, float fullscale_voltage) :
+AUDIOChannel::AUDIOChannel(Index index, unsigned int sample_rate, float fullscale_voltage, bool captured, struct ev_loop *loop_p) :
     m_index(index),
+    m_captured(captured),
     m_fullscale_voltage(fullscale_voltage),
     m_sample_rate(sample_rate),
-    m_loop_p(ev_default_loop(0))
+    m_role(ROLE_UNKNOWN),
+    m_fullscale_level(AUDIO_CHANNEL_FULL_SCALE_LEVEL),
+    m_position(0),
+    m_read_fd(-1),
+    m_write_fd(-1),
+    m_loop_p(loop_p)
 {
-    LOG_GENERATE_TRACE(g_logger, "AUDIOChannel::AUDIOChannel enter this=%p index=%d sample_rate=%d fullscale_voltage=%f", this, index, sample_rate, fullscale_voltage);
+    LOG_GENERATE_TRACE(g_logger, "AUDIOChannel::AUDIOChannel enter this=%p index=%d sample_rate=%d fullscale_voltage=%f captured=%d loop_p=%p", this, index, sample_rate, fullscale_voltage, captured, loop_p);
+
+    // virtual channels are handed their samples directly so they don't need the pipe
+    if (false == m_captured)
+    {
+        LOG_GENERATE_TRACE(g_logger, "AUDIOChannel::AUDIOChannel exit");
+        return;
+    }
 
     // allocate the pipe file descriptors
     int fds[2];
@@ -69,15 +101,91 @@ AUDIOChannel::~AUDIOChannel()
 {
     LOG_GENERATE_TRACE(g_logger, "AUDIOChannel::~AUDIOChannel enter this=%p", this);
 
-    // stop the watcher
-    ev_io_stop(m_loop_p, &m_watcher);
-    // close the file descriptors for the pipe
-    close(m_read_fd);
-    close(m_write_fd);
+    if (true == m_captured)
+    {
+        // stop the watcher
+        ev_io_stop(m_loop_p, &m_watcher);
+        // close the file descriptors for the pipe
+        close(m_read_fd);
+        close(m_write_fd);
+    }
 
     LOG_GENERATE_TRACE(g_logger, "AUDIOChannel::AUDIOChannel exit");
 }
 
+void AUDIOChannel::set_role(Role role)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOChannel::set_role enter this=%p role=%d", this, role);
+
+    m_role = role;
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOChannel::set_role exit");
+}
+
+void AUDIOChannel::set_fullscale_level(Sample level)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOChannel::set_fullscale_level enter this=%p level=%f", this, level);
+
+    m_fullscale_level = level;
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOChannel::set_fullscale_level exit");
+}
+
+size_t AUDIOChannel::get_maximum_block_length() const
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOChannel::get_maximum_block_length enter this=%p", this);
+
+    // captured channels are always read a block at a time
+    size_t length = CALC_NUM_SAMPLES_FOR_MILLIS(AUDIO_CHANNEL_BLOCK_TIME_IN_MS, m_sample_rate);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOChannel::get_maximum_block_length exit length=%d", length);
+    return length;
+}
+
+void AUDIOChannel::to_fixed(const size_t buffer_length, const Sample *buffer_p, Fixed *output_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOChannel::to_fixed enter buffer_length=%d buffer_p=%p output_p=%p", buffer_length, buffer_p, output_p);
+
+    for (size_t counter = 0; counter < buffer_length; counter++)
+    {
+        output_p[counter] = to_fixed(buffer_p[counter]);
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOChannel::to_fixed exit");
+}
+
+void AUDIOChannel::to_samples(const size_t buffer_length, const Fixed *buffer_p, Sample *output_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOChannel::to_samples enter buffer_length=%d buffer_p=%p output_p=%p", buffer_length, buffer_p, output_p);
+
+    for (size_t counter = 0; counter < buffer_length; counter++)
+    {
+        output_p[counter] = to_sample(buffer_p[counter]);
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOChannel::to_samples exit");
+}
+
+ResultCode AUDIOChannel::find_role(const char *name_p, Role *role_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOChannel::find_role enter name_p=%s role_p=%p", name_p, role_p);
+
+    // assume we won't find it
+    ResultCode result_code = RESULT_CODE_ERROR;
+    for (size_t counter = 0; counter < (sizeof(c_role_names) / sizeof(c_role_names[0])); counter++)
+    {
+        if (0 == strcasecmp(name_p, c_role_names[counter].name_p))
+        {
+            *role_p = c_role_names[counter].role;
+            result_code = RESULT_CODE_OK;
+            break;
+        }
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOChannel::find_role exit result_code=%d", result_code);
+    return result_code;
+}
+
 
 ///////////////////////////////////////////////////////////////////////////////
 // private function implementations
@@ -91,33 +199,35 @@ void AUDIOChannel::read_cb(struct ev_loop *loop_p, struct ev_io *w_p, int revent
     AUDIOChannel *channel_p = (AUDIOChannel *)w_p->data;
 
     // calculate the number of samples in 50ms of samples 
-    const unsigned int num_samples = CALC_NUM_SAMPLES_FOR_MILLIS(50, channel_p->get_sample_rate());
+    const unsigned int num_samples = CALC_NUM_SAMPLES_FOR_MILLIS(AUDIO_CHANNEL_BLOCK_TIME_IN_MS, channel_p->get_sample_rate());
 
     // setup buffer space on the stack for the audio samples
     AUDIOChannel::Sample buffer[num_samples];
 
+#ifdef AUDIO_FIXED_POINT
+    // the capture thread writes Q31 so the level meters can skip the float conversion
+    AUDIOChannel::Fixed fixed_buffer[num_samples];
+
     // read the data from the pipe
-    int rc = read(channel_p->get_read_fd(), buffer, sizeof(buffer));
+    int rc = read(channel_p->get_read_fd(), fixed_buffer, sizeof(fixed_buffer));
     if (0 > rc)
     {
         LOG_GENERATE_ERROR(g_logger, "read returned error=%d", rc);
         return;
     }
-    // iterate through all handlers
-    AUDIOCaptureManager *manager_p = AUDIOCaptureManager::get_instance();
-    for (std::list<AUDIOCaptureManager::Handler *>::iterator iter=manager_p->m_handlers.begin();
-            iter != manager_p->m_handlers.end();
-            ++iter)
+    // pass the block on to all of the handlers, buffer is only filled in if one of them wants float
+    AUDIOCaptureManager::get_instance()->dispatch_samples(channel_p, num_samples, buffer, fixed_buffer);
+#else
+    // read the data from the pipe
+    int rc = read(channel_p->get_read_fd(), buffer, sizeof(buffer));
+    if (0 > rc)
     {
-        // call the handler to do something useful with this audio frame
-        AUDIOCaptureManager::Handler *handler_p = *iter;
-        ResultCode result = handler_p->handle_samples(channel_p, num_samples, buffer);
-        if (RESULT_CODE_OK != result)
-        {
-            LOG_GENERATE_ERROR(g_logger, "handler_p->handle_samples returned error=%d", result);
-            return;
-        }
+        LOG_GENERATE_ERROR(g_logger, "read returned error=%d", rc);
+        return;
     }
+    // pass the block on to all of the handlers
+    AUDIOCaptureManager::get_instance()->dispatch_samples(channel_p, num_samples, buffer);
+#endif
 
     LOG_GENERATE_TRACE(g_logger, "AUDIOChannel::read_cb exit");
 }
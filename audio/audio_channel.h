@@ -10,7 +10,13 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #define AUDIO_CHANNEL_ZERO_LEVEL	(0.0f)
+#define AUDIO_CHANNEL_FULL_SCALE_LEVEL   (1.0f)
 #define CALC_NUM_SAMPLES_FOR_MILLIS(millis, rate)  (((rate) * (millis)) / 1000)
+#define AUDIO_CHANNEL_BLOCK_TIME_IN_MS   (50)
+// Q31 full scale, a fixed sample of 2^31 would be 1.0
+#define AUDIO_CHANNEL_FIXED_FULL_SCALE   (2147483648.0f)
+#define AUDIO_CHANNEL_FIXED_MAXIMUM      ((int32_t)0x7fffffff)
+#define AUDIO_CHANNEL_FIXED_MINIMUM      (-AUDIO_CHANNEL_FIXED_MAXIMUM - 1)
 
 ///////////////////////////////////////////////////////////////////////////////
 // forward declarations
@@ -23,6 +29,7 @@
 
 class AUDIOChannel
 {
+    friend class AUDIOCaptureManager;
 
 ///////////////////////////////////////////////////////////////////////////////
 // type defitions
@@ -31,6 +38,21 @@ class AUDIOChannel
 public:
     typedef uint16_t Index;
     typedef float Sample;
+    typedef int32_t Fixed;
+
+    // where the channel sits on its bus, the loudness meter weights the surrounds by it
+    typedef enum
+    {
+        ROLE_UNKNOWN = 0,
+        ROLE_LEFT,
+        ROLE_RIGHT,
+        ROLE_CENTRE,
+        ROLE_LFE,
+        ROLE_LEFT_SURROUND,
+        ROLE_RIGHT_SURROUND,
+        ROLE_LEFT_REAR_SURROUND,
+        ROLE_RIGHT_REAR_SURROUND
+    } Role;
 
 ///////////////////////////////////////////////////////////////////////////////
 // public function declarations
@@ -38,15 +60,32 @@ public:
 
 public:
 
-    AUDIOChannel(Index index, unsigned int sample_rate, float fullscale_volatage);
+    // a captured channel's pipe is watched on loop_p
+    AUDIOChannel(Index index, unsigned int sample_rate, float fullscale_volatage, bool captured = true, struct ev_loop *loop_p = NULL);
     virtual ~AUDIOChannel();
 
     inline Index get_index() const;
+    inline bool is_captured() const;
     inline float get_fullscale_voltage() const;
     inline unsigned int get_sample_rate() const;
+    inline Role get_role() const;
+    void set_role(Role role);
+    inline uint64_t get_position() const;
+    inline Sample get_fullscale_level() const;
+    void set_fullscale_level(Sample level);
+    // the most samples a single dispatch of this channel can carry
+    virtual size_t get_maximum_block_length() const;
     inline int get_read_fd();
     inline int get_write_fd();
 
+    static inline Fixed to_fixed(Sample sample);
+    static inline Sample to_sample(Fixed sample);
+    static inline Fixed fixed_abs(Fixed sample);
+    static inline Fixed fixed_multiply(Fixed first, Fixed second);
+    static void to_fixed(const size_t buffer_length, const Sample *buffer_p, Fixed *output_p);
+    static void to_samples(const size_t buffer_length, const Fixed *buffer_p, Sample *output_p);
+    static ResultCode find_role(const char *name_p, Role *role_p);
+
 ///////////////////////////////////////////////////////////////////////////////
 // inner class declarations
 ///////////////////////////////////////////////////////////////////////////////
@@ -65,8 +104,14 @@ private:
 
 private:
     Index m_index;
+    bool m_captured;
     float m_fullscale_voltage;
     unsigned int m_sample_rate;
+    Role m_role;
+    // the level the capture format clips at, just under 1.0 for the integer formats
+    Sample m_fullscale_level;
+    // sample position of the next block to be dispatched, only touched on the loop
+    uint64_t m_position;
     int m_read_fd;
     int m_write_fd;
     struct ev_loop *m_loop_p;
@@ -82,6 +127,11 @@ AUDIOChannel::Index AUDIOChannel::get_index() const
     return m_index;
 }
 
+bool AUDIOChannel::is_captured() const
+{
+    return m_captured;
+}
+
 float AUDIOChannel::get_fullscale_voltage() const 
 {
     return m_fullscale_voltage;
@@ -92,6 +142,21 @@ unsigned int AUDIOChannel::get_sample_rate() const
     return m_sample_rate;
 }
 
+AUDIOChannel::Role AUDIOChannel::get_role() const
+{
+    return m_role;
+}
+
+uint64_t AUDIOChannel::get_position() const
+{
+    return m_position;
+}
+
+AUDIOChannel::Sample AUDIOChannel::get_fullscale_level() const
+{
+    return m_fullscale_level;
+}
+
 int AUDIOChannel::get_read_fd()
 {
     return m_read_fd;
@@ -102,6 +167,40 @@ int AUDIOChannel::get_write_fd()
     return m_write_fd;
 }
 
+AUDIOChannel::Fixed AUDIOChannel::to_fixed(Sample sample)
+{
+    // saturate rather than wrap anything at or beyond full scale
+    if (1.0f <= sample)
+    {
+        return AUDIO_CHANNEL_FIXED_MAXIMUM;
+    }
+    if (-1.0f >= sample)
+    {
+        return AUDIO_CHANNEL_FIXED_MINIMUM;
+    }
+    return (Fixed)(sample * AUDIO_CHANNEL_FIXED_FULL_SCALE);
+}
+
+AUDIOChannel::Sample AUDIOChannel::to_sample(Fixed sample)
+{
+    return ((Sample)sample) * (1.0f / AUDIO_CHANNEL_FIXED_FULL_SCALE);
+}
+
+AUDIOChannel::Fixed AUDIOChannel::fixed_abs(Fixed sample)
+{
+    // -1.0 has no positive twin in Q31 so it clips to the largest one
+    if (0 <= sample)
+    {
+        return sample;
+    }
+    return (AUDIO_CHANNEL_FIXED_MINIMUM == sample) ? AUDIO_CHANNEL_FIXED_MAXIMUM : -sample;
+}
+
+AUDIOChannel::Fixed AUDIOChannel::fixed_multiply(Fixed first, Fixed second)
+{
+    return (Fixed)(((int64_t)first * second) >> 31);
+}
+
 
 
 #endif
@@ -0,0 +1,191 @@
+
+#include "audio_correlationmeter.h"
+#include "log.h"
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+#define LEFT    (PAIR_QUEUE_LEFT)
+#define RIGHT   (PAIR_QUEUE_RIGHT)
+
+///////////////////////////////////////////////////////////////////////////////
+// type defintions
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// constants
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// module variables
+///////////////////////////////////////////////////////////////////////////////
+
+static LogInstance g_logger("audio.correlationmeter");
+
+///////////////////////////////////////////////////////////////////////////////
+// private function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// public function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+AUDIOCorrelationMeter::AUDIOCorrelationMeter(AUDIOChannel *channel_p, AUDIOChannel *paired_p) :
+    AUDIOProcessor::Meter(channel_p),
+    m_paired_p(paired_p),
+    m_queue(channel_p, CALC_NUM_SAMPLES_FOR_MILLIS(CORRELATION_PENDING_TIME_IN_MS, channel_p->get_sample_rate())),
+    m_window_index(0),
+    m_sum_left(0.0),
+    m_sum_right(0.0),
+    m_sum_cross(0.0)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOCorrelationMeter::AUDIOCorrelationMeter enter this=%p channel_p=%p paired_p=%p", this, channel_p, paired_p);
+
+    // sample positions are only comparable if both channels run at the same rate
+    ASSERT(channel_p->get_sample_rate() == paired_p->get_sample_rate());
+
+    const unsigned int sample_rate = channel_p->get_sample_rate();
+    for (int side = LEFT; side <= RIGHT; side++)
+    {
+        m_window[side].resize(CALC_NUM_SAMPLES_FOR_MILLIS(CORRELATION_WINDOW_TIME_IN_MS, sample_rate), AUDIO_CHANNEL_ZERO_LEVEL);
+    }
+
+    // we need the samples from the other channel too
+    add_linked_channel(paired_p);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOCorrelationMeter::AUDIOCorrelationMeter exit");
+}
+
+AUDIOCorrelationMeter::~AUDIOCorrelationMeter()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOCorrelationMeter::~AUDIOCorrelationMeter enter this=%p", this);
+    LOG_GENERATE_TRACE(g_logger, "AUDIOCorrelationMeter::~AUDIOCorrelationMeter exit");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// AUDIOProcessor::Meter implementation
+///////////////////////////////////////////////////////////////////////////////
+
+void AUDIOCorrelationMeter::process_samples(const size_t buffer_length, AUDIOChannel::Sample *buffer_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOCorrelationMeter::process_samples enter this=%p buffer_length=%d buffer_p=%p", this, buffer_length, buffer_p);
+
+    m_queue.queue(LEFT, get_block_position(), buffer_length, buffer_p);
+    process_pairs();
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOCorrelationMeter::process_samples exit");
+}
+
+void AUDIOCorrelationMeter::process_linked_samples(const AUDIOChannel *channel_p, const size_t buffer_length, AUDIOChannel::Sample *buffer_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOCorrelationMeter::process_linked_samples enter this=%p channel_p=%p buffer_length=%d buffer_p=%p", this, channel_p, buffer_length, buffer_p);
+
+    if (channel_p == m_paired_p)
+    {
+        m_queue.queue(RIGHT, get_block_position(), buffer_length, buffer_p);
+        process_pairs();
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOCorrelationMeter::process_linked_samples exit");
+}
+
+AUDIOProcessor::ResultData AUDIOCorrelationMeter::create_result_data()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOCorrelationMeter::create_result_data enter this=%p", this);
+
+    AUDIOProcessor::ResultData data;
+    memset(&data, 0, sizeof(data));
+
+    // populate the type
+    data.type = AUDIOProcessor::LEVEL_TYPE_CORRELATION;
+
+    // populate the channel
+    data.channel = get_channel_p()->get_index();
+    data.values.correlation.pairedChannel = m_paired_p->get_index();
+
+    // silence on either side has no defined correlation so report it as uncorrelated
+    data.values.correlation.coefficient = 0.0f;
+    data.values.correlation.balance = 0.0f;
+    const double sum_left = std::max(m_sum_left, 0.0);
+    const double sum_right = std::max(m_sum_right, 0.0);
+    if ((0.0 < sum_left) && (0.0 < sum_right))
+    {
+        double coefficient = m_sum_cross / sqrt(sum_left * sum_right);
+        data.values.correlation.coefficient = (float)std::max(-1.0, std::min(coefficient, 1.0));
+    }
+    // -1 is all left, +1 is all right
+    if (0.0 < (sum_left + sum_right))
+    {
+        data.values.correlation.balance = (float)((sum_right - sum_left) / (sum_right + sum_left));
+    }
+
+    LOG_GENERATE_DEBUG(g_logger, "correlation coefficient=%f balance=%f", data.values.correlation.coefficient, data.values.correlation.balance);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOCorrelationMeter::create_result_data exit");
+    return data;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// private function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+void AUDIOCorrelationMeter::process_pairs()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOCorrelationMeter::process_pairs enter this=%p", this);
+
+    // slide the window over every pair both channels have samples for
+    const size_t pairs = m_queue.align();
+    const size_t window_length = m_window[LEFT].size();
+    for (size_t counter = 0; counter < pairs; counter++)
+    {
+        const AUDIOChannel::Sample l = m_queue.peek(LEFT, counter);
+        const AUDIOChannel::Sample r = m_queue.peek(RIGHT, counter);
+
+        // remove the oldest pair from the running sums and add the new one
+        const AUDIOChannel::Sample old_l = m_window[LEFT][m_window_index];
+        const AUDIOChannel::Sample old_r = m_window[RIGHT][m_window_index];
+        m_sum_left += ((double)l * l) - ((double)old_l * old_l);
+        m_sum_right += ((double)r * r) - ((double)old_r * old_r);
+        m_sum_cross += ((double)l * r) - ((double)old_l * old_r);
+        m_window[LEFT][m_window_index] = l;
+        m_window[RIGHT][m_window_index] = r;
+
+        // every time the window wraps re-sum it so rounding errors can't build up
+        m_window_index++;
+        if (window_length == m_window_index)
+        {
+            m_window_index = 0;
+            recalculate_sums();
+        }
+    }
+    m_queue.consume(pairs);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOCorrelationMeter::process_pairs exit");
+}
+
+void AUDIOCorrelationMeter::recalculate_sums()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOCorrelationMeter::recalculate_sums enter this=%p", this);
+
+    m_sum_left = 0.0;
+    m_sum_right = 0.0;
+    m_sum_cross = 0.0;
+    for (size_t counter = 0; counter < m_window[LEFT].size(); counter++)
+    {
+        const double l = m_window[LEFT][counter];
+        const double r = m_window[RIGHT][counter];
+        m_sum_left += l * l;
+        m_sum_right += r * r;
+        m_sum_cross += l * r;
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOCorrelationMeter::recalculate_sums exit");
+}
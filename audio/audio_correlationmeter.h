@@ -0,0 +1,87 @@
+#ifndef _AUDIO_CORRELATIONMETER_H_
+#define _AUDIO_CORRELATIONMETER_H_
+
+#include "common.h"
+#include "audio_channel.h"
+#include "audio_processor.h"
+#include "audio_pairqueue.h"
+
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+#define CORRELATION_WINDOW_TIME_IN_MS       (300)
+#define CORRELATION_PENDING_TIME_IN_MS      (250)
+
+///////////////////////////////////////////////////////////////////////////////
+// forward declarations
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// class definition
+///////////////////////////////////////////////////////////////////////////////
+
+class AUDIOCorrelationMeter : public AUDIOProcessor::Meter
+{
+
+///////////////////////////////////////////////////////////////////////////////
+// type definitions
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+// public function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+    AUDIOCorrelationMeter(AUDIOChannel *channel_p, AUDIOChannel *paired_p);
+    virtual ~AUDIOCorrelationMeter();
+
+///////////////////////////////////////////////////////////////////////////////
+// AUDIOProcessor::Meter declarations
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+    void process_samples(const size_t buffer_length, AUDIOChannel::Sample *buffer_p);
+    void process_linked_samples(const AUDIOChannel *channel_p, const size_t buffer_length, AUDIOChannel::Sample *buffer_p);
+    AUDIOProcessor::ResultData create_result_data();
+    inline AUDIOProcessor::LevelType get_level_type();
+
+///////////////////////////////////////////////////////////////////////////////
+// private function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+    void process_pairs();
+    void recalculate_sums();
+
+///////////////////////////////////////////////////////////////////////////////
+// private variable definitions
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+    const AUDIOChannel *m_paired_p;
+    // samples waiting for the matching capture position on the other channel
+    AUDIOPairQueue m_queue;
+
+    // sliding window of paired samples + the running sums over it
+    std::vector<AUDIOChannel::Sample> m_window[2];
+    size_t m_window_index;
+    double m_sum_left;
+    double m_sum_right;
+    double m_sum_cross;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// inline function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+inline AUDIOProcessor::LevelType AUDIOCorrelationMeter::get_level_type()
+{
+    return AUDIOProcessor::LEVEL_TYPE_CORRELATION;
+}
+
+#endif
+
@@ -0,0 +1,199 @@
+
+#include "audio_crestmeter.h"
+#include "log.h"
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+// the dynamic range is the spread between the loud + quiet 100ms blocks
+#define CREST_RANGE_LOW_PERCENTILE      (0.10f)
+#define CREST_RANGE_HIGH_PERCENTILE     (0.95f)
+
+///////////////////////////////////////////////////////////////////////////////
+// type defintions
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// constants
+///////////////////////////////////////////////////////////////////////////////
+
+static const float c_zero_level_in_db = -96;
+
+///////////////////////////////////////////////////////////////////////////////
+// module variables
+///////////////////////////////////////////////////////////////////////////////
+
+static LogInstance g_logger("audio.crestmeter");
+
+///////////////////////////////////////////////////////////////////////////////
+// private function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// public function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+AUDIOCrestMeter::AUDIOCrestMeter(AUDIOChannel *channel_p) :
+    AUDIOProcessor::Meter(channel_p),
+    m_block_length(CALC_NUM_SAMPLES_FOR_MILLIS(CREST_BLOCK_TIME_IN_MS, channel_p->get_sample_rate())),
+    m_block_fill(0),
+    m_block_peak(AUDIO_CHANNEL_ZERO_LEVEL),
+    m_block_sum_squares(0.0f)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOCrestMeter::AUDIOCrestMeter enter this=%p channel_p=%p", this, channel_p);
+
+    memset(&m_accumulators, 0, sizeof(m_accumulators));
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOCrestMeter::AUDIOCrestMeter exit");
+}
+
+AUDIOCrestMeter::~AUDIOCrestMeter()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOCrestMeter::~AUDIOCrestMeter enter this=%p", this);
+    LOG_GENERATE_TRACE(g_logger, "AUDIOCrestMeter::~AUDIOCrestMeter exit");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// AUDIOProcessor::Meter implementation
+///////////////////////////////////////////////////////////////////////////////
+
+void AUDIOCrestMeter::process_samples(const size_t buffer_length, AUDIOChannel::Sample *buffer_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOCrestMeter::process_samples enter this=%p buffer_length=%d buffer_p=%p", this, buffer_length, buffer_p);
+
+    size_t offset = 0;
+    while (offset < buffer_length)
+    {
+        // one pass over the block for both the peak and the sum of squares
+        const size_t count = std::min(buffer_length - offset, (size_t)(m_block_length - m_block_fill));
+        AUDIOChannel::Sample peak = m_block_peak;
+        float sum_squares = 0.0f;
+        for (size_t counter = offset; counter < (offset + count); counter++)
+        {
+            const AUDIOChannel::Sample sample = buffer_p[counter];
+            peak = std::max(peak, (AUDIOChannel::Sample)fabsf(sample));
+            sum_squares += sample * sample;
+        }
+        m_block_peak = peak;
+        m_block_sum_squares += sum_squares;
+        m_block_fill += count;
+        offset += count;
+
+        // store completed blocks in the ring
+        if (m_block_length == m_block_fill)
+        {
+            m_accumulators.peaks[m_accumulators.block_index] = m_block_peak;
+            m_accumulators.mean_squares[m_accumulators.block_index] = m_block_sum_squares / m_block_length;
+            m_accumulators.block_index = (m_accumulators.block_index + 1) % CREST_RANGE_BLOCKS;
+            m_accumulators.block_count = std::min(m_accumulators.block_count + 1, (unsigned int)CREST_RANGE_BLOCKS);
+            m_block_peak = AUDIO_CHANNEL_ZERO_LEVEL;
+            m_block_sum_squares = 0.0f;
+            m_block_fill = 0;
+        }
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOCrestMeter::process_samples exit");
+}
+
+AUDIOProcessor::ResultData AUDIOCrestMeter::create_result_data()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOCrestMeter::create_result_data enter this=%p", this);
+    AUDIOProcessor::ResultData data = create_accumulated_result_data(m_accumulators);
+    LOG_GENERATE_TRACE(g_logger, "AUDIOCrestMeter::create_result_data exit");
+    return data;
+}
+
+size_t AUDIOCrestMeter::get_accumulators_size() const
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOCrestMeter::get_accumulators_size enter this=%p", this);
+    LOG_GENERATE_TRACE(g_logger, "AUDIOCrestMeter::get_accumulators_size exit");
+    return sizeof(Accumulators);
+}
+
+void AUDIOCrestMeter::save_accumulators(void *accumulators_p) const
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOCrestMeter::save_accumulators enter this=%p accumulators_p=%p", this, accumulators_p);
+    memcpy(accumulators_p, &m_accumulators, sizeof(m_accumulators));
+    LOG_GENERATE_TRACE(g_logger, "AUDIOCrestMeter::save_accumulators exit");
+}
+
+void AUDIOCrestMeter::queue_accumulated_result_data(const void *accumulators_p, AUDIOProcessor::ResultData &data, AUDIODecibels &decibels) const
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOCrestMeter::queue_accumulated_result_data enter this=%p accumulators_p=%p data=%p decibels=%p", this, accumulators_p, &data, &decibels);
+    // the range needs the block levels themselves so the dB are worked out here
+    data = create_accumulated_result_data(*(const Accumulators *)accumulators_p);
+    LOG_GENERATE_TRACE(g_logger, "AUDIOCrestMeter::queue_accumulated_result_data exit");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// private function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+AUDIOProcessor::ResultData AUDIOCrestMeter::create_accumulated_result_data(const Accumulators &accumulators) const
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOCrestMeter::create_accumulated_result_data enter this=%p accumulators=%p", this, &accumulators);
+
+    AUDIOProcessor::ResultData data;
+    memset(&data, 0, sizeof(data));
+
+    // populate the type
+    data.type = AUDIOProcessor::LEVEL_TYPE_CREST;
+
+    // populate the channel
+    data.channel = get_channel_p()->get_index();
+
+    // assume there is no signal
+    data.values.crest.peakInDB = c_zero_level_in_db;
+    data.values.crest.rmsInDB = c_zero_level_in_db;
+    data.values.crest.crestInDB = 0.0f;
+    data.values.crest.rangeInDB = 0.0f;
+
+    // peak + RMS over the most recent blocks
+    const unsigned int crest_blocks = std::min(accumulators.block_count, (unsigned int)CREST_CREST_BLOCKS);
+    AUDIOChannel::Sample peak = AUDIO_CHANNEL_ZERO_LEVEL;
+    float mean_square = 0.0f;
+    for (unsigned int counter = 1; counter <= crest_blocks; counter++)
+    {
+        const unsigned int index = (accumulators.block_index + CREST_RANGE_BLOCKS - counter) % CREST_RANGE_BLOCKS;
+        peak = std::max(peak, accumulators.peaks[index]);
+        mean_square += accumulators.mean_squares[index];
+    }
+    if ((AUDIO_CHANNEL_ZERO_LEVEL < peak) && (0.0f < mean_square))
+    {
+        mean_square /= crest_blocks;
+        data.values.crest.peakInDB = std::max(20.0f * log10f(peak), c_zero_level_in_db);
+        data.values.crest.rmsInDB = std::max(10.0f * log10f(mean_square), c_zero_level_in_db);
+        data.values.crest.crestInDB = data.values.crest.peakInDB - data.values.crest.rmsInDB;
+    }
+
+    // spread of the block levels over the longer window, silent blocks are ignored
+    float levels[CREST_RANGE_BLOCKS];
+    unsigned int level_count = 0;
+    for (unsigned int counter = 1; counter <= accumulators.block_count; counter++)
+    {
+        const float block_mean_square = accumulators.mean_squares[(accumulators.block_index + CREST_RANGE_BLOCKS - counter) % CREST_RANGE_BLOCKS];
+        if (0.0f < block_mean_square)
+        {
+            levels[level_count++] = 10.0f * log10f(block_mean_square);
+        }
+    }
+    if (1 < level_count)
+    {
+        std::sort(levels, levels + level_count);
+        const unsigned int low_index = (unsigned int)(CREST_RANGE_LOW_PERCENTILE * (level_count - 1));
+        const unsigned int high_index = (unsigned int)(CREST_RANGE_HIGH_PERCENTILE * (level_count - 1));
+        data.values.crest.rangeInDB = levels[high_index] - levels[low_index];
+    }
+
+    LOG_GENERATE_DEBUG(g_logger, "crest peak(dB)=%f rms(dB)=%f crest(dB)=%f range(dB)=%f", data.values.crest.peakInDB, data.values.crest.rmsInDB, data.values.crest.crestInDB, data.values.crest.rangeInDB);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOCrestMeter::create_accumulated_result_data exit");
+    return data;
+}
@@ -0,0 +1,93 @@
+#ifndef _AUDIO_CRESTMETER_H_
+#define _AUDIO_CRESTMETER_H_
+
+#include "common.h"
+#include "audio_channel.h"
+#include "audio_processor.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+// 100ms blocks, crest is measured over 300ms and the dynamic range over 3s
+#define CREST_BLOCK_TIME_IN_MS          (100)
+#define CREST_CREST_BLOCKS              (3)
+#define CREST_RANGE_BLOCKS              (30)
+
+///////////////////////////////////////////////////////////////////////////////
+// forward declarations
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// class definition
+///////////////////////////////////////////////////////////////////////////////
+
+class AUDIOCrestMeter : public AUDIOProcessor::Meter
+{
+
+///////////////////////////////////////////////////////////////////////////////
+// type definitions
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+
+    // ring of the most recent completed blocks, everything the results are worked out from
+    typedef struct
+    {
+        AUDIOChannel::Sample peaks[CREST_RANGE_BLOCKS];
+        float mean_squares[CREST_RANGE_BLOCKS];
+        unsigned int block_index;
+        unsigned int block_count;
+    } Accumulators;
+
+///////////////////////////////////////////////////////////////////////////////
+// public function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+    AUDIOCrestMeter(AUDIOChannel *channel_p);
+    virtual ~AUDIOCrestMeter();
+
+///////////////////////////////////////////////////////////////////////////////
+// AUDIOProcessor::Meter declarations
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+    void process_samples(const size_t buffer_length, AUDIOChannel::Sample *buffer_p);
+    AUDIOProcessor::ResultData create_result_data();
+    size_t get_accumulators_size() const;
+    void save_accumulators(void *accumulators_p) const;
+    void queue_accumulated_result_data(const void *accumulators_p, AUDIOProcessor::ResultData &data, AUDIODecibels &decibels) const;
+    inline AUDIOProcessor::LevelType get_level_type();
+
+///////////////////////////////////////////////////////////////////////////////
+// private function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+    AUDIOProcessor::ResultData create_accumulated_result_data(const Accumulators &accumulators) const;
+
+///////////////////////////////////////////////////////////////////////////////
+// private variable definitions
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+    unsigned int m_block_length;
+    unsigned int m_block_fill;
+    AUDIOChannel::Sample m_block_peak;
+    float m_block_sum_squares;
+    Accumulators m_accumulators;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// inline function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+inline AUDIOProcessor::LevelType AUDIOCrestMeter::get_level_type()
+{
+    return AUDIOProcessor::LEVEL_TYPE_CREST;
+}
+
+#endif
+
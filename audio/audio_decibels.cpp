@@ -0,0 +1,182 @@
+#include "audio_decibels.h"
+#include "log.h"
+
+#include <float.h>
+#include <algorithm>
+#ifdef __ARM_NEON__
+#include <arm_neon.h>
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+#define FLOAT_MANTISSA_MASK     (0x007fffff)
+#define FLOAT_EXPONENT_ONE      (0x3f800000)
+#define FLOAT_EXPONENT_BIAS     (127)
+#define FLOAT_MANTISSA_BITS     (23)
+
+///////////////////////////////////////////////////////////////////////////////
+// type defintions
+///////////////////////////////////////////////////////////////////////////////
+
+typedef union
+{
+    float value;
+    uint32_t bits;
+} FloatBits;
+
+///////////////////////////////////////////////////////////////////////////////
+// constants
+///////////////////////////////////////////////////////////////////////////////
+
+// mantissas above sqrt(2) are folded down an octave to keep the polynomial short
+static const uint32_t c_sqrt2_mantissa = 0x003504f3;
+static const float c_db_per_octave = 6.02059991f;
+
+// log2(1 + u) / u fitted over u in [sqrt(0.5) - 1, sqrt(2) - 1], good to 3e-5dB
+static const float c_log2_coefficient_1 = 1.44270044f;
+static const float c_log2_coefficient_2 = -0.72119575f;
+static const float c_log2_coefficient_3 = 0.47992557f;
+static const float c_log2_coefficient_4 = -0.36692577f;
+static const float c_log2_coefficient_5 = 0.31689819f;
+static const float c_log2_coefficient_6 = -0.20228926f;
+
+///////////////////////////////////////////////////////////////////////////////
+// module variables
+///////////////////////////////////////////////////////////////////////////////
+
+static LogInstance g_logger("audio.decibels");
+
+///////////////////////////////////////////////////////////////////////////////
+// private function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// public function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+AUDIODecibels::AUDIODecibels()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIODecibels::AUDIODecibels enter this=%p", this);
+    LOG_GENERATE_TRACE(g_logger, "AUDIODecibels::AUDIODecibels exit");
+}
+
+AUDIODecibels::~AUDIODecibels()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIODecibels::~AUDIODecibels enter this=%p", this);
+    LOG_GENERATE_TRACE(g_logger, "AUDIODecibels::~AUDIODecibels exit");
+}
+
+void AUDIODecibels::add(float amplitude, float offset_in_db, float floor_in_db, float *output_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIODecibels::add enter this=%p amplitude=%f offset_in_db=%f floor_in_db=%f output_p=%p", this, amplitude, offset_in_db, floor_in_db, output_p);
+
+    m_amplitudes.push_back(amplitude);
+    m_offsets.push_back(offset_in_db);
+    m_floors.push_back(floor_in_db);
+    m_outputs.push_back(output_p);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIODecibels::add exit");
+}
+
+void AUDIODecibels::convert()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIODecibels::convert enter this=%p count=%d", this, m_amplitudes.size());
+
+    const size_t count = m_amplitudes.size();
+    if (0 < count)
+    {
+        // one pass for every level queued this tick
+        m_levels.resize(count);
+        amplitudes_to_db(count, &m_amplitudes[0], &m_levels[0]);
+
+        for (size_t counter = 0; counter < count; counter++)
+        {
+            *m_outputs[counter] = std::max(m_levels[counter] + m_offsets[counter], m_floors[counter]);
+        }
+    }
+
+    // the storage is kept so the next tick doesn't allocate
+    m_amplitudes.clear();
+    m_offsets.clear();
+    m_floors.clear();
+    m_outputs.clear();
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIODecibels::convert exit");
+}
+
+void AUDIODecibels::reserve(size_t count)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIODecibels::reserve enter this=%p count=%d", this, count);
+
+    // lets a batch of up to count levels go through without allocating
+    m_amplitudes.reserve(count);
+    m_offsets.reserve(count);
+    m_floors.reserve(count);
+    m_levels.reserve(count);
+    m_outputs.reserve(count);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIODecibels::reserve exit");
+}
+
+void AUDIODecibels::amplitudes_to_db(const size_t count, const float amplitudes[], float output[])
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIODecibels::amplitudes_to_db enter count=%d amplitudes=%p output=%p", count, amplitudes, output);
+
+    size_t counter = 0;
+#ifdef __ARM_NEON__
+    // four levels at a time, the compiler won't vectorize float loops on its own
+    const float32x4_t minimum = vdupq_n_f32(DECIBELS_MINIMUM_IN_DB);
+    for (; (counter + 4) <= count; counter += 4)
+    {
+        const float32x4_t amplitude = vld1q_f32(&amplitudes[counter]);
+        const uint32x4_t bits = vreinterpretq_u32_f32(amplitude);
+
+        // the fold mask is all ones where the mantissa moves down an octave
+        const uint32x4_t mantissa = vandq_u32(bits, vdupq_n_u32(FLOAT_MANTISSA_MASK));
+        const uint32x4_t fold = vcgtq_u32(mantissa, vdupq_n_u32(c_sqrt2_mantissa));
+        const int32x4_t biased = vreinterpretq_s32_u32(vandq_u32(vshrq_n_u32(bits, FLOAT_MANTISSA_BITS), vdupq_n_u32(0xff)));
+        const int32x4_t exponent = vsubq_s32(vsubq_s32(biased, vdupq_n_s32(FLOAT_EXPONENT_BIAS)), vreinterpretq_s32_u32(fold));
+        const uint32x4_t normalized = vsubq_u32(vorrq_u32(mantissa, vdupq_n_u32(FLOAT_EXPONENT_ONE)), vandq_u32(fold, vdupq_n_u32(1 << FLOAT_MANTISSA_BITS)));
+
+        const float32x4_t u = vsubq_f32(vreinterpretq_f32_u32(normalized), vdupq_n_f32(1.0f));
+        float32x4_t polynomial = vmlaq_f32(vdupq_n_f32(c_log2_coefficient_5), u, vdupq_n_f32(c_log2_coefficient_6));
+        polynomial = vmlaq_f32(vdupq_n_f32(c_log2_coefficient_4), u, polynomial);
+        polynomial = vmlaq_f32(vdupq_n_f32(c_log2_coefficient_3), u, polynomial);
+        polynomial = vmlaq_f32(vdupq_n_f32(c_log2_coefficient_2), u, polynomial);
+        polynomial = vmlaq_f32(vdupq_n_f32(c_log2_coefficient_1), u, polynomial);
+        const float32x4_t log2 = vmlaq_f32(vcvtq_f32_s32(exponent), u, polynomial);
+
+        const uint32x4_t valid = vcgeq_f32(amplitude, vdupq_n_f32(FLT_MIN));
+        vst1q_f32(&output[counter], vbslq_f32(valid, vmulq_n_f32(log2, c_db_per_octave), minimum));
+    }
+#endif
+    for (; counter < count; counter++)
+    {
+        FloatBits amplitude;
+        amplitude.value = amplitudes[counter];
+
+        // split into exponent + mantissa, moving the top half of the octave down one
+        const uint32_t mantissa = amplitude.bits & FLOAT_MANTISSA_MASK;
+        const uint32_t fold = (mantissa > c_sqrt2_mantissa) ? 1 : 0;
+        const int32_t exponent = (int32_t)((amplitude.bits >> FLOAT_MANTISSA_BITS) & 0xff) - FLOAT_EXPONENT_BIAS + (int32_t)fold;
+        FloatBits normalized;
+        normalized.bits = (mantissa | FLOAT_EXPONENT_ONE) - (fold << FLOAT_MANTISSA_BITS);
+
+        const float u = normalized.value - 1.0f;
+        const float log2 = (float)exponent + (u * (c_log2_coefficient_1 + u * (c_log2_coefficient_2 + u * (c_log2_coefficient_3 +
+                        u * (c_log2_coefficient_4 + u * (c_log2_coefficient_5 + u * c_log2_coefficient_6))))));
+
+        // zero, negative + denormal amplitudes have no useful level
+        output[counter] = (FLT_MIN <= amplitudes[counter]) ? (c_db_per_octave * log2) : DECIBELS_MINIMUM_IN_DB;
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIODecibels::amplitudes_to_db exit");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// private function implementations
+///////////////////////////////////////////////////////////////////////////////
+
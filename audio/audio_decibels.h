@@ -0,0 +1,65 @@
+#ifndef _AUDIO_DECIBELS_H_
+#define _AUDIO_DECIBELS_H_
+
+#include "common.h"
+
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+// anything at or below the smallest normal float comes out as this
+#define DECIBELS_MINIMUM_IN_DB       (-1000.0f)
+
+///////////////////////////////////////////////////////////////////////////////
+// forward declarations
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// class definition
+///////////////////////////////////////////////////////////////////////////////
+
+class AUDIODecibels
+{
+
+///////////////////////////////////////////////////////////////////////////////
+// public function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+    AUDIODecibels();
+    virtual ~AUDIODecibels();
+
+    void add(float amplitude, float offset_in_db, float floor_in_db, float *output_p);
+    void convert();
+    void reserve(size_t count);
+    inline size_t get_count() const;
+
+    static void amplitudes_to_db(const size_t count, const float amplitudes[], float output[]);
+
+///////////////////////////////////////////////////////////////////////////////
+// private variable definitions
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+    // kept apart so the conversion runs down plain float arrays
+    std::vector<float> m_amplitudes;
+    std::vector<float> m_offsets;
+    std::vector<float> m_floors;
+    std::vector<float> m_levels;
+    std::vector<float *> m_outputs;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// inline function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+inline size_t AUDIODecibels::get_count() const
+{
+    return m_amplitudes.size();
+}
+
+#endif
+
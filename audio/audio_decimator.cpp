@@ -0,0 +1,169 @@
+#include "audio_decimator.h"
+#include "log.h"
+
+#include <math.h>
+#include <string.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+// half-band lowpass, every other tap is zero apart from the centre so only the odd ones are stored.
+// 47 taps with a kaiser window gives ~60dB of rejection from 0.29 of the input rate up
+#define DECIMATOR_TAP_COUNT                 (47)
+#define DECIMATOR_CENTRE                    ((DECIMATOR_TAP_COUNT - 1) / 2)
+#define DECIMATOR_HISTORY_LENGTH            (DECIMATOR_TAP_COUNT - 1)
+#define DECIMATOR_KAISER_BETA               (5.65)
+
+///////////////////////////////////////////////////////////////////////////////
+// type defintions
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// constants
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// module variables
+///////////////////////////////////////////////////////////////////////////////
+
+static LogInstance g_logger("audio.decimator");
+
+pthread_once_t AUDIODecimator::g_taps_once = PTHREAD_ONCE_INIT;
+std::vector<float> AUDIODecimator::g_taps;
+
+///////////////////////////////////////////////////////////////////////////////
+// private function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+static double calculate_bessel_i0(double x);
+
+///////////////////////////////////////////////////////////////////////////////
+// public function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+AUDIODecimator::AUDIODecimator() :
+    m_work(DECIMATOR_HISTORY_LENGTH, AUDIO_CHANNEL_ZERO_LEVEL),
+    m_phase(0)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIODecimator::AUDIODecimator enter this=%p", this);
+
+    // the taps are ready before the decimator can be handed to a worker
+    get_taps();
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIODecimator::AUDIODecimator exit");
+}
+
+AUDIODecimator::~AUDIODecimator()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIODecimator::~AUDIODecimator enter this=%p", this);
+    LOG_GENERATE_TRACE(g_logger, "AUDIODecimator::~AUDIODecimator exit");
+}
+
+void AUDIODecimator::reserve(const size_t buffer_length)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIODecimator::reserve enter this=%p buffer_length=%d", this, buffer_length);
+
+    // sized up front so a thread that mustn't allocate never has to
+    if (m_work.size() < DECIMATOR_HISTORY_LENGTH + buffer_length)
+    {
+        m_work.resize(DECIMATOR_HISTORY_LENGTH + buffer_length, AUDIO_CHANNEL_ZERO_LEVEL);
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIODecimator::reserve exit");
+}
+
+size_t AUDIODecimator::process(const size_t buffer_length, const AUDIOChannel::Sample *buffer_p, AUDIOChannel::Sample *output_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIODecimator::process enter this=%p buffer_length=%d buffer_p=%p output_p=%p", this, buffer_length, buffer_p, output_p);
+
+    const std::vector<float> &taps = get_taps();
+
+    // the block size is fixed so this only allocates on the first block
+    const size_t work_length = DECIMATOR_HISTORY_LENGTH + buffer_length;
+    if (m_work.size() < work_length)
+    {
+        m_work.resize(work_length);
+    }
+    memcpy(&m_work[DECIMATOR_HISTORY_LENGTH], buffer_p, buffer_length * sizeof(AUDIOChannel::Sample));
+
+    // only every other output is computed, the phase carries odd length blocks over
+    size_t output_length = 0;
+    size_t end = DECIMATOR_HISTORY_LENGTH + m_phase;
+    for (; end < work_length; end += 2)
+    {
+        const AUDIOChannel::Sample *centre_p = &m_work[end - DECIMATOR_CENTRE];
+        float sum = 0.5f * centre_p[0];
+        for (size_t tap = 0; tap < taps.size(); tap++)
+        {
+            const size_t offset = (2 * tap) + 1;
+            sum += taps[tap] * (centre_p[-(ptrdiff_t)offset] + centre_p[offset]);
+        }
+        output_p[output_length++] = sum;
+    }
+    m_phase = end - work_length;
+
+    // keep the tail as the history for the next block
+    memmove(&m_work[0], &m_work[buffer_length], DECIMATOR_HISTORY_LENGTH * sizeof(AUDIOChannel::Sample));
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIODecimator::process exit output_length=%d", output_length);
+    return output_length;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// private function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+const std::vector<float> &AUDIODecimator::get_taps()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIODecimator::get_taps enter");
+
+    pthread_once(&g_taps_once, calculate_taps);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIODecimator::get_taps exit");
+    return g_taps;
+}
+
+void AUDIODecimator::calculate_taps()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIODecimator::calculate_taps enter");
+
+    // kaiser windowed sinc at a quarter of the input rate, shared by every stage
+    std::vector<double> taps;
+    double sum = 0.0;
+    const double denominator = calculate_bessel_i0(DECIMATOR_KAISER_BETA);
+    for (int offset = 1; offset <= DECIMATOR_CENTRE; offset += 2)
+    {
+        const double ratio = (double)offset / DECIMATOR_CENTRE;
+        const double window = calculate_bessel_i0(DECIMATOR_KAISER_BETA * sqrt(1.0 - (ratio * ratio))) / denominator;
+        const double tap = (sin((M_PI * offset) / 2.0) / (M_PI * offset)) * window;
+        taps.push_back(tap);
+        sum += tap;
+    }
+    // unity gain at DC, the centre stays at exactly a half so the side taps sum to a quarter
+    for (std::vector<double>::iterator it = taps.begin(); it != taps.end(); it++)
+    {
+        g_taps.push_back((float)(((*it) * 0.25) / sum));
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIODecimator::calculate_taps exit");
+}
+
+static double calculate_bessel_i0(double x)
+{
+    LOG_GENERATE_TRACE(g_logger, "calculate_bessel_i0 enter x=%f", x);
+
+    // power series, converges quickly for the betas we use
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 32; k++)
+    {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "calculate_bessel_i0 exit sum=%f", sum);
+    return sum;
+}
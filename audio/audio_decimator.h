@@ -0,0 +1,67 @@
+#ifndef _AUDIO_DECIMATOR_H_
+#define _AUDIO_DECIMATOR_H_
+
+#include "common.h"
+#include "audio_channel.h"
+
+#include <pthread.h>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+// each stage halves the rate and keeps everything below this fraction of the new rate
+#define AUDIO_DECIMATOR_PASSBAND_RATIO      (0.4167f)
+
+///////////////////////////////////////////////////////////////////////////////
+// forward declarations
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// class definition
+///////////////////////////////////////////////////////////////////////////////
+
+class AUDIODecimator
+{
+
+///////////////////////////////////////////////////////////////////////////////
+// public function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+
+    AUDIODecimator();
+    virtual ~AUDIODecimator();
+
+    // the output needs room for half the input plus one
+    size_t process(const size_t buffer_length, const AUDIOChannel::Sample *buffer_p, AUDIOChannel::Sample *output_p);
+    void reserve(const size_t buffer_length);
+
+///////////////////////////////////////////////////////////////////////////////
+// private function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+
+    static const std::vector<float> &get_taps();
+    static void calculate_taps();
+
+///////////////////////////////////////////////////////////////////////////////
+// private variable definitions
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+    // worked out once by whichever thread gets there first, read only after that
+    static pthread_once_t g_taps_once;
+    static std::vector<float> g_taps;
+
+    // the filter history followed by the current block
+    std::vector<AUDIOChannel::Sample> m_work;
+    size_t m_phase;
+
+};
+
+#endif
+
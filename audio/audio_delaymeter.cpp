@@ -0,0 +1,275 @@
+
+#include "audio_delaymeter.h"
+#include "log.h"
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+#define LEFT    (PAIR_QUEUE_LEFT)
+#define RIGHT   (PAIR_QUEUE_RIGHT)
+
+// the cross spectrum is averaged over ~4 frames so a single noisy frame can't move the peak
+#define DELAY_CROSS_SMOOTHING           (0.75f)
+
+// bins quieter than this carry no phase worth weighting
+#define DELAY_MINIMUM_MAGNITUDE         (1e-20f)
+
+///////////////////////////////////////////////////////////////////////////////
+// type defintions
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// constants
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// module variables
+///////////////////////////////////////////////////////////////////////////////
+
+static LogInstance g_logger("audio.delaymeter");
+
+///////////////////////////////////////////////////////////////////////////////
+// private function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// public function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+AUDIODelayMeter::AUDIODelayMeter(AUDIOChannel *channel_p, AUDIOChannel *paired_p) :
+    AUDIOProcessor::Meter(channel_p),
+    m_paired_p(paired_p),
+    m_stage(STAGE_IDLE),
+    m_fft_p(AUDIOFFT::get_instance(AUDIOFFT::calculate_length(CALC_NUM_SAMPLES_FOR_MILLIS(DELAY_FRAME_TIME_IN_MS, channel_p->get_sample_rate())))),
+    m_queue(channel_p, m_fft_p->get_length() + CALC_NUM_SAMPLES_FOR_MILLIS(DELAY_PENDING_TIME_IN_MS, channel_p->get_sample_rate())),
+    m_lag_in_samples(0.0f),
+    m_confidence(0.0f)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIODelayMeter::AUDIODelayMeter enter this=%p channel_p=%p paired_p=%p", this, channel_p, paired_p);
+
+    // sample positions are only comparable if both channels run at the same rate
+    ASSERT(channel_p->get_sample_rate() == paired_p->get_sample_rate());
+
+    // grab the working buffers up front so the audio path never allocates
+    const size_t length = m_fft_p->get_length();
+    const size_t bins = (length / 2) + 1;
+    AUDIOFFT::Complex zero = {0.0f, 0.0f};
+    for (int side = LEFT; side <= RIGHT; side++)
+    {
+        m_frames[side].resize(length);
+        m_spectra[side].resize(bins, zero);
+    }
+    m_scratch_p = m_fft_p->acquire_scratch();
+    m_cross.resize(bins, zero);
+    m_weighted.resize(bins, zero);
+    m_correlation.resize(length);
+
+    // we need the samples from the other channel too
+    add_linked_channel(paired_p);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIODelayMeter::AUDIODelayMeter exit");
+}
+
+AUDIODelayMeter::~AUDIODelayMeter()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIODelayMeter::~AUDIODelayMeter enter this=%p", this);
+
+    // give the scratch back to the pool
+    m_fft_p->release_scratch(m_scratch_p);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIODelayMeter::~AUDIODelayMeter exit");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// AUDIOProcessor::Meter implementation
+///////////////////////////////////////////////////////////////////////////////
+
+void AUDIODelayMeter::process_samples(const size_t buffer_length, AUDIOChannel::Sample *buffer_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIODelayMeter::process_samples enter this=%p buffer_length=%d buffer_p=%p", this, buffer_length, buffer_p);
+
+    m_queue.queue(LEFT, get_block_position(), buffer_length, buffer_p);
+    run_stage();
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIODelayMeter::process_samples exit");
+}
+
+void AUDIODelayMeter::process_linked_samples(const AUDIOChannel *channel_p, const size_t buffer_length, AUDIOChannel::Sample *buffer_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIODelayMeter::process_linked_samples enter this=%p channel_p=%p buffer_length=%d buffer_p=%p", this, channel_p, buffer_length, buffer_p);
+
+    if (channel_p == m_paired_p)
+    {
+        m_queue.queue(RIGHT, get_block_position(), buffer_length, buffer_p);
+        run_stage();
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIODelayMeter::process_linked_samples exit");
+}
+
+AUDIOProcessor::ResultData AUDIODelayMeter::create_result_data()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIODelayMeter::create_result_data enter this=%p", this);
+
+    AUDIOProcessor::ResultData data;
+    memset(&data, 0, sizeof(data));
+
+    // populate the type
+    data.type = AUDIOProcessor::LEVEL_TYPE_DELAY;
+
+    // populate the channel
+    data.channel = get_channel_p()->get_index();
+    data.values.delay.pairedChannel = m_paired_p->get_index();
+
+    // the estimate is only updated once a correlation has run all the way through, nothing heavy happens here
+    data.values.delay.lagInSamples = m_lag_in_samples;
+    data.values.delay.lagInMs = (m_lag_in_samples * 1000.0f) / get_channel_p()->get_sample_rate();
+    data.values.delay.confidence = m_confidence;
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIODelayMeter::create_result_data exit");
+    return data;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// private function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+void AUDIODelayMeter::run_stage()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIODelayMeter::run_stage enter this=%p stage=%d", this, m_stage);
+
+    // at most one transform per call so a correlation never holds up the loop for long
+    switch (m_stage)
+    {
+        case STAGE_IDLE:
+            if (true == fetch_frames())
+            {
+                m_stage = STAGE_TRANSFORM_LEFT;
+            }
+            break;
+
+        case STAGE_TRANSFORM_LEFT:
+            m_fft_p->transform(&m_frames[LEFT][0], &m_spectra[LEFT][0], m_scratch_p);
+            m_stage = STAGE_TRANSFORM_RIGHT;
+            break;
+
+        case STAGE_TRANSFORM_RIGHT:
+            m_fft_p->transform(&m_frames[RIGHT][0], &m_spectra[RIGHT][0], m_scratch_p);
+            m_stage = STAGE_CORRELATE;
+            break;
+
+        case STAGE_CORRELATE:
+            correlate();
+            m_stage = STAGE_FIND_PEAK;
+            break;
+
+        case STAGE_FIND_PEAK:
+            find_peak();
+            m_stage = STAGE_IDLE;
+            break;
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIODelayMeter::run_stage exit");
+}
+
+bool AUDIODelayMeter::fetch_frames()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIODelayMeter::fetch_frames enter this=%p", this);
+
+    // copy out a frame from each side once both have one, then step on by half a frame
+    const size_t length = m_frames[LEFT].size();
+    bool fetched = false;
+    if (length <= m_queue.align())
+    {
+        for (int side = LEFT; side <= RIGHT; side++)
+        {
+            for (size_t counter = 0; counter < length; counter++)
+            {
+                m_frames[side][counter] = m_queue.peek(side, counter);
+            }
+        }
+        m_queue.consume(length / 2);
+        fetched = true;
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIODelayMeter::fetch_frames exit fetched=%d", fetched);
+    return fetched;
+}
+
+void AUDIODelayMeter::correlate()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIODelayMeter::correlate enter this=%p", this);
+
+    // conj(left) * right peaks at a positive lag when the paired channel is behind
+    for (size_t bin = 0; bin < m_cross.size(); bin++)
+    {
+        const AUDIOFFT::Complex &l = m_spectra[LEFT][bin];
+        const AUDIOFFT::Complex &r = m_spectra[RIGHT][bin];
+        AUDIOFFT::Complex &cross = m_cross[bin];
+        cross.re = (DELAY_CROSS_SMOOTHING * cross.re) + ((1.0f - DELAY_CROSS_SMOOTHING) * ((l.re * r.re) + (l.im * r.im)));
+        cross.im = (DELAY_CROSS_SMOOTHING * cross.im) + ((1.0f - DELAY_CROSS_SMOOTHING) * ((l.re * r.im) - (l.im * r.re)));
+
+        // phase transform, keep only the phase so every bin votes equally
+        float magnitude = sqrtf((cross.re * cross.re) + (cross.im * cross.im));
+        m_weighted[bin].re = 0.0f;
+        m_weighted[bin].im = 0.0f;
+        if (DELAY_MINIMUM_MAGNITUDE < magnitude)
+        {
+            m_weighted[bin].re = cross.re / magnitude;
+            m_weighted[bin].im = cross.im / magnitude;
+        }
+    }
+
+    m_fft_p->inverse_transform(&m_weighted[0], &m_correlation[0], m_scratch_p);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIODelayMeter::correlate exit");
+}
+
+void AUDIODelayMeter::find_peak()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIODelayMeter::find_peak enter this=%p", this);
+
+    const size_t length = m_correlation.size();
+    size_t peak_index = 0;
+    for (size_t counter = 1; counter < length; counter++)
+    {
+        if (m_correlation[counter] > m_correlation[peak_index])
+        {
+            peak_index = counter;
+        }
+    }
+
+    // a perfectly coherent pair peaks at 1, uncorrelated ones stay close to 0
+    m_confidence = std::max(0.0f, std::min(m_correlation[peak_index], 1.0f));
+
+    // fit a parabola through the peak + its neighbours for the sub-sample lag
+    const float before = m_correlation[(peak_index + length - 1) % length];
+    const float peak = m_correlation[peak_index];
+    const float after = m_correlation[(peak_index + 1) % length];
+    const float curvature = before - (2.0f * peak) + after;
+    float offset = 0.0f;
+    if (0.0f > curvature)
+    {
+        offset = (0.5f * (before - after)) / curvature;
+    }
+
+    // the correlation wraps, the top half are the negative lags
+    float lag = (float)peak_index;
+    if ((length / 2) <= peak_index)
+    {
+        lag -= (float)length;
+    }
+    m_lag_in_samples = lag + offset;
+
+    LOG_GENERATE_DEBUG(g_logger, "delay lag(samples)=%f confidence=%f", m_lag_in_samples, m_confidence);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIODelayMeter::find_peak exit");
+}
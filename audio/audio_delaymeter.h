@@ -0,0 +1,110 @@
+#ifndef _AUDIO_DELAYMETER_H_
+#define _AUDIO_DELAYMETER_H_
+
+#include "common.h"
+#include "audio_channel.h"
+#include "audio_processor.h"
+#include "audio_fft.h"
+#include "audio_pairqueue.h"
+
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+// ~200ms frames with 50% overlap, lags up to half a frame either way can be seen
+#define DELAY_FRAME_TIME_IN_MS          (200)
+#define DELAY_PENDING_TIME_IN_MS        (250)
+
+///////////////////////////////////////////////////////////////////////////////
+// forward declarations
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// class definition
+///////////////////////////////////////////////////////////////////////////////
+
+class AUDIODelayMeter : public AUDIOProcessor::Meter
+{
+
+///////////////////////////////////////////////////////////////////////////////
+// type definitions
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+
+    // the correlation is spread over several calls, one stage per call
+    typedef enum
+    {
+        STAGE_IDLE = 0,
+        STAGE_TRANSFORM_LEFT = 1,
+        STAGE_TRANSFORM_RIGHT = 2,
+        STAGE_CORRELATE = 3,
+        STAGE_FIND_PEAK = 4
+    } Stage;
+
+///////////////////////////////////////////////////////////////////////////////
+// public function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+    AUDIODelayMeter(AUDIOChannel *channel_p, AUDIOChannel *paired_p);
+    virtual ~AUDIODelayMeter();
+
+///////////////////////////////////////////////////////////////////////////////
+// AUDIOProcessor::Meter declarations
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+    void process_samples(const size_t buffer_length, AUDIOChannel::Sample *buffer_p);
+    void process_linked_samples(const AUDIOChannel *channel_p, const size_t buffer_length, AUDIOChannel::Sample *buffer_p);
+    AUDIOProcessor::ResultData create_result_data();
+    inline AUDIOProcessor::LevelType get_level_type();
+
+///////////////////////////////////////////////////////////////////////////////
+// private function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+    void run_stage();
+    bool fetch_frames();
+    void correlate();
+    void find_peak();
+
+///////////////////////////////////////////////////////////////////////////////
+// private variable definitions
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+    const AUDIOChannel *m_paired_p;
+    Stage m_stage;
+
+    AUDIOFFT *m_fft_p;
+    // samples waiting for the matching capture position on the other channel
+    AUDIOPairQueue m_queue;
+    AUDIOFFT::Complex *m_scratch_p;
+    std::vector<AUDIOChannel::Sample> m_frames[2];
+    std::vector<AUDIOFFT::Complex> m_spectra[2];
+
+    // smoothed cross spectrum + its phase transform
+    std::vector<AUDIOFFT::Complex> m_cross;
+    std::vector<AUDIOFFT::Complex> m_weighted;
+    std::vector<float> m_correlation;
+
+    float m_lag_in_samples;
+    float m_confidence;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// inline function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+inline AUDIOProcessor::LevelType AUDIODelayMeter::get_level_type()
+{
+    return AUDIOProcessor::LEVEL_TYPE_DELAY;
+}
+
+#endif
+
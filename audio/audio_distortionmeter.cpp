@@ -0,0 +1,284 @@
+
+#include "audio_distortionmeter.h"
+#include "config.h"
+#include "log.h"
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+#define DISTORTION_BLOCK_TIME_IN_MS         (100)
+#define DISTORTION_BANDWIDTH_Q              (0.7071067811865476)
+
+// a q of 5 leaves the 2nd harmonic alone while settling in a couple of ms at 1kHz
+#define DISTORTION_NOTCH_Q                  (5.0)
+
+// the notch is retuned on any change but only measures once the estimate has held still
+#define DISTORTION_RETUNE_TOLERANCE         (1e-6)
+#define DISTORTION_SETTLED_TOLERANCE        (1e-5)
+#define DISTORTION_SETTLED_BLOCKS           (2)
+
+// below this there isn't a test tone to measure against
+#define DISTORTION_MINIMUM_LEVEL_IN_DBFS    (-60.0f)
+#define DISTORTION_MINIMUM_CROSSINGS        (3)
+#define DISTORTION_HYSTERESIS_RATIO         (0.5)
+
+#define DISTORTION_CONFIG_SECTION           "distortion-meter"
+#define DISTORTION_LOW_CONFIG_ITEM          "low-frequency"
+#define DISTORTION_HIGH_CONFIG_ITEM         "high-frequency"
+#define DISTORTION_DEFAULT_LOW_FREQUENCY    (20.0f)
+#define DISTORTION_DEFAULT_HIGH_FREQUENCY   (20000.0f)
+
+// leave the lowpass out when the band edge is this close to nyquist
+#define DISTORTION_MAXIMUM_NYQUIST_RATIO    (0.9)
+
+///////////////////////////////////////////////////////////////////////////////
+// type defintions
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// constants
+///////////////////////////////////////////////////////////////////////////////
+
+static const float c_zero_level_in_db = -96;
+
+///////////////////////////////////////////////////////////////////////////////
+// module variables
+///////////////////////////////////////////////////////////////////////////////
+
+static LogInstance g_logger("audio.distortionmeter");
+
+///////////////////////////////////////////////////////////////////////////////
+// private function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// public function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+AUDIODistortionMeter::AUDIODistortionMeter(AUDIOChannel *channel_p, float low_frequency, float high_frequency) :
+    AUDIOProcessor::Meter(channel_p),
+    m_block_length(CALC_NUM_SAMPLES_FOR_MILLIS(DISTORTION_BLOCK_TIME_IN_MS, channel_p->get_sample_rate())),
+    m_block_fill(0),
+    m_notch_frequency(0.0),
+    m_settled_blocks(0),
+    m_sum_total(0.0),
+    m_sum_residual(0.0),
+    m_previous(0.0),
+    m_hysteresis(0.0),
+    m_armed(false),
+    m_crossings(0),
+    m_first_crossing(0.0),
+    m_last_crossing(0.0),
+    m_frequency(0.0f),
+    m_level_in_db(c_zero_level_in_db),
+    m_thdn_in_db(0.0f),
+    m_sinad_in_db(0.0f)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIODistortionMeter::AUDIODistortionMeter enter this=%p channel_p=%p low_frequency=%f high_frequency=%f", this, channel_p, low_frequency, high_frequency);
+
+    const unsigned int sample_rate = channel_p->get_sample_rate();
+    ASSERT((0.0f < low_frequency) && (low_frequency < high_frequency));
+
+    m_highpass.set_coefficients(AUDIOBiquad::create_highpass(sample_rate, low_frequency, DISTORTION_BANDWIDTH_Q));
+    if ((DISTORTION_MAXIMUM_NYQUIST_RATIO * (sample_rate / 2.0)) > high_frequency)
+    {
+        m_lowpass.set_coefficients(AUDIOBiquad::create_lowpass(sample_rate, high_frequency, DISTORTION_BANDWIDTH_Q));
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIODistortionMeter::AUDIODistortionMeter exit");
+}
+
+AUDIODistortionMeter::~AUDIODistortionMeter()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIODistortionMeter::~AUDIODistortionMeter enter this=%p", this);
+    LOG_GENERATE_TRACE(g_logger, "AUDIODistortionMeter::~AUDIODistortionMeter exit");
+}
+
+void AUDIODistortionMeter::fetch_default_bandwidth(float *low_frequency_p, float *high_frequency_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIODistortionMeter::fetch_default_bandwidth enter low_frequency_p=%p high_frequency_p=%p", low_frequency_p, high_frequency_p);
+
+    Config::get_instance_p()->get_float_with_default(DISTORTION_CONFIG_SECTION, DISTORTION_LOW_CONFIG_ITEM, DISTORTION_DEFAULT_LOW_FREQUENCY, low_frequency_p);
+    Config::get_instance_p()->get_float_with_default(DISTORTION_CONFIG_SECTION, DISTORTION_HIGH_CONFIG_ITEM, DISTORTION_DEFAULT_HIGH_FREQUENCY, high_frequency_p);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIODistortionMeter::fetch_default_bandwidth exit low_frequency=%f high_frequency=%f", *low_frequency_p, *high_frequency_p);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// AUDIOProcessor::Meter implementation
+///////////////////////////////////////////////////////////////////////////////
+
+void AUDIODistortionMeter::process_samples(const size_t buffer_length, AUDIOChannel::Sample *buffer_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIODistortionMeter::process_samples enter this=%p buffer_length=%d buffer_p=%p", this, buffer_length, buffer_p);
+
+    for (size_t counter = 0; counter < buffer_length; counter++)
+    {
+        // band limit the signal then notch out the fundamental, what's left is the noise + distortion
+        const double sample = m_lowpass.process(m_highpass.process(buffer_p[counter]));
+        const double residual = m_notch.process(sample);
+        m_sum_total += sample * sample;
+        m_sum_residual += residual * residual;
+
+        // time the rising zero crossings to the sub-sample
+        if ((true == m_armed) && (0.0 > m_previous) && (0.0 <= sample))
+        {
+            double crossing = ((double)m_block_fill - 1.0) + (-m_previous / (sample - m_previous));
+            if (0 == m_crossings)
+            {
+                m_first_crossing = crossing;
+            }
+            m_last_crossing = crossing;
+            m_crossings++;
+            m_armed = false;
+        }
+        if (-m_hysteresis > sample)
+        {
+            m_armed = true;
+        }
+        m_previous = sample;
+
+        m_block_fill++;
+        if (m_block_length == m_block_fill)
+        {
+            complete_block();
+        }
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIODistortionMeter::process_samples exit");
+}
+
+AUDIOProcessor::ResultData AUDIODistortionMeter::create_result_data()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIODistortionMeter::create_result_data enter this=%p", this);
+    Accumulators accumulators;
+    save_accumulators(&accumulators);
+    AUDIOProcessor::ResultData data = create_accumulated_result_data(accumulators);
+    LOG_GENERATE_TRACE(g_logger, "AUDIODistortionMeter::create_result_data exit");
+    return data;
+}
+
+size_t AUDIODistortionMeter::get_accumulators_size() const
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIODistortionMeter::get_accumulators_size enter this=%p", this);
+    LOG_GENERATE_TRACE(g_logger, "AUDIODistortionMeter::get_accumulators_size exit");
+    return sizeof(Accumulators);
+}
+
+void AUDIODistortionMeter::save_accumulators(void *accumulators_p) const
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIODistortionMeter::save_accumulators enter this=%p accumulators_p=%p", this, accumulators_p);
+
+    Accumulators *saved_p = (Accumulators *)accumulators_p;
+    saved_p->frequency = m_frequency;
+    saved_p->level_in_db = m_level_in_db;
+    saved_p->thdn_in_db = m_thdn_in_db;
+    saved_p->sinad_in_db = m_sinad_in_db;
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIODistortionMeter::save_accumulators exit");
+}
+
+void AUDIODistortionMeter::queue_accumulated_result_data(const void *accumulators_p, AUDIOProcessor::ResultData &data, AUDIODecibels &decibels) const
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIODistortionMeter::queue_accumulated_result_data enter this=%p accumulators_p=%p data=%p decibels=%p", this, accumulators_p, &data, &decibels);
+    // the levels are already in dB so there's nothing to batch
+    data = create_accumulated_result_data(*(const Accumulators *)accumulators_p);
+    LOG_GENERATE_TRACE(g_logger, "AUDIODistortionMeter::queue_accumulated_result_data exit");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// private function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+AUDIOProcessor::ResultData AUDIODistortionMeter::create_accumulated_result_data(const Accumulators &accumulators) const
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIODistortionMeter::create_accumulated_result_data enter this=%p accumulators=%p", this, &accumulators);
+
+    AUDIOProcessor::ResultData data;
+    memset(&data, 0, sizeof(data));
+
+    // populate the type
+    data.type = AUDIOProcessor::LEVEL_TYPE_DISTORTION;
+
+    // populate the channel
+    data.channel = get_channel_p()->get_index();
+
+    // report the last completed block
+    data.values.distortion.frequency = accumulators.frequency;
+    data.values.distortion.levelInDB = accumulators.level_in_db;
+    data.values.distortion.thdnInDB = accumulators.thdn_in_db;
+    data.values.distortion.sinadInDB = accumulators.sinad_in_db;
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIODistortionMeter::create_accumulated_result_data exit");
+    return data;
+}
+
+void AUDIODistortionMeter::complete_block()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIODistortionMeter::complete_block enter this=%p", this);
+
+    const double mean_square = m_sum_total / m_block_length;
+    m_level_in_db = c_zero_level_in_db;
+    if (0.0 < mean_square)
+    {
+        m_level_in_db = std::max((float)(10.0 * log10(mean_square)), c_zero_level_in_db);
+    }
+
+    // no measurement until there's a tone and the notch has settled on it
+    m_frequency = 0.0f;
+    m_thdn_in_db = 0.0f;
+    m_sinad_in_db = 0.0f;
+    if ((DISTORTION_MINIMUM_LEVEL_IN_DBFS <= m_level_in_db) && (DISTORTION_MINIMUM_CROSSINGS <= m_crossings) && (m_first_crossing < m_last_crossing))
+    {
+        const double frequency = ((m_crossings - 1) * (double)get_channel_p()->get_sample_rate()) / (m_last_crossing - m_first_crossing);
+        const double error = fabs(frequency - m_notch_frequency) / frequency;
+        if (DISTORTION_SETTLED_TOLERANCE < error)
+        {
+            LOG_GENERATE_DEBUG(g_logger, "fundamental moved to frequency=%f on channel=%d", frequency, get_channel_p()->get_index());
+            m_settled_blocks = 0;
+        }
+        else if (DISTORTION_SETTLED_BLOCKS > m_settled_blocks)
+        {
+            m_settled_blocks++;
+        }
+
+        // the residual of this block was measured with the old tuning so only report it when that was close enough
+        if (DISTORTION_SETTLED_BLOCKS <= m_settled_blocks)
+        {
+            m_frequency = (float)frequency;
+            m_thdn_in_db = c_zero_level_in_db;
+            if (0.0 < m_sum_residual)
+            {
+                m_thdn_in_db = std::max((float)(10.0 * log10(m_sum_residual / m_sum_total)), c_zero_level_in_db);
+            }
+            m_sinad_in_db = -m_thdn_in_db;
+        }
+
+        if (DISTORTION_RETUNE_TOLERANCE < error)
+        {
+            m_notch_frequency = frequency;
+            // the notch keeps its history so retuning doesn't restart it
+            m_notch.set_coefficients(AUDIOBiquad::create_notch(get_channel_p()->get_sample_rate(), frequency, DISTORTION_NOTCH_Q));
+        }
+    }
+    else
+    {
+        m_settled_blocks = 0;
+    }
+
+    // the next block's hysteresis follows this block's level
+    m_hysteresis = DISTORTION_HYSTERESIS_RATIO * sqrt(mean_square);
+    m_sum_total = 0.0;
+    m_sum_residual = 0.0;
+    m_crossings = 0;
+    m_block_fill = 0;
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIODistortionMeter::complete_block exit");
+}
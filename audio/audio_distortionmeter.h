@@ -0,0 +1,114 @@
+#ifndef _AUDIO_DISTORTIONMETER_H_
+#define _AUDIO_DISTORTIONMETER_H_
+
+#include "common.h"
+#include "audio_channel.h"
+#include "audio_biquad.h"
+#include "audio_processor.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// forward declarations
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// class definition
+///////////////////////////////////////////////////////////////////////////////
+
+class AUDIODistortionMeter : public AUDIOProcessor::Meter
+{
+
+///////////////////////////////////////////////////////////////////////////////
+// type definitions
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+
+    // the last completed block, already worked out as it completed
+    typedef struct
+    {
+        float frequency;
+        float level_in_db;
+        float thdn_in_db;
+        float sinad_in_db;
+    } Accumulators;
+
+///////////////////////////////////////////////////////////////////////////////
+// public function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+    AUDIODistortionMeter(AUDIOChannel *channel_p, float low_frequency, float high_frequency);
+    virtual ~AUDIODistortionMeter();
+
+    static void fetch_default_bandwidth(float *low_frequency_p, float *high_frequency_p);
+
+///////////////////////////////////////////////////////////////////////////////
+// AUDIOProcessor::Meter declarations
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+    void process_samples(const size_t buffer_length, AUDIOChannel::Sample *buffer_p);
+    AUDIOProcessor::ResultData create_result_data();
+    size_t get_accumulators_size() const;
+    void save_accumulators(void *accumulators_p) const;
+    void queue_accumulated_result_data(const void *accumulators_p, AUDIOProcessor::ResultData &data, AUDIODecibels &decibels) const;
+    inline AUDIOProcessor::LevelType get_level_type();
+
+///////////////////////////////////////////////////////////////////////////////
+// private function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+    void complete_block();
+    AUDIOProcessor::ResultData create_accumulated_result_data(const Accumulators &accumulators) const;
+
+///////////////////////////////////////////////////////////////////////////////
+// private variable definitions
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+    unsigned int m_block_length;
+    unsigned int m_block_fill;
+
+    // the measurement bandwidth applies to both the signal and the residual, the
+    // floor is set by filter rounding so these run in double
+    AUDIOBiquad::Precise m_highpass;
+    AUDIOBiquad::Precise m_lowpass;
+    AUDIOBiquad::Precise m_notch;
+    double m_notch_frequency;
+    unsigned int m_settled_blocks;
+
+    double m_sum_total;
+    double m_sum_residual;
+
+    // zero crossing state for tracking the fundamental
+    double m_previous;
+    double m_hysteresis;
+    bool m_armed;
+    unsigned int m_crossings;
+    double m_first_crossing;
+    double m_last_crossing;
+
+    float m_frequency;
+    float m_level_in_db;
+    float m_thdn_in_db;
+    float m_sinad_in_db;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// inline function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+inline AUDIOProcessor::LevelType AUDIODistortionMeter::get_level_type()
+{
+    return AUDIOProcessor::LEVEL_TYPE_DISTORTION;
+}
+
+#endif
+
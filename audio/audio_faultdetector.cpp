@@ -0,0 +1,309 @@
+
+#include "audio_faultdetector.h"
+#include "config.h"
+#include "log.h"
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+#define FAULT_DETECTOR_CONFIG_SECTION               "fault-detector"
+#define FAULT_DETECTOR_SILENCE_LEVEL_CONFIG_ITEM    "silence-level"
+#define FAULT_DETECTOR_SILENCE_TIME_CONFIG_ITEM     "silence-time"
+#define FAULT_DETECTOR_DROPOUT_TIME_CONFIG_ITEM     "dropout-time"
+#define FAULT_DETECTOR_DC_LEVEL_CONFIG_ITEM         "dc-level"
+
+///////////////////////////////////////////////////////////////////////////////
+// type defintions
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// constants
+///////////////////////////////////////////////////////////////////////////////
+
+static const float c_zero_level_in_db = -96;
+
+// just under full scale so the conversion can't overflow
+static const float c_maximum_sample = 0.99999994f;
+static const float c_sample_to_int = 2147483648.0f;
+
+// a float sample only carries 24 bits, the bottom of a 32 bit word comes and goes with the level
+static const uint32_t c_stuck_bit_mask = 0xffffff00;
+
+///////////////////////////////////////////////////////////////////////////////
+// module variables
+///////////////////////////////////////////////////////////////////////////////
+
+static LogInstance g_logger("audio.faultdetector");
+
+///////////////////////////////////////////////////////////////////////////////
+// private function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+static float level_to_db(float level);
+
+///////////////////////////////////////////////////////////////////////////////
+// public function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+AUDIOFaultDetector::AUDIOFaultDetector()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOFaultDetector::AUDIOFaultDetector enter this=%p", this);
+
+    const Config *config_p = Config::get_instance_p();
+    float silence_level_in_db = FAULT_DEFAULT_SILENCE_LEVEL_IN_DB;
+    float dc_level_in_db = FAULT_DEFAULT_DC_LEVEL_IN_DB;
+    config_p->get_float_with_default(FAULT_DETECTOR_CONFIG_SECTION, FAULT_DETECTOR_SILENCE_LEVEL_CONFIG_ITEM, FAULT_DEFAULT_SILENCE_LEVEL_IN_DB, &silence_level_in_db);
+    config_p->get_float_with_default(FAULT_DETECTOR_CONFIG_SECTION, FAULT_DETECTOR_SILENCE_TIME_CONFIG_ITEM, FAULT_DEFAULT_SILENCE_TIME_IN_SECS, &m_silence_time_in_secs);
+    config_p->get_float_with_default(FAULT_DETECTOR_CONFIG_SECTION, FAULT_DETECTOR_DROPOUT_TIME_CONFIG_ITEM, FAULT_DEFAULT_DROPOUT_TIME_IN_MS, &m_dropout_time_in_ms);
+    config_p->get_float_with_default(FAULT_DETECTOR_CONFIG_SECTION, FAULT_DETECTOR_DC_LEVEL_CONFIG_ITEM, FAULT_DEFAULT_DC_LEVEL_IN_DB, &dc_level_in_db);
+
+    // the sample loop works on linear levels
+    m_silence_level = powf(10.0f, silence_level_in_db / 20.0f);
+    m_dc_level = powf(10.0f, dc_level_in_db / 20.0f);
+
+    LOG_GENERATE_INFO(g_logger, "silence below %fdB for %fs, dropout after %fms of zeros, dc above %fdB", silence_level_in_db, m_silence_time_in_secs, m_dropout_time_in_ms, dc_level_in_db);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOFaultDetector::AUDIOFaultDetector exit");
+}
+
+AUDIOFaultDetector::~AUDIOFaultDetector()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOFaultDetector::~AUDIOFaultDetector enter this=%p", this);
+    LOG_GENERATE_TRACE(g_logger, "AUDIOFaultDetector::~AUDIOFaultDetector exit");
+}
+
+void AUDIOFaultDetector::add_handler(Handler *handler_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOFaultDetector::add_handler enter this=%p handler_p=%p", this, handler_p);
+
+    m_handlers.push_back(handler_p);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOFaultDetector::add_handler exit");
+}
+
+void AUDIOFaultDetector::remove_handler(Handler *handler_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOFaultDetector::remove_handler enter this=%p handler_p=%p", this, handler_p);
+
+    m_handlers.remove(handler_p);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOFaultDetector::remove_handler exit");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// AUDIOCaptureManager::Handler implementation
+///////////////////////////////////////////////////////////////////////////////
+
+ResultCode AUDIOFaultDetector::handle_samples(AUDIOChannel *channel_p, const size_t buffer_length, AUDIOChannel::Sample *buffer_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOFaultDetector::handle_samples enter this=%p channel_p=%p buffer_length=%d buffer_p=%p", this, channel_p, buffer_length, buffer_p);
+
+    // first sight of a channel sets up its state for the channel rate
+    std::map<AUDIOChannel::Index, State>::iterator iter = m_states_map.find(channel_p->get_index());
+    if (iter == m_states_map.end())
+    {
+        const unsigned int rate = channel_p->get_sample_rate();
+        State state;
+        memset(&state, 0, sizeof(state));
+        state.silence_samples = (uint64_t)(m_silence_time_in_secs * rate);
+        state.dropout_samples = std::max((uint32_t)CALC_NUM_SAMPLES_FOR_MILLIS(m_dropout_time_in_ms, rate), (uint32_t)1);
+        state.window_length = CALC_NUM_SAMPLES_FOR_MILLIS(FAULT_STUCK_BIT_WINDOW_IN_MS, rate);
+        state.dc_coefficient = 1.0f - expf(-1.0f / (FAULT_DC_TIME_CONSTANT_IN_SECS * rate));
+        reset_window(state);
+        iter = m_states_map.insert(std::make_pair(channel_p->get_index(), state)).first;
+    }
+    State &state = iter->second;
+
+    // one pass does the lot, the state is a handful of words per channel
+    float peak = 0.0f;
+    float dc_mean = state.dc_mean;
+    uint32_t and_mask = state.and_mask;
+    uint32_t or_mask = state.or_mask;
+    for (size_t counter = 0; counter < buffer_length; counter++)
+    {
+        const float sample = buffer_p[counter];
+        const float level = fabsf(sample);
+        peak = std::max(peak, level);
+        dc_mean += state.dc_coefficient * (sample - dc_mean);
+
+        // the bit pattern the converter would have delivered
+        const int32_t value = (int32_t)(std::max(std::min(sample, c_maximum_sample), -1.0f) * c_sample_to_int);
+        and_mask &= (uint32_t)value;
+        or_mask |= (uint32_t)value;
+        if (0 < value)
+        {
+            state.window_positive = true;
+        }
+        else if (0 > value)
+        {
+            state.window_negative = true;
+        }
+
+        // exact zeros straight after program are a dropout, fading down into silence isn't
+        if (0.0f == sample)
+        {
+            state.zero_run++;
+            if ((false == state.dropout_active) && (state.dropout_samples == state.zero_run) && (m_silence_level <= state.last_level))
+            {
+                state.dropout_active = true;
+                notify(FAULT_TYPE_DROPOUT, channel_p, true, state.position + counter + 1 - state.zero_run, level_to_db(state.last_level), 0);
+            }
+        }
+        else
+        {
+            if (true == state.dropout_active)
+            {
+                state.dropout_active = false;
+                notify(FAULT_TYPE_DROPOUT, channel_p, false, state.position + counter, level_to_db(level), 0);
+            }
+            state.zero_run = 0;
+            state.last_level = level;
+        }
+    }
+    state.dc_mean = dc_mean;
+    state.and_mask = and_mask;
+    state.or_mask = or_mask;
+    state.window_peak = std::max(state.window_peak, peak);
+    state.window_fill += buffer_length;
+    state.position += buffer_length;
+
+    // silence is judged on whole blocks, that's plenty for a timeout in seconds
+    if (m_silence_level > peak)
+    {
+        state.silent_samples += buffer_length;
+        if ((false == state.silence_active) && (state.silence_samples <= state.silent_samples))
+        {
+            state.silence_active = true;
+            notify(FAULT_TYPE_SILENCE, channel_p, true, state.position - state.silent_samples, level_to_db(peak), 0);
+        }
+    }
+    else
+    {
+        if (true == state.silence_active)
+        {
+            state.silence_active = false;
+            notify(FAULT_TYPE_SILENCE, channel_p, false, state.position - buffer_length, level_to_db(peak), 0);
+        }
+        state.silent_samples = 0;
+    }
+
+    // 6dB of hysteresis stops an offset sat on the threshold from chattering
+    const float dc_level = fabsf(state.dc_mean);
+    if ((false == state.dc_active) && (m_dc_level <= dc_level))
+    {
+        state.dc_active = true;
+        notify(FAULT_TYPE_DC_OFFSET, channel_p, true, state.position, level_to_db(dc_level), 0);
+    }
+    else if ((true == state.dc_active) && ((m_dc_level / 2.0f) > dc_level))
+    {
+        state.dc_active = false;
+        notify(FAULT_TYPE_DC_OFFSET, channel_p, false, state.position, level_to_db(dc_level), 0);
+    }
+
+    if (state.window_length <= state.window_fill)
+    {
+        check_window(channel_p, state);
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOFaultDetector::handle_samples exit");
+    return RESULT_CODE_OK;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// private function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+void AUDIOFaultDetector::reset_window(State &state)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOFaultDetector::reset_window enter this=%p", this);
+
+    state.window_fill = 0;
+    state.and_mask = 0xffffffff;
+    state.or_mask = 0;
+    state.window_positive = false;
+    state.window_negative = false;
+    state.window_peak = 0.0f;
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOFaultDetector::reset_window exit");
+}
+
+void AUDIOFaultDetector::check_window(const AUDIOChannel *channel_p, State &state)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOFaultDetector::check_window enter this=%p channel_p=%p", this, channel_p);
+
+    // it takes program swinging both ways before the bits say anything
+    if ((m_silence_level <= state.window_peak) && (true == state.window_positive) && (true == state.window_negative))
+    {
+        // a bit set in every sample is stuck high, a hole in the bits that do move is stuck low
+        uint32_t stuck_bits = state.and_mask;
+        if (0 != state.or_mask)
+        {
+            const uint32_t lowest_bit = state.or_mask & (~state.or_mask + 1);
+            stuck_bits |= ~state.or_mask & ~(lowest_bit - 1);
+        }
+        stuck_bits &= c_stuck_bit_mask;
+
+        if ((false == state.stuck_active) && (0 != stuck_bits))
+        {
+            state.stuck_active = true;
+            notify(FAULT_TYPE_STUCK_BIT, channel_p, true, state.position - state.window_fill, level_to_db(state.window_peak), stuck_bits);
+        }
+        else if ((true == state.stuck_active) && (0 == stuck_bits))
+        {
+            state.stuck_active = false;
+            notify(FAULT_TYPE_STUCK_BIT, channel_p, false, state.position - state.window_fill, level_to_db(state.window_peak), 0);
+        }
+    }
+    reset_window(state);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOFaultDetector::check_window exit");
+}
+
+void AUDIOFaultDetector::notify(FaultType type, const AUDIOChannel *channel_p, bool active, uint64_t position, float level_in_db, uint32_t stuck_bits)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOFaultDetector::notify enter this=%p type=%d channel_p=%p active=%d", this, type, channel_p, active);
+
+    LOG_GENERATE_INFO(g_logger, "fault type=%d %s on channel=%d at position=%llu level(dB)=%f bits=0x%08x", type, (true == active) ? "raised" : "cleared", channel_p->get_index(), (unsigned long long)position, level_in_db, stuck_bits);
+
+    Fault fault;
+    fault.type = type;
+    fault.channel = channel_p->get_index();
+    fault.active = active;
+    fault.position = position;
+    fault.levelInDB = level_in_db;
+    fault.stuckBits = stuck_bits;
+
+    // one handler failing doesn't stop the rest hearing about it
+    for (std::list<Handler *>::iterator iter = m_handlers.begin();
+            iter != m_handlers.end();
+            ++iter)
+    {
+        ResultCode result_code = (*iter)->handle_fault(fault);
+        if (RESULT_CODE_OK != result_code)
+        {
+            LOG_GENERATE_ERROR(g_logger, "handle_fault returned error=%d", result_code);
+        }
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOFaultDetector::notify exit");
+}
+
+float level_to_db(float level)
+{
+    LOG_GENERATE_TRACE(g_logger, "level_to_db enter level=%f", level);
+
+    float level_in_db = c_zero_level_in_db;
+    if (0.0f < level)
+    {
+        level_in_db = std::max(20.0f * log10f(level), c_zero_level_in_db);
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "level_to_db exit level_in_db=%f", level_in_db);
+    return level_in_db;
+}
@@ -0,0 +1,149 @@
+#ifndef _AUDIO_FAULTDETECTOR_H_
+#define _AUDIO_FAULTDETECTOR_H_
+
+#include "common.h"
+#include "audio_channel.h"
+#include "audio_capturemgr.h"
+
+#include <list>
+#include <map>
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+#define FAULT_DEFAULT_SILENCE_LEVEL_IN_DB       (-60.0f)
+#define FAULT_DEFAULT_SILENCE_TIME_IN_SECS      (10.0f)
+#define FAULT_DEFAULT_DROPOUT_TIME_IN_MS        (2.0f)
+#define FAULT_DEFAULT_DC_LEVEL_IN_DB            (-40.0f)
+
+// the dc average and the stuck bit masks both look at about a second of audio
+#define FAULT_DC_TIME_CONSTANT_IN_SECS          (1.0f)
+#define FAULT_STUCK_BIT_WINDOW_IN_MS            (1000)
+
+///////////////////////////////////////////////////////////////////////////////
+// forward declarations
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// class definition
+///////////////////////////////////////////////////////////////////////////////
+
+class AUDIOFaultDetector : public AUDIOCaptureManager::Handler
+{
+
+///////////////////////////////////////////////////////////////////////////////
+// type definitions
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+
+    typedef enum
+    {
+        FAULT_TYPE_SILENCE = 0,
+        FAULT_TYPE_DROPOUT = 1,
+        FAULT_TYPE_DC_OFFSET = 2,
+        FAULT_TYPE_STUCK_BIT = 3
+    } FaultType;
+
+    typedef struct
+    {
+        FaultType type;
+        AUDIOChannel::Index channel;
+        // raised or cleared, only changes are reported
+        bool active;
+        uint64_t position;
+        float levelInDB;
+        uint32_t stuckBits;
+    } Fault;
+
+    class Handler
+    {
+    public:
+        virtual ResultCode handle_fault(const Fault &fault) = 0;
+    };
+
+private:
+
+    typedef struct
+    {
+        // worked out from the channel rate when it's first seen
+        uint64_t silence_samples;
+        uint32_t dropout_samples;
+        uint32_t window_length;
+        float dc_coefficient;
+
+        uint64_t position;
+
+        bool silence_active;
+        uint64_t silent_samples;
+
+        bool dropout_active;
+        uint32_t zero_run;
+        float last_level;
+
+        bool dc_active;
+        float dc_mean;
+
+        bool stuck_active;
+        uint32_t window_fill;
+        uint32_t and_mask;
+        uint32_t or_mask;
+        bool window_positive;
+        bool window_negative;
+        float window_peak;
+    } State;
+
+///////////////////////////////////////////////////////////////////////////////
+// public function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+
+    AUDIOFaultDetector();
+    virtual ~AUDIOFaultDetector();
+
+    void add_handler(Handler *handler_p);
+    void remove_handler(Handler *handler_p);
+
+///////////////////////////////////////////////////////////////////////////////
+// AUDIOCaptureManager::Handler declarations
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+
+    ResultCode handle_samples(AUDIOChannel *channel_p, const size_t buffer_length, AUDIOChannel::Sample *buffer_p);
+
+///////////////////////////////////////////////////////////////////////////////
+// private function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+
+    void reset_window(State &state);
+    void check_window(const AUDIOChannel *channel_p, State &state);
+    void notify(FaultType type, const AUDIOChannel *channel_p, bool active, uint64_t position, float level_in_db, uint32_t stuck_bits);
+
+///////////////////////////////////////////////////////////////////////////////
+// private variable definitions
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+    float m_silence_level;
+    float m_silence_time_in_secs;
+    float m_dropout_time_in_ms;
+    float m_dc_level;
+
+    std::list<Handler *> m_handlers;
+    std::map<AUDIOChannel::Index, State> m_states_map;
+
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// inline function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+
+#endif
+
@@ -0,0 +1,446 @@
+
+#include "audio_fft.h"
+#include "log.h"
+
+#include <math.h>
+#include <stdlib.h>
+#ifdef __ARM_NEON__
+#include <arm_neon.h>
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// type defintions
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// constants
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// module variables
+///////////////////////////////////////////////////////////////////////////////
+
+static LogInstance g_logger("audio.fft");
+
+// one instance per transform length
+std::map<size_t, AUDIOFFT *> AUDIOFFT::g_instances;
+
+///////////////////////////////////////////////////////////////////////////////
+// private function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// public function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+AUDIOFFT *AUDIOFFT::get_instance(size_t length)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOFFT::get_instance enter length=%d", length);
+
+    ASSERT((AUDIO_FFT_MINIMUM_LENGTH <= length) && (0 == (length & (length - 1))));
+
+    // the twiddles + window are shared by everyone using the same length
+    AUDIOFFT *instance_p = NULL;
+    std::map<size_t, AUDIOFFT *>::iterator it = g_instances.find(length);
+    if (g_instances.end() != it)
+    {
+        instance_p = it->second;
+    }
+    else
+    {
+        instance_p = new AUDIOFFT(length);
+        g_instances[length] = instance_p;
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOFFT::get_instance exit instance_p=%p", instance_p);
+    return instance_p;
+}
+
+size_t AUDIOFFT::calculate_length(unsigned int minimum_length)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOFFT::calculate_length enter minimum_length=%d", minimum_length);
+
+    // round up to the next power of two
+    size_t length = AUDIO_FFT_MINIMUM_LENGTH;
+    while (length < minimum_length)
+    {
+        length <<= 1;
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOFFT::calculate_length exit length=%d", length);
+    return length;
+}
+
+AUDIOFFT::Complex *AUDIOFFT::acquire_scratch()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOFFT::acquire_scratch enter this=%p", this);
+
+    // reuse a released buffer if we have one
+    Complex *scratch_p = NULL;
+    if (false == m_scratch_pool.empty())
+    {
+        scratch_p = m_scratch_pool.front();
+        m_scratch_pool.pop_front();
+    }
+    else
+    {
+        scratch_p = (Complex *)malloc(sizeof(Complex) * m_half_length);
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOFFT::acquire_scratch exit scratch_p=%p", scratch_p);
+    return scratch_p;
+}
+
+void AUDIOFFT::release_scratch(Complex *scratch_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOFFT::release_scratch enter this=%p scratch_p=%p", this, scratch_p);
+
+    // hang onto it for the next meter
+    m_scratch_pool.push_front(scratch_p);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOFFT::release_scratch exit");
+}
+
+void AUDIOFFT::transform(const AUDIOChannel::Sample *input_p, Complex *output_p, Complex *scratch_p) const
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOFFT::transform enter this=%p input_p=%p output_p=%p scratch_p=%p", this, input_p, output_p, scratch_p);
+
+    // pack the windowed real input into a half length complex sequence in bit reversed order
+    for (size_t counter = 0; counter < m_half_length; counter++)
+    {
+        Complex &value = scratch_p[m_bit_reverse[counter]];
+        value.re = input_p[2 * counter] * m_window[2 * counter];
+        value.im = input_p[(2 * counter) + 1] * m_window[(2 * counter) + 1];
+    }
+
+    transform_complex(scratch_p);
+
+    // split the half length transform into the real spectrum
+    for (size_t k = 0; k <= m_half_length; k++)
+    {
+        const Complex &z = scratch_p[k % m_half_length];
+        const Complex &zn = scratch_p[(m_half_length - k) % m_half_length];
+        const Complex &w = m_real_twiddles[k];
+        // even = (Z[k] + conj(Z[N/2-k])) / 2, odd = (Z[k] - conj(Z[N/2-k])) / 2j
+        float even_re = 0.5f * (z.re + zn.re);
+        float even_im = 0.5f * (z.im - zn.im);
+        float odd_re = 0.5f * (z.im + zn.im);
+        float odd_im = -0.5f * (z.re - zn.re);
+        output_p[k].re = even_re + (w.re * odd_re) - (w.im * odd_im);
+        output_p[k].im = even_im + (w.re * odd_im) + (w.im * odd_re);
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOFFT::transform exit");
+}
+
+void AUDIOFFT::transform_power(const AUDIOChannel::Sample *input_p, float *power_p, Complex *scratch_p) const
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOFFT::transform_power enter this=%p input_p=%p power_p=%p scratch_p=%p", this, input_p, power_p, scratch_p);
+
+    // same as transform but only keep the squared magnitude
+    for (size_t counter = 0; counter < m_half_length; counter++)
+    {
+        Complex &value = scratch_p[m_bit_reverse[counter]];
+        value.re = input_p[2 * counter] * m_window[2 * counter];
+        value.im = input_p[(2 * counter) + 1] * m_window[(2 * counter) + 1];
+    }
+
+    transform_complex(scratch_p);
+
+    for (size_t k = 0; k <= m_half_length; k++)
+    {
+        const Complex &z = scratch_p[k % m_half_length];
+        const Complex &zn = scratch_p[(m_half_length - k) % m_half_length];
+        const Complex &w = m_real_twiddles[k];
+        float even_re = 0.5f * (z.re + zn.re);
+        float even_im = 0.5f * (z.im - zn.im);
+        float odd_re = 0.5f * (z.im + zn.im);
+        float odd_im = -0.5f * (z.re - zn.re);
+        float re = even_re + (w.re * odd_re) - (w.im * odd_im);
+        float im = even_im + (w.re * odd_im) + (w.im * odd_re);
+        power_p[k] = (re * re) + (im * im);
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOFFT::transform_power exit");
+}
+
+void AUDIOFFT::inverse_transform(const Complex *input_p, float *output_p, Complex *scratch_p) const
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOFFT::inverse_transform enter this=%p input_p=%p output_p=%p scratch_p=%p", this, input_p, output_p, scratch_p);
+
+    // merge the real spectrum back into the half length complex one, conjugated so the forward
+    // transform runs it backwards. no window is applied
+    for (size_t k = 0; k < m_half_length; k++)
+    {
+        const Complex &x = input_p[k];
+        const Complex &xn = input_p[m_half_length - k];
+        const Complex &w = m_real_twiddles[k];
+        // even = (X[k] + conj(X[N/2-k])) / 2, odd = (X[k] - conj(X[N/2-k])) * conj(W^k) / 2
+        float even_re = 0.5f * (x.re + xn.re);
+        float even_im = 0.5f * (x.im - xn.im);
+        float diff_re = 0.5f * (x.re - xn.re);
+        float diff_im = 0.5f * (x.im + xn.im);
+        float odd_re = (w.re * diff_re) + (w.im * diff_im);
+        float odd_im = (w.re * diff_im) - (w.im * diff_re);
+        // Z[k] = even + j * odd
+        Complex &value = scratch_p[m_bit_reverse[k]];
+        value.re = even_re - odd_im;
+        value.im = -(even_im + odd_re);
+    }
+
+    transform_complex(scratch_p);
+
+    // conjugate back + scale, the real + imaginary parts are the even + odd samples
+    const float scale = 1.0f / m_half_length;
+    for (size_t counter = 0; counter < m_half_length; counter++)
+    {
+        output_p[2 * counter] = scratch_p[counter].re * scale;
+        output_p[(2 * counter) + 1] = -scratch_p[counter].im * scale;
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOFFT::inverse_transform exit");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// private function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+AUDIOFFT::AUDIOFFT(size_t length) :
+    m_length(length),
+    m_half_length(length / 2),
+    m_half_length_log2(0),
+    m_window_power(0.0f)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOFFT::AUDIOFFT enter this=%p length=%d", this, length);
+
+    while (((size_t)1 << m_half_length_log2) < m_half_length)
+    {
+        m_half_length_log2++;
+    }
+
+    // bit reversal table for the half length complex transform
+    m_bit_reverse.resize(m_half_length);
+    for (size_t counter = 0; counter < m_half_length; counter++)
+    {
+        uint32_t reversed = 0;
+        for (unsigned int bit = 0; bit < m_half_length_log2; bit++)
+        {
+            if (0 != (counter & (1 << bit)))
+            {
+                reversed |= 1 << (m_half_length_log2 - 1 - bit);
+            }
+        }
+        m_bit_reverse[counter] = reversed;
+    }
+
+    // twiddles for the complex transform, W(N/2)^k
+    m_twiddles.resize(m_half_length);
+    for (size_t k = 0; k < m_half_length; k++)
+    {
+        double angle = (-2.0 * M_PI * k) / m_half_length;
+        m_twiddles[k].re = (float)cos(angle);
+        m_twiddles[k].im = (float)sin(angle);
+    }
+
+#ifdef __ARM_NEON__
+    // the strided twiddles gathered per pass, so four butterflies can load theirs in one go
+    size_t pass_length = (0 != (m_half_length_log2 & 1)) ? 2 : 1;
+    while (pass_length < m_half_length)
+    {
+        const size_t stride = m_half_length / (4 * pass_length);
+        if (4 <= pass_length)
+        {
+            for (size_t multiple = 1; multiple <= 3; multiple++)
+            {
+                for (size_t k = 0; k < pass_length; k++)
+                {
+                    m_pass_twiddles.push_back(m_twiddles[multiple * k * stride]);
+                }
+            }
+        }
+        pass_length *= 4;
+    }
+#endif
+
+    // twiddles for splitting out the real transform, W(N)^k
+    m_real_twiddles.resize(m_half_length + 1);
+    for (size_t k = 0; k <= m_half_length; k++)
+    {
+        double angle = (-2.0 * M_PI * k) / m_length;
+        m_real_twiddles[k].re = (float)cos(angle);
+        m_real_twiddles[k].im = (float)sin(angle);
+    }
+
+    // periodic hann window
+    m_window.resize(m_length);
+    for (size_t counter = 0; counter < m_length; counter++)
+    {
+        m_window[counter] = (float)(0.5 - (0.5 * cos((2.0 * M_PI * counter) / m_length)));
+        m_window_power += m_window[counter] * m_window[counter];
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOFFT::AUDIOFFT exit");
+}
+
+AUDIOFFT::~AUDIOFFT()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOFFT::~AUDIOFFT enter this=%p", this);
+
+    // release the pooled scratch buffers
+    for (std::list<Complex *>::iterator it = m_scratch_pool.begin();
+            it != m_scratch_pool.end();
+            it++)
+    {
+        free(*it);
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOFFT::~AUDIOFFT exit");
+}
+
+void AUDIOFFT::transform_complex(Complex *data_p) const
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOFFT::transform_complex enter this=%p data_p=%p", this, data_p);
+
+    // the input is already in bit reversed order, start with the sub-transform length of 1
+    size_t length = 1;
+
+    // an odd number of stages needs a single radix-2 pass first
+    if (0 != (m_half_length_log2 & 1))
+    {
+        for (size_t counter = 0; counter < m_half_length; counter += 2)
+        {
+            Complex a = data_p[counter];
+            Complex b = data_p[counter + 1];
+            data_p[counter].re = a.re + b.re;
+            data_p[counter].im = a.im + b.im;
+            data_p[counter + 1].re = a.re - b.re;
+            data_p[counter + 1].im = a.im - b.im;
+        }
+        length = 2;
+    }
+
+#ifdef __ARM_NEON__
+    const Complex *pass_twiddles_p = m_pass_twiddles.empty() ? NULL : &m_pass_twiddles[0];
+#endif
+
+    // radix-4 passes, each combines four sub-transforms into one four times as long
+    while (length < m_half_length)
+    {
+        const size_t stride = m_half_length / (4 * length);
+        for (size_t base = 0; base < m_half_length; base += 4 * length)
+        {
+            size_t k = 0;
+#ifdef __ARM_NEON__
+            // four butterflies at a time, split into real + imaginary lanes by the interleaved loads
+            if (4 <= length)
+            {
+                for (; k < length; k += 4)
+                {
+                    const float32x4x2_t w1 = vld2q_f32((const float *)&pass_twiddles_p[k]);
+                    const float32x4x2_t w2 = vld2q_f32((const float *)&pass_twiddles_p[length + k]);
+                    const float32x4x2_t w3 = vld2q_f32((const float *)&pass_twiddles_p[(2 * length) + k]);
+
+                    float *p0 = (float *)&data_p[base + k];
+                    float *p1 = p0 + (2 * length);
+                    float *p2 = p1 + (2 * length);
+                    float *p3 = p2 + (2 * length);
+
+                    const float32x4x2_t x0 = vld2q_f32(p0);
+                    const float32x4x2_t x1 = vld2q_f32(p1);
+                    const float32x4x2_t x2 = vld2q_f32(p2);
+                    const float32x4x2_t x3 = vld2q_f32(p3);
+
+                    // a = x0, b = w2 * x1, c = w1 * x2, d = w3 * x3
+                    const float32x4_t b_re = vmlsq_f32(vmulq_f32(w2.val[0], x1.val[0]), w2.val[1], x1.val[1]);
+                    const float32x4_t b_im = vmlaq_f32(vmulq_f32(w2.val[0], x1.val[1]), w2.val[1], x1.val[0]);
+                    const float32x4_t c_re = vmlsq_f32(vmulq_f32(w1.val[0], x2.val[0]), w1.val[1], x2.val[1]);
+                    const float32x4_t c_im = vmlaq_f32(vmulq_f32(w1.val[0], x2.val[1]), w1.val[1], x2.val[0]);
+                    const float32x4_t d_re = vmlsq_f32(vmulq_f32(w3.val[0], x3.val[0]), w3.val[1], x3.val[1]);
+                    const float32x4_t d_im = vmlaq_f32(vmulq_f32(w3.val[0], x3.val[1]), w3.val[1], x3.val[0]);
+
+                    const float32x4_t apb_re = vaddq_f32(x0.val[0], b_re);
+                    const float32x4_t apb_im = vaddq_f32(x0.val[1], b_im);
+                    const float32x4_t amb_re = vsubq_f32(x0.val[0], b_re);
+                    const float32x4_t amb_im = vsubq_f32(x0.val[1], b_im);
+                    const float32x4_t cpd_re = vaddq_f32(c_re, d_re);
+                    const float32x4_t cpd_im = vaddq_f32(c_im, d_im);
+                    const float32x4_t cmd_re = vsubq_f32(c_re, d_re);
+                    const float32x4_t cmd_im = vsubq_f32(c_im, d_im);
+
+                    float32x4x2_t y;
+                    y.val[0] = vaddq_f32(apb_re, cpd_re);
+                    y.val[1] = vaddq_f32(apb_im, cpd_im);
+                    vst2q_f32(p0, y);
+                    y.val[0] = vsubq_f32(apb_re, cpd_re);
+                    y.val[1] = vsubq_f32(apb_im, cpd_im);
+                    vst2q_f32(p2, y);
+                    y.val[0] = vaddq_f32(amb_re, cmd_im);
+                    y.val[1] = vsubq_f32(amb_im, cmd_re);
+                    vst2q_f32(p1, y);
+                    y.val[0] = vsubq_f32(amb_re, cmd_im);
+                    y.val[1] = vaddq_f32(amb_im, cmd_re);
+                    vst2q_f32(p3, y);
+                }
+            }
+#endif
+            for (; k < length; k++)
+            {
+                const Complex &w1 = m_twiddles[k * stride];
+                const Complex &w2 = m_twiddles[2 * k * stride];
+                const Complex &w3 = m_twiddles[3 * k * stride];
+
+                Complex *p0 = &data_p[base + k];
+                Complex *p1 = p0 + length;
+                Complex *p2 = p1 + length;
+                Complex *p3 = p2 + length;
+
+                // a = x0, b = w2 * x1, c = w1 * x2, d = w3 * x3
+                float a_re = p0->re;
+                float a_im = p0->im;
+                float b_re = (w2.re * p1->re) - (w2.im * p1->im);
+                float b_im = (w2.re * p1->im) + (w2.im * p1->re);
+                float c_re = (w1.re * p2->re) - (w1.im * p2->im);
+                float c_im = (w1.re * p2->im) + (w1.im * p2->re);
+                float d_re = (w3.re * p3->re) - (w3.im * p3->im);
+                float d_im = (w3.re * p3->im) + (w3.im * p3->re);
+
+                float apb_re = a_re + b_re;
+                float apb_im = a_im + b_im;
+                float amb_re = a_re - b_re;
+                float amb_im = a_im - b_im;
+                float cpd_re = c_re + d_re;
+                float cpd_im = c_im + d_im;
+                float cmd_re = c_re - d_re;
+                float cmd_im = c_im - d_im;
+
+                // X[k] = (a + b) + (c + d), X[k + 2L] = (a + b) - (c + d)
+                p0->re = apb_re + cpd_re;
+                p0->im = apb_im + cpd_im;
+                p2->re = apb_re - cpd_re;
+                p2->im = apb_im - cpd_im;
+                // X[k + L] = (a - b) - j(c - d), X[k + 3L] = (a - b) + j(c - d)
+                p1->re = amb_re + cmd_im;
+                p1->im = amb_im - cmd_re;
+                p3->re = amb_re - cmd_im;
+                p3->im = amb_im + cmd_re;
+            }
+        }
+#ifdef __ARM_NEON__
+        if (4 <= length)
+        {
+            pass_twiddles_p += 3 * length;
+        }
+#endif
+        length *= 4;
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOFFT::transform_complex exit");
+}
@@ -0,0 +1,113 @@
+#ifndef _AUDIO_FFT_H_
+#define _AUDIO_FFT_H_
+
+#include "common.h"
+#include "audio_channel.h"
+
+#include <list>
+#include <map>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+#define AUDIO_FFT_MINIMUM_LENGTH    (4)
+
+///////////////////////////////////////////////////////////////////////////////
+// forward declarations
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// class definition
+///////////////////////////////////////////////////////////////////////////////
+
+class AUDIOFFT
+{
+
+///////////////////////////////////////////////////////////////////////////////
+// type definitions
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+
+    typedef struct
+    {
+        float re;
+        float im;
+    } Complex;
+
+///////////////////////////////////////////////////////////////////////////////
+// public function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+
+    static AUDIOFFT *get_instance(size_t length);
+    static size_t calculate_length(unsigned int minimum_length);
+
+    inline size_t get_length() const;
+    inline const float *get_window() const;
+    inline float get_window_power() const;
+
+    Complex *acquire_scratch();
+    void release_scratch(Complex *scratch_p);
+
+    void transform(const AUDIOChannel::Sample *input_p, Complex *output_p, Complex *scratch_p) const;
+    void transform_power(const AUDIOChannel::Sample *input_p, float *power_p, Complex *scratch_p) const;
+    void inverse_transform(const Complex *input_p, float *output_p, Complex *scratch_p) const;
+
+///////////////////////////////////////////////////////////////////////////////
+// private function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+
+    AUDIOFFT(size_t length);
+    virtual ~AUDIOFFT();
+
+    void transform_complex(Complex *data_p) const;
+
+///////////////////////////////////////////////////////////////////////////////
+// private variable definitions
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+    static std::map<size_t, AUDIOFFT *> g_instances;
+
+    size_t m_length;
+    size_t m_half_length;
+    unsigned int m_half_length_log2;
+    std::vector<uint32_t> m_bit_reverse;
+    std::vector<Complex> m_twiddles;
+    std::vector<Complex> m_real_twiddles;
+    // w1, w2, w3 laid out contiguously per radix-4 pass, only filled for NEON
+    std::vector<Complex> m_pass_twiddles;
+    std::vector<float> m_window;
+    float m_window_power;
+    std::list<Complex *> m_scratch_pool;
+
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// inline function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+inline size_t AUDIOFFT::get_length() const
+{
+    return m_length;
+}
+
+inline const float *AUDIOFFT::get_window() const
+{
+    return &m_window[0];
+}
+
+inline float AUDIOFFT::get_window_power() const
+{
+    return m_window_power;
+}
+
+#endif
+
@@ -105,6 +105,20 @@ void AUDIOSigned16BitFormatter::format_samples(uint8_t *raw_buffer_p, AUDIOChann
     LOG_GENERATE_TRACE(g_logger, "AUDIOSigned16BitFormatter::format_sample exit");
 }
 
+void AUDIOSigned16BitFormatter::format_fixed_samples(uint8_t *raw_buffer_p, AUDIOChannel::Index index, AUDIOChannel::Fixed *sample_buffer_p, size_t num_samples)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOSigned16BitFormatter::format_fixed_samples enter this=%p raw_buffer_p=%p index=%d sample_buffer_p=%p num_samples=%d", this, raw_buffer_p, index, sample_buffer_p, num_samples);
+
+    for (int counter = 0; counter < num_samples; counter++)
+    {
+        int16_t sample = ((int16_t *)raw_buffer_p)[(2 * counter) + index];
+        // Q15 to Q31 is just a shift up
+        sample_buffer_p[counter] = ((AUDIOChannel::Fixed)sample) * (1 << 16);
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOSigned16BitFormatter::format_fixed_samples exit");
+}
+
 AUDIOSigned32BitFormatter::AUDIOSigned32BitFormatter()
 {
     LOG_GENERATE_TRACE(g_logger, "AUDIOSigned32BitFormatter::AUDIOSigned32BitFormatter enter this=%p", this);
@@ -130,6 +144,19 @@ void AUDIOSigned32BitFormatter::format_samples(uint8_t *raw_buffer_p, AUDIOChann
     LOG_GENERATE_TRACE(g_logger, "AUDIOSigned16BitFormatter::format_sample exit");
 }
 
+void AUDIOSigned32BitFormatter::format_fixed_samples(uint8_t *raw_buffer_p, AUDIOChannel::Index index, AUDIOChannel::Fixed *sample_buffer_p, size_t num_samples)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOSigned32BitFormatter::format_fixed_samples enter this=%p raw_buffer_p=%p index=%d sample_buffer_p=%p num_samples=%d", this, raw_buffer_p, index, sample_buffer_p, num_samples);
+
+    for (int counter = 0; counter < num_samples; counter++)
+    {
+        // the device already hands us Q31
+        sample_buffer_p[counter] = ((int32_t *)raw_buffer_p)[(2 * counter) + index];
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOSigned32BitFormatter::format_fixed_samples exit");
+}
+
 AUDIOFloatFormatter::AUDIOFloatFormatter()
 {
     LOG_GENERATE_TRACE(g_logger, "AUDIOFloatFormatter::AUDIOFloatFormatter enter this=%p", this);
@@ -155,6 +182,19 @@ void AUDIOFloatFormatter::format_samples(uint8_t *raw_buffer_p, AUDIOChannel::In
     LOG_GENERATE_TRACE(g_logger, "AUDIOSigned16BitFormatter::format_sample exit");
 }
 
+void AUDIOFloatFormatter::format_fixed_samples(uint8_t *raw_buffer_p, AUDIOChannel::Index index, AUDIOChannel::Fixed *sample_buffer_p, size_t num_samples)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOFloatFormatter::format_fixed_samples enter this=%p raw_buffer_p=%p index=%d sample_buffer_p=%p num_samples=%d", this, raw_buffer_p, index, sample_buffer_p, num_samples);
+
+    for (int counter = 0; counter < num_samples; counter++)
+    {
+        float sample = ((float *)raw_buffer_p)[(2 * counter) + index];
+        sample_buffer_p[counter] = AUDIOChannel::to_fixed(sample);
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOFloatFormatter::format_fixed_samples exit");
+}
+
 
 ///////////////////////////////////////////////////////////////////////////////
 // protected function implementations
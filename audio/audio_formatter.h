@@ -42,7 +42,10 @@ public:
 
     virtual const snd_pcm_format_t format() = 0;
     virtual void format_samples(uint8_t *raw_buffer_p, AUDIOChannel::Index index, AUDIOChannel::Sample *sample_buffer_p, size_t num_samples) = 0;
+    virtual void format_fixed_samples(uint8_t *raw_buffer_p, AUDIOChannel::Index index, AUDIOChannel::Fixed *sample_buffer_p, size_t num_samples) = 0;
     virtual const size_t sample_sizeof() = 0;
+    // the largest level the format can carry once normalised
+    virtual const AUDIOChannel::Sample fullscale_level() = 0;
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -114,11 +117,17 @@ public:
     }
 
     void format_samples(uint8_t *raw_buffer_p, AUDIOChannel::Index index, AUDIOChannel::Sample *sample_buffer_p, size_t num_samples);
+    void format_fixed_samples(uint8_t *raw_buffer_p, AUDIOChannel::Index index, AUDIOChannel::Fixed *sample_buffer_p, size_t num_samples);
 
     const size_t sample_sizeof()
     {
         return sizeof(int16_t);
     }
+
+    const AUDIOChannel::Sample fullscale_level()
+    {
+        return (AUDIOChannel::Sample)(32767.0 / 32768.0);
+    }
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -148,11 +157,17 @@ public:
     }
 
     void format_samples(uint8_t *raw_buffer_p, AUDIOChannel::Index index, AUDIOChannel::Sample *sample_buffer_p, size_t num_samples);
+    void format_fixed_samples(uint8_t *raw_buffer_p, AUDIOChannel::Index index, AUDIOChannel::Fixed *sample_buffer_p, size_t num_samples);
 
     const size_t sample_sizeof()
     {
         return sizeof(int32_t);
     }
+
+    const AUDIOChannel::Sample fullscale_level()
+    {
+        return (AUDIOChannel::Sample)(2147483647.0 / 2147483648.0);
+    }
 };
 
 class AUDIOFloatFormatter : public AUDIOFormatter
@@ -178,11 +193,17 @@ public:
     }
 
     void format_samples(uint8_t *raw_buffer_p, AUDIOChannel::Index index, AUDIOChannel::Sample *sample_buffer_p, size_t num_samples);
+    void format_fixed_samples(uint8_t *raw_buffer_p, AUDIOChannel::Index index, AUDIOChannel::Fixed *sample_buffer_p, size_t num_samples);
 
     const size_t sample_sizeof()
     {
         return sizeof(float);
     }
+
+    const AUDIOChannel::Sample fullscale_level()
+    {
+        return AUDIO_CHANNEL_FULL_SCALE_LEVEL;
+    }
 };
 
 
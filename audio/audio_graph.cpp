@@ -0,0 +1,996 @@
+
+#include "audio_graph.h"
+#include "audio_weighting.h"
+#include "audio_decimator.h"
+#include "log.h"
+
+#include <string.h>
+#include <algorithm>
+#include <typeinfo>
+#ifdef __ARM_NEON__
+#include <arm_neon.h>
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// type defintions
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// constants
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// module variables
+///////////////////////////////////////////////////////////////////////////////
+
+static LogInstance g_logger("audio.graph");
+
+///////////////////////////////////////////////////////////////////////////////
+// private function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+static AUDIOChannel::Index find_root(std::map<AUDIOChannel::Index, AUDIOChannel::Index> &roots_map, AUDIOChannel::Index index);
+static void mix_samples(AUDIOChannel::Sample *output_p, const AUDIOChannel::Sample *input_p, float gain, size_t length);
+
+///////////////////////////////////////////////////////////////////////////////
+// public function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+AUDIOGraph::AUDIOGraph(AUDIOWorkerPool *pool_p) :
+    m_node_count(0),
+    m_cost(0),
+    m_buffer_count(0),
+    m_buffer_length(0),
+    m_mixer_length(0),
+    m_pool_p(pool_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGraph::AUDIOGraph enter this=%p pool_p=%p", this, pool_p);
+
+    // the loop runs the schedules itself without a pool, otherwise each worker needs its own scratch space
+    m_buffers.resize((NULL == m_pool_p) ? 1 : std::max((size_t)1, m_pool_p->get_worker_count()));
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGraph::AUDIOGraph exit");
+}
+
+AUDIOGraph::~AUDIOGraph()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGraph::~AUDIOGraph enter this=%p", this);
+
+    // nothing can still be running against the filters + meters
+    wait();
+
+    // release the strands
+    for (std::vector<Strand *>::iterator it = m_strands.begin();
+            it != m_strands.end();
+            it++)
+    {
+        delete *it;
+    }
+
+    // release the weighting filters
+    for (std::map<FilterKey, AUDIOWeightingFilter *>::iterator it = m_filters_map.begin();
+            it != m_filters_map.end();
+            it++)
+    {
+        delete it->second;
+    }
+
+    // release the decimators
+    for (std::map<DecimatorKey, AUDIODecimator *>::iterator it = m_decimators_map.begin();
+            it != m_decimators_map.end();
+            it++)
+    {
+        delete it->second;
+    }
+
+    // release the mixers
+    for (std::map<AUDIOChannel::Index, Mixer *>::iterator it = m_mixers_map.begin();
+            it != m_mixers_map.end();
+            it++)
+    {
+        delete it->second;
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGraph::~AUDIOGraph exit");
+}
+
+void AUDIOGraph::build(const Description &description)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGraph::build enter this=%p meters=%d linked=%d mixers=%d sinks=%d", this, description.meters.size(), description.linkedMeters.size(), description.mixers.size(), description.sinks.size());
+
+    // the old schedules have to be finished with before anything is swapped out
+    wait();
+
+    // every channel a meter reads from is a source, its own meters go ahead of any linked ones
+    std::multimap<AUDIOChannel::Index, std::pair<AUDIOProcessor::Meter *, bool> > consumers_map;
+    std::map<AUDIOChannel::Index, const AUDIOChannel *> channels_map;
+    for (std::multimap<AUDIOChannel::Index, AUDIOProcessor::Meter *>::const_iterator it = description.meters.begin();
+            it != description.meters.end();
+            it++)
+    {
+        consumers_map.insert(std::make_pair(it->first, std::make_pair(it->second, false)));
+        channels_map[it->first] = it->second->get_channel_p();
+    }
+    for (std::multimap<AUDIOChannel::Index, AUDIOProcessor::Meter *>::const_iterator it = description.linkedMeters.begin();
+            it != description.linkedMeters.end();
+            it++)
+    {
+        consumers_map.insert(std::make_pair(it->first, std::make_pair(it->second, true)));
+        const std::vector<AUDIOChannel *> &linked_channels = it->second->get_linked_channels();
+        for (std::vector<AUDIOChannel *>::const_iterator link_it = linked_channels.begin();
+                link_it != linked_channels.end();
+                link_it++)
+        {
+            if ((it->first == (*link_it)->get_index()) && (channels_map.end() == channels_map.find(it->first)))
+            {
+                channels_map[it->first] = *link_it;
+            }
+        }
+    }
+
+    // a mix can only take in captured channels + the mixes described before it, which keeps the graph acyclic
+    std::set<AUDIOChannel::Index> mixed_channels;
+    for (std::vector<MixerDescription>::const_iterator it = description.mixers.begin();
+            it != description.mixers.end();
+            it++)
+    {
+        mixed_channels.insert(it->channel_p->get_index());
+    }
+    std::map<AUDIOChannel::Index, Mixer *> mixers_map;
+    std::map<AUDIOChannel::Index, size_t> depths_map;
+    size_t mixer_length = 0;
+    for (std::vector<MixerDescription>::const_iterator it = description.mixers.begin();
+            it != description.mixers.end();
+            it++)
+    {
+        const AUDIOChannel::Index index = it->channel_p->get_index();
+        bool acyclic = (mixers_map.end() == mixers_map.find(index)) && (false == it->inputs.empty());
+        size_t depth = 1;
+        for (std::vector<MixerInput>::const_iterator input_it = it->inputs.begin();
+                (true == acyclic) && (input_it != it->inputs.end());
+                input_it++)
+        {
+            const AUDIOChannel::Index input = input_it->channel_p->get_index();
+            if (0 != mixed_channels.count(input))
+            {
+                std::map<AUDIOChannel::Index, size_t>::const_iterator depth_it = depths_map.find(input);
+                acyclic = (depths_map.end() != depth_it);
+                depth = (true == acyclic) ? std::max(depth, depth_it->second + 1) : depth;
+            }
+        }
+        if (false == acyclic)
+        {
+            LOG_GENERATE_ERROR(g_logger, "leaving out the mix for channel=%d, it has no inputs or takes in itself or a later mix", index);
+            continue;
+        }
+        depths_map[index] = depth;
+
+        // carry the mixer over if it still sums the same channels, the new gains take over from the next block
+        const size_t capacity = std::max((size_t)1, it->pendingLength);
+        Mixer *mixer_p = NULL;
+        std::map<AUDIOChannel::Index, Mixer *>::iterator mixer_it = m_mixers_map.find(index);
+        if ((m_mixers_map.end() != mixer_it) && (mixer_it->second->ring.size() == capacity) && (mixer_it->second->inputs.size() == it->inputs.size()))
+        {
+            mixer_p = mixer_it->second;
+            for (size_t term = 0; term < it->inputs.size(); term++)
+            {
+                if (mixer_p->inputs[term].channel_p != it->inputs[term].channel_p)
+                {
+                    mixer_p = NULL;
+                    break;
+                }
+            }
+        }
+        if (NULL != mixer_p)
+        {
+            m_mixers_map.erase(mixer_it);
+        }
+        else
+        {
+            mixer_p = new Mixer;
+            mixer_p->positions.assign(it->inputs.size(), 0);
+            mixer_p->ring.assign(capacity, AUDIO_CHANNEL_ZERO_LEVEL);
+            mixer_p->position = 0;
+        }
+        mixer_p->channel_p = it->channel_p;
+        mixer_p->inputs = it->inputs;
+        mixers_map[index] = mixer_p;
+        mixer_length += capacity;
+
+        // the mix + each of its inputs are sources as well
+        channels_map[index] = it->channel_p;
+        for (std::vector<MixerInput>::const_iterator input_it = it->inputs.begin();
+                input_it != it->inputs.end();
+                input_it++)
+        {
+            channels_map[input_it->channel_p->get_index()] = input_it->channel_p;
+        }
+    }
+    for (std::vector<SinkDescription>::const_iterator it = description.sinks.begin();
+            it != description.sinks.end();
+            it++)
+    {
+        channels_map[it->channel_p->get_index()] = it->channel_p;
+    }
+
+    std::map<AUDIOChannel::Index, Schedule> schedules_map;
+    std::set<AUDIOChannel::Index> sample_channels;
+    std::map<FilterKey, AUDIOWeightingFilter *> filters_map;
+    std::map<DecimatorKey, AUDIODecimator *> decimators_map;
+    std::vector<size_t> level_counts;
+    size_t node_count = 0;
+    unsigned int cost = 0;
+    size_t buffer_length = 0;
+    for (std::map<AUDIOChannel::Index, const AUDIOChannel *>::const_iterator channel_it = channels_map.begin();
+            channel_it != channels_map.end();
+            channel_it++)
+    {
+        const AUDIOChannel::Index index = channel_it->first;
+        const AUDIOChannel *channel_p = channel_it->second;
+
+        // the nodes go in as they're first needed, the source is always node zero + on a mix it's the mixer's output
+        std::map<AUDIOChannel::Index, Mixer *>::const_iterator mixer_it = mixers_map.find(index);
+        Mixer *source_mixer_p = (mixers_map.end() != mixer_it) ? mixer_it->second : NULL;
+        Schedule nodes;
+        Node source = { NODE_TYPE_SOURCE, 0, GRAPH_NO_BUFFER, NULL, NULL, NULL, false, source_mixer_p, 0, NULL };
+        nodes.push_back(source);
+        std::map<DecimatorKey, size_t> producers_map;
+        std::pair<std::multimap<AUDIOChannel::Index, std::pair<AUDIOProcessor::Meter *, bool> >::iterator, std::multimap<AUDIOChannel::Index, std::pair<AUDIOProcessor::Meter *, bool> >::iterator> range = consumers_map.equal_range(index);
+        for (std::multimap<AUDIOChannel::Index, std::pair<AUDIOProcessor::Meter *, bool> >::iterator it = range.first;
+                it != range.second;
+                it++)
+        {
+            AUDIOProcessor::Meter *meter_p = it->second.first;
+            cost += meter_p->get_cost();
+            const size_t input = find_producer(nodes, producers_map, channel_p, meter_p->get_weighting(), meter_p->get_decimation_stages(), filters_map, decimators_map);
+            Node node = { NODE_TYPE_METER, input, GRAPH_NO_BUFFER, NULL, NULL, meter_p, it->second.second, NULL, 0, NULL };
+            nodes.push_back(node);
+        }
+
+        // the sinks hand the block on before anything mixed from it goes out
+        for (std::vector<SinkDescription>::const_iterator it = description.sinks.begin();
+                it != description.sinks.end();
+                it++)
+        {
+            if (index == it->channel_p->get_index())
+            {
+                Node node = { NODE_TYPE_SINK, 0, GRAPH_NO_BUFFER, NULL, NULL, NULL, false, NULL, 0, it->sink_p };
+                nodes.push_back(node);
+            }
+        }
+
+        // a channel feeds a mix once for each time it turns up in it
+        for (std::map<AUDIOChannel::Index, Mixer *>::const_iterator it = mixers_map.begin();
+                it != mixers_map.end();
+                it++)
+        {
+            for (size_t term = 0; term < it->second->inputs.size(); term++)
+            {
+                if (index == it->second->inputs[term].channel_p->get_index())
+                {
+                    Node node = { NODE_TYPE_MIXER, 0, GRAPH_NO_BUFFER, NULL, NULL, NULL, false, it->second, term, NULL };
+                    nodes.push_back(node);
+                }
+            }
+        }
+
+        // depth first gives a topological order that lets each buffer go as early as possible
+        Schedule schedule;
+        std::vector<size_t> positions(nodes.size(), 0);
+        order_nodes(nodes, 0, schedule, positions);
+        const size_t depth = (NULL == source_mixer_p) ? 0 : depths_map[index];
+        if (level_counts.size() <= depth)
+        {
+            level_counts.resize(depth + 1, 0);
+        }
+        level_counts[depth] = std::max(level_counts[depth], allocate_buffers(schedule));
+        buffer_length = std::max(buffer_length, channel_p->get_maximum_block_length());
+        if (NULL != source_mixer_p)
+        {
+            buffer_length = std::max(buffer_length, source_mixer_p->ring.size());
+        }
+        node_count += schedule.size();
+        schedules_map[index] = schedule;
+
+        // filters, decimators, mixers, sinks + linked meters all read float, as do meters without an integer path
+        for (Schedule::const_iterator node_it = schedule.begin();
+                node_it != schedule.end();
+                node_it++)
+        {
+            if ((NODE_TYPE_WEIGHTING == node_it->type) || (NODE_TYPE_DECIMATOR == node_it->type) ||
+                    (NODE_TYPE_MIXER == node_it->type) || (NODE_TYPE_SINK == node_it->type) ||
+                    ((NODE_TYPE_METER == node_it->type) && ((true == node_it->linked) || (0 != node_it->input) || (false == node_it->meter_p->is_fixed_point()))))
+            {
+                sample_channels.insert(index);
+                break;
+            }
+        }
+    }
+
+    // a mix runs inside the schedule that completes it, so each depth of mixing gets buffers of its own after the one above
+    std::vector<size_t> level_bases(level_counts.size(), 0);
+    size_t buffer_count = 0;
+    for (size_t depth = 0; depth < level_counts.size(); depth++)
+    {
+        level_bases[depth] = buffer_count;
+        buffer_count += level_counts[depth];
+    }
+    for (std::map<AUDIOChannel::Index, Schedule>::iterator it = schedules_map.begin();
+            it != schedules_map.end();
+            it++)
+    {
+        const size_t base = (NULL == it->second[0].mixer_p) ? 0 : level_bases[depths_map[it->first]];
+        for (Schedule::iterator node_it = it->second.begin();
+                node_it != it->second.end();
+                node_it++)
+        {
+            if (GRAPH_NO_BUFFER != node_it->buffer)
+            {
+                node_it->buffer += (int)base;
+            }
+        }
+    }
+
+    // anything not carried over has stale history, so let it go
+    for (std::map<FilterKey, AUDIOWeightingFilter *>::iterator filter_it = m_filters_map.begin();
+            filter_it != m_filters_map.end();
+            filter_it++)
+    {
+        delete filter_it->second;
+    }
+    for (std::map<DecimatorKey, AUDIODecimator *>::iterator decimator_it = m_decimators_map.begin();
+            decimator_it != m_decimators_map.end();
+            decimator_it++)
+    {
+        delete decimator_it->second;
+    }
+    for (std::map<AUDIOChannel::Index, Mixer *>::iterator mixer_it = m_mixers_map.begin();
+            mixer_it != m_mixers_map.end();
+            mixer_it++)
+    {
+        delete mixer_it->second;
+    }
+    m_filters_map.swap(filters_map);
+    m_decimators_map.swap(decimators_map);
+    m_mixers_map.swap(mixers_map);
+    m_schedules_map.swap(schedules_map);
+    m_sample_channels.swap(sample_channels);
+    m_node_count = node_count;
+    m_cost = cost;
+    m_mixer_length = mixer_length;
+    resize_buffers(buffer_count, buffer_length);
+    for (std::map<DecimatorKey, AUDIODecimator *>::iterator decimator_it = m_decimators_map.begin();
+            decimator_it != m_decimators_map.end();
+            decimator_it++)
+    {
+        decimator_it->second->reserve(buffer_length);
+    }
+    build_strands();
+
+    LOG_GENERATE_INFO(g_logger, "graph built sources=%d mixers=%d nodes=%d cost=%d strands=%d buffers=%d footprint=%d", m_schedules_map.size(), m_mixers_map.size(), m_node_count, m_cost, m_strands.size(), m_buffer_count, get_footprint());
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGraph::build exit");
+}
+
+void AUDIOGraph::build(const std::multimap<AUDIOChannel::Index, AUDIOProcessor::Meter *> &meters_map, const std::multimap<AUDIOChannel::Index, AUDIOProcessor::Meter *> &linked_meters_map)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGraph::build enter this=%p meters=%d linked=%d", this, meters_map.size(), linked_meters_map.size());
+
+    // meters alone, the channels they read are all captured or mixed elsewhere
+    Description description;
+    description.meters = meters_map;
+    description.linkedMeters = linked_meters_map;
+    build(description);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGraph::build exit");
+}
+
+void AUDIOGraph::run(const AUDIOChannel *channel_p, uint64_t position, const size_t buffer_length, AUDIOChannel::Sample *buffer_p, const AUDIOChannel::Fixed *fixed_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGraph::run enter this=%p channel_p=%p position=%llu buffer_length=%d buffer_p=%p fixed_p=%p", this, channel_p, (unsigned long long)position, buffer_length, buffer_p, fixed_p);
+
+    // a mix only ever comes out of its mixer
+    std::map<AUDIOChannel::Index, Schedule>::iterator it = m_schedules_map.find(channel_p->get_index());
+    if ((m_schedules_map.end() == it) || (m_mixers_map.end() != m_mixers_map.find(channel_p->get_index())))
+    {
+        LOG_GENERATE_TRACE(g_logger, "AUDIOGraph::run exit nothing to do");
+        return;
+    }
+
+    if (NULL == m_pool_p)
+    {
+        run_schedule(it->second, channel_p, position, buffer_length, buffer_p, fixed_p, m_buffers[0]);
+    }
+    else
+    {
+        // the block waits on its strand, which only needs handing to the pool if it isn't already there
+        Strand *strand_p = m_strands_map[channel_p->get_index()];
+        if (true == strand_p->queue(channel_p, &it->second, position, buffer_length, buffer_p, fixed_p))
+        {
+            m_pool_p->submit(strand_p);
+        }
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGraph::run exit");
+}
+
+void AUDIOGraph::wait()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGraph::wait enter this=%p", this);
+
+    // once the pool is idle every block handed to run has been through its meters
+    if (NULL != m_pool_p)
+    {
+        m_pool_p->wait();
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGraph::wait exit");
+}
+
+bool AUDIOGraph::needs_samples(const AUDIOChannel *channel_p) const
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGraph::needs_samples enter this=%p channel_p=%p", this, channel_p);
+
+    bool needs = (0 != m_sample_channels.count(channel_p->get_index()));
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGraph::needs_samples exit needs=%d", needs);
+    return needs;
+}
+
+AUDIOGraph::Strand::Strand(AUDIOGraph *graph_p, unsigned int cost) :
+    m_graph_p(graph_p),
+    m_cost(cost),
+    m_scheduled(false)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGraph::Strand::Strand enter this=%p graph_p=%p cost=%d", this, graph_p, cost);
+
+    pthread_mutex_init(&m_mutex, NULL);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGraph::Strand::Strand exit");
+}
+
+AUDIOGraph::Strand::~Strand()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGraph::Strand::~Strand enter this=%p", this);
+
+    for (std::vector<Block *>::iterator it = m_spare.begin();
+            it != m_spare.end();
+            it++)
+    {
+        delete *it;
+    }
+    for (std::deque<Block *>::iterator it = m_pending.begin();
+            it != m_pending.end();
+            it++)
+    {
+        delete *it;
+    }
+    pthread_mutex_destroy(&m_mutex);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGraph::Strand::~Strand exit");
+}
+
+bool AUDIOGraph::Strand::queue(const AUDIOChannel *channel_p, Schedule *schedule_p, uint64_t position, const size_t buffer_length, const AUDIOChannel::Sample *buffer_p, const AUDIOChannel::Fixed *fixed_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGraph::Strand::queue enter this=%p channel_p=%p schedule_p=%p position=%llu buffer_length=%d buffer_p=%p fixed_p=%p", this, channel_p, schedule_p, (unsigned long long)position, buffer_length, buffer_p, fixed_p);
+
+    pthread_mutex_lock(&m_mutex);
+    Block *block_p = NULL;
+    if (true == m_spare.empty())
+    {
+        block_p = new Block;
+    }
+    else
+    {
+        block_p = m_spare.back();
+        m_spare.pop_back();
+    }
+    block_p->channel_p = channel_p;
+    block_p->schedule_p = schedule_p;
+    block_p->position = position;
+    block_p->samples.assign(buffer_p, buffer_p + buffer_length);
+    if (NULL != fixed_p)
+    {
+        block_p->fixed.assign(fixed_p, fixed_p + buffer_length);
+    }
+    else
+    {
+        block_p->fixed.clear();
+    }
+    m_pending.push_back(block_p);
+
+    // a strand that's already running picks the block up before it lets go
+    const bool submit = (false == m_scheduled);
+    m_scheduled = true;
+    pthread_mutex_unlock(&m_mutex);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGraph::Strand::queue exit submit=%d", submit);
+    return submit;
+}
+
+void AUDIOGraph::Strand::run(size_t worker)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGraph::Strand::run enter this=%p worker=%d", this, worker);
+
+    for (;;)
+    {
+        pthread_mutex_lock(&m_mutex);
+        if (true == m_pending.empty())
+        {
+            m_scheduled = false;
+            pthread_mutex_unlock(&m_mutex);
+            break;
+        }
+        Block *block_p = m_pending.front();
+        m_pending.pop_front();
+        pthread_mutex_unlock(&m_mutex);
+
+        const AUDIOChannel::Fixed *fixed_p = (true == block_p->fixed.empty()) ? NULL : &block_p->fixed[0];
+        m_graph_p->run_schedule(*block_p->schedule_p, block_p->channel_p, block_p->position, block_p->samples.size(), &block_p->samples[0], fixed_p, m_graph_p->m_buffers[worker]);
+
+        pthread_mutex_lock(&m_mutex);
+        m_spare.push_back(block_p);
+        pthread_mutex_unlock(&m_mutex);
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGraph::Strand::run exit");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// private function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+void AUDIOGraph::run_schedule(Schedule &schedule, const AUDIOChannel *channel_p, uint64_t position, const size_t buffer_length, AUDIOChannel::Sample *buffer_p, const AUDIOChannel::Fixed *fixed_p, Buffers &buffers)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGraph::run_schedule enter this=%p channel_p=%p position=%llu buffer_length=%d buffer_p=%p fixed_p=%p", this, channel_p, (unsigned long long)position, buffer_length, buffer_p, fixed_p);
+
+    // the buffers are sized at build for the largest block, anything bigger is taken in pieces
+    if ((false == buffers.empty()) && (buffers[0].size() < buffer_length))
+    {
+        const size_t chunk_length = buffers[0].size();
+        for (size_t offset = 0; offset < buffer_length; offset += chunk_length)
+        {
+            run_schedule(schedule, channel_p, position + offset, std::min(chunk_length, buffer_length - offset),
+                    buffer_p + offset, (NULL != fixed_p) ? (fixed_p + offset) : NULL, buffers);
+        }
+
+        LOG_GENERATE_TRACE(g_logger, "AUDIOGraph::run_schedule exit");
+        return;
+    }
+
+    // the source block is only ever read, everything else lands in the pool
+    AUDIOChannel::Sample *samples_p[schedule.size()];
+    size_t lengths[schedule.size()];
+    for (size_t counter = 0; counter < schedule.size(); counter++)
+    {
+        Node &node = schedule[counter];
+        switch (node.type)
+        {
+            case NODE_TYPE_SOURCE:
+                samples_p[counter] = buffer_p;
+                lengths[counter] = buffer_length;
+                break;
+
+            case NODE_TYPE_WEIGHTING:
+                samples_p[counter] = &buffers[node.buffer][0];
+                lengths[counter] = lengths[node.input];
+                node.filter_p->process(lengths[node.input], samples_p[node.input], samples_p[counter]);
+                break;
+
+            case NODE_TYPE_DECIMATOR:
+                samples_p[counter] = &buffers[node.buffer][0];
+                lengths[counter] = node.decimator_p->process(lengths[node.input], samples_p[node.input], samples_p[counter]);
+                break;
+
+            case NODE_TYPE_METER:
+                // meters pairing channels line them up by where the block sits in the capture
+                node.meter_p->set_block_position(position);
+                if (true == node.linked)
+                {
+                    node.meter_p->process_linked_samples(channel_p, lengths[node.input], samples_p[node.input]);
+                }
+                else if ((NULL != fixed_p) && (0 == node.input) && (true == node.meter_p->is_fixed_point()))
+                {
+                    // the raw channel is there in Q31 as well for meters that can take it
+                    node.meter_p->process_fixed_samples(buffer_length, fixed_p);
+                }
+                else
+                {
+                    node.meter_p->process_samples(lengths[node.input], samples_p[node.input]);
+                }
+                break;
+
+            case NODE_TYPE_MIXER:
+                mix_input(*node.mixer_p, node.term, lengths[node.input], samples_p[node.input], buffers);
+                break;
+
+            case NODE_TYPE_SINK:
+                node.sink_p->handle_graph_samples(channel_p, position, lengths[node.input], samples_p[node.input]);
+                break;
+        }
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGraph::run_schedule exit");
+}
+
+size_t AUDIOGraph::find_producer(Schedule &nodes, std::map<DecimatorKey, size_t> &producers_map, const AUDIOChannel *channel_p, AUDIOProcessor::Weighting weighting, unsigned int stages, std::map<FilterKey, AUDIOWeightingFilter *> &filters_map, std::map<DecimatorKey, AUDIODecimator *> &decimators_map)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGraph::find_producer enter this=%p channel_p=%p weighting=%d stages=%d", this, channel_p, weighting, stages);
+
+    // each weighting + rate is produced once however many meters read it
+    const DecimatorKey key(FilterKey(channel_p->get_index(), weighting), stages);
+    std::map<DecimatorKey, size_t>::iterator it = producers_map.find(key);
+    if (producers_map.end() != it)
+    {
+        LOG_GENERATE_TRACE(g_logger, "AUDIOGraph::find_producer exit index=%d", it->second);
+        return it->second;
+    }
+
+    // flat weighting at the full rate is the source itself
+    if ((0 == stages) && (AUDIOProcessor::WEIGHTING_Z == weighting))
+    {
+        producers_map[key] = 0;
+        LOG_GENERATE_TRACE(g_logger, "AUDIOGraph::find_producer exit index=0");
+        return 0;
+    }
+
+    Node node = { NODE_TYPE_WEIGHTING, 0, GRAPH_NO_BUFFER, NULL, NULL, NULL, false, NULL, 0, NULL };
+    if (0 == stages)
+    {
+        // carry the filter over from the last build if it was already running
+        std::map<FilterKey, AUDIOWeightingFilter *>::iterator filter_it = m_filters_map.find(key.first);
+        if (m_filters_map.end() != filter_it)
+        {
+            node.filter_p = filter_it->second;
+            m_filters_map.erase(filter_it);
+        }
+        else
+        {
+            node.filter_p = new AUDIOWeightingFilter(weighting, channel_p->get_sample_rate());
+        }
+        filters_map[key.first] = node.filter_p;
+    }
+    else
+    {
+        // each stage halves the one before it so a 12kHz meter shares the 24kHz work
+        node.type = NODE_TYPE_DECIMATOR;
+        node.input = find_producer(nodes, producers_map, channel_p, weighting, stages - 1, filters_map, decimators_map);
+        std::map<DecimatorKey, AUDIODecimator *>::iterator decimator_it = m_decimators_map.find(key);
+        if (m_decimators_map.end() != decimator_it)
+        {
+            node.decimator_p = decimator_it->second;
+            m_decimators_map.erase(decimator_it);
+        }
+        else
+        {
+            node.decimator_p = new AUDIODecimator();
+        }
+        decimators_map[key] = node.decimator_p;
+    }
+    nodes.push_back(node);
+    const size_t index = nodes.size() - 1;
+    producers_map[key] = index;
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGraph::find_producer exit index=%d", index);
+    return index;
+}
+
+void AUDIOGraph::order_nodes(const Schedule &nodes, size_t index, Schedule &schedule, std::vector<size_t> &positions) const
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGraph::order_nodes enter this=%p index=%d", this, index);
+
+    // the input has always been placed already, so point at where it ended up
+    Node node = nodes[index];
+    node.input = positions[node.input];
+    positions[index] = schedule.size();
+    schedule.push_back(node);
+
+    // the meters reading this node go straight after it, one class at a time so its code stays hot
+    std::vector<std::pair<std::pair<int, std::string>, size_t> > meters;
+    for (size_t counter = 1; counter < nodes.size(); counter++)
+    {
+        if ((NODE_TYPE_METER == nodes[counter].type) && (index == nodes[counter].input))
+        {
+            AUDIOProcessor::Meter *meter_p = nodes[counter].meter_p;
+            meters.push_back(std::make_pair(std::make_pair((int)meter_p->get_level_type(), std::string(typeid(*meter_p).name())), counter));
+        }
+    }
+    std::sort(meters.begin(), meters.end());
+    for (std::vector<std::pair<std::pair<int, std::string>, size_t> >::iterator it = meters.begin();
+            it != meters.end();
+            it++)
+    {
+        order_nodes(nodes, it->second, schedule, positions);
+    }
+
+    // then each branch in turn
+    for (size_t counter = 1; counter < nodes.size(); counter++)
+    {
+        if ((NODE_TYPE_METER != nodes[counter].type) && (index == nodes[counter].input))
+        {
+            order_nodes(nodes, counter, schedule, positions);
+        }
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGraph::order_nodes exit");
+}
+
+size_t AUDIOGraph::allocate_buffers(Schedule &schedule) const
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGraph::allocate_buffers enter this=%p nodes=%d", this, schedule.size());
+
+    // a buffer is live from the node that writes it to the last node that reads it
+    std::vector<size_t> last_use(schedule.size(), 0);
+    for (size_t counter = 1; counter < schedule.size(); counter++)
+    {
+        last_use[schedule[counter].input] = counter;
+    }
+
+    // the output is taken before the input is handed back, so a node never reads + writes the same buffer
+    std::vector<bool> in_use;
+    for (size_t counter = 0; counter < schedule.size(); counter++)
+    {
+        Node &node = schedule[counter];
+        // a mix's source is written by its mixer, a captured one is the block itself
+        if ((NODE_TYPE_WEIGHTING == node.type) || (NODE_TYPE_DECIMATOR == node.type) || ((NODE_TYPE_SOURCE == node.type) && (NULL != node.mixer_p)))
+        {
+            std::vector<bool>::iterator free_it = std::find(in_use.begin(), in_use.end(), false);
+            node.buffer = (int)(free_it - in_use.begin());
+            if (in_use.end() == free_it)
+            {
+                in_use.push_back(true);
+            }
+            else
+            {
+                *free_it = true;
+            }
+        }
+        if ((0 < counter) && (counter == last_use[node.input]) && (GRAPH_NO_BUFFER != schedule[node.input].buffer))
+        {
+            in_use[schedule[node.input].buffer] = false;
+        }
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGraph::allocate_buffers exit count=%d", in_use.size());
+    return in_use.size();
+}
+
+void AUDIOGraph::mix_input(Mixer &mixer, size_t term, const size_t buffer_length, const AUDIOChannel::Sample *buffer_p, Buffers &buffers)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGraph::mix_input enter this=%p mixer=%p term=%d buffer_length=%d buffer_p=%p", this, &mixer, term, buffer_length, buffer_p);
+
+    const size_t capacity = mixer.ring.size();
+    uint64_t &position = mixer.positions[term];
+
+    // if another input has stalled send the oldest samples on without it
+    if ((position + buffer_length) > (mixer.position + capacity))
+    {
+        size_t count = (size_t)((position + buffer_length) - (mixer.position + capacity));
+        LOG_GENERATE_WARN(g_logger, "sending %d samples without all inputs for channel=%d", count, mixer.channel_p->get_index());
+        flush_mixer(mixer, count, buffers);
+    }
+
+    // skip anything that has already gone out
+    size_t skip = 0;
+    if (position < mixer.position)
+    {
+        skip = (size_t)std::min(mixer.position - position, (uint64_t)buffer_length);
+    }
+
+    // the ring can wrap once inside the block
+    size_t offset = skip;
+    while (offset < buffer_length)
+    {
+        const size_t slot = (size_t)((position + offset) % capacity);
+        const size_t count = std::min(buffer_length - offset, capacity - slot);
+        mix_samples(&mixer.ring[slot], &buffer_p[offset], mixer.inputs[term].gain, count);
+        offset += count;
+    }
+    position += buffer_length;
+
+    // send on everything every input has contributed to
+    const uint64_t reached = *std::min_element(mixer.positions.begin(), mixer.positions.end());
+    if (reached > mixer.position)
+    {
+        flush_mixer(mixer, (size_t)(reached - mixer.position), buffers);
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGraph::mix_input exit");
+}
+
+void AUDIOGraph::flush_mixer(Mixer &mixer, size_t count, Buffers &buffers)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGraph::flush_mixer enter this=%p mixer=%p count=%d", this, &mixer, count);
+
+    // the mix lands in its source's buffer, which is a depth below any the calling schedule still has live
+    Schedule &schedule = m_schedules_map[mixer.channel_p->get_index()];
+    AUDIOChannel::Sample *output_p = &buffers[schedule[0].buffer][0];
+    const size_t capacity = mixer.ring.size();
+
+    // copy the oldest samples out + clear their slots for reuse
+    size_t offset = 0;
+    while (offset < count)
+    {
+        const size_t slot = (size_t)((mixer.position + offset) % capacity);
+        const size_t length = std::min(count - offset, capacity - slot);
+        memcpy(&output_p[offset], &mixer.ring[slot], length * sizeof(AUDIOChannel::Sample));
+        memset(&mixer.ring[slot], 0, length * sizeof(AUDIOChannel::Sample));
+        offset += length;
+    }
+    const uint64_t position = mixer.position;
+    mixer.position += count;
+
+    // the mix goes through its own nodes exactly like a captured block
+    run_schedule(schedule, mixer.channel_p, position, count, output_p, NULL, buffers);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGraph::flush_mixer exit");
+}
+
+void AUDIOGraph::resize_buffers(size_t buffer_count, size_t buffer_length)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGraph::resize_buffers enter this=%p buffer_count=%d buffer_length=%d", this, buffer_count, buffer_length);
+
+    for (std::vector<Buffers>::iterator it = m_buffers.begin();
+            it != m_buffers.end();
+            it++)
+    {
+        it->resize(buffer_count);
+        for (size_t counter = 0; counter < buffer_count; counter++)
+        {
+            (*it)[counter].resize(buffer_length);
+        }
+    }
+    m_buffer_count = buffer_count;
+    m_buffer_length = buffer_length;
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGraph::resize_buffers exit");
+}
+
+void AUDIOGraph::build_strands()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGraph::build_strands enter this=%p", this);
+
+    // the pool has drained so nothing is left pending on the old strands
+    for (std::vector<Strand *>::iterator it = m_strands.begin();
+            it != m_strands.end();
+            it++)
+    {
+        delete *it;
+    }
+    m_strands.clear();
+    m_strands_map.clear();
+
+    if (NULL == m_pool_p)
+    {
+        LOG_GENERATE_TRACE(g_logger, "AUDIOGraph::build_strands exit inline");
+        return;
+    }
+
+    // a linked meter joins the channel it reads to its own + a mixer its input to the mix, so they end up with the same root
+    std::map<AUDIOChannel::Index, AUDIOChannel::Index> roots_map;
+    for (std::map<AUDIOChannel::Index, Schedule>::const_iterator it = m_schedules_map.begin();
+            it != m_schedules_map.end();
+            it++)
+    {
+        roots_map[it->first] = it->first;
+    }
+    for (std::map<AUDIOChannel::Index, Schedule>::const_iterator it = m_schedules_map.begin();
+            it != m_schedules_map.end();
+            it++)
+    {
+        for (Schedule::const_iterator node_it = it->second.begin();
+                node_it != it->second.end();
+                node_it++)
+        {
+            AUDIOChannel::Index owner = it->first;
+            if ((NODE_TYPE_METER == node_it->type) && (true == node_it->linked))
+            {
+                owner = node_it->meter_p->get_channel_p()->get_index();
+            }
+            else if (NODE_TYPE_MIXER == node_it->type)
+            {
+                owner = node_it->mixer_p->channel_p->get_index();
+            }
+            if (owner != it->first)
+            {
+                if (roots_map.end() == roots_map.find(owner))
+                {
+                    roots_map[owner] = owner;
+                }
+                const AUDIOChannel::Index first = find_root(roots_map, it->first);
+                const AUDIOChannel::Index second = find_root(roots_map, owner);
+                if (first != second)
+                {
+                    roots_map[first] = second;
+                }
+            }
+        }
+    }
+
+    // each strand costs what its meters do, which is what the pool places it by
+    std::map<AUDIOChannel::Index, unsigned int> costs_map;
+    for (std::map<AUDIOChannel::Index, Schedule>::const_iterator it = m_schedules_map.begin();
+            it != m_schedules_map.end();
+            it++)
+    {
+        unsigned int &cost = costs_map[find_root(roots_map, it->first)];
+        for (Schedule::const_iterator node_it = it->second.begin();
+                node_it != it->second.end();
+                node_it++)
+        {
+            if (NODE_TYPE_METER == node_it->type)
+            {
+                cost += node_it->meter_p->get_cost();
+            }
+        }
+    }
+
+    std::map<AUDIOChannel::Index, Strand *> roots_strands_map;
+    for (std::map<AUDIOChannel::Index, unsigned int>::const_iterator it = costs_map.begin();
+            it != costs_map.end();
+            it++)
+    {
+        Strand *strand_p = new Strand(this, std::max(it->second, (unsigned int)METER_COST_DEFAULT));
+        m_strands.push_back(strand_p);
+        roots_strands_map[it->first] = strand_p;
+    }
+    for (std::map<AUDIOChannel::Index, Schedule>::const_iterator it = m_schedules_map.begin();
+            it != m_schedules_map.end();
+            it++)
+    {
+        m_strands_map[it->first] = roots_strands_map[find_root(roots_map, it->first)];
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGraph::build_strands exit strands=%d", m_strands.size());
+}
+
+static AUDIOChannel::Index find_root(std::map<AUDIOChannel::Index, AUDIOChannel::Index> &roots_map, AUDIOChannel::Index index)
+{
+    LOG_GENERATE_TRACE(g_logger, "find_root enter index=%d", index);
+
+    // point everything passed on the way straight at the root so the next look is shorter
+    AUDIOChannel::Index root = index;
+    while (roots_map[root] != root)
+    {
+        root = roots_map[root];
+    }
+    while (roots_map[index] != root)
+    {
+        const AUDIOChannel::Index next = roots_map[index];
+        roots_map[index] = root;
+        index = next;
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "find_root exit root=%d", root);
+    return root;
+}
+
+static void mix_samples(AUDIOChannel::Sample *output_p, const AUDIOChannel::Sample *input_p, float gain, size_t length)
+{
+    LOG_GENERATE_TRACE(g_logger, "mix_samples enter output_p=%p input_p=%p gain=%f length=%d", output_p, input_p, gain, length);
+
+    size_t counter = 0;
+#ifdef __ARM_NEON__
+    // four samples per multiply accumulate, the compiler won't vectorize float loops on its own
+    for (; (counter + 4) <= length; counter += 4)
+    {
+        float32x4_t output = vld1q_f32(&output_p[counter]);
+        output = vmlaq_n_f32(output, vld1q_f32(&input_p[counter]), gain);
+        vst1q_f32(&output_p[counter], output);
+    }
+#endif
+    for (; counter < length; counter++)
+    {
+        output_p[counter] += gain * input_p[counter];
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "mix_samples exit");
+}
+
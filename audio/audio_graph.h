@@ -0,0 +1,253 @@
+#ifndef _AUDIO_GRAPH_H_
+#define _AUDIO_GRAPH_H_
+
+#include "common.h"
+#include "audio_channel.h"
+#include "audio_processor.h"
+#include "audio_workerpool.h"
+
+#include <pthread.h>
+#include <deque>
+#include <map>
+#include <set>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+#define GRAPH_NO_BUFFER         (-1)
+
+///////////////////////////////////////////////////////////////////////////////
+// forward declarations
+///////////////////////////////////////////////////////////////////////////////
+
+class AUDIOWeightingFilter;
+class AUDIODecimator;
+
+///////////////////////////////////////////////////////////////////////////////
+// class definition
+///////////////////////////////////////////////////////////////////////////////
+
+class AUDIOGraph
+{
+    friend class Strand;
+
+///////////////////////////////////////////////////////////////////////////////
+// type definitions
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+
+    typedef enum
+    {
+        NODE_TYPE_SOURCE = 0,
+        NODE_TYPE_WEIGHTING = 1,
+        NODE_TYPE_DECIMATOR = 2,
+        NODE_TYPE_METER = 3,
+        NODE_TYPE_MIXER = 4,
+        NODE_TYPE_SINK = 5
+    } NodeType;
+
+    // what a schedule hands its channel's blocks on to once the meters have seen them
+    class Sink
+    {
+    public:
+        virtual void handle_graph_samples(const AUDIOChannel *channel_p, uint64_t position, const size_t buffer_length, AUDIOChannel::Sample *buffer_p) = 0;
+    };
+
+    // one term of a mix
+    typedef struct
+    {
+        const AUDIOChannel *channel_p;
+        float gain;
+    } MixerInput;
+
+    // a channel worked out as the weighted sum of others, it can take in the mixes described before it
+    typedef struct
+    {
+        const AUDIOChannel *channel_p;
+        std::vector<MixerInput> inputs;
+        // how far one input can run ahead of the others before the mix goes out without it
+        size_t pendingLength;
+    } MixerDescription;
+
+    typedef struct
+    {
+        const AUDIOChannel *channel_p;
+        Sink *sink_p;
+    } SinkDescription;
+
+    // everything the graph is built from, the meters read any channel, captured or mixed
+    typedef struct
+    {
+        std::multimap<AUDIOChannel::Index, AUDIOProcessor::Meter *> meters;
+        std::multimap<AUDIOChannel::Index, AUDIOProcessor::Meter *> linkedMeters;
+        std::vector<MixerDescription> mixers;
+        std::vector<SinkDescription> sinks;
+    } Description;
+
+private:
+
+    // the ring a mix is summed into, it carries the inputs' progress so it lives on across rebuilds like the filters
+    typedef struct
+    {
+        const AUDIOChannel *channel_p;
+        std::vector<MixerInput> inputs;
+        // sample position each input has reached
+        std::vector<uint64_t> positions;
+        // position is the sample position of the oldest slot
+        std::vector<AUDIOChannel::Sample> ring;
+        uint64_t position;
+    } Mixer;
+
+    typedef std::pair<AUDIOChannel::Index, AUDIOProcessor::Weighting> FilterKey;
+    typedef std::pair<FilterKey, unsigned int> DecimatorKey;
+
+    typedef struct
+    {
+        NodeType type;
+        // the node feeding this one, always earlier in the schedule
+        size_t input;
+        int buffer;
+        AUDIOWeightingFilter *filter_p;
+        AUDIODecimator *decimator_p;
+        AUDIOProcessor::Meter *meter_p;
+        bool linked;
+        // on a mixer the mix + which of its inputs this is, on a mix's source the mix it comes out of
+        Mixer *mixer_p;
+        size_t term;
+        Sink *sink_p;
+    } Node;
+
+    // one per source channel, in the order the nodes run
+    typedef std::vector<Node> Schedule;
+
+    // the scratch space a schedule runs in, one set per thread running schedules
+    typedef std::vector<std::vector<AUDIOChannel::Sample> > Buffers;
+
+    // the channels a linked meter reads from share one strand so their blocks run one at a time + in order
+    class Strand : public AUDIOWorkerPool::Task
+    {
+    public:
+        Strand(AUDIOGraph *graph_p, unsigned int cost);
+        virtual ~Strand();
+        bool queue(const AUDIOChannel *channel_p, Schedule *schedule_p, uint64_t position, const size_t buffer_length, const AUDIOChannel::Sample *buffer_p, const AUDIOChannel::Fixed *fixed_p);
+        void run(size_t worker);
+        inline unsigned int get_cost() const;
+    private:
+        // the capture buffer is gone once the read returns so each block is copied in
+        typedef struct
+        {
+            const AUDIOChannel *channel_p;
+            Schedule *schedule_p;
+            uint64_t position;
+            std::vector<AUDIOChannel::Sample> samples;
+            std::vector<AUDIOChannel::Fixed> fixed;
+        } Block;
+
+        AUDIOGraph *m_graph_p;
+        unsigned int m_cost;
+        pthread_mutex_t m_mutex;
+        std::deque<Block *> m_pending;
+        // blocks are reused rather than allocated every read
+        std::vector<Block *> m_spare;
+        // set from the submit until the strand runs out of blocks
+        bool m_scheduled;
+    };
+
+///////////////////////////////////////////////////////////////////////////////
+// public function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+    AUDIOGraph(AUDIOWorkerPool *pool_p = NULL);
+    virtual ~AUDIOGraph();
+
+    void build(const Description &description);
+    void build(const std::multimap<AUDIOChannel::Index, AUDIOProcessor::Meter *> &meters_map, const std::multimap<AUDIOChannel::Index, AUDIOProcessor::Meter *> &linked_meters_map);
+    void run(const AUDIOChannel *channel_p, uint64_t position, const size_t buffer_length, AUDIOChannel::Sample *buffer_p, const AUDIOChannel::Fixed *fixed_p = NULL);
+    void wait();
+    bool needs_samples(const AUDIOChannel *channel_p) const;
+
+    inline size_t get_node_count() const;
+    inline unsigned int get_cost() const;
+    inline size_t get_buffer_count() const;
+    inline size_t get_footprint() const;
+
+///////////////////////////////////////////////////////////////////////////////
+// private function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+    size_t find_producer(Schedule &nodes, std::map<DecimatorKey, size_t> &producers_map, const AUDIOChannel *channel_p, AUDIOProcessor::Weighting weighting, unsigned int stages, std::map<FilterKey, AUDIOWeightingFilter *> &filters_map, std::map<DecimatorKey, AUDIODecimator *> &decimators_map);
+    void order_nodes(const Schedule &nodes, size_t index, Schedule &schedule, std::vector<size_t> &positions) const;
+    void run_schedule(Schedule &schedule, const AUDIOChannel *channel_p, uint64_t position, const size_t buffer_length, AUDIOChannel::Sample *buffer_p, const AUDIOChannel::Fixed *fixed_p, Buffers &buffers);
+    size_t allocate_buffers(Schedule &schedule) const;
+    void mix_input(Mixer &mixer, size_t term, const size_t buffer_length, const AUDIOChannel::Sample *buffer_p, Buffers &buffers);
+    void flush_mixer(Mixer &mixer, size_t count, Buffers &buffers);
+    void resize_buffers(size_t buffer_count, size_t buffer_length);
+    void build_strands();
+
+///////////////////////////////////////////////////////////////////////////////
+// private variable definitions
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+    std::map<AUDIOChannel::Index, Schedule> m_schedules_map;
+    // the channels with a node that can't run from the Q31 block alone
+    std::set<AUDIOChannel::Index> m_sample_channels;
+    size_t m_node_count;
+    // the summed cost of every meter, one per simple peak meter
+    unsigned int m_cost;
+
+    // the filters + decimators carry history so they live on across rebuilds while still in use
+    std::map<FilterKey, AUDIOWeightingFilter *> m_filters_map;
+    std::map<DecimatorKey, AUDIODecimator *> m_decimators_map;
+    // keyed by the mix's channel
+    std::map<AUDIOChannel::Index, Mixer *> m_mixers_map;
+
+    // every schedule on a thread shares that thread's set, sized when the graph is built
+    std::vector<Buffers> m_buffers;
+    size_t m_buffer_count;
+    size_t m_buffer_length;
+    // every mixer's ring added up
+    size_t m_mixer_length;
+
+    // NULL when everything runs inline on the loop
+    AUDIOWorkerPool *m_pool_p;
+    std::vector<Strand *> m_strands;
+    std::map<AUDIOChannel::Index, Strand *> m_strands_map;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// inline function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+inline size_t AUDIOGraph::get_node_count() const
+{
+    return m_node_count;
+}
+
+inline unsigned int AUDIOGraph::get_cost() const
+{
+    return m_cost;
+}
+
+inline size_t AUDIOGraph::get_buffer_count() const
+{
+    return m_buffer_count;
+}
+
+inline size_t AUDIOGraph::get_footprint() const
+{
+    return ((m_buffers.size() * m_buffer_count * m_buffer_length) + m_mixer_length) * sizeof(AUDIOChannel::Sample);
+}
+
+inline unsigned int AUDIOGraph::Strand::get_cost() const
+{
+    return m_cost;
+}
+
+#endif
+
@@ -0,0 +1,337 @@
+
+#include "audio_groupmeter.h"
+#include "audio_decibels.h"
+#include "log.h"
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// type defintions
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// constants
+///////////////////////////////////////////////////////////////////////////////
+
+static const float c_zero_level_in_db = -96;
+
+///////////////////////////////////////////////////////////////////////////////
+// module variables
+///////////////////////////////////////////////////////////////////////////////
+
+static LogInstance g_logger("audio.groupmeter");
+
+///////////////////////////////////////////////////////////////////////////////
+// private function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// public function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+AUDIOGroupMeter::AUDIOGroupMeter(AUDIOChannel *channel_p, AUDIOProcessor::LevelType ballistics, AUDIOBallistics::Standard standard) :
+    AUDIOProcessor::PeakMeter(channel_p),
+    m_ballistics(ballistics),
+    m_rise_factor(1.0f),
+    m_fall_factor(1.0f),
+    m_member_count(0)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGroupMeter::AUDIOGroupMeter enter this=%p channel_p=%p ballistics=%d standard=%d", this, channel_p, ballistics, standard);
+
+    ASSERT((AUDIOProcessor::LEVEL_TYPE_PPM == ballistics) || (AUDIOProcessor::LEVEL_TYPE_DIGITALPEAK == ballistics));
+
+    // every member runs the same integrator so the group moves as one
+    if (AUDIOProcessor::LEVEL_TYPE_PPM == m_ballistics)
+    {
+        set_standard(standard);
+        m_rise_factor = get_coefficients().rise;
+        m_fall_factor = get_coefficients().fall;
+    }
+
+    memset(m_fullscale_voltages, 0, sizeof(m_fullscale_voltages));
+    memset(m_offsets_in_db, 0, sizeof(m_offsets_in_db));
+    memset(m_peaks, 0, sizeof(m_peaks));
+    memset(m_members, 0, sizeof(m_members));
+
+    // the lead channel is the first member
+    for (size_t member = 0; member < GROUP_MAXIMUM_CHANNELS; member++)
+    {
+        m_pending[member].channel_p = NULL;
+        m_pending[member].read_index = 0;
+        m_pending[member].count = 0;
+        m_pending[member].position = 0;
+    }
+    m_pending[0].channel_p = channel_p;
+    m_pending[0].samples.resize(CALC_NUM_SAMPLES_FOR_MILLIS(GROUP_PENDING_TIME_IN_MS, channel_p->get_sample_rate()));
+    m_fullscale_voltages[0] = channel_p->get_fullscale_voltage();
+    m_offsets_in_db[0] = calculate_offset_in_db(channel_p);
+    m_member_count = 1;
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGroupMeter::AUDIOGroupMeter exit");
+}
+
+AUDIOGroupMeter::~AUDIOGroupMeter()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGroupMeter::~AUDIOGroupMeter enter this=%p", this);
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGroupMeter::~AUDIOGroupMeter exit");
+}
+
+ResultCode AUDIOGroupMeter::add_channel(AUDIOChannel *channel_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGroupMeter::add_channel enter this=%p channel_p=%p", this, channel_p);
+
+    if (GROUP_MAXIMUM_CHANNELS <= m_member_count)
+    {
+        LOG_GENERATE_ERROR(g_logger, "group for channel=%d is full", get_channel_p()->get_index());
+        return RESULT_CODE_ERROR;
+    }
+
+    // the members are lined up by sample position so every channel must run at the same rate
+    if (channel_p->get_sample_rate() != get_channel_p()->get_sample_rate())
+    {
+        LOG_GENERATE_ERROR(g_logger, "channel=%d sample_rate=%d does not match sample_rate=%d", channel_p->get_index(), channel_p->get_sample_rate(), get_channel_p()->get_sample_rate());
+        return RESULT_CODE_ERROR;
+    }
+
+    // each channel can only be in the group once
+    for (size_t member = 0; member < m_member_count; member++)
+    {
+        if (m_pending[member].channel_p == channel_p)
+        {
+            LOG_GENERATE_ERROR(g_logger, "channel=%d is already part of the group", channel_p->get_index());
+            return RESULT_CODE_ERROR;
+        }
+    }
+
+    // store it + let the processor know we want its samples
+    m_pending[m_member_count].channel_p = channel_p;
+    m_pending[m_member_count].samples.resize(m_pending[0].samples.size());
+    m_fullscale_voltages[m_member_count] = channel_p->get_fullscale_voltage();
+    m_offsets_in_db[m_member_count] = calculate_offset_in_db(channel_p);
+    m_member_count++;
+    add_linked_channel(channel_p);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGroupMeter::add_channel exit");
+    return RESULT_CODE_OK;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// AUDIOProcessor::Meter implementation
+///////////////////////////////////////////////////////////////////////////////
+
+void AUDIOGroupMeter::process_samples(const size_t buffer_length, AUDIOChannel::Sample *buffer_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGroupMeter::process_samples enter this=%p buffer_length=%d buffer_p=%p", this, buffer_length, buffer_p);
+
+    queue_samples(m_pending[0], buffer_length, buffer_p);
+    process_frames();
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGroupMeter::process_samples exit");
+}
+
+void AUDIOGroupMeter::process_linked_samples(const AUDIOChannel *channel_p, const size_t buffer_length, AUDIOChannel::Sample *buffer_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGroupMeter::process_linked_samples enter this=%p channel_p=%p buffer_length=%d buffer_p=%p", this, channel_p, buffer_length, buffer_p);
+
+    for (size_t member = 1; member < m_member_count; member++)
+    {
+        if (m_pending[member].channel_p == channel_p)
+        {
+            queue_samples(m_pending[member], buffer_length, buffer_p);
+            process_frames();
+            break;
+        }
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGroupMeter::process_linked_samples exit");
+}
+
+AUDIOProcessor::ResultData AUDIOGroupMeter::create_result_data()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGroupMeter::create_result_data enter this=%p", this);
+    AUDIOProcessor::ResultData data = create_queued_result_data();
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGroupMeter::create_result_data exit");
+    return data;
+}
+
+void AUDIOGroupMeter::queue_result_data(AUDIOProcessor::ResultData &data, AUDIODecibels &decibels)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGroupMeter::queue_result_data enter this=%p data=%p decibels=%p", this, &data, &decibels);
+
+    memset(&data, 0, sizeof(data));
+
+    // populate the type
+    data.type = AUDIOProcessor::LEVEL_TYPE_GROUP;
+
+    // populate the channel
+    data.channel = get_channel_p()->get_index();
+
+    // the linked peak + hold are kept relative to the lead channel's full scale
+    data.values.group.ballistics = m_ballistics;
+    decibels.add(AUDIOProcessor::level_to_sample(get_peak()), m_offsets_in_db[0], c_zero_level_in_db, &data.values.group.peakInDB);
+    decibels.add(AUDIOProcessor::level_to_sample(get_hold()), m_offsets_in_db[0], c_zero_level_in_db, &data.values.group.holdInDB);
+
+    // the members stay owned by the meter, they're valid until the next result
+    for (size_t member = 0; member < m_member_count; member++)
+    {
+        m_members[member].channel = m_pending[member].channel_p->get_index();
+        decibels.add(m_peaks[member], m_offsets_in_db[member], c_zero_level_in_db, &m_members[member].peakInDB);
+    }
+    data.values.group.memberCount = m_member_count;
+    data.values.group.members_p = m_members;
+
+    LOG_GENERATE_DEBUG(g_logger, "group members=%d", m_member_count);
+
+    // digital peaks are only held until they've been reported
+    if (AUDIOProcessor::LEVEL_TYPE_DIGITALPEAK == m_ballistics)
+    {
+        memset(m_peaks, 0, sizeof(m_peaks));
+        set_peak(AUDIO_CHANNEL_ZERO_LEVEL);
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGroupMeter::queue_result_data exit");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// private function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+void AUDIOGroupMeter::queue_samples(Pending &pending, const size_t buffer_length, const AUDIOChannel::Sample *buffer_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGroupMeter::queue_samples enter this=%p pending=%p buffer_length=%d buffer_p=%p", this, &pending, buffer_length, buffer_p);
+
+    const size_t capacity = pending.samples.size();
+
+    // if another member has stalled drop our oldest samples, the positions keep the frames honest
+    if ((pending.count + buffer_length) > capacity)
+    {
+        size_t dropped = std::min(pending.count + buffer_length - capacity, pending.count);
+        LOG_GENERATE_WARN(g_logger, "dropping %d unmatched samples for channel=%d", dropped, pending.channel_p->get_index());
+        pending.read_index = (pending.read_index + dropped) % capacity;
+        pending.count -= dropped;
+        pending.position += dropped;
+    }
+
+    // only the newest samples fit if the block itself is bigger than the queue
+    size_t skip = 0;
+    if (buffer_length > capacity)
+    {
+        skip = buffer_length - capacity;
+        pending.position += skip;
+    }
+
+    for (size_t counter = skip; counter < buffer_length; counter++)
+    {
+        pending.samples[(pending.read_index + pending.count) % capacity] = buffer_p[counter];
+        pending.count++;
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGroupMeter::queue_samples exit");
+}
+
+void AUDIOGroupMeter::process_frames()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGroupMeter::process_frames enter this=%p", this);
+
+    // line up the sample positions if any member had to drop samples
+    uint64_t position = 0;
+    for (size_t member = 0; member < m_member_count; member++)
+    {
+        position = std::max(position, m_pending[member].position);
+    }
+    size_t frames = m_pending[0].samples.size();
+    for (size_t member = 0; member < m_member_count; member++)
+    {
+        Pending &pending = m_pending[member];
+        const size_t dropped = (size_t)std::min(position - pending.position, (uint64_t)pending.count);
+        pending.read_index = (pending.read_index + dropped) % pending.samples.size();
+        pending.count -= dropped;
+        pending.position += dropped;
+        frames = std::min(frames, pending.count);
+    }
+
+    // one pass over the frames with every member's detector side by side
+    const bool integrate = (AUDIOProcessor::LEVEL_TYPE_PPM == m_ballistics);
+    const size_t capacity = m_pending[0].samples.size();
+    float scales[GROUP_MAXIMUM_CHANNELS];
+    for (size_t member = 0; member < m_member_count; member++)
+    {
+        scales[member] = (true == integrate) ? (m_fullscale_voltages[member] / m_fullscale_voltages[0]) : 1.0f;
+    }
+    float linked_max = AUDIO_CHANNEL_ZERO_LEVEL;
+    float linked = AUDIO_CHANNEL_ZERO_LEVEL;
+    for (size_t frame = 0; frame < frames; frame++)
+    {
+        linked = AUDIO_CHANNEL_ZERO_LEVEL;
+        for (size_t member = 0; member < m_member_count; member++)
+        {
+            Pending &pending = m_pending[member];
+            size_t index = pending.read_index + frame;
+            if (index >= capacity)
+            {
+                index -= capacity;
+            }
+            const AUDIOChannel::Sample amplitude = fabsf(pending.samples[index]);
+            AUDIOChannel::Sample peak = m_peaks[member];
+            if (amplitude > peak)
+            {
+                peak += m_rise_factor * (amplitude - peak);
+            }
+            else if (true == integrate)
+            {
+                peak *= m_fall_factor;
+            }
+            m_peaks[member] = peak;
+            // the group follows whichever member is loudest, PPMs compare voltages + digital meters full scale
+            linked = std::max(linked, peak * scales[member]);
+        }
+        linked_max = std::max(linked_max, linked);
+    }
+    for (size_t member = 0; member < m_member_count; member++)
+    {
+        Pending &pending = m_pending[member];
+        pending.read_index = (pending.read_index + frames) % capacity;
+        pending.count -= frames;
+        pending.position += frames;
+    }
+
+    // the shared hold sees the highest point of the pass, the peak is left where the detector ended up
+    if (0 < frames)
+    {
+        if (true == integrate)
+        {
+            set_peak(AUDIOProcessor::sample_to_level(linked_max));
+            set_peak(AUDIOProcessor::sample_to_level(linked));
+        }
+        else
+        {
+            set_peak(std::max(get_peak(), AUDIOProcessor::sample_to_level(linked_max)));
+        }
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGroupMeter::process_frames exit frames=%d", frames);
+}
+
+float AUDIOGroupMeter::calculate_offset_in_db(const AUDIOChannel *channel_p) const
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGroupMeter::calculate_offset_in_db enter this=%p channel_p=%p", this, channel_p);
+
+    // PPMs read in dBu so the full scale voltage shifts them, digital meters read full scale as is
+    float offset_in_db = 0.0f;
+    if (AUDIOProcessor::LEVEL_TYPE_PPM == m_ballistics)
+    {
+        offset_in_db = 20.0f * log10f(channel_p->get_fullscale_voltage() / ZERO_DB_PEAK_VOLTAGE);
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOGroupMeter::calculate_offset_in_db exit offset_in_db=%f", offset_in_db);
+    return offset_in_db;
+}
@@ -0,0 +1,104 @@
+#ifndef _AUDIO_GROUPMETER_H_
+#define _AUDIO_GROUPMETER_H_
+
+#include "common.h"
+#include "audio_channel.h"
+#include "audio_processor.h"
+
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+// big enough for a 7.1 bus
+#define GROUP_MAXIMUM_CHANNELS          (8)
+#define GROUP_PENDING_TIME_IN_MS        (250)
+
+///////////////////////////////////////////////////////////////////////////////
+// forward declarations
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// class definition
+///////////////////////////////////////////////////////////////////////////////
+
+class AUDIOGroupMeter : public AUDIOProcessor::PeakMeter
+{
+
+///////////////////////////////////////////////////////////////////////////////
+// type definitions
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+
+    // samples waiting for the matching sample position on the other members
+    typedef struct
+    {
+        const AUDIOChannel *channel_p;
+        std::vector<AUDIOChannel::Sample> samples;
+        size_t read_index;
+        size_t count;
+        uint64_t position;
+    } Pending;
+
+///////////////////////////////////////////////////////////////////////////////
+// public function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+    AUDIOGroupMeter(AUDIOChannel *channel_p, AUDIOProcessor::LevelType ballistics, AUDIOBallistics::Standard standard = AUDIOBallistics::STANDARD_LEGACY);
+    virtual ~AUDIOGroupMeter();
+
+    ResultCode add_channel(AUDIOChannel *channel_p);
+
+///////////////////////////////////////////////////////////////////////////////
+// AUDIOProcessor::Meter declarations
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+    void process_samples(const size_t buffer_length, AUDIOChannel::Sample *buffer_p);
+    void process_linked_samples(const AUDIOChannel *channel_p, const size_t buffer_length, AUDIOChannel::Sample *buffer_p);
+    AUDIOProcessor::ResultData create_result_data();
+    void queue_result_data(AUDIOProcessor::ResultData &data, AUDIODecibels &decibels);
+    inline AUDIOProcessor::LevelType get_level_type();
+
+///////////////////////////////////////////////////////////////////////////////
+// private function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+    void queue_samples(Pending &pending, const size_t buffer_length, const AUDIOChannel::Sample *buffer_p);
+    void process_frames();
+    float calculate_offset_in_db(const AUDIOChannel *channel_p) const;
+
+///////////////////////////////////////////////////////////////////////////////
+// private variable definitions
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+    AUDIOProcessor::LevelType m_ballistics;
+    float m_rise_factor;
+    float m_fall_factor;
+    size_t m_member_count;
+
+    // per member state, the lead channel is always member zero
+    Pending m_pending[GROUP_MAXIMUM_CHANNELS];
+    float m_fullscale_voltages[GROUP_MAXIMUM_CHANNELS];
+    float m_offsets_in_db[GROUP_MAXIMUM_CHANNELS];
+    AUDIOChannel::Sample m_peaks[GROUP_MAXIMUM_CHANNELS];
+    AUDIOProcessor::GroupMemberData m_members[GROUP_MAXIMUM_CHANNELS];
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// inline function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+inline AUDIOProcessor::LevelType AUDIOGroupMeter::get_level_type()
+{
+    return AUDIOProcessor::LEVEL_TYPE_GROUP;
+}
+
+#endif
+
@@ -0,0 +1,205 @@
+
+#include "audio_histogrammeter.h"
+#include "log.h"
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+// the level distribution only needs the audio band so it can run decimated
+#define HISTOGRAM_BANDWIDTH             (20000)
+
+#define HISTOGRAM_SECONDS_PER_MINUTE    (60)
+#define HISTOGRAM_SECONDS_PER_HOUR      (60 * 60)
+#define HISTOGRAM_SECONDS_PER_DAY       (24 * 60 * 60)
+
+///////////////////////////////////////////////////////////////////////////////
+// type defintions
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// constants
+///////////////////////////////////////////////////////////////////////////////
+
+static const float c_zero_level_in_db = -96;
+
+///////////////////////////////////////////////////////////////////////////////
+// module variables
+///////////////////////////////////////////////////////////////////////////////
+
+static LogInstance g_logger("audio.histogrammeter");
+
+///////////////////////////////////////////////////////////////////////////////
+// private function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// public function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+AUDIOHistogramMeter::AUDIOHistogramMeter(AUDIOChannel *channel_p, Window window) :
+    AUDIOProcessor::Meter(channel_p, HISTOGRAM_BANDWIDTH),
+    m_window(window),
+    m_block_length(CALC_NUM_SAMPLES_FOR_MILLIS(HISTOGRAM_BLOCK_TIME_IN_MS, get_sample_rate())),
+    m_block_fill(0),
+    m_block_sum_squares(0.0f),
+    m_level_in_db(c_zero_level_in_db),
+    m_total_count(0),
+    m_bucket_index(0),
+    m_bucket_fill(0)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOHistogramMeter::AUDIOHistogramMeter enter this=%p channel_p=%p window=%d", this, channel_p, window);
+
+    // work out how many blocks each bucket covers, a day bucket is 24 minutes which still fits the 16 bit counts
+    unsigned int window_in_secs = HISTOGRAM_SECONDS_PER_MINUTE;
+    if (WINDOW_HOUR == window)
+    {
+        window_in_secs = HISTOGRAM_SECONDS_PER_HOUR;
+    }
+    else if (WINDOW_DAY == window)
+    {
+        window_in_secs = HISTOGRAM_SECONDS_PER_DAY;
+    }
+    m_bucket_length = (window_in_secs * (1000 / HISTOGRAM_BLOCK_TIME_IN_MS)) / HISTOGRAM_BUCKETS;
+
+    memset(m_buckets, 0, sizeof(m_buckets));
+    memset(m_totals, 0, sizeof(m_totals));
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOHistogramMeter::AUDIOHistogramMeter exit");
+}
+
+AUDIOHistogramMeter::~AUDIOHistogramMeter()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOHistogramMeter::~AUDIOHistogramMeter enter this=%p", this);
+    LOG_GENERATE_TRACE(g_logger, "AUDIOHistogramMeter::~AUDIOHistogramMeter exit");
+}
+
+float AUDIOHistogramMeter::calculate_percentile(float percentile) const
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOHistogramMeter::calculate_percentile enter this=%p percentile=%f", this, percentile);
+
+    // nothing counted yet
+    float level_in_db = c_zero_level_in_db;
+    if (0 < m_total_count)
+    {
+        // walk up the bins until we pass the rank + interpolate inside the bin it lands in
+        const float rank = (std::max(0.0f, std::min(percentile, 100.0f)) / 100.0f) * m_total_count;
+        uint32_t below = 0;
+        for (unsigned int bin = 0; bin < HISTOGRAM_BINS; bin++)
+        {
+            if ((0 < m_totals[bin]) && (rank <= (float)(below + m_totals[bin])))
+            {
+                const float fraction = (rank - below) / m_totals[bin];
+                level_in_db = c_zero_level_in_db + (HISTOGRAM_BIN_WIDTH_IN_DB * (bin + fraction));
+                break;
+            }
+            below += m_totals[bin];
+        }
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOHistogramMeter::calculate_percentile exit level_in_db=%f", level_in_db);
+    return level_in_db;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// AUDIOProcessor::Meter implementation
+///////////////////////////////////////////////////////////////////////////////
+
+void AUDIOHistogramMeter::process_samples(const size_t buffer_length, AUDIOChannel::Sample *buffer_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOHistogramMeter::process_samples enter this=%p buffer_length=%d buffer_p=%p", this, buffer_length, buffer_p);
+
+    size_t offset = 0;
+    while (offset < buffer_length)
+    {
+        const size_t count = std::min(buffer_length - offset, (size_t)(m_block_length - m_block_fill));
+        float sum_squares = 0.0f;
+        for (size_t counter = offset; counter < (offset + count); counter++)
+        {
+            sum_squares += buffer_p[counter] * buffer_p[counter];
+        }
+        m_block_sum_squares += sum_squares;
+        m_block_fill += count;
+        offset += count;
+
+        if (m_block_length == m_block_fill)
+        {
+            complete_block();
+        }
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOHistogramMeter::process_samples exit");
+}
+
+AUDIOProcessor::ResultData AUDIOHistogramMeter::create_result_data()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOHistogramMeter::create_result_data enter this=%p", this);
+
+    AUDIOProcessor::ResultData data;
+    memset(&data, 0, sizeof(data));
+
+    // populate the type
+    data.type = AUDIOProcessor::LEVEL_TYPE_HISTOGRAM;
+
+    // populate the channel
+    data.channel = get_channel_p()->get_index();
+
+    // the usual percentiles go out every tick, anything else has to be asked for
+    data.values.histogram.levelInDB = m_level_in_db;
+    data.values.histogram.p10InDB = calculate_percentile(10.0f);
+    data.values.histogram.p50InDB = calculate_percentile(50.0f);
+    data.values.histogram.p95InDB = calculate_percentile(95.0f);
+
+    LOG_GENERATE_DEBUG(g_logger, "histogram level(dB)=%f p10(dB)=%f p50(dB)=%f p95(dB)=%f", data.values.histogram.levelInDB, data.values.histogram.p10InDB, data.values.histogram.p50InDB, data.values.histogram.p95InDB);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOHistogramMeter::create_result_data exit");
+    return data;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// private function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+void AUDIOHistogramMeter::complete_block()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOHistogramMeter::complete_block enter this=%p", this);
+
+    // silence lands in the bottom bin
+    const float mean_square = m_block_sum_squares / m_block_length;
+    m_level_in_db = c_zero_level_in_db;
+    if (0.0f < mean_square)
+    {
+        m_level_in_db = std::min(std::max(10.0f * log10f(mean_square), c_zero_level_in_db), 0.0f);
+    }
+    const unsigned int bin = std::min((unsigned int)((m_level_in_db - c_zero_level_in_db) / HISTOGRAM_BIN_WIDTH_IN_DB), (unsigned int)(HISTOGRAM_BINS - 1));
+
+    // roll the window on, the bucket we're moving into holds the oldest counts
+    if (m_bucket_length == m_bucket_fill)
+    {
+        m_bucket_index = (m_bucket_index + 1) % HISTOGRAM_BUCKETS;
+        uint16_t *bucket_p = m_buckets[m_bucket_index];
+        for (unsigned int counter = 0; counter < HISTOGRAM_BINS; counter++)
+        {
+            m_totals[counter] -= bucket_p[counter];
+            m_total_count -= bucket_p[counter];
+        }
+        memset(bucket_p, 0, sizeof(m_buckets[0]));
+        m_bucket_fill = 0;
+    }
+    m_buckets[m_bucket_index][bin]++;
+    m_totals[bin]++;
+    m_total_count++;
+    m_bucket_fill++;
+
+    // start the next block
+    m_block_sum_squares = 0.0f;
+    m_block_fill = 0;
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOHistogramMeter::complete_block exit");
+}
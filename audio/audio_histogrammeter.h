@@ -0,0 +1,113 @@
+#ifndef _AUDIO_HISTOGRAMMETER_H_
+#define _AUDIO_HISTOGRAMMETER_H_
+
+#include "common.h"
+#include "audio_channel.h"
+#include "audio_processor.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+// 100ms levels counted into 0.5dB bins from -96dB up to full scale
+#define HISTOGRAM_BLOCK_TIME_IN_MS      (100)
+#define HISTOGRAM_BIN_WIDTH_IN_DB       (0.5f)
+#define HISTOGRAM_BINS                  (192)
+
+// the window rolls in 60 steps whatever its length, so a day costs the same memory as a minute
+#define HISTOGRAM_BUCKETS               (60)
+
+///////////////////////////////////////////////////////////////////////////////
+// forward declarations
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// class definition
+///////////////////////////////////////////////////////////////////////////////
+
+class AUDIOHistogramMeter : public AUDIOProcessor::Meter
+{
+
+///////////////////////////////////////////////////////////////////////////////
+// type definitions
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+
+    typedef enum
+    {
+        WINDOW_MINUTE = 0,
+        WINDOW_HOUR = 1,
+        WINDOW_DAY = 2
+    } Window;
+
+///////////////////////////////////////////////////////////////////////////////
+// public function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+    AUDIOHistogramMeter(AUDIOChannel *channel_p, Window window);
+    virtual ~AUDIOHistogramMeter();
+
+    inline Window get_window() const;
+    inline uint32_t get_block_count() const;
+    float calculate_percentile(float percentile) const;
+
+///////////////////////////////////////////////////////////////////////////////
+// AUDIOProcessor::Meter declarations
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+    void process_samples(const size_t buffer_length, AUDIOChannel::Sample *buffer_p);
+    AUDIOProcessor::ResultData create_result_data();
+    inline AUDIOProcessor::LevelType get_level_type();
+
+///////////////////////////////////////////////////////////////////////////////
+// private function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+    void complete_block();
+
+///////////////////////////////////////////////////////////////////////////////
+// private variable definitions
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+    Window m_window;
+    unsigned int m_block_length;
+    unsigned int m_block_fill;
+    float m_block_sum_squares;
+    float m_level_in_db;
+
+    // the oldest bucket is taken off the totals as the window rolls over it
+    uint16_t m_buckets[HISTOGRAM_BUCKETS][HISTOGRAM_BINS];
+    uint32_t m_totals[HISTOGRAM_BINS];
+    uint32_t m_total_count;
+    unsigned int m_bucket_index;
+    unsigned int m_bucket_fill;
+    unsigned int m_bucket_length;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// inline function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+inline AUDIOHistogramMeter::Window AUDIOHistogramMeter::get_window() const
+{
+    return m_window;
+}
+
+inline uint32_t AUDIOHistogramMeter::get_block_count() const
+{
+    return m_total_count;
+}
+
+inline AUDIOProcessor::LevelType AUDIOHistogramMeter::get_level_type()
+{
+    return AUDIOProcessor::LEVEL_TYPE_HISTOGRAM;
+}
+
+#endif
+
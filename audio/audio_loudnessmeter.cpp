@@ -0,0 +1,525 @@
+
+#include "audio_loudnessmeter.h"
+#include "log.h"
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+// reference: ITU-R BS.1770-4 and EBU Tech 3341/3342
+#define LOUDNESS_OFFSET_IN_LU                   (-0.691)
+#define LOUDNESS_INTEGRATED_RELATIVE_GATE_IN_LU (-10.0f)
+#define LOUDNESS_RANGE_RELATIVE_GATE_IN_LU      (-20.0f)
+#define LOUDNESS_RANGE_LOW_PERCENTILE           (0.10)
+#define LOUDNESS_RANGE_HIGH_PERCENTILE          (0.95)
+
+// channel weights for the surround channels, the LFE is not measured
+#define LOUDNESS_FRONT_CHANNEL_WEIGHT           (1.0f)
+#define LOUDNESS_SURROUND_CHANNEL_WEIGHT        (1.41f)
+#define LOUDNESS_LFE_CHANNEL_WEIGHT             (0.0f)
+
+// BS.1770 only needs the audio band, anything above can run decimated
+#define LOUDNESS_BANDWIDTH                      (20000)
+
+///////////////////////////////////////////////////////////////////////////////
+// type defintions
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// constants
+///////////////////////////////////////////////////////////////////////////////
+
+static const float c_zero_level_in_lufs = -96;
+
+///////////////////////////////////////////////////////////////////////////////
+// module variables
+///////////////////////////////////////////////////////////////////////////////
+
+static LogInstance g_logger("audio.loudnessmeter");
+
+///////////////////////////////////////////////////////////////////////////////
+// private function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// public function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+AUDIOLoudnessMeter::AUDIOLoudnessMeter(AUDIOChannel *channel_p) :
+    AUDIOProcessor::Meter(channel_p, LOUDNESS_BANDWIDTH),
+    m_block_length(CALC_NUM_SAMPLES_FOR_MILLIS(LOUDNESS_BLOCK_TIME_IN_MS, get_sample_rate())),
+    m_blocks(0)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOLoudnessMeter::AUDIOLoudnessMeter enter this=%p channel_p=%p", this, channel_p);
+
+    // clear the block ring + histograms
+    memset(&m_accumulators, 0, sizeof(m_accumulators));
+
+    // the meter's own channel is always the first member of the group
+    add_member(channel_p, get_default_weight(channel_p->get_role()));
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOLoudnessMeter::AUDIOLoudnessMeter exit");
+}
+
+AUDIOLoudnessMeter::~AUDIOLoudnessMeter()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOLoudnessMeter::~AUDIOLoudnessMeter enter this=%p", this);
+    LOG_GENERATE_TRACE(g_logger, "AUDIOLoudnessMeter::~AUDIOLoudnessMeter exit");
+}
+
+ResultCode AUDIOLoudnessMeter::add_channel(AUDIOChannel *channel_p, float weight)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOLoudnessMeter::add_channel enter this=%p channel_p=%p weight=%f", this, channel_p, weight);
+
+    // the block boundaries are counted in samples so every channel must run at the same rate
+    if (channel_p->get_sample_rate() != get_channel_p()->get_sample_rate())
+    {
+        LOG_GENERATE_ERROR(g_logger, "channel=%d sample_rate=%d does not match sample_rate=%d", channel_p->get_index(), channel_p->get_sample_rate(), get_channel_p()->get_sample_rate());
+        return RESULT_CODE_ERROR;
+    }
+
+    // each channel can only be summed once
+    for (std::vector<Member>::iterator it = m_members.begin();
+            it != m_members.end();
+            it++)
+    {
+        if (it->channel_p == channel_p)
+        {
+            LOG_GENERATE_ERROR(g_logger, "channel=%d is already part of the group", channel_p->get_index());
+            return RESULT_CODE_ERROR;
+        }
+    }
+
+    // store it + let the processor know we want its samples
+    add_member(channel_p, weight);
+    add_linked_channel(channel_p);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOLoudnessMeter::add_channel exit");
+    return RESULT_CODE_OK;
+}
+
+float AUDIOLoudnessMeter::get_default_weight(AUDIOChannel::Role role)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOLoudnessMeter::get_default_weight enter role=%d", role);
+
+    // fronts + anything without a role weight equally
+    float weight = LOUDNESS_FRONT_CHANNEL_WEIGHT;
+
+    switch (role)
+    {
+        case AUDIOChannel::ROLE_LFE:
+            weight = LOUDNESS_LFE_CHANNEL_WEIGHT;
+            break;
+        case AUDIOChannel::ROLE_LEFT_SURROUND:
+        case AUDIOChannel::ROLE_RIGHT_SURROUND:
+        case AUDIOChannel::ROLE_LEFT_REAR_SURROUND:
+        case AUDIOChannel::ROLE_RIGHT_REAR_SURROUND:
+            weight = LOUDNESS_SURROUND_CHANNEL_WEIGHT;
+            break;
+        default:
+            break;
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOLoudnessMeter::get_default_weight exit weight=%f", weight);
+    return weight;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// AUDIOProcessor::Meter implementation
+///////////////////////////////////////////////////////////////////////////////
+
+void AUDIOLoudnessMeter::process_samples(const size_t buffer_length, AUDIOChannel::Sample *buffer_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOLoudnessMeter::process_samples enter this=%p buffer_length=%d buffer_p=%p", this, buffer_length, buffer_p);
+
+    // the first member is always our own channel
+    accumulate(m_members[0], buffer_length, buffer_p);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOLoudnessMeter::process_samples exit");
+}
+
+void AUDIOLoudnessMeter::process_linked_samples(const AUDIOChannel *channel_p, const size_t buffer_length, AUDIOChannel::Sample *buffer_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOLoudnessMeter::process_linked_samples enter this=%p channel_p=%p buffer_length=%d buffer_p=%p", this, channel_p, buffer_length, buffer_p);
+
+    // find the member for this channel
+    for (std::vector<Member>::iterator it = m_members.begin() + 1;
+            it != m_members.end();
+            it++)
+    {
+        if (it->channel_p == channel_p)
+        {
+            accumulate(*it, buffer_length, buffer_p);
+            break;
+        }
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOLoudnessMeter::process_linked_samples exit");
+}
+
+AUDIOProcessor::ResultData AUDIOLoudnessMeter::create_result_data()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOLoudnessMeter::create_result_data enter this=%p", this);
+    AUDIOProcessor::ResultData data = create_accumulated_result_data(m_accumulators);
+    LOG_GENERATE_TRACE(g_logger, "AUDIOLoudnessMeter::create_result_data exit");
+    return data;
+}
+
+size_t AUDIOLoudnessMeter::get_accumulators_size() const
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOLoudnessMeter::get_accumulators_size enter this=%p", this);
+    LOG_GENERATE_TRACE(g_logger, "AUDIOLoudnessMeter::get_accumulators_size exit");
+    return sizeof(Accumulators);
+}
+
+void AUDIOLoudnessMeter::save_accumulators(void *accumulators_p) const
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOLoudnessMeter::save_accumulators enter this=%p accumulators_p=%p", this, accumulators_p);
+    memcpy(accumulators_p, &m_accumulators, sizeof(m_accumulators));
+    LOG_GENERATE_TRACE(g_logger, "AUDIOLoudnessMeter::save_accumulators exit");
+}
+
+void AUDIOLoudnessMeter::queue_accumulated_result_data(const void *accumulators_p, AUDIOProcessor::ResultData &data, AUDIODecibels &decibels) const
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOLoudnessMeter::queue_accumulated_result_data enter this=%p accumulators_p=%p data=%p decibels=%p", this, accumulators_p, &data, &decibels);
+    // the levels are already in LUFS so there's nothing to batch
+    data = create_accumulated_result_data(*(const Accumulators *)accumulators_p);
+    LOG_GENERATE_TRACE(g_logger, "AUDIOLoudnessMeter::queue_accumulated_result_data exit");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// private function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+void AUDIOLoudnessMeter::add_member(const AUDIOChannel *channel_p, float weight)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOLoudnessMeter::add_member enter this=%p channel_p=%p weight=%f", this, channel_p, weight);
+
+    Member member;
+    member.channel_p = channel_p;
+    member.weight = weight;
+    member.shelf.set_coefficients(AUDIOBiquad::create_kweighting_shelf(get_sample_rate()));
+    member.highpass.set_coefficients(AUDIOBiquad::create_kweighting_highpass(get_sample_rate()));
+    member.sum_squares = 0.0;
+    member.sample_count = 0;
+    // a late joiner starts at the group's current block
+    member.completed_blocks = m_blocks;
+    memset(member.block_energies, 0, sizeof(member.block_energies));
+    member.stalled = false;
+    member.missed_blocks = 0;
+    m_members.push_back(member);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOLoudnessMeter::add_member exit");
+}
+
+void AUDIOLoudnessMeter::accumulate(Member &member, const size_t buffer_length, const AUDIOChannel::Sample *buffer_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOLoudnessMeter::accumulate enter this=%p channel=%d buffer_length=%d buffer_p=%p", this, member.channel_p->get_index(), buffer_length, buffer_p);
+
+    for (int counter = 0; counter < buffer_length; counter++)
+    {
+        // K-weight the sample
+        float weighted = member.highpass.process(member.shelf.process(buffer_p[counter]));
+        member.sum_squares += weighted * weighted;
+
+        // see if we've filled a block
+        member.sample_count++;
+        if (m_block_length == member.sample_count)
+        {
+            // don't overwrite a block the rest of the group hasn't caught up to, give up waiting on it instead
+            if ((member.completed_blocks - m_blocks) >= LOUDNESS_PENDING_BLOCKS)
+            {
+                flush_block();
+            }
+            if (member.stalled)
+            {
+                LOG_GENERATE_INFO(g_logger, "channel=%d rejoined the group after missing blocks=%llu", member.channel_p->get_index(), (unsigned long long)member.missed_blocks);
+                member.stalled = false;
+            }
+            member.block_energies[member.completed_blocks % LOUDNESS_PENDING_BLOCKS] = member.sum_squares / m_block_length;
+            member.completed_blocks++;
+            member.sum_squares = 0.0;
+            member.sample_count = 0;
+        }
+    }
+
+    // see if the whole group has now completed any blocks
+    complete_blocks();
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOLoudnessMeter::accumulate exit");
+}
+
+void AUDIOLoudnessMeter::complete_blocks()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOLoudnessMeter::complete_blocks enter this=%p", this);
+
+    while (true)
+    {
+        // sum the weighted energy across the group, bailing if any member is not done yet
+        double energy = 0.0;
+        std::vector<Member>::const_iterator it = m_members.begin();
+        for (; it != m_members.end(); it++)
+        {
+            if (it->completed_blocks <= m_blocks)
+            {
+                break;
+            }
+            energy += it->weight * it->block_energies[m_blocks % LOUDNESS_PENDING_BLOCKS];
+        }
+        if (it != m_members.end())
+        {
+            break;
+        }
+
+        // we have a complete block
+        add_block(energy);
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOLoudnessMeter::complete_blocks exit");
+}
+
+void AUDIOLoudnessMeter::flush_block()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOLoudnessMeter::flush_block enter this=%p", this);
+
+    // complete the oldest block with whatever the group has, lagging members count as silence
+    double energy = 0.0;
+    for (std::vector<Member>::iterator it = m_members.begin();
+            it != m_members.end();
+            it++)
+    {
+        if (it->completed_blocks > m_blocks)
+        {
+            energy += it->weight * it->block_energies[m_blocks % LOUDNESS_PENDING_BLOCKS];
+            continue;
+        }
+
+        // only complain once per stall
+        if (!it->stalled)
+        {
+            LOG_GENERATE_WARN(g_logger, "channel=%d stalled, measuring the group without it", it->channel_p->get_index());
+            it->stalled = true;
+            it->missed_blocks = 0;
+        }
+        it->missed_blocks++;
+
+        // skip it past the block, any partial block it had is now out of step
+        it->completed_blocks = m_blocks + 1;
+        it->sum_squares = 0.0;
+        it->sample_count = 0;
+    }
+    add_block(energy);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOLoudnessMeter::flush_block exit");
+}
+
+void AUDIOLoudnessMeter::add_block(double energy)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOLoudnessMeter::add_block enter this=%p energy=%f", this, energy);
+
+    // store the block in the ring
+    m_accumulators.block_energies[m_accumulators.block_index] = energy;
+    m_accumulators.block_index = (m_accumulators.block_index + 1) % LOUDNESS_SHORTTERM_BLOCKS;
+    m_accumulators.block_count = std::min(m_accumulators.block_count + 1, (unsigned int)LOUDNESS_SHORTTERM_BLOCKS);
+    m_blocks++;
+
+    // every block completes a 400ms gating block with 75% overlap
+    if (LOUDNESS_MOMENTARY_BLOCKS <= m_accumulators.block_count)
+    {
+        double gating_energy = calculate_mean_energy(m_accumulators, LOUDNESS_MOMENTARY_BLOCKS);
+        // apply the absolute gate
+        if (lufs_to_energy(LOUDNESS_HISTOGRAM_MINIMUM_IN_LUFS) <= gating_energy)
+        {
+            int bin = lufs_to_bin(energy_to_lufs(gating_energy));
+            m_accumulators.integrated_counts[bin]++;
+            m_accumulators.integrated_energies[bin] += gating_energy;
+        }
+    }
+
+    // and a 3s short-term value for the loudness range
+    if (LOUDNESS_SHORTTERM_BLOCKS <= m_accumulators.block_count)
+    {
+        double shortterm_energy = calculate_mean_energy(m_accumulators, LOUDNESS_SHORTTERM_BLOCKS);
+        // apply the absolute gate
+        if (lufs_to_energy(LOUDNESS_HISTOGRAM_MINIMUM_IN_LUFS) <= shortterm_energy)
+        {
+            m_accumulators.range_counts[lufs_to_bin(energy_to_lufs(shortterm_energy))]++;
+        }
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOLoudnessMeter::add_block exit");
+}
+
+AUDIOProcessor::ResultData AUDIOLoudnessMeter::create_accumulated_result_data(const Accumulators &accumulators) const
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOLoudnessMeter::create_accumulated_result_data enter this=%p accumulators=%p", this, &accumulators);
+
+    AUDIOProcessor::ResultData data;
+    memset(&data, 0, sizeof(data));
+
+    // populate the type
+    data.type = AUDIOProcessor::LEVEL_TYPE_LOUDNESS;
+
+    // populate the channel
+    data.channel = get_channel_p()->get_index();
+
+    // assume the levels are zero for now
+    data.values.loudness.momentaryInLUFS = c_zero_level_in_lufs;
+    data.values.loudness.shorttermInLUFS = c_zero_level_in_lufs;
+
+    // the sliding windows are only valid once enough blocks have been seen
+    if (LOUDNESS_MOMENTARY_BLOCKS <= accumulators.block_count)
+    {
+        data.values.loudness.momentaryInLUFS = std::max(energy_to_lufs(calculate_mean_energy(accumulators, LOUDNESS_MOMENTARY_BLOCKS)), c_zero_level_in_lufs);
+    }
+    if (LOUDNESS_SHORTTERM_BLOCKS <= accumulators.block_count)
+    {
+        data.values.loudness.shorttermInLUFS = std::max(energy_to_lufs(calculate_mean_energy(accumulators, LOUDNESS_SHORTTERM_BLOCKS)), c_zero_level_in_lufs);
+    }
+
+    // the long term values come from the histograms
+    data.values.loudness.integratedInLUFS = calculate_integrated(accumulators);
+    data.values.loudness.rangeInLU = calculate_range(accumulators);
+
+    LOG_GENERATE_DEBUG(g_logger, "loudness momentary(LUFS)=%f short-term(LUFS)=%f integrated(LUFS)=%f range(LU)=%f", data.values.loudness.momentaryInLUFS, data.values.loudness.shorttermInLUFS, data.values.loudness.integratedInLUFS, data.values.loudness.rangeInLU);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOLoudnessMeter::create_accumulated_result_data exit");
+    return data;
+}
+
+double AUDIOLoudnessMeter::calculate_mean_energy(const Accumulators &accumulators, unsigned int block_count)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOLoudnessMeter::calculate_mean_energy enter accumulators=%p block_count=%d", &accumulators, block_count);
+
+    // walk backwards from the most recent block
+    double sum = 0.0;
+    for (unsigned int counter = 1; counter <= block_count; counter++)
+    {
+        sum += accumulators.block_energies[(accumulators.block_index + LOUDNESS_SHORTTERM_BLOCKS - counter) % LOUDNESS_SHORTTERM_BLOCKS];
+    }
+    double mean = sum / block_count;
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOLoudnessMeter::calculate_mean_energy exit mean=%f", mean);
+    return mean;
+}
+
+float AUDIOLoudnessMeter::calculate_integrated(const Accumulators &accumulators)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOLoudnessMeter::calculate_integrated enter accumulators=%p", &accumulators);
+
+    // assume there is no signal
+    float integrated = c_zero_level_in_lufs;
+
+    // everything in the histogram has already passed the absolute gate
+    uint64_t count = 0;
+    double energy = 0.0;
+    for (int bin = 0; bin < LOUDNESS_HISTOGRAM_BINS; bin++)
+    {
+        count += accumulators.integrated_counts[bin];
+        energy += accumulators.integrated_energies[bin];
+    }
+
+    if (0 < count)
+    {
+        // apply the relative gate
+        float gate = energy_to_lufs(energy / count) + LOUDNESS_INTEGRATED_RELATIVE_GATE_IN_LU;
+        count = 0;
+        energy = 0.0;
+        for (int bin = lufs_to_bin(gate); bin < LOUDNESS_HISTOGRAM_BINS; bin++)
+        {
+            count += accumulators.integrated_counts[bin];
+            energy += accumulators.integrated_energies[bin];
+        }
+        if (0 < count)
+        {
+            integrated = energy_to_lufs(energy / count);
+        }
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOLoudnessMeter::calculate_integrated exit integrated=%f", integrated);
+    return integrated;
+}
+
+float AUDIOLoudnessMeter::calculate_range(const Accumulators &accumulators)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOLoudnessMeter::calculate_range enter accumulators=%p", &accumulators);
+
+    // assume there is no range
+    float range = 0.0f;
+
+    // the mean is calculated using the bin centres
+    uint64_t count = 0;
+    double energy = 0.0;
+    for (int bin = 0; bin < LOUDNESS_HISTOGRAM_BINS; bin++)
+    {
+        count += accumulators.range_counts[bin];
+        energy += accumulators.range_counts[bin] * lufs_to_energy(bin_to_lufs(bin) + (0.5f / LOUDNESS_HISTOGRAM_BINS_PER_LU));
+    }
+
+    if (0 < count)
+    {
+        // apply the relative gate
+        int first_bin = lufs_to_bin(energy_to_lufs(energy / count) + LOUDNESS_RANGE_RELATIVE_GATE_IN_LU);
+        count = 0;
+        for (int bin = first_bin; bin < LOUDNESS_HISTOGRAM_BINS; bin++)
+        {
+            count += accumulators.range_counts[bin];
+        }
+
+        // find the percentiles
+        if (0 < count)
+        {
+            int low_bin = -1;
+            int high_bin = -1;
+            uint64_t cumulative = 0;
+            for (int bin = first_bin; (bin < LOUDNESS_HISTOGRAM_BINS) && (-1 == high_bin); bin++)
+            {
+                cumulative += accumulators.range_counts[bin];
+                if ((-1 == low_bin) && (cumulative >= (LOUDNESS_RANGE_LOW_PERCENTILE * count)))
+                {
+                    low_bin = bin;
+                }
+                if (cumulative >= (LOUDNESS_RANGE_HIGH_PERCENTILE * count))
+                {
+                    high_bin = bin;
+                }
+            }
+            range = bin_to_lufs(high_bin) - bin_to_lufs(low_bin);
+        }
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOLoudnessMeter::calculate_range exit range=%f", range);
+    return range;
+}
+
+float AUDIOLoudnessMeter::energy_to_lufs(double energy)
+{
+    // silence maps onto the floor of the scale
+    if (0.0 >= energy)
+    {
+        return c_zero_level_in_lufs;
+    }
+    return (float)(LOUDNESS_OFFSET_IN_LU + (10.0 * log10(energy)));
+}
+
+double AUDIOLoudnessMeter::lufs_to_energy(float lufs)
+{
+    return pow(10.0, (lufs - LOUDNESS_OFFSET_IN_LU) / 10.0);
+}
+
+int AUDIOLoudnessMeter::lufs_to_bin(float lufs)
+{
+    int bin = (int)floorf((lufs - LOUDNESS_HISTOGRAM_MINIMUM_IN_LUFS) * LOUDNESS_HISTOGRAM_BINS_PER_LU);
+    return std::max(0, std::min(bin, LOUDNESS_HISTOGRAM_BINS - 1));
+}
+
+float AUDIOLoudnessMeter::bin_to_lufs(int bin)
+{
+    return LOUDNESS_HISTOGRAM_MINIMUM_IN_LUFS + ((float)bin / LOUDNESS_HISTOGRAM_BINS_PER_LU);
+}
@@ -0,0 +1,143 @@
+#ifndef _AUDIO_LOUDNESSMETER_H_
+#define _AUDIO_LOUDNESSMETER_H_
+
+#include "common.h"
+#include "audio_channel.h"
+#include "audio_processor.h"
+#include "audio_biquad.h"
+
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+// 100ms blocks, momentary is 4 blocks (400ms) and short-term is 30 blocks (3s)
+#define LOUDNESS_BLOCK_TIME_IN_MS               (100)
+#define LOUDNESS_MOMENTARY_BLOCKS               (4)
+#define LOUDNESS_SHORTTERM_BLOCKS               (30)
+
+// number of completed blocks a linked channel may run ahead of the others, past
+// this the oldest block is flushed with the lagging channels counted as silent
+#define LOUDNESS_PENDING_BLOCKS                 (4)
+
+// histogram covers the absolute gate up to well above full scale in 0.1 LU steps
+#define LOUDNESS_HISTOGRAM_MINIMUM_IN_LUFS      (-70.0f)
+#define LOUDNESS_HISTOGRAM_MAXIMUM_IN_LUFS      (5.0f)
+#define LOUDNESS_HISTOGRAM_BINS_PER_LU          (10)
+#define LOUDNESS_HISTOGRAM_BINS                 ((int)((LOUDNESS_HISTOGRAM_MAXIMUM_IN_LUFS - LOUDNESS_HISTOGRAM_MINIMUM_IN_LUFS) * LOUDNESS_HISTOGRAM_BINS_PER_LU))
+
+///////////////////////////////////////////////////////////////////////////////
+// forward declarations
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// class definition
+///////////////////////////////////////////////////////////////////////////////
+
+class AUDIOLoudnessMeter : public AUDIOProcessor::Meter
+{
+
+///////////////////////////////////////////////////////////////////////////////
+// type definitions
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+
+    typedef struct
+    {
+        const AUDIOChannel *channel_p;
+        float weight;
+        AUDIOBiquad shelf;
+        AUDIOBiquad highpass;
+        double sum_squares;
+        unsigned int sample_count;
+        uint64_t completed_blocks;
+        double block_energies[LOUDNESS_PENDING_BLOCKS];
+        bool stalled;
+        uint64_t missed_blocks;
+    } Member;
+
+    // everything the results are worked out from
+    typedef struct
+    {
+        // ring of the most recent 100ms block energies
+        double block_energies[LOUDNESS_SHORTTERM_BLOCKS];
+        unsigned int block_index;
+        unsigned int block_count;
+
+        // gated histograms, fixed size no matter how long the program runs
+        uint32_t integrated_counts[LOUDNESS_HISTOGRAM_BINS];
+        double integrated_energies[LOUDNESS_HISTOGRAM_BINS];
+        uint32_t range_counts[LOUDNESS_HISTOGRAM_BINS];
+    } Accumulators;
+
+///////////////////////////////////////////////////////////////////////////////
+// public function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+    AUDIOLoudnessMeter(AUDIOChannel *channel_p);
+    virtual ~AUDIOLoudnessMeter();
+
+    ResultCode add_channel(AUDIOChannel *channel_p, float weight);
+
+    static float get_default_weight(AUDIOChannel::Role role);
+
+///////////////////////////////////////////////////////////////////////////////
+// AUDIOProcessor::Meter declarations
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+    void process_samples(const size_t buffer_length, AUDIOChannel::Sample *buffer_p);
+    void process_linked_samples(const AUDIOChannel *channel_p, const size_t buffer_length, AUDIOChannel::Sample *buffer_p);
+    AUDIOProcessor::ResultData create_result_data();
+    size_t get_accumulators_size() const;
+    void save_accumulators(void *accumulators_p) const;
+    void queue_accumulated_result_data(const void *accumulators_p, AUDIOProcessor::ResultData &data, AUDIODecibels &decibels) const;
+    inline AUDIOProcessor::LevelType get_level_type();
+
+///////////////////////////////////////////////////////////////////////////////
+// private function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+    void add_member(const AUDIOChannel *channel_p, float weight);
+    void accumulate(Member &member, const size_t buffer_length, const AUDIOChannel::Sample *buffer_p);
+    void complete_blocks();
+    void flush_block();
+    void add_block(double energy);
+    AUDIOProcessor::ResultData create_accumulated_result_data(const Accumulators &accumulators) const;
+
+    static double calculate_mean_energy(const Accumulators &accumulators, unsigned int block_count);
+    static float calculate_integrated(const Accumulators &accumulators);
+    static float calculate_range(const Accumulators &accumulators);
+
+    static float energy_to_lufs(double energy);
+    static double lufs_to_energy(float lufs);
+    static int lufs_to_bin(float lufs);
+    static float bin_to_lufs(int bin);
+
+///////////////////////////////////////////////////////////////////////////////
+// private variable definitions
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+    std::vector<Member> m_members;
+    unsigned int m_block_length;
+    uint64_t m_blocks;
+    Accumulators m_accumulators;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// inline function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+inline AUDIOProcessor::LevelType AUDIOLoudnessMeter::get_level_type()
+{
+    return AUDIOProcessor::LEVEL_TYPE_LOUDNESS;
+}
+
+#endif
+
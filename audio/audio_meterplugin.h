@@ -0,0 +1,82 @@
+#ifndef _AUDIO_METERPLUGIN_H_
+#define _AUDIO_METERPLUGIN_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+// everything a plugin sees is in this file + plain C, so it only changes when the structures below do
+#define METER_PLUGIN_ABI_VERSION        (4)
+#define METER_PLUGIN_ENTRY_SYMBOL       "audio_meter_plugin_v4"
+#define METER_PLUGIN_ANY_SAMPLE_RATE    (0)
+// the results are written into a buffer of this many floats at most
+#define METER_PLUGIN_MAXIMUM_VALUES     (32)
+
+#ifdef __cplusplus
+#define METER_PLUGIN_EXTERN_C           extern "C"
+#else
+#define METER_PLUGIN_EXTERN_C
+#endif
+
+// each plugin's shared object hands its descriptor over through this
+#define METER_PLUGIN_DECLARE(descriptor) \
+    METER_PLUGIN_EXTERN_C const MeterPluginDescriptor *audio_meter_plugin_v4(void) \
+    { \
+        return &(descriptor); \
+    }
+
+///////////////////////////////////////////////////////////////////////////////
+// type definitions
+///////////////////////////////////////////////////////////////////////////////
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// what the client asked for in the SETLEVEL, only valid for the length of the create call
+typedef struct
+{
+    // the rate of the samples process is handed + the sample value of full scale
+    uint32_t sampleRate;
+    float fullscaleLevel;
+    // 0 unless the client asked for one
+    uint32_t holdTimeInSecs;
+    uint32_t frequencyCount;
+    const float *frequencies_p;
+    uint32_t bandsPerOctave;
+    float lowFrequency;
+    float highFrequency;
+} MeterPluginParameters;
+
+typedef struct
+{
+    // METER_PLUGIN_ABI_VERSION as the plugin saw it
+    uint32_t abiVersion;
+    // what clients + alarms ask for it by
+    const char *name_p;
+    // the work per sample against a simple peak meter
+    uint32_t cost;
+    // channels slower than this are refused
+    uint32_t minimumSampleRate;
+    // the readings in each result, in the order of the names
+    uint32_t valueCount;
+    const char * const *valueNames_p;
+
+    // returns 0 + the meter's state through state_pp, anything else refuses the request
+    int (*create_p)(const MeterPluginParameters *parameters_p, void **state_pp);
+    // the samples are always floats, whichever way the daemon was built
+    void (*process_p)(void *state_p, const float *samples_p, size_t sample_count);
+    // called once a tick, writes valueCount readings into values_p
+    void (*result_p)(void *state_p, float *values_p);
+    void (*destroy_p)(void *state_p);
+} MeterPluginDescriptor;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,787 @@
+#include "audio_meterregistry.h"
+#include "audio_loudnessmeter.h"
+#include "audio_spectrummeter.h"
+#include "audio_correlationmeter.h"
+#include "audio_tonemeter.h"
+#include "audio_crestmeter.h"
+#include "audio_distortionmeter.h"
+#include "audio_noisefloormeter.h"
+#include "audio_delaymeter.h"
+#include "audio_groupmeter.h"
+#include "audio_histogrammeter.h"
+#include "audio_pluginmeter.h"
+#include "config.h"
+#include "log.h"
+
+#include <algorithm>
+#include <dirent.h>
+#include <dlfcn.h>
+#include <string.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+#define METER_PLUGIN_CONFIG_SECTION         "meter-plugins"
+#define METER_PLUGIN_DIRECTORY_CONFIG_ITEM  "directory"
+
+#define VALUE_COUNT(names)                  ((uint8_t)(sizeof(names) / sizeof(names[0])))
+
+///////////////////////////////////////////////////////////////////////////////
+// type defintions
+///////////////////////////////////////////////////////////////////////////////
+
+typedef const MeterPluginDescriptor *(*EntryPoint)();
+
+///////////////////////////////////////////////////////////////////////////////
+// private function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+static ResultCode create_ppm_meter(AUDIOChannel *channel_p, const AUDIOMeterRegistry::Parameters &parameters, AUDIOProcessor::Meter **meter_pp);
+static ResultCode create_digitalpeak_meter(AUDIOChannel *channel_p, const AUDIOMeterRegistry::Parameters &parameters, AUDIOProcessor::Meter **meter_pp);
+static ResultCode create_vu_meter(AUDIOChannel *channel_p, const AUDIOMeterRegistry::Parameters &parameters, AUDIOProcessor::Meter **meter_pp);
+static ResultCode create_loudness_meter(AUDIOChannel *channel_p, const AUDIOMeterRegistry::Parameters &parameters, AUDIOProcessor::Meter **meter_pp);
+static ResultCode create_spectrum_meter(AUDIOChannel *channel_p, const AUDIOMeterRegistry::Parameters &parameters, AUDIOProcessor::Meter **meter_pp);
+static ResultCode create_correlation_meter(AUDIOChannel *channel_p, const AUDIOMeterRegistry::Parameters &parameters, AUDIOProcessor::Meter **meter_pp);
+static ResultCode create_tone_meter(AUDIOChannel *channel_p, const AUDIOMeterRegistry::Parameters &parameters, AUDIOProcessor::Meter **meter_pp);
+static ResultCode create_crest_meter(AUDIOChannel *channel_p, const AUDIOMeterRegistry::Parameters &parameters, AUDIOProcessor::Meter **meter_pp);
+static ResultCode create_distortion_meter(AUDIOChannel *channel_p, const AUDIOMeterRegistry::Parameters &parameters, AUDIOProcessor::Meter **meter_pp);
+static ResultCode create_noisefloor_meter(AUDIOChannel *channel_p, const AUDIOMeterRegistry::Parameters &parameters, AUDIOProcessor::Meter **meter_pp);
+static ResultCode create_delay_meter(AUDIOChannel *channel_p, const AUDIOMeterRegistry::Parameters &parameters, AUDIOProcessor::Meter **meter_pp);
+static ResultCode create_group_meter(AUDIOChannel *channel_p, const AUDIOMeterRegistry::Parameters &parameters, AUDIOProcessor::Meter **meter_pp);
+static ResultCode create_histogram_meter(AUDIOChannel *channel_p, const AUDIOMeterRegistry::Parameters &parameters, AUDIOProcessor::Meter **meter_pp);
+static ResultCode validate_hold_time(uint32_t hold_time_in_secs);
+static ResultCode validate_standard(AUDIOBallistics::Standard standard);
+static AUDIOChannel *validate_paired_channel(AUDIOChannel *channel_p, const AUDIOMeterRegistry::Parameters &parameters);
+
+///////////////////////////////////////////////////////////////////////////////
+// constants
+///////////////////////////////////////////////////////////////////////////////
+
+// the schemas match the ResultData the built in meters fill
+static const char * const c_peak_values[] = { "peakInDB", "holdInDB" };
+static const char * const c_vu_values[] = { "vuInUnits" };
+static const char * const c_loudness_values[] = { "momentaryInLUFS", "shorttermInLUFS", "integratedInLUFS", "rangeInLU" };
+static const char * const c_correlation_values[] = { "correlation", "balance" };
+static const char * const c_crest_values[] = { "peakInDB", "rmsInDB", "crestInDB", "rangeInDB" };
+static const char * const c_distortion_values[] = { "frequency", "levelInDB", "thdnInDB", "sinadInDB" };
+static const char * const c_noisefloor_values[] = { "levelInDB", "floorInDB" };
+static const char * const c_delay_values[] = { "lagInSamples", "lagInMs", "confidence" };
+static const char * const c_histogram_values[] = { "levelInDB", "p10InDB", "p50InDB", "p95InDB" };
+
+// costs are rough per sample figures taken against the digital peak meter
+static const AUDIOMeterRegistry::Descriptor c_builtin_meters[] =
+{
+    { "digitalpeak", AUDIOProcessor::LEVEL_TYPE_DIGITALPEAK, 1, METER_PLUGIN_ANY_SAMPLE_RATE, VALUE_COUNT(c_peak_values), c_peak_values, create_digitalpeak_meter, NULL },
+    { "ppm", AUDIOProcessor::LEVEL_TYPE_PPM, 1, METER_PLUGIN_ANY_SAMPLE_RATE, VALUE_COUNT(c_peak_values), c_peak_values, create_ppm_meter, NULL },
+    { "vu", AUDIOProcessor::LEVEL_TYPE_VU, 1, METER_PLUGIN_ANY_SAMPLE_RATE, VALUE_COUNT(c_vu_values), c_vu_values, create_vu_meter, NULL },
+    { "loudness", AUDIOProcessor::LEVEL_TYPE_LOUDNESS, 3, METER_PLUGIN_ANY_SAMPLE_RATE, VALUE_COUNT(c_loudness_values), c_loudness_values, create_loudness_meter, NULL },
+    { "spectrum", AUDIOProcessor::LEVEL_TYPE_SPECTRUM, 8, METER_PLUGIN_ANY_SAMPLE_RATE, METER_PLUGIN_VALUES_VARIABLE, NULL, create_spectrum_meter, NULL },
+    { "correlation", AUDIOProcessor::LEVEL_TYPE_CORRELATION, 2, METER_PLUGIN_ANY_SAMPLE_RATE, VALUE_COUNT(c_correlation_values), c_correlation_values, create_correlation_meter, NULL },
+    { "tone", AUDIOProcessor::LEVEL_TYPE_TONE, 4, METER_PLUGIN_ANY_SAMPLE_RATE, METER_PLUGIN_VALUES_VARIABLE, NULL, create_tone_meter, NULL },
+    { "crest", AUDIOProcessor::LEVEL_TYPE_CREST, 1, METER_PLUGIN_ANY_SAMPLE_RATE, VALUE_COUNT(c_crest_values), c_crest_values, create_crest_meter, NULL },
+    { "distortion", AUDIOProcessor::LEVEL_TYPE_DISTORTION, 6, METER_PLUGIN_ANY_SAMPLE_RATE, VALUE_COUNT(c_distortion_values), c_distortion_values, create_distortion_meter, NULL },
+    { "noisefloor", AUDIOProcessor::LEVEL_TYPE_NOISEFLOOR, 2, METER_PLUGIN_ANY_SAMPLE_RATE, VALUE_COUNT(c_noisefloor_values), c_noisefloor_values, create_noisefloor_meter, NULL },
+    { "delay", AUDIOProcessor::LEVEL_TYPE_DELAY, 8, METER_PLUGIN_ANY_SAMPLE_RATE, VALUE_COUNT(c_delay_values), c_delay_values, create_delay_meter, NULL },
+    { "group", AUDIOProcessor::LEVEL_TYPE_GROUP, 2, METER_PLUGIN_ANY_SAMPLE_RATE, METER_PLUGIN_VALUES_VARIABLE, NULL, create_group_meter, NULL },
+    { "histogram", AUDIOProcessor::LEVEL_TYPE_HISTOGRAM, 1, METER_PLUGIN_ANY_SAMPLE_RATE, VALUE_COUNT(c_histogram_values), c_histogram_values, create_histogram_meter, NULL }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// module variables
+///////////////////////////////////////////////////////////////////////////////
+
+static LogInstance g_logger("audio.meterregistry");
+
+// singleton pointer
+AUDIOMeterRegistry *AUDIOMeterRegistry::g_instance_p = NULL;
+
+///////////////////////////////////////////////////////////////////////////////
+// public function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+AUDIOMeterRegistry *AUDIOMeterRegistry::get_instance()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOMeterRegistry::get_instance enter");
+
+    if (NULL == g_instance_p)
+    {
+        g_instance_p = new AUDIOMeterRegistry();
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOMeterRegistry::get_instance exit g_instance=%p", g_instance_p);
+
+    return g_instance_p;
+}
+
+ResultCode AUDIOMeterRegistry::register_meter(const Descriptor *descriptor_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOMeterRegistry::register_meter enter this=%p descriptor_p=%p", this, descriptor_p);
+
+    ResultCode result_code = RESULT_CODE_OK;
+
+    do
+    {
+        if ((NULL == descriptor_p->name_p) || ((NULL == descriptor_p->factory_p) && (NULL == descriptor_p->plugin_p)) ||
+                ((0 < descriptor_p->valueCount) && (NULL == descriptor_p->valueNames_p)))
+        {
+            LOG_GENERATE_ERROR(g_logger, "incomplete meter descriptor=%p", descriptor_p);
+            result_code = RESULT_CODE_ERROR;
+            break;
+        }
+        // the name is what clients + alarms use, the built in types only ever have one meter
+        if ((NULL != find_meter(descriptor_p->name_p)) ||
+                ((AUDIOProcessor::LEVEL_TYPE_PLUGIN != descriptor_p->type) && (NULL != find_meter(descriptor_p->type))))
+        {
+            LOG_GENERATE_ERROR(g_logger, "meter name=%s type=%d already registered", descriptor_p->name_p, descriptor_p->type);
+            result_code = RESULT_CODE_ERROR;
+            break;
+        }
+
+        m_descriptors.push_back(descriptor_p);
+        LOG_GENERATE_DEBUG(g_logger, "registered meter name=%s type=%d cost=%d", descriptor_p->name_p, descriptor_p->type, descriptor_p->cost);
+    }
+    while (false);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOMeterRegistry::register_meter exit result_code=%d", result_code);
+    return result_code;
+}
+
+const AUDIOMeterRegistry::Descriptor *AUDIOMeterRegistry::find_meter(AUDIOProcessor::LevelType type) const
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOMeterRegistry::find_meter enter this=%p type=%d", this, type);
+
+    // the plugins share a type so they can only be found by name
+    const Descriptor *descriptor_p = NULL;
+    for (DescriptorIterator it = m_descriptors.begin();
+            (AUDIOProcessor::LEVEL_TYPE_PLUGIN != type) && (it != m_descriptors.end());
+            it++)
+    {
+        if (type == (*it)->type)
+        {
+            descriptor_p = *it;
+            break;
+        }
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOMeterRegistry::find_meter exit descriptor_p=%p", descriptor_p);
+    return descriptor_p;
+}
+
+const AUDIOMeterRegistry::Descriptor *AUDIOMeterRegistry::find_meter(const char *name_p) const
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOMeterRegistry::find_meter enter this=%p name_p=%s", this, name_p);
+
+    const Descriptor *descriptor_p = NULL;
+    for (DescriptorIterator it = m_descriptors.begin(); it != m_descriptors.end(); it++)
+    {
+        if (0 == strcmp(name_p, (*it)->name_p))
+        {
+            descriptor_p = *it;
+            break;
+        }
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOMeterRegistry::find_meter exit descriptor_p=%p", descriptor_p);
+    return descriptor_p;
+}
+
+ResultCode AUDIOMeterRegistry::create_meter(const Descriptor *descriptor_p, AUDIOChannel *channel_p, const Parameters &parameters, AUDIOProcessor::Meter **meter_pp) const
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOMeterRegistry::create_meter enter this=%p name=%s channel_p=%p meter_pp=%p", this, descriptor_p->name_p, channel_p, meter_pp);
+
+    ResultCode result_code = RESULT_CODE_OK;
+    *meter_pp = NULL;
+
+    do
+    {
+        if (descriptor_p->minimumSampleRate > channel_p->get_sample_rate())
+        {
+            LOG_GENERATE_ERROR(g_logger, "meter name=%s needs sample rate=%d channel rate=%d", descriptor_p->name_p, descriptor_p->minimumSampleRate, channel_p->get_sample_rate());
+            result_code = RESULT_CODE_ERROR;
+            break;
+        }
+        if (NULL != descriptor_p->plugin_p)
+        {
+            result_code = create_plugin_meter(descriptor_p->plugin_p, channel_p, parameters, meter_pp);
+        }
+        else
+        {
+            result_code = descriptor_p->factory_p(channel_p, parameters, meter_pp);
+        }
+        if (RESULT_CODE_OK != result_code)
+        {
+            break;
+        }
+        // a misbehaving plugin mustn't take the processor down with it
+        if (NULL == *meter_pp)
+        {
+            LOG_GENERATE_ERROR(g_logger, "meter name=%s created nothing", descriptor_p->name_p);
+            result_code = RESULT_CODE_ERROR;
+            break;
+        }
+        if (descriptor_p->type != (*meter_pp)->get_level_type())
+        {
+            LOG_GENERATE_ERROR(g_logger, "meter name=%s created type=%d", descriptor_p->name_p, (*meter_pp)->get_level_type());
+            delete *meter_pp;
+            *meter_pp = NULL;
+            result_code = RESULT_CODE_ERROR;
+            break;
+        }
+        (*meter_pp)->set_cost(descriptor_p->cost);
+    }
+    while (false);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOMeterRegistry::create_meter exit result_code=%d meter_p=%p", result_code, *meter_pp);
+    return result_code;
+}
+
+void AUDIOMeterRegistry::init_parameters(Parameters &parameters)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOMeterRegistry::init_parameters enter parameters=%p", &parameters);
+
+    // the defaults for anything the client leaves out
+    parameters.holdTimeInSecs = METER_HOLD_TIME_INVALID;
+    parameters.linkedChannels.clear();
+    parameters.frequencies.clear();
+    parameters.bandsPerOctave = SPECTRUM_BANDS_PER_OCTAVE_THIRD;
+    AUDIODistortionMeter::fetch_default_bandwidth(&parameters.lowFrequency, &parameters.highFrequency);
+    parameters.ballistics = AUDIOProcessor::LEVEL_TYPE_PPM;
+    parameters.standard = AUDIOBallistics::STANDARD_LEGACY;
+    parameters.window = AUDIOHistogramMeter::WINDOW_HOUR;
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOMeterRegistry::init_parameters exit");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// private function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+AUDIOMeterRegistry::AUDIOMeterRegistry()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOMeterRegistry::AUDIOMeterRegistry enter this=%p", this);
+
+    for (size_t counter = 0; counter < (sizeof(c_builtin_meters) / sizeof(c_builtin_meters[0])); counter++)
+    {
+        ResultCode result_code = register_meter(&c_builtin_meters[counter]);
+        ASSERT(RESULT_CODE_OK == result_code);
+    }
+    load_plugins();
+
+    LOG_GENERATE_INFO(g_logger, "meter registry ready meters=%d plugins=%d", m_descriptors.size(), m_handles.size());
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOMeterRegistry::AUDIOMeterRegistry exit");
+}
+
+AUDIOMeterRegistry::~AUDIOMeterRegistry()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOMeterRegistry::~AUDIOMeterRegistry enter this=%p", this);
+
+    m_descriptors.clear();
+    for (std::vector<Descriptor *>::iterator it = m_plugin_descriptors.begin(); it != m_plugin_descriptors.end(); it++)
+    {
+        delete *it;
+    }
+    for (std::vector<void *>::iterator it = m_handles.begin(); it != m_handles.end(); it++)
+    {
+        dlclose(*it);
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOMeterRegistry::~AUDIOMeterRegistry exit");
+}
+
+void AUDIOMeterRegistry::load_plugins()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOMeterRegistry::load_plugins enter this=%p", this);
+
+    do
+    {
+        // no directory, no plugins
+        const char *directory_p = NULL;
+        Config::get_instance_p()->get_string_with_default(METER_PLUGIN_CONFIG_SECTION, METER_PLUGIN_DIRECTORY_CONFIG_ITEM, NULL, &directory_p);
+        if (NULL == directory_p)
+        {
+            break;
+        }
+        DIR *dir_p = opendir(directory_p);
+        if (NULL == dir_p)
+        {
+            LOG_GENERATE_ERROR(g_logger, "unable to open meter plugin directory=%s", directory_p);
+            break;
+        }
+
+        // sorted so the registration order doesn't depend on the filesystem
+        std::vector<std::string> paths;
+        const size_t suffix_length = strlen(METER_PLUGIN_SUFFIX);
+        for (struct dirent *entry_p = readdir(dir_p); NULL != entry_p; entry_p = readdir(dir_p))
+        {
+            const size_t length = strlen(entry_p->d_name);
+            if ((suffix_length < length) && (0 == strcmp(&entry_p->d_name[length - suffix_length], METER_PLUGIN_SUFFIX)))
+            {
+                paths.push_back(std::string(directory_p) + "/" + entry_p->d_name);
+            }
+        }
+        closedir(dir_p);
+        std::sort(paths.begin(), paths.end());
+
+        // a bad plugin is skipped rather than stopping the daemon
+        for (std::vector<std::string>::iterator it = paths.begin(); it != paths.end(); it++)
+        {
+            load_plugin(*it);
+        }
+    }
+    while (false);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOMeterRegistry::load_plugins exit");
+}
+
+ResultCode AUDIOMeterRegistry::load_plugin(const std::string &path)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOMeterRegistry::load_plugin enter this=%p path=%s", this, path.c_str());
+
+    ResultCode result_code = RESULT_CODE_OK;
+
+    do
+    {
+        // the plugins only see the C interface so nothing in them resolves against the daemon
+        void *handle_p = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+        if (NULL == handle_p)
+        {
+            LOG_GENERATE_ERROR(g_logger, "unable to load meter plugin=%s error=%s", path.c_str(), dlerror());
+            result_code = RESULT_CODE_ERROR;
+            break;
+        }
+        EntryPoint entry_p = (EntryPoint)dlsym(handle_p, METER_PLUGIN_ENTRY_SYMBOL);
+        const MeterPluginDescriptor *plugin_p = (NULL != entry_p) ? entry_p() : NULL;
+        if (NULL == plugin_p)
+        {
+            LOG_GENERATE_ERROR(g_logger, "meter plugin=%s has no %s", path.c_str(), METER_PLUGIN_ENTRY_SYMBOL);
+            dlclose(handle_p);
+            result_code = RESULT_CODE_ERROR;
+            break;
+        }
+        result_code = validate_plugin(path, plugin_p);
+        if (RESULT_CODE_OK != result_code)
+        {
+            dlclose(handle_p);
+            break;
+        }
+
+        // wrapped up as one of ours, every plugin shares the one level type
+        Descriptor *descriptor_p = new Descriptor;
+        descriptor_p->name_p = plugin_p->name_p;
+        descriptor_p->type = AUDIOProcessor::LEVEL_TYPE_PLUGIN;
+        descriptor_p->cost = plugin_p->cost;
+        descriptor_p->minimumSampleRate = plugin_p->minimumSampleRate;
+        descriptor_p->valueCount = (uint8_t)plugin_p->valueCount;
+        descriptor_p->valueNames_p = plugin_p->valueNames_p;
+        descriptor_p->factory_p = NULL;
+        descriptor_p->plugin_p = plugin_p;
+        result_code = register_meter(descriptor_p);
+        if (RESULT_CODE_OK != result_code)
+        {
+            delete descriptor_p;
+            dlclose(handle_p);
+            break;
+        }
+        m_plugin_descriptors.push_back(descriptor_p);
+        m_handles.push_back(handle_p);
+
+        LOG_GENERATE_INFO(g_logger, "loaded meter plugin=%s name=%s values=%d", path.c_str(), plugin_p->name_p, plugin_p->valueCount);
+    }
+    while (false);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOMeterRegistry::load_plugin exit result_code=%d", result_code);
+    return result_code;
+}
+
+ResultCode AUDIOMeterRegistry::validate_plugin(const std::string &path, const MeterPluginDescriptor *plugin_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOMeterRegistry::validate_plugin enter path=%s plugin_p=%p", path.c_str(), plugin_p);
+
+    ResultCode result_code = RESULT_CODE_OK;
+
+    do
+    {
+        // anything built against another version of the structures can't be read
+        if (METER_PLUGIN_ABI_VERSION != plugin_p->abiVersion)
+        {
+            LOG_GENERATE_ERROR(g_logger, "meter plugin=%s abi version=%d doesn't match version=%d", path.c_str(), plugin_p->abiVersion, METER_PLUGIN_ABI_VERSION);
+            result_code = RESULT_CODE_ERROR;
+            break;
+        }
+        if ((NULL == plugin_p->name_p) || (NULL == plugin_p->create_p) || (NULL == plugin_p->process_p) ||
+                (NULL == plugin_p->result_p) || (NULL == plugin_p->destroy_p) || (NULL == plugin_p->valueNames_p))
+        {
+            LOG_GENERATE_ERROR(g_logger, "meter plugin=%s has an incomplete descriptor", path.c_str());
+            result_code = RESULT_CODE_ERROR;
+            break;
+        }
+        // the results go into a buffer we provide so the count has to be fixed + fit
+        if ((0 == plugin_p->valueCount) || (METER_PLUGIN_MAXIMUM_VALUES < plugin_p->valueCount))
+        {
+            LOG_GENERATE_ERROR(g_logger, "meter plugin=%s values=%d must be 1 to %d", path.c_str(), plugin_p->valueCount, METER_PLUGIN_MAXIMUM_VALUES);
+            result_code = RESULT_CODE_ERROR;
+            break;
+        }
+    }
+    while (false);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOMeterRegistry::validate_plugin exit result_code=%d", result_code);
+    return result_code;
+}
+
+ResultCode AUDIOMeterRegistry::create_plugin_meter(const MeterPluginDescriptor *plugin_p, AUDIOChannel *channel_p, const Parameters &parameters, AUDIOProcessor::Meter **meter_pp)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOMeterRegistry::create_plugin_meter enter plugin_p=%p channel_p=%p meter_pp=%p", plugin_p, channel_p, meter_pp);
+
+    ResultCode result_code = RESULT_CODE_OK;
+
+    do
+    {
+        // the plugin only gets to see plain values
+        MeterPluginParameters plugin_parameters;
+        memset(&plugin_parameters, 0, sizeof(plugin_parameters));
+        plugin_parameters.sampleRate = channel_p->get_sample_rate();
+        plugin_parameters.fullscaleLevel = channel_p->get_fullscale_level();
+        plugin_parameters.holdTimeInSecs = parameters.holdTimeInSecs;
+        plugin_parameters.frequencyCount = parameters.frequencies.size();
+        plugin_parameters.frequencies_p = (false == parameters.frequencies.empty()) ? &parameters.frequencies[0] : NULL;
+        plugin_parameters.bandsPerOctave = parameters.bandsPerOctave;
+        plugin_parameters.lowFrequency = parameters.lowFrequency;
+        plugin_parameters.highFrequency = parameters.highFrequency;
+
+        void *state_p = NULL;
+        int rc = plugin_p->create_p(&plugin_parameters, &state_p);
+        if (0 != rc)
+        {
+            LOG_GENERATE_ERROR(g_logger, "meter plugin name=%s refused the request rc=%d", plugin_p->name_p, rc);
+            result_code = RESULT_CODE_ERROR;
+            break;
+        }
+        *meter_pp = new AUDIOPluginMeter(channel_p, plugin_p, state_p);
+    }
+    while (false);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOMeterRegistry::create_plugin_meter exit result_code=%d", result_code);
+    return result_code;
+}
+
+static ResultCode validate_hold_time(uint32_t hold_time_in_secs)
+{
+    LOG_GENERATE_TRACE(g_logger, "validate_hold_time enter hold_time_in_secs=%d", hold_time_in_secs);
+
+    ResultCode result_code = RESULT_CODE_OK;
+    if ((METER_HOLD_TIME_INVALID != hold_time_in_secs) &&
+            ((METER_HOLD_TIME_MINIMUM_IN_SECS > hold_time_in_secs) || (METER_HOLD_TIME_MAXIMUM_IN_SECS < hold_time_in_secs)))
+    {
+        LOG_GENERATE_ERROR(g_logger, "invalid hold time=%d received from client", hold_time_in_secs);
+        result_code = RESULT_CODE_ERROR;
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "validate_hold_time exit result_code=%d", result_code);
+    return result_code;
+}
+
+static ResultCode validate_standard(AUDIOBallistics::Standard standard)
+{
+    LOG_GENERATE_TRACE(g_logger, "validate_standard enter standard=%d", standard);
+
+    ResultCode result_code = RESULT_CODE_OK;
+    if (false == AUDIOBallistics::is_valid_standard(standard))
+    {
+        LOG_GENERATE_ERROR(g_logger, "invalid ppm standard=%d received from client", standard);
+        result_code = RESULT_CODE_ERROR;
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "validate_standard exit result_code=%d", result_code);
+    return result_code;
+}
+
+static AUDIOChannel *validate_paired_channel(AUDIOChannel *channel_p, const AUDIOMeterRegistry::Parameters &parameters)
+{
+    LOG_GENERATE_TRACE(g_logger, "validate_paired_channel enter channel_p=%p linked=%d", channel_p, parameters.linkedChannels.size());
+
+    // exactly one other channel running at the same rate
+    AUDIOChannel *paired_p = NULL;
+    if (1 != parameters.linkedChannels.size())
+    {
+        LOG_GENERATE_ERROR(g_logger, "invalid linked channel count=%d received from client", parameters.linkedChannels.size());
+    }
+    else if ((parameters.linkedChannels[0] == channel_p) || (parameters.linkedChannels[0]->get_sample_rate() != channel_p->get_sample_rate()))
+    {
+        LOG_GENERATE_ERROR(g_logger, "invalid linked channel=%d received from client", parameters.linkedChannels[0]->get_index());
+    }
+    else
+    {
+        paired_p = parameters.linkedChannels[0];
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "validate_paired_channel exit paired_p=%p", paired_p);
+    return paired_p;
+}
+
+static ResultCode create_ppm_meter(AUDIOChannel *channel_p, const AUDIOMeterRegistry::Parameters &parameters, AUDIOProcessor::Meter **meter_pp)
+{
+    LOG_GENERATE_TRACE(g_logger, "create_ppm_meter enter channel_p=%p meter_pp=%p", channel_p, meter_pp);
+
+    ResultCode result_code = validate_hold_time(parameters.holdTimeInSecs);
+    if (RESULT_CODE_OK == result_code)
+    {
+        result_code = validate_standard(parameters.standard);
+    }
+    if (RESULT_CODE_OK == result_code)
+    {
+        AUDIOProcessor::PeakMeter *meter_p = new AUDIOProcessor::PPMMeter(channel_p, parameters.standard);
+        meter_p->set_hold_time(parameters.holdTimeInSecs);
+        *meter_pp = meter_p;
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "create_ppm_meter exit result_code=%d", result_code);
+    return result_code;
+}
+
+static ResultCode create_digitalpeak_meter(AUDIOChannel *channel_p, const AUDIOMeterRegistry::Parameters &parameters, AUDIOProcessor::Meter **meter_pp)
+{
+    LOG_GENERATE_TRACE(g_logger, "create_digitalpeak_meter enter channel_p=%p meter_pp=%p", channel_p, meter_pp);
+
+    ResultCode result_code = validate_hold_time(parameters.holdTimeInSecs);
+    if (RESULT_CODE_OK == result_code)
+    {
+        AUDIOProcessor::PeakMeter *meter_p = new AUDIOProcessor::DigitalPeakMeter(channel_p);
+        meter_p->set_hold_time(parameters.holdTimeInSecs);
+        *meter_pp = meter_p;
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "create_digitalpeak_meter exit result_code=%d", result_code);
+    return result_code;
+}
+
+static ResultCode create_vu_meter(AUDIOChannel *channel_p, const AUDIOMeterRegistry::Parameters &parameters, AUDIOProcessor::Meter **meter_pp)
+{
+    LOG_GENERATE_TRACE(g_logger, "create_vu_meter enter channel_p=%p meter_pp=%p", channel_p, meter_pp);
+
+    *meter_pp = new AUDIOProcessor::VUMeter(channel_p);
+
+    LOG_GENERATE_TRACE(g_logger, "create_vu_meter exit");
+    return RESULT_CODE_OK;
+}
+
+static ResultCode create_loudness_meter(AUDIOChannel *channel_p, const AUDIOMeterRegistry::Parameters &parameters, AUDIOProcessor::Meter **meter_pp)
+{
+    LOG_GENERATE_TRACE(g_logger, "create_loudness_meter enter channel_p=%p meter_pp=%p", channel_p, meter_pp);
+
+    ResultCode result_code = RESULT_CODE_OK;
+
+    // sum in any linked channels using the BS.1770 weight for their role on the bus
+    AUDIOLoudnessMeter *meter_p = new AUDIOLoudnessMeter(channel_p);
+    for (size_t counter = 0; (RESULT_CODE_OK == result_code) && (counter < parameters.linkedChannels.size()); counter++)
+    {
+        AUDIOChannel *linked_p = parameters.linkedChannels[counter];
+        result_code = meter_p->add_channel(linked_p, AUDIOLoudnessMeter::get_default_weight(linked_p->get_role()));
+    }
+    // only hand the meter over if the whole group is valid
+    if (RESULT_CODE_OK != result_code)
+    {
+        delete meter_p;
+    }
+    else
+    {
+        *meter_pp = meter_p;
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "create_loudness_meter exit result_code=%d", result_code);
+    return result_code;
+}
+
+static ResultCode create_spectrum_meter(AUDIOChannel *channel_p, const AUDIOMeterRegistry::Parameters &parameters, AUDIOProcessor::Meter **meter_pp)
+{
+    LOG_GENERATE_TRACE(g_logger, "create_spectrum_meter enter channel_p=%p meter_pp=%p", channel_p, meter_pp);
+
+    ResultCode result_code = RESULT_CODE_OK;
+    if ((SPECTRUM_BANDS_PER_OCTAVE_OCTAVE != parameters.bandsPerOctave) && (SPECTRUM_BANDS_PER_OCTAVE_THIRD != parameters.bandsPerOctave))
+    {
+        LOG_GENERATE_ERROR(g_logger, "invalid bands per octave=%d received from client", parameters.bandsPerOctave);
+        result_code = RESULT_CODE_ERROR;
+    }
+    else
+    {
+        *meter_pp = new AUDIOSpectrumMeter(channel_p, parameters.bandsPerOctave);
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "create_spectrum_meter exit result_code=%d", result_code);
+    return result_code;
+}
+
+static ResultCode create_correlation_meter(AUDIOChannel *channel_p, const AUDIOMeterRegistry::Parameters &parameters, AUDIOProcessor::Meter **meter_pp)
+{
+    LOG_GENERATE_TRACE(g_logger, "create_correlation_meter enter channel_p=%p meter_pp=%p", channel_p, meter_pp);
+
+    ResultCode result_code = RESULT_CODE_OK;
+    AUDIOChannel *paired_p = validate_paired_channel(channel_p, parameters);
+    if (NULL == paired_p)
+    {
+        result_code = RESULT_CODE_ERROR;
+    }
+    else
+    {
+        *meter_pp = new AUDIOCorrelationMeter(channel_p, paired_p);
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "create_correlation_meter exit result_code=%d", result_code);
+    return result_code;
+}
+
+static ResultCode create_tone_meter(AUDIOChannel *channel_p, const AUDIOMeterRegistry::Parameters &parameters, AUDIOProcessor::Meter **meter_pp)
+{
+    LOG_GENERATE_TRACE(g_logger, "create_tone_meter enter channel_p=%p meter_pp=%p", channel_p, meter_pp);
+
+    ResultCode result_code = RESULT_CODE_OK;
+
+    // use the tones from the request if there are any, otherwise the configured ones
+    std::vector<float> frequencies = parameters.frequencies;
+    if (true == frequencies.empty())
+    {
+        frequencies = AUDIOToneMeter::fetch_default_frequencies();
+    }
+    if ((true == frequencies.empty()) || (TONE_MAXIMUM_TONES < frequencies.size()))
+    {
+        LOG_GENERATE_ERROR(g_logger, "invalid tone count=%d", frequencies.size());
+        result_code = RESULT_CODE_ERROR;
+    }
+    for (std::vector<float>::iterator it = frequencies.begin(); (RESULT_CODE_OK == result_code) && (it != frequencies.end()); it++)
+    {
+        if ((0.0f >= *it) || ((channel_p->get_sample_rate() / 2) <= *it))
+        {
+            LOG_GENERATE_ERROR(g_logger, "invalid tone frequency=%f", *it);
+            result_code = RESULT_CODE_ERROR;
+        }
+    }
+    if (RESULT_CODE_OK == result_code)
+    {
+        *meter_pp = new AUDIOToneMeter(channel_p, frequencies);
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "create_tone_meter exit result_code=%d", result_code);
+    return result_code;
+}
+
+static ResultCode create_crest_meter(AUDIOChannel *channel_p, const AUDIOMeterRegistry::Parameters &parameters, AUDIOProcessor::Meter **meter_pp)
+{
+    LOG_GENERATE_TRACE(g_logger, "create_crest_meter enter channel_p=%p meter_pp=%p", channel_p, meter_pp);
+
+    *meter_pp = new AUDIOCrestMeter(channel_p);
+
+    LOG_GENERATE_TRACE(g_logger, "create_crest_meter exit");
+    return RESULT_CODE_OK;
+}
+
+static ResultCode create_distortion_meter(AUDIOChannel *channel_p, const AUDIOMeterRegistry::Parameters &parameters, AUDIOProcessor::Meter **meter_pp)
+{
+    LOG_GENERATE_TRACE(g_logger, "create_distortion_meter enter channel_p=%p meter_pp=%p", channel_p, meter_pp);
+
+    ResultCode result_code = RESULT_CODE_OK;
+    if ((0.0f >= parameters.lowFrequency) || (parameters.lowFrequency >= parameters.highFrequency) || ((channel_p->get_sample_rate() / 2) <= parameters.lowFrequency))
+    {
+        LOG_GENERATE_ERROR(g_logger, "invalid distortion bandwidth low=%f high=%f", parameters.lowFrequency, parameters.highFrequency);
+        result_code = RESULT_CODE_ERROR;
+    }
+    else
+    {
+        *meter_pp = new AUDIODistortionMeter(channel_p, parameters.lowFrequency, parameters.highFrequency);
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "create_distortion_meter exit result_code=%d", result_code);
+    return result_code;
+}
+
+static ResultCode create_noisefloor_meter(AUDIOChannel *channel_p, const AUDIOMeterRegistry::Parameters &parameters, AUDIOProcessor::Meter **meter_pp)
+{
+    LOG_GENERATE_TRACE(g_logger, "create_noisefloor_meter enter channel_p=%p meter_pp=%p", channel_p, meter_pp);
+
+    *meter_pp = new AUDIONoiseFloorMeter(channel_p);
+
+    LOG_GENERATE_TRACE(g_logger, "create_noisefloor_meter exit");
+    return RESULT_CODE_OK;
+}
+
+static ResultCode create_delay_meter(AUDIOChannel *channel_p, const AUDIOMeterRegistry::Parameters &parameters, AUDIOProcessor::Meter **meter_pp)
+{
+    LOG_GENERATE_TRACE(g_logger, "create_delay_meter enter channel_p=%p meter_pp=%p", channel_p, meter_pp);
+
+    ResultCode result_code = RESULT_CODE_OK;
+    AUDIOChannel *paired_p = validate_paired_channel(channel_p, parameters);
+    if (NULL == paired_p)
+    {
+        result_code = RESULT_CODE_ERROR;
+    }
+    else
+    {
+        *meter_pp = new AUDIODelayMeter(channel_p, paired_p);
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "create_delay_meter exit result_code=%d", result_code);
+    return result_code;
+}
+
+static ResultCode create_group_meter(AUDIOChannel *channel_p, const AUDIOMeterRegistry::Parameters &parameters, AUDIOProcessor::Meter **meter_pp)
+{
+    LOG_GENERATE_TRACE(g_logger, "create_group_meter enter channel_p=%p meter_pp=%p", channel_p, meter_pp);
+
+    ResultCode result_code = RESULT_CODE_OK;
+
+    do
+    {
+        // the group needs at least one other member
+        if ((1 > parameters.linkedChannels.size()) || (GROUP_MAXIMUM_CHANNELS <= parameters.linkedChannels.size()))
+        {
+            LOG_GENERATE_ERROR(g_logger, "invalid linked channel count=%d received from client", parameters.linkedChannels.size());
+            result_code = RESULT_CODE_ERROR;
+            break;
+        }
+        if ((AUDIOProcessor::LEVEL_TYPE_PPM != parameters.ballistics) && (AUDIOProcessor::LEVEL_TYPE_DIGITALPEAK != parameters.ballistics))
+        {
+            LOG_GENERATE_ERROR(g_logger, "invalid group ballistics=%d received from client", parameters.ballistics);
+            result_code = RESULT_CODE_ERROR;
+            break;
+        }
+        result_code = validate_hold_time(parameters.holdTimeInSecs);
+        if (RESULT_CODE_OK == result_code)
+        {
+            result_code = validate_standard(parameters.standard);
+        }
+        if (RESULT_CODE_OK != result_code)
+        {
+            break;
+        }
+
+        AUDIOGroupMeter *meter_p = new AUDIOGroupMeter(channel_p, parameters.ballistics, parameters.standard);
+        for (size_t counter = 0; (RESULT_CODE_OK == result_code) && (counter < parameters.linkedChannels.size()); counter++)
+        {
+            result_code = meter_p->add_channel(parameters.linkedChannels[counter]);
+        }
+        // only hand the meter over if the whole group is valid
+        if (RESULT_CODE_OK != result_code)
+        {
+            delete meter_p;
+            break;
+        }
+        meter_p->set_hold_time(parameters.holdTimeInSecs);
+        *meter_pp = meter_p;
+    }
+    while (false);
+
+    LOG_GENERATE_TRACE(g_logger, "create_group_meter exit result_code=%d", result_code);
+    return result_code;
+}
+
+static ResultCode create_histogram_meter(AUDIOChannel *channel_p, const AUDIOMeterRegistry::Parameters &parameters, AUDIOProcessor::Meter **meter_pp)
+{
+    LOG_GENERATE_TRACE(g_logger, "create_histogram_meter enter channel_p=%p meter_pp=%p", channel_p, meter_pp);
+
+    *meter_pp = new AUDIOHistogramMeter(channel_p, parameters.window);
+
+    LOG_GENERATE_TRACE(g_logger, "create_histogram_meter exit");
+    return RESULT_CODE_OK;
+}
+
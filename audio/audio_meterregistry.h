@@ -0,0 +1,138 @@
+#ifndef _AUDIO_METERREGISTRY_H_
+#define _AUDIO_METERREGISTRY_H_
+
+#include "common.h"
+#include "audio_channel.h"
+#include "audio_processor.h"
+#include "audio_histogrammeter.h"
+#include "audio_meterplugin.h"
+
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+// the request decides how many readings there are, e.g. the spectrum bands
+#define METER_PLUGIN_VALUES_VARIABLE    (0)
+#define METER_PLUGIN_SUFFIX             ".so"
+
+///////////////////////////////////////////////////////////////////////////////
+// forward declarations
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// class definition
+///////////////////////////////////////////////////////////////////////////////
+
+class AUDIOMeterRegistry
+{
+
+///////////////////////////////////////////////////////////////////////////////
+// type definitions
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+
+    // everything a client can ask for in a SETLEVEL, each meter takes what it needs
+    typedef struct
+    {
+        // METER_HOLD_TIME_INVALID unless the client asked for one
+        uint32_t holdTimeInSecs;
+        std::vector<AUDIOChannel *> linkedChannels;
+        // empty for the configured tones
+        std::vector<float> frequencies;
+        unsigned int bandsPerOctave;
+        float lowFrequency;
+        float highFrequency;
+        AUDIOProcessor::LevelType ballistics;
+        // the PPM scale, for PPMs + groups with PPM ballistics
+        AUDIOBallistics::Standard standard;
+        AUDIOHistogramMeter::Window window;
+    } Parameters;
+
+    typedef ResultCode (*Factory)(AUDIOChannel *channel_p, const Parameters &parameters, AUDIOProcessor::Meter **meter_pp);
+
+    // the daemon's own view of a meter, the plugins' descriptors are wrapped in one of these
+    typedef struct
+    {
+        const char *name_p;
+        // LEVEL_TYPE_PLUGIN for anything that isn't built in
+        AUDIOProcessor::LevelType type;
+        // the work per sample against a simple peak meter
+        unsigned int cost;
+        // channels slower than this are refused
+        unsigned int minimumSampleRate;
+        // the readings in each result, in the order of the names
+        uint8_t valueCount;
+        const char * const *valueNames_p;
+        // the built in meters have a factory, the plugins go through their C interface instead
+        Factory factory_p;
+        const MeterPluginDescriptor *plugin_p;
+    } Descriptor;
+
+    typedef std::vector<const Descriptor *>::const_iterator DescriptorIterator;
+
+///////////////////////////////////////////////////////////////////////////////
+// public function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+
+    static AUDIOMeterRegistry *get_instance();
+
+    ResultCode register_meter(const Descriptor *descriptor_p);
+    const Descriptor *find_meter(AUDIOProcessor::LevelType type) const;
+    const Descriptor *find_meter(const char *name_p) const;
+    ResultCode create_meter(const Descriptor *descriptor_p, AUDIOChannel *channel_p, const Parameters &parameters, AUDIOProcessor::Meter **meter_pp) const;
+
+    inline DescriptorIterator begin() const;
+    inline DescriptorIterator end() const;
+
+    static void init_parameters(Parameters &parameters);
+
+///////////////////////////////////////////////////////////////////////////////
+// private function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+
+    AUDIOMeterRegistry();
+    virtual ~AUDIOMeterRegistry();
+
+    void load_plugins();
+    ResultCode load_plugin(const std::string &path);
+    static ResultCode validate_plugin(const std::string &path, const MeterPluginDescriptor *plugin_p);
+    static ResultCode create_plugin_meter(const MeterPluginDescriptor *plugin_p, AUDIOChannel *channel_p, const Parameters &parameters, AUDIOProcessor::Meter **meter_pp);
+
+///////////////////////////////////////////////////////////////////////////////
+// private variable definitions
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+    static AUDIOMeterRegistry *g_instance_p;
+
+    std::vector<const Descriptor *> m_descriptors;
+    // the descriptors wrapping the plugins' ones are ours to free
+    std::vector<Descriptor *> m_plugin_descriptors;
+    // the plugins stay loaded for as long as their meters might be running
+    std::vector<void *> m_handles;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// inline function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+inline AUDIOMeterRegistry::DescriptorIterator AUDIOMeterRegistry::begin() const
+{
+    return m_descriptors.begin();
+}
+
+inline AUDIOMeterRegistry::DescriptorIterator AUDIOMeterRegistry::end() const
+{
+    return m_descriptors.end();
+}
+
+#endif
+
@@ -0,0 +1,215 @@
+
+#include "audio_noisefloormeter.h"
+#include "log.h"
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+// ~250ms time constant on the short term energy so single clicks don't set the minimum
+#define NOISEFLOOR_SMOOTHING            (0.8f)
+
+// the floor is measured over the audio band so it can run decimated
+#define NOISEFLOOR_BANDWIDTH            (20000)
+
+///////////////////////////////////////////////////////////////////////////////
+// type defintions
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// constants
+///////////////////////////////////////////////////////////////////////////////
+
+static const float c_zero_level_in_db = -96;
+
+///////////////////////////////////////////////////////////////////////////////
+// module variables
+///////////////////////////////////////////////////////////////////////////////
+
+static LogInstance g_logger("audio.noisefloormeter");
+
+///////////////////////////////////////////////////////////////////////////////
+// private function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+static float calculate_level_in_db(float energy);
+
+///////////////////////////////////////////////////////////////////////////////
+// public function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+AUDIONoiseFloorMeter::AUDIONoiseFloorMeter(AUDIOChannel *channel_p) :
+    AUDIOProcessor::Meter(channel_p, NOISEFLOOR_BANDWIDTH),
+    m_block_length(CALC_NUM_SAMPLES_FOR_MILLIS(NOISEFLOOR_BLOCK_TIME_IN_MS, get_sample_rate())),
+    m_block_fill(0),
+    m_block_sum_squares(0.0f),
+    m_energy(0.0f),
+    m_primed(false),
+    m_subwindow_minimum(0.0f),
+    m_subwindow_fill(0),
+    m_minima_index(0),
+    m_minima_count(0),
+    m_floor(0.0f)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIONoiseFloorMeter::AUDIONoiseFloorMeter enter this=%p channel_p=%p", this, channel_p);
+
+    memset(m_minima, 0, sizeof(m_minima));
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIONoiseFloorMeter::AUDIONoiseFloorMeter exit");
+}
+
+AUDIONoiseFloorMeter::~AUDIONoiseFloorMeter()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIONoiseFloorMeter::~AUDIONoiseFloorMeter enter this=%p", this);
+    LOG_GENERATE_TRACE(g_logger, "AUDIONoiseFloorMeter::~AUDIONoiseFloorMeter exit");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// AUDIOProcessor::Meter implementation
+///////////////////////////////////////////////////////////////////////////////
+
+void AUDIONoiseFloorMeter::process_samples(const size_t buffer_length, AUDIOChannel::Sample *buffer_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIONoiseFloorMeter::process_samples enter this=%p buffer_length=%d buffer_p=%p", this, buffer_length, buffer_p);
+
+    size_t offset = 0;
+    while (offset < buffer_length)
+    {
+        const size_t count = std::min(buffer_length - offset, (size_t)(m_block_length - m_block_fill));
+        float sum_squares = 0.0f;
+        for (size_t counter = offset; counter < (offset + count); counter++)
+        {
+            sum_squares += buffer_p[counter] * buffer_p[counter];
+        }
+        m_block_sum_squares += sum_squares;
+        m_block_fill += count;
+        offset += count;
+
+        if (m_block_length == m_block_fill)
+        {
+            complete_block();
+        }
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIONoiseFloorMeter::process_samples exit");
+}
+
+AUDIOProcessor::ResultData AUDIONoiseFloorMeter::create_result_data()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIONoiseFloorMeter::create_result_data enter this=%p", this);
+    Accumulators accumulators;
+    save_accumulators(&accumulators);
+    AUDIOProcessor::ResultData data = create_accumulated_result_data(accumulators);
+    LOG_GENERATE_TRACE(g_logger, "AUDIONoiseFloorMeter::create_result_data exit");
+    return data;
+}
+
+size_t AUDIONoiseFloorMeter::get_accumulators_size() const
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIONoiseFloorMeter::get_accumulators_size enter this=%p", this);
+    LOG_GENERATE_TRACE(g_logger, "AUDIONoiseFloorMeter::get_accumulators_size exit");
+    return sizeof(Accumulators);
+}
+
+void AUDIONoiseFloorMeter::save_accumulators(void *accumulators_p) const
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIONoiseFloorMeter::save_accumulators enter this=%p accumulators_p=%p", this, accumulators_p);
+
+    Accumulators *saved_p = (Accumulators *)accumulators_p;
+    saved_p->energy = m_energy;
+    saved_p->floor = m_floor;
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIONoiseFloorMeter::save_accumulators exit");
+}
+
+void AUDIONoiseFloorMeter::queue_accumulated_result_data(const void *accumulators_p, AUDIOProcessor::ResultData &data, AUDIODecibels &decibels) const
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIONoiseFloorMeter::queue_accumulated_result_data enter this=%p accumulators_p=%p data=%p decibels=%p", this, accumulators_p, &data, &decibels);
+    // both levels share the floor's own conversion so there's nothing to batch
+    data = create_accumulated_result_data(*(const Accumulators *)accumulators_p);
+    LOG_GENERATE_TRACE(g_logger, "AUDIONoiseFloorMeter::queue_accumulated_result_data exit");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// private function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+AUDIOProcessor::ResultData AUDIONoiseFloorMeter::create_accumulated_result_data(const Accumulators &accumulators) const
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIONoiseFloorMeter::create_accumulated_result_data enter this=%p accumulators=%p", this, &accumulators);
+
+    AUDIOProcessor::ResultData data;
+    memset(&data, 0, sizeof(data));
+
+    // populate the type
+    data.type = AUDIOProcessor::LEVEL_TYPE_NOISEFLOOR;
+
+    // populate the channel
+    data.channel = get_channel_p()->get_index();
+
+    // report the live level next to the floor so a client can see the headroom
+    data.values.noisefloor.levelInDB = calculate_level_in_db(accumulators.energy);
+    data.values.noisefloor.floorInDB = calculate_level_in_db(accumulators.floor);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIONoiseFloorMeter::create_accumulated_result_data exit");
+    return data;
+}
+
+void AUDIONoiseFloorMeter::complete_block()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIONoiseFloorMeter::complete_block enter this=%p", this);
+
+    // smooth the block energy, the first block seeds the filter so we don't ramp up from silence
+    const float block_energy = m_block_sum_squares / m_block_length;
+    if (false == m_primed)
+    {
+        m_energy = block_energy;
+        m_subwindow_minimum = block_energy;
+        m_primed = true;
+    }
+    m_energy = (NOISEFLOOR_SMOOTHING * m_energy) + ((1.0f - NOISEFLOOR_SMOOTHING) * block_energy);
+    m_block_sum_squares = 0.0f;
+    m_block_fill = 0;
+
+    // track the minimum of the current sub-window
+    m_subwindow_minimum = std::min(m_subwindow_minimum, m_energy);
+    m_subwindow_fill++;
+
+    // the floor is the lowest of the completed sub-windows and the one in progress
+    m_floor = m_subwindow_minimum;
+    for (unsigned int counter = 0; counter < m_minima_count; counter++)
+    {
+        m_floor = std::min(m_floor, m_minima[counter]);
+    }
+
+    // roll the sub-window over, the oldest one drops out of the window
+    if (NOISEFLOOR_SUBWINDOW_BLOCKS == m_subwindow_fill)
+    {
+        m_minima[m_minima_index] = m_subwindow_minimum;
+        m_minima_index = (m_minima_index + 1) % NOISEFLOOR_SUBWINDOWS;
+        m_minima_count = std::min(m_minima_count + 1, (unsigned int)NOISEFLOOR_SUBWINDOWS);
+        m_subwindow_minimum = m_energy;
+        m_subwindow_fill = 0;
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIONoiseFloorMeter::complete_block exit");
+}
+
+static float calculate_level_in_db(float energy)
+{
+    LOG_GENERATE_TRACE(g_logger, "calculate_level_in_db enter energy=%f", energy);
+
+    float level_in_db = c_zero_level_in_db;
+    if (0.0f < energy)
+    {
+        level_in_db = std::max(10.0f * log10f(energy), c_zero_level_in_db);
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "calculate_level_in_db exit level_in_db=%f", level_in_db);
+    return level_in_db;
+}
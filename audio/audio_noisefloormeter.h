@@ -0,0 +1,102 @@
+#ifndef _AUDIO_NOISEFLOORMETER_H_
+#define _AUDIO_NOISEFLOORMETER_H_
+
+#include "common.h"
+#include "audio_channel.h"
+#include "audio_processor.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+// the floor is the quietest smoothed 50ms block of the last 10s, tracked as 8 sub-windows of 1.25s
+#define NOISEFLOOR_BLOCK_TIME_IN_MS     (50)
+#define NOISEFLOOR_SUBWINDOW_BLOCKS     (25)
+#define NOISEFLOOR_SUBWINDOWS           (8)
+
+///////////////////////////////////////////////////////////////////////////////
+// forward declarations
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// class definition
+///////////////////////////////////////////////////////////////////////////////
+
+class AUDIONoiseFloorMeter : public AUDIOProcessor::Meter
+{
+
+///////////////////////////////////////////////////////////////////////////////
+// type definitions
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+
+    // the energies the levels are worked out from
+    typedef struct
+    {
+        float energy;
+        float floor;
+    } Accumulators;
+
+///////////////////////////////////////////////////////////////////////////////
+// public function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+    AUDIONoiseFloorMeter(AUDIOChannel *channel_p);
+    virtual ~AUDIONoiseFloorMeter();
+
+///////////////////////////////////////////////////////////////////////////////
+// AUDIOProcessor::Meter declarations
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+    void process_samples(const size_t buffer_length, AUDIOChannel::Sample *buffer_p);
+    AUDIOProcessor::ResultData create_result_data();
+    size_t get_accumulators_size() const;
+    void save_accumulators(void *accumulators_p) const;
+    void queue_accumulated_result_data(const void *accumulators_p, AUDIOProcessor::ResultData &data, AUDIODecibels &decibels) const;
+    inline AUDIOProcessor::LevelType get_level_type();
+
+///////////////////////////////////////////////////////////////////////////////
+// private function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+    void complete_block();
+    AUDIOProcessor::ResultData create_accumulated_result_data(const Accumulators &accumulators) const;
+
+///////////////////////////////////////////////////////////////////////////////
+// private variable definitions
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+    unsigned int m_block_length;
+    unsigned int m_block_fill;
+    float m_block_sum_squares;
+
+    // smoothed short term energy
+    float m_energy;
+    bool m_primed;
+
+    // minimum of the sub-window in progress + the minima of the completed ones
+    float m_subwindow_minimum;
+    unsigned int m_subwindow_fill;
+    float m_minima[NOISEFLOOR_SUBWINDOWS];
+    unsigned int m_minima_index;
+    unsigned int m_minima_count;
+    float m_floor;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// inline function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+inline AUDIOProcessor::LevelType AUDIONoiseFloorMeter::get_level_type()
+{
+    return AUDIOProcessor::LEVEL_TYPE_NOISEFLOOR;
+}
+
+#endif
+
@@ -0,0 +1,169 @@
+
+#include "audio_overdetector.h"
+#include "config.h"
+#include "log.h"
+
+#include <math.h>
+#include <string.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+#define OVER_DETECTOR_CONFIG_SECTION                "over-detector"
+#define OVER_DETECTOR_CONSECUTIVE_CONFIG_ITEM       "consecutive-samples"
+
+///////////////////////////////////////////////////////////////////////////////
+// type defintions
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// constants
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// module variables
+///////////////////////////////////////////////////////////////////////////////
+
+static LogInstance g_logger("audio.overdetector");
+
+///////////////////////////////////////////////////////////////////////////////
+// private function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// public function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+AUDIOOverDetector::AUDIOOverDetector() :
+    m_consecutive_samples(OVER_DEFAULT_CONSECUTIVE_SAMPLES)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOOverDetector::AUDIOOverDetector enter this=%p", this);
+
+    // a single full scale sample is legal, it takes a run of them to count as an over
+    float consecutive_samples = OVER_DEFAULT_CONSECUTIVE_SAMPLES;
+    Config::get_instance_p()->get_float_with_default(OVER_DETECTOR_CONFIG_SECTION, OVER_DETECTOR_CONSECUTIVE_CONFIG_ITEM, OVER_DEFAULT_CONSECUTIVE_SAMPLES, &consecutive_samples);
+    if (1.0f <= consecutive_samples)
+    {
+        m_consecutive_samples = (unsigned int)consecutive_samples;
+    }
+    else
+    {
+        LOG_GENERATE_WARN(g_logger, "ignoring %s=%f, using %d", OVER_DETECTOR_CONSECUTIVE_CONFIG_ITEM, consecutive_samples, m_consecutive_samples);
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOOverDetector::AUDIOOverDetector exit m_consecutive_samples=%d", m_consecutive_samples);
+}
+
+AUDIOOverDetector::~AUDIOOverDetector()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOOverDetector::~AUDIOOverDetector enter this=%p", this);
+    LOG_GENERATE_TRACE(g_logger, "AUDIOOverDetector::~AUDIOOverDetector exit");
+}
+
+ResultCode AUDIOOverDetector::query_overs(const AUDIOChannel *channel_p, Overs *overs_p) const
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOOverDetector::query_overs enter this=%p channel_p=%p overs_p=%p", this, channel_p, overs_p);
+
+    ResultCode result_code = RESULT_CODE_OK;
+    memset(overs_p, 0, sizeof(*overs_p));
+
+    // a channel that hasn't delivered anything yet just reads as clean
+    std::map<AUDIOChannel::Index, Counters>::const_iterator iter = m_counters_map.find(channel_p->get_index());
+    if (iter != m_counters_map.end())
+    {
+        const Counters &counters = iter->second;
+        overs_p->position = counters.position;
+        overs_p->over_count = counters.over_count;
+        overs_p->clipped_count = counters.clipped_count;
+
+        // unroll the ring so the oldest event comes first
+        overs_p->event_count = counters.event_count;
+        const size_t oldest = (counters.event_index + OVER_MAXIMUM_EVENTS - counters.event_count) % OVER_MAXIMUM_EVENTS;
+        for (size_t counter = 0; counter < counters.event_count; counter++)
+        {
+            overs_p->events[counter] = counters.events[(oldest + counter) % OVER_MAXIMUM_EVENTS];
+        }
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOOverDetector::query_overs exit result_code=%d", result_code);
+    return result_code;
+}
+
+void AUDIOOverDetector::reset_overs(const AUDIOChannel *channel_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOOverDetector::reset_overs enter this=%p channel_p=%p", this, channel_p);
+
+    // the position keeps counting so later events still line up with earlier ones
+    std::map<AUDIOChannel::Index, Counters>::iterator iter = m_counters_map.find(channel_p->get_index());
+    if (iter != m_counters_map.end())
+    {
+        Counters &counters = iter->second;
+        counters.over_count = 0;
+        counters.clipped_count = 0;
+        counters.event_index = 0;
+        counters.event_count = 0;
+        // the run length is left alone, an over in progress has already been counted + mustn't be counted again
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOOverDetector::reset_overs exit");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// AUDIOCaptureManager::Handler implementation
+///////////////////////////////////////////////////////////////////////////////
+
+ResultCode AUDIOOverDetector::handle_samples(AUDIOChannel *channel_p, const size_t buffer_length, AUDIOChannel::Sample *buffer_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOOverDetector::handle_samples enter this=%p channel_p=%p buffer_length=%d buffer_p=%p", this, channel_p, buffer_length, buffer_p);
+
+    // first sight of a channel starts its counters from zero
+    std::map<AUDIOChannel::Index, Counters>::iterator iter = m_counters_map.find(channel_p->get_index());
+    if (iter == m_counters_map.end())
+    {
+        Counters counters;
+        memset(&counters, 0, sizeof(counters));
+        iter = m_counters_map.insert(std::make_pair(channel_p->get_index(), counters)).first;
+    }
+    Counters &counters = iter->second;
+
+    // the run carries over from the last block so an over can straddle two of them
+    const AUDIOChannel::Sample fullscale_level = channel_p->get_fullscale_level();
+    for (size_t counter = 0; counter < buffer_length; counter++)
+    {
+        if (fullscale_level > fabsf(buffer_p[counter]))
+        {
+            counters.run_length = 0;
+            continue;
+        }
+
+        counters.clipped_count++;
+        counters.run_length++;
+        if (counters.run_length == m_consecutive_samples)
+        {
+            // log the event as soon as it qualifies, its length grows while the run lasts
+            counters.over_count++;
+            Event &event = counters.events[counters.event_index];
+            event.position = counters.position + counter + 1 - m_consecutive_samples;
+            event.length = counters.run_length;
+            counters.event_index = (counters.event_index + 1) % OVER_MAXIMUM_EVENTS;
+            if (OVER_MAXIMUM_EVENTS > counters.event_count)
+            {
+                counters.event_count++;
+            }
+            LOG_GENERATE_DEBUG(g_logger, "over on channel=%d at position=%llu", channel_p->get_index(), (unsigned long long)event.position);
+        }
+        // a run counted before a reset has no event left to grow
+        else if ((counters.run_length > m_consecutive_samples) && (0 < counters.event_count))
+        {
+            counters.events[(counters.event_index + OVER_MAXIMUM_EVENTS - 1) % OVER_MAXIMUM_EVENTS].length = counters.run_length;
+        }
+    }
+    counters.position += buffer_length;
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOOverDetector::handle_samples exit");
+    return RESULT_CODE_OK;
+}
@@ -0,0 +1,106 @@
+#ifndef _AUDIO_OVERDETECTOR_H_
+#define _AUDIO_OVERDETECTOR_H_
+
+#include "common.h"
+#include "audio_channel.h"
+#include "audio_capturemgr.h"
+
+#include <map>
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+#define OVER_DEFAULT_CONSECUTIVE_SAMPLES    (3)
+#define OVER_MAXIMUM_EVENTS                 (16)
+
+///////////////////////////////////////////////////////////////////////////////
+// forward declarations
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// class definition
+///////////////////////////////////////////////////////////////////////////////
+
+class AUDIOOverDetector : public AUDIOCaptureManager::Handler
+{
+
+///////////////////////////////////////////////////////////////////////////////
+// type definitions
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+
+    typedef struct
+    {
+        // sample position of the first full scale sample
+        uint64_t position;
+        uint32_t length;
+    } Event;
+
+    typedef struct
+    {
+        uint64_t position;
+        uint32_t over_count;
+        uint64_t clipped_count;
+        // oldest first
+        size_t event_count;
+        Event events[OVER_MAXIMUM_EVENTS];
+    } Overs;
+
+private:
+
+    typedef struct
+    {
+        uint64_t position;
+        uint32_t over_count;
+        uint64_t clipped_count;
+        uint32_t run_length;
+        Event events[OVER_MAXIMUM_EVENTS];
+        size_t event_index;
+        size_t event_count;
+    } Counters;
+
+///////////////////////////////////////////////////////////////////////////////
+// public function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+
+    AUDIOOverDetector();
+    virtual ~AUDIOOverDetector();
+
+    inline unsigned int get_consecutive_samples() const;
+    ResultCode query_overs(const AUDIOChannel *channel_p, Overs *overs_p) const;
+    void reset_overs(const AUDIOChannel *channel_p);
+
+///////////////////////////////////////////////////////////////////////////////
+// AUDIOCaptureManager::Handler declarations
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+
+    ResultCode handle_samples(AUDIOChannel *channel_p, const size_t buffer_length, AUDIOChannel::Sample *buffer_p);
+
+///////////////////////////////////////////////////////////////////////////////
+// private variable definitions
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+    unsigned int m_consecutive_samples;
+    std::map<AUDIOChannel::Index, Counters> m_counters_map;
+
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// inline function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+inline unsigned int AUDIOOverDetector::get_consecutive_samples() const
+{
+    return m_consecutive_samples;
+}
+
+#endif
+
@@ -0,0 +1,158 @@
+#include "audio_pairqueue.h"
+#include "log.h"
+
+#include <algorithm>
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// type defintions
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// constants
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// module variables
+///////////////////////////////////////////////////////////////////////////////
+
+static LogInstance g_logger("audio.pairqueue");
+
+///////////////////////////////////////////////////////////////////////////////
+// private function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// public function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+AUDIOPairQueue::AUDIOPairQueue(const AUDIOChannel *channel_p, size_t capacity) :
+    m_channel_p(channel_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOPairQueue::AUDIOPairQueue enter this=%p channel_p=%p capacity=%d", this, channel_p, capacity);
+
+    for (int side = PAIR_QUEUE_LEFT; side <= PAIR_QUEUE_RIGHT; side++)
+    {
+        m_pending[side].samples.resize(capacity);
+        m_pending[side].read_index = 0;
+        m_pending[side].count = 0;
+        m_pending[side].position = 0;
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOPairQueue::AUDIOPairQueue exit");
+}
+
+AUDIOPairQueue::~AUDIOPairQueue()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOPairQueue::~AUDIOPairQueue enter this=%p", this);
+    LOG_GENERATE_TRACE(g_logger, "AUDIOPairQueue::~AUDIOPairQueue exit");
+}
+
+void AUDIOPairQueue::queue(unsigned int side, uint64_t position, const size_t buffer_length, const AUDIOChannel::Sample *buffer_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOPairQueue::queue enter this=%p side=%d position=%llu buffer_length=%d buffer_p=%p", this, side, (unsigned long long)position, buffer_length, buffer_p);
+
+    Pending &pending = m_pending[side];
+    const size_t capacity = pending.samples.size();
+
+    // an empty side simply starts at the block, otherwise it has to carry on from what's queued
+    const uint64_t end = pending.position + pending.count;
+    size_t skip = 0;
+    if (position < end)
+    {
+        skip = (size_t)std::min(end - position, (uint64_t)buffer_length);
+    }
+    else if (0 == pending.count)
+    {
+        pending.position = position;
+    }
+    else if (position > end)
+    {
+        LOG_GENERATE_WARN(g_logger, "gap of %llu samples on side=%d for channel=%d", (unsigned long long)(position - end), side, m_channel_p->get_index());
+        drop(pending, pending.count);
+        pending.position = position;
+    }
+
+    // only the newest samples fit if the block itself is bigger than the queue
+    if ((buffer_length - skip) > capacity)
+    {
+        drop(pending, pending.count);
+        skip = buffer_length - capacity;
+        pending.position = position + skip;
+    }
+
+    // if the other side has stalled drop our oldest samples, the positions keep the pairing honest
+    if ((pending.count + buffer_length - skip) > capacity)
+    {
+        size_t dropped = pending.count + buffer_length - skip - capacity;
+        LOG_GENERATE_WARN(g_logger, "dropping %d unpaired samples on side=%d for channel=%d", dropped, side, m_channel_p->get_index());
+        drop(pending, dropped);
+    }
+
+    for (size_t counter = skip; counter < buffer_length; counter++)
+    {
+        pending.samples[(pending.read_index + pending.count) % capacity] = buffer_p[counter];
+        pending.count++;
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOPairQueue::queue exit");
+}
+
+size_t AUDIOPairQueue::align()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOPairQueue::align enter this=%p", this);
+
+    Pending &left = m_pending[PAIR_QUEUE_LEFT];
+    Pending &right = m_pending[PAIR_QUEUE_RIGHT];
+
+    // anything older than the other side's oldest sample will never have a partner
+    if (left.position < right.position)
+    {
+        drop(left, (size_t)std::min(right.position - left.position, (uint64_t)left.count));
+    }
+    if (right.position < left.position)
+    {
+        drop(right, (size_t)std::min(left.position - right.position, (uint64_t)right.count));
+    }
+
+    size_t pairs = 0;
+    if (left.position == right.position)
+    {
+        pairs = std::min(left.count, right.count);
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOPairQueue::align exit pairs=%d", pairs);
+    return pairs;
+}
+
+void AUDIOPairQueue::consume(size_t count)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOPairQueue::consume enter this=%p count=%d", this, count);
+
+    drop(m_pending[PAIR_QUEUE_LEFT], count);
+    drop(m_pending[PAIR_QUEUE_RIGHT], count);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOPairQueue::consume exit");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// private function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+void AUDIOPairQueue::drop(Pending &pending, size_t count)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOPairQueue::drop enter this=%p pending=%p count=%d", this, &pending, count);
+
+    pending.read_index = (pending.read_index + count) % pending.samples.size();
+    pending.count -= count;
+    pending.position += count;
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOPairQueue::drop exit");
+}
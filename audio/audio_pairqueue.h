@@ -0,0 +1,91 @@
+#ifndef _AUDIO_PAIRQUEUE_H_
+#define _AUDIO_PAIRQUEUE_H_
+
+#include "common.h"
+#include "audio_channel.h"
+
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+#define PAIR_QUEUE_LEFT     (0)
+#define PAIR_QUEUE_RIGHT    (1)
+
+///////////////////////////////////////////////////////////////////////////////
+// forward declarations
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// class definition
+///////////////////////////////////////////////////////////////////////////////
+
+// holds the blocks of two channels until the other side has the same capture positions
+class AUDIOPairQueue
+{
+
+///////////////////////////////////////////////////////////////////////////////
+// type definitions
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+
+    typedef struct
+    {
+        std::vector<AUDIOChannel::Sample> samples;
+        size_t read_index;
+        size_t count;
+        // capture position of the sample at read_index
+        uint64_t position;
+    } Pending;
+
+///////////////////////////////////////////////////////////////////////////////
+// public function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+    AUDIOPairQueue(const AUDIOChannel *channel_p, size_t capacity);
+    virtual ~AUDIOPairQueue();
+
+    void queue(unsigned int side, uint64_t position, const size_t buffer_length, const AUDIOChannel::Sample *buffer_p);
+    size_t align();
+    void consume(size_t count);
+
+    inline AUDIOChannel::Sample peek(unsigned int side, size_t offset) const;
+    inline uint64_t get_position() const;
+
+///////////////////////////////////////////////////////////////////////////////
+// private function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+    void drop(Pending &pending, size_t count);
+
+///////////////////////////////////////////////////////////////////////////////
+// private variable definitions
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+    // only used to say whose samples were dropped
+    const AUDIOChannel *m_channel_p;
+    Pending m_pending[2];
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// inline function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+inline AUDIOChannel::Sample AUDIOPairQueue::peek(unsigned int side, size_t offset) const
+{
+    const Pending &pending = m_pending[side];
+    return pending.samples[(pending.read_index + offset) % pending.samples.size()];
+}
+
+inline uint64_t AUDIOPairQueue::get_position() const
+{
+    return m_pending[PAIR_QUEUE_LEFT].position;
+}
+
+#endif
@@ -0,0 +1,82 @@
+#include "audio_pluginmeter.h"
+#include "log.h"
+
+#include <string.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// type defintions
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// module variables
+///////////////////////////////////////////////////////////////////////////////
+
+static LogInstance g_logger("audio.pluginmeter");
+
+///////////////////////////////////////////////////////////////////////////////
+// public function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+AUDIOPluginMeter::AUDIOPluginMeter(AUDIOChannel *channel_p, const MeterPluginDescriptor *plugin_p, void *state_p) :
+    AUDIOProcessor::Meter(channel_p),
+    m_plugin_p(plugin_p),
+    m_state_p(state_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOPluginMeter::AUDIOPluginMeter enter this=%p channel_p=%p plugin_p=%p state_p=%p", this, channel_p, plugin_p, state_p);
+
+    memset(m_values, 0, sizeof(m_values));
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOPluginMeter::AUDIOPluginMeter exit");
+}
+
+AUDIOPluginMeter::~AUDIOPluginMeter()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOPluginMeter::~AUDIOPluginMeter enter this=%p", this);
+
+    m_plugin_p->destroy_p(m_state_p);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOPluginMeter::~AUDIOPluginMeter exit");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// AUDIOProcessor::Meter implementation
+///////////////////////////////////////////////////////////////////////////////
+
+void AUDIOPluginMeter::process_samples(const size_t buffer_length, AUDIOChannel::Sample *buffer_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOPluginMeter::process_samples enter this=%p buffer_length=%d buffer_p=%p", this, buffer_length, buffer_p);
+
+    // the buffer is shared with the other meters on the channel so the plugin only gets to read it
+    m_plugin_p->process_p(m_state_p, buffer_p, buffer_length);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOPluginMeter::process_samples exit");
+}
+
+AUDIOProcessor::ResultData AUDIOPluginMeter::create_result_data()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOPluginMeter::create_result_data enter this=%p", this);
+
+    AUDIOProcessor::ResultData data;
+    memset(&data, 0, sizeof(data));
+
+    // populate the type
+    data.type = AUDIOProcessor::LEVEL_TYPE_PLUGIN;
+
+    // populate the channel
+    data.channel = get_channel_p()->get_index();
+
+    // the registry refused any plugin with more readings than the buffer holds
+    m_plugin_p->result_p(m_state_p, m_values);
+    data.values.plugin.name_p = m_plugin_p->name_p;
+    data.values.plugin.valueCount = (uint8_t)m_plugin_p->valueCount;
+    data.values.plugin.values_p = m_values;
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOPluginMeter::create_result_data exit");
+    return data;
+}
@@ -0,0 +1,65 @@
+#ifndef _AUDIO_PLUGINMETER_H_
+#define _AUDIO_PLUGINMETER_H_
+
+#include "common.h"
+#include "audio_channel.h"
+#include "audio_processor.h"
+#include "audio_meterplugin.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// forward declarations
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// class definition
+///////////////////////////////////////////////////////////////////////////////
+
+// runs a plugin's meter through its C interface so the plugin never sees the Meter class
+class AUDIOPluginMeter : public AUDIOProcessor::Meter
+{
+
+///////////////////////////////////////////////////////////////////////////////
+// public function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+    // takes over the state the plugin's create handed back
+    AUDIOPluginMeter(AUDIOChannel *channel_p, const MeterPluginDescriptor *plugin_p, void *state_p);
+    virtual ~AUDIOPluginMeter();
+
+///////////////////////////////////////////////////////////////////////////////
+// AUDIOProcessor::Meter declarations
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+    void process_samples(const size_t buffer_length, AUDIOChannel::Sample *buffer_p);
+    AUDIOProcessor::ResultData create_result_data();
+    inline AUDIOProcessor::LevelType get_level_type();
+
+///////////////////////////////////////////////////////////////////////////////
+// private variable definitions
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+    const MeterPluginDescriptor *m_plugin_p;
+    void *m_state_p;
+    // the plugin writes its readings here, they stay put until the next tick
+    float m_values[METER_PLUGIN_MAXIMUM_VALUES];
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// inline function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+inline AUDIOProcessor::LevelType AUDIOPluginMeter::get_level_type()
+{
+    return AUDIOProcessor::LEVEL_TYPE_PLUGIN;
+}
+
+#endif
@@ -4,14 +4,24 @@
 
 #include "audio_processor.h"
 #include "audio_capturemgr.h"
+#include "audio_decimator.h"
+#include "audio_graph.h"
+#include "audio_workerpool.h"
+#include "audio_alarmengine.h"
+#include "audio_meterregistry.h"
+#include "audio_decibels.h"
+#include "config.h"
 #include "log.h"
 
 #include <ev.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
 #include <string.h>
 #include <stdint.h>
 #include <time.h>
+#include <sched.h>
+#include <set>
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -22,16 +32,32 @@
 #define UPDATE_FREQUENCY        (1.0f/UPDATES_PER_SECOND)
 #define VU_NUMBER_OF_SAMPLES(x)	((3 * x) / 10)   // 300ms of samples
 #define ZERO_DB_RMS_VOLTAGE     (0.775f)
-#define ZERO_DB_PEAK_VOLTAGE    (1.0f)
 #define ZERO_VU_LEVEL_IN_DB     (4.0f)
-
-// reference: http://en.wikipedia.org/wiki/Peak_programme_meter
-// -2dB (80%) in 5ms -> 40% in 2.5ms
-#define PPM_TYPE_1_INTEGRATION_RISE_LEVEL (0.4f)
-#define PPM_TYPE_1_INTEGRATION_RISE_TIME  (0.0025f)
-// -24dB in 1.7s 
-#define PPM_TYPE_1_INTEGRATION_DROP_LEVEL  (powf(10.0f, (-24.0f / 20.f)))
-#define PPM_TYPE_1_INTEGRATION_DROP_TIME   (2.8f)
+#ifdef AUDIO_FIXED_POINT
+// there is no integer decimator so the VU stays at the full rate to keep off the FPU
+#define VU_BANDWIDTH            (METER_BANDWIDTH_FULL)
+#else
+// IEC 60268-17 only asks for a flat response up to 10kHz
+#define VU_BANDWIDTH            (10000)
+#endif
+#define VU_FIXED_FULL_SCALE     (32768.0f)
+
+#define WORKER_POOL_CONFIG_SECTION          "worker-pool"
+#define WORKER_POOL_THREADS_CONFIG_ITEM     "threads"
+#define WORKER_POOL_DEFAULT_THREADS         (0)
+
+#define INLINE_METERING_CONFIG_SECTION      "inline-metering"
+#define INLINE_METERING_ENABLED_CONFIG_ITEM "enabled"
+#define INLINE_METERING_DEFAULT_ENABLED     (0)
+
+#define METER_CONFIG_SECTION                "meter-%d"
+#define METER_CHANNEL_CONFIG_ITEM           "channel"
+#define METER_TYPE_CONFIG_ITEM              "type"
+#define METER_WEIGHTING_CONFIG_ITEM         "weighting"
+#define METER_LINKED_CHANNEL_CONFIG_ITEM    "linked-channel"
+#define METER_HOLD_TIME_CONFIG_ITEM         "hold-time"
+#define METER_LOW_FREQUENCY_CONFIG_ITEM     "low-frequency"
+#define METER_HIGH_FREQUENCY_CONFIG_ITEM    "high-frequency"
 
 ///////////////////////////////////////////////////////////////////////////////
 // type defintions
@@ -54,16 +80,23 @@ static LogInstance g_logger("audio.processor");
 // private function declarations
 ///////////////////////////////////////////////////////////////////////////////
 
+static AUDIOWorkerPool *create_worker_pool();
+
 
 ///////////////////////////////////////////////////////////////////////////////
 // public function implementations
 ///////////////////////////////////////////////////////////////////////////////
 
-AUDIOProcessor::AUDIOProcessor() :
+AUDIOProcessor::AUDIOProcessor(struct ev_loop *loop_p) :
     m_handler_p(NULL),
-    m_loop_p(ev_default_loop(0))
+    m_loop_p(loop_p),
+    m_pool_p(create_worker_pool()),
+    m_graph_p(new AUDIOGraph(m_pool_p)),
+    m_alarm_engine_p(new AUDIOAlarmEngine(UPDATE_FREQUENCY)),
+    m_decibels_p(new AUDIODecibels()),
+    m_level_notifications(true)
 {
-    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::AUDIOProcessor enter this=%p", this);
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::AUDIOProcessor enter this=%p loop_p=%p", this, loop_p);
 
     // register for audio data
     AUDIOCaptureManager::get_instance()->add_handler(this);
@@ -73,6 +106,31 @@ AUDIOProcessor::AUDIOProcessor() :
     m_timer.data = (void *)this;
     ev_timer_start(m_loop_p, &m_timer);
 
+    // the captured channels can be metered on their capture threads instead of coming through the pipe
+    float enabled = INLINE_METERING_DEFAULT_ENABLED;
+    Config::get_instance_p()->get_float_with_default(INLINE_METERING_CONFIG_SECTION, INLINE_METERING_ENABLED_CONFIG_ITEM, INLINE_METERING_DEFAULT_ENABLED, &enabled);
+    if (0.0f != enabled)
+    {
+        AUDIOCaptureManager *manager_p = AUDIOCaptureManager::get_instance();
+        for (AUDIOCaptureManager::ChannelIterator it = manager_p->begin();
+                it != manager_p->end();
+                it++)
+        {
+            if (true == it->second->is_captured())
+            {
+                m_inline_slots_map[it->first].version_p = NULL;
+            }
+        }
+        manager_p->set_inline_handler(this);
+        LOG_GENERATE_INFO(g_logger, "inline metering enabled channels=%d", m_inline_slots_map.size());
+    }
+
+    // the configured alarms are watched whether or not a client is metering their channels
+    update_alarm_meters();
+
+    // the configured meters are there before the client asks for anything, a SETLEVEL replaces them like any other
+    add_configured_meters();
+
     LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::AUDIOProcessor exit");
 }
 
@@ -83,6 +141,27 @@ AUDIOProcessor::~AUDIOProcessor()
     // deregister
     AUDIOCaptureManager::get_instance()->remove_handler(this);
 
+    // let the workers finish with the meters before they go
+    m_graph_p->wait();
+
+    // the capture threads are clear of every version once the handler is gone
+    if (false == m_inline_slots_map.empty())
+    {
+        AUDIOCaptureManager::get_instance()->set_inline_handler(NULL);
+        for (std::map<AUDIOChannel::Index, InlineSlot>::iterator it = m_inline_slots_map.begin();
+                it != m_inline_slots_map.end();
+                it++)
+        {
+            if (NULL != it->second.version_p)
+            {
+                // the meter goes with the rest below
+                release_inline_version(it->second.version_p);
+                it->second.version_p = NULL;
+            }
+        }
+        reclaim_inline_versions(true);
+    }
+
     // release the meters (if they exist)
     for (std::map<AUDIOChannel::Index, Meter *>::iterator it = m_meters_map.begin();
             it != m_meters_map.end();
@@ -91,6 +170,22 @@ AUDIOProcessor::~AUDIOProcessor()
         Meter *meter_p = it->second;
         delete meter_p;
     }
+    for (std::map<AlarmMeterKey, Meter *>::iterator it = m_alarm_meters_map.begin();
+            it != m_alarm_meters_map.end();
+            it++)
+    {
+        delete it->second;
+    }
+
+    // release the processing graph, then the threads it ran on
+    delete m_graph_p;
+    delete m_pool_p;
+
+    // release the alarm rules
+    delete m_alarm_engine_p;
+
+    // release the level conversion
+    delete m_decibels_p;
 
     // stop the timer
     ev_timer_stop(m_loop_p, &m_timer);
@@ -102,34 +197,121 @@ void AUDIOProcessor::add_meter(Meter *meter_p)
 {
     LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::add_meter enter this=%p meter_p=%p", this, meter_p);
 
-    // release the existing meter (if it exists)
-    std::map<AUDIOChannel::Index, Meter *>::iterator it = m_meters_map.find(meter_p->get_channel_p()->get_index());
-    if (it != m_meters_map.end())
+    install_meter(meter_p);
+
+    // the new meter's weighting + rate get wired in
+    rebuild();
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::add_meter exit");
+}
+
+void AUDIOProcessor::add_configured_meters()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::add_configured_meters enter this=%p", this);
+
+    // sections are numbered from one, the first one missing ends the list
+    const Config *config_p = Config::get_instance_p();
+    AUDIOCaptureManager *manager_p = AUDIOCaptureManager::get_instance();
+    AUDIOMeterRegistry *registry_p = AUDIOMeterRegistry::get_instance();
+    bool changed = false;
+    for (int counter = 1; ; counter++)
     {
-        // delete the meter
-        delete it->second;
-        // erase it from the lookup
-        m_meters_map.erase(it);
+        char section[128];
+        snprintf(section, sizeof(section), METER_CONFIG_SECTION, counter);
+        const char *type_p = NULL;
+        config_p->get_string_with_default(section, METER_TYPE_CONFIG_ITEM, NULL, &type_p);
+        if (NULL == type_p)
+        {
+            break;
+        }
+
+        // with shards the meter is only added by the shard that has the channel
+        float channel = 0.0f;
+        config_p->get_float_with_default(section, METER_CHANNEL_CONFIG_ITEM, 0.0f, &channel);
+        if (false == manager_p->owns_index((AUDIOChannel::Index)channel))
+        {
+            LOG_GENERATE_DEBUG(g_logger, "leaving meter section=%s to the shard with channel=%f", section, channel);
+            continue;
+        }
+
+        // a bad section is skipped rather than stopping the rest
+        AUDIOChannel *channel_p = manager_p->find_channel((AUDIOChannel::Index)channel);
+        const AUDIOMeterRegistry::Descriptor *descriptor_p = registry_p->find_meter(type_p);
+        if ((NULL == channel_p) || (NULL == descriptor_p))
+        {
+            LOG_GENERATE_ERROR(g_logger, "meter section=%s has unknown channel=%f or type=%s", section, channel, type_p);
+            continue;
+        }
+
+        // the same parameters a client can set, anything left out takes the client's default
+        AUDIOMeterRegistry::Parameters parameters;
+        AUDIOMeterRegistry::init_parameters(parameters);
+        float hold_time = (float)parameters.holdTimeInSecs;
+        float linked = 0.0f;
+        config_p->get_float_with_default(section, METER_HOLD_TIME_CONFIG_ITEM, hold_time, &hold_time);
+        config_p->get_float_with_default(section, METER_LOW_FREQUENCY_CONFIG_ITEM, parameters.lowFrequency, &parameters.lowFrequency);
+        config_p->get_float_with_default(section, METER_HIGH_FREQUENCY_CONFIG_ITEM, parameters.highFrequency, &parameters.highFrequency);
+        config_p->get_float_with_default(section, METER_LINKED_CHANNEL_CONFIG_ITEM, 0.0f, &linked);
+        parameters.holdTimeInSecs = (uint32_t)std::max(hold_time, 0.0f);
+        if (0.0f != linked)
+        {
+            AUDIOChannel *linked_p = manager_p->find_channel((AUDIOChannel::Index)linked);
+            if (NULL == linked_p)
+            {
+                LOG_GENERATE_ERROR(g_logger, "meter section=%s has unknown linked channel=%f", section, linked);
+                continue;
+            }
+            parameters.linkedChannels.push_back(linked_p);
+        }
+
+        const char *weighting_p = NULL;
+        config_p->get_string_with_default(section, METER_WEIGHTING_CONFIG_ITEM, "z", &weighting_p);
+        Weighting weighting = WEIGHTING_Z;
+        if (0 == strcmp(weighting_p, "a"))
+        {
+            weighting = WEIGHTING_A;
+        }
+        else if (0 == strcmp(weighting_p, "c"))
+        {
+            weighting = WEIGHTING_C;
+        }
+
+        Meter *meter_p = NULL;
+        if (RESULT_CODE_OK != registry_p->create_meter(descriptor_p, channel_p, parameters, &meter_p))
+        {
+            LOG_GENERATE_ERROR(g_logger, "unable to create the meter for section=%s", section);
+            continue;
+        }
+        meter_p->set_weighting(weighting);
+        LOG_GENERATE_INFO(g_logger, "metering channel=%d with type=%s from section=%s", channel_p->get_index(), type_p, section);
+        install_meter(meter_p);
+        changed = true;
     }
 
-    // store the new meter
-    m_meters_map[meter_p->get_channel_p()->get_index()] = meter_p;
+    // the whole description goes into the one build
+    if (true == changed)
+    {
+        rebuild();
+    }
 
-    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::add_meter exit");
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::add_configured_meters exit");
 }
 
 void AUDIOProcessor::clear_meter(AUDIOChannel *channel_p)
 {
     LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::clear_meter enter this=%p channel_p=%p", this, channel_p);
 
+    m_graph_p->wait();
+
     // release the existing meter (if it exists)
     std::map<AUDIOChannel::Index, Meter *>::iterator it = m_meters_map.find(channel_p->get_index());
     if (it != m_meters_map.end())
     {
-        // delete the meter
-        delete it->second;
         // erase it from the lookup
+        Meter *meter_p = it->second;
         m_meters_map.erase(it);
+        // delete the meter
+        release_meter(meter_p);
     }
 
     LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::clear_meter exit");
@@ -139,6 +321,9 @@ const AUDIOProcessor::Meter *AUDIOProcessor::get_meter(const AUDIOChannel *chann
 {
     LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::get_meter enter this=%p channel_p=%d", this, channel_p);
 
+    // the caller reads the meter's state so the workers have to be done with it
+    m_graph_p->wait();
+
     // find the meter (if it exists)
     Meter *meter_p = find_meter_by_channel_index(channel_p->get_index());
 
@@ -146,21 +331,116 @@ const AUDIOProcessor::Meter *AUDIOProcessor::get_meter(const AUDIOChannel *chann
     return meter_p;
 }
 
-ResultCode AUDIOProcessor::handle_samples(AUDIOChannel *channel_p, const size_t buffer_length, AUDIOChannel::Sample *buffer_p)
+ResultCode AUDIOProcessor::set_weighting(const AUDIOChannel *channel_p, Weighting weighting)
 {
-    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::handler_samples enter this=%p channel_p=%p buffer_length=%d buffer_p=%p", this, channel_p, buffer_length, buffer_p);
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::set_weighting enter this=%p channel_p=%p weighting=%d", this, channel_p, weighting);
+
+    // assume failure
+    ResultCode result_code = RESULT_CODE_ERROR;
 
-    // if we have a meter let it do its thing
+    m_graph_p->wait();
+
+    // the weighting belongs to the meter so it goes away with it
     Meter *meter_p = find_meter_by_channel_index(channel_p->get_index());
     if (NULL != meter_p)
     {
-        meter_p->process_samples(buffer_length, buffer_p);
+        meter_p->set_weighting(weighting);
+        rebuild();
+        result_code = RESULT_CODE_OK;
+    }
+    else
+    {
+        LOG_GENERATE_ERROR(g_logger, "no meter for channel=%d", channel_p->get_index());
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::set_weighting exit result_code=%d", result_code);
+    return result_code;
+}
+
+ResultCode AUDIOProcessor::set_alarm_rules(const std::vector<AlarmRule> &rules)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::set_alarm_rules enter this=%p count=%d", this, rules.size());
+
+    // the configured rules stay, these replace whatever the client sent last time
+    ResultCode result_code = m_alarm_engine_p->set_rules(rules);
+    if (RESULT_CODE_OK == result_code)
+    {
+        update_alarm_meters();
     }
 
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::set_alarm_rules exit result_code=%d", result_code);
+    return result_code;
+}
+
+void AUDIOProcessor::set_level_notifications(bool enabled)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::set_level_notifications enter this=%p enabled=%d", this, enabled);
+
+    m_level_notifications = enabled;
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::set_level_notifications exit");
+}
+
+ResultCode AUDIOProcessor::handle_samples(AUDIOChannel *channel_p, const size_t buffer_length, AUDIOChannel::Sample *buffer_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::handler_samples enter this=%p channel_p=%p buffer_length=%d buffer_p=%p", this, channel_p, buffer_length, buffer_p);
+
+    // each weighting + rate in use on the channel is worked out once + shared by every meter reading it
+    m_graph_p->run(channel_p, channel_p->get_position(), buffer_length, buffer_p);
+
     LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::handler_samples exit");
     return RESULT_CODE_OK;
 }
 
+void AUDIOProcessor::handle_inline_samples(AUDIOChannel *channel_p, uint64_t position, const size_t buffer_length, AUDIOChannel::Sample *buffer_p, const AUDIOChannel::Fixed *fixed_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::handle_inline_samples enter this=%p channel_p=%p position=%llu buffer_length=%d buffer_p=%p fixed_p=%p", this, channel_p, (unsigned long long)position, buffer_length, buffer_p, fixed_p);
+
+    // this runs on the capture thread so it only reads the slots + writes its own accumulators
+    std::map<AUDIOChannel::Index, InlineSlot>::const_iterator it = m_inline_slots_map.find(channel_p->get_index());
+    if (m_inline_slots_map.end() != it)
+    {
+        InlineVersion *version_p = __atomic_load_n(&it->second.version_p, __ATOMIC_SEQ_CST);
+        if (NULL != version_p)
+        {
+            // buffer_p is only scratch alongside a Q31 block
+            if ((NULL != fixed_p) && (true == version_p->graph_p->needs_samples(channel_p)))
+            {
+                AUDIOChannel::to_samples(buffer_length, fixed_p, buffer_p);
+            }
+            version_p->graph_p->run(channel_p, position, buffer_length, buffer_p, fixed_p);
+
+            // only the raw accumulators are copied out here, the tick works the result out from them
+            version_p->meter_p->save_accumulators(version_p->saved_p);
+            publish_inline_accumulators(version_p);
+        }
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::handle_inline_samples exit");
+}
+
+ResultCode AUDIOProcessor::handle_fixed_samples(AUDIOChannel *channel_p, const size_t buffer_length, const AUDIOChannel::Fixed *fixed_p, AUDIOChannel::Sample *buffer_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::handle_fixed_samples enter this=%p channel_p=%p buffer_length=%d fixed_p=%p buffer_p=%p", this, channel_p, buffer_length, fixed_p, buffer_p);
+
+    // meters reading the raw channel take the Q31 block, the rest the float one
+    m_graph_p->run(channel_p, channel_p->get_position(), buffer_length, buffer_p, fixed_p);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::handle_fixed_samples exit");
+    return RESULT_CODE_OK;
+}
+
+bool AUDIOProcessor::needs_samples(const AUDIOChannel *channel_p) const
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::needs_samples enter this=%p channel_p=%p", this, channel_p);
+
+    // a channel only read by Q31 meters never needs the float copy
+    bool needs = m_graph_p->needs_samples(channel_p);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::needs_samples exit needs=%d", needs);
+    return needs;
+}
+
 void AUDIOProcessor::add_handler(AUDIOProcessor::Handler *handler_p)
 {
     LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::add_handler enter this=%p handler_p=%p", this, handler_p);
@@ -199,6 +479,62 @@ AUDIOProcessor::Meter::~Meter()
     LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::Meter::~Meter exit");
 }
 
+void AUDIOProcessor::Meter::process_linked_samples(const AUDIOChannel *channel_p, const size_t buffer_length, AUDIOChannel::Sample *buffer_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::Meter::process_linked_samples enter this=%p channel_p=%p buffer_length=%d buffer_p=%p", this, channel_p, buffer_length, buffer_p);
+    // single channel meters have nothing linked so there is nothing to do
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::Meter::process_linked_samples exit");
+}
+
+void AUDIOProcessor::Meter::process_fixed_samples(const size_t buffer_length, const AUDIOChannel::Fixed *buffer_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::Meter::process_fixed_samples enter this=%p buffer_length=%d buffer_p=%p", this, buffer_length, buffer_p);
+
+    // meters without an integer path work in float
+    AUDIOChannel::Sample samples[buffer_length];
+    AUDIOChannel::to_samples(buffer_length, buffer_p, samples);
+    process_samples(buffer_length, samples);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::Meter::process_fixed_samples exit");
+}
+
+void AUDIOProcessor::Meter::queue_result_data(ResultData &data, AUDIODecibels &decibels)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::Meter::queue_result_data enter this=%p data=%p decibels=%p", this, &data, &decibels);
+    // meters that work out their own levels just fill the record straight away
+    data = create_result_data();
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::Meter::queue_result_data exit");
+}
+
+size_t AUDIOProcessor::Meter::get_accumulators_size() const
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::Meter::get_accumulators_size enter this=%p", this);
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::Meter::get_accumulators_size exit");
+    return 0;
+}
+
+void AUDIOProcessor::Meter::save_accumulators(void *accumulators_p) const
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::Meter::save_accumulators enter this=%p accumulators_p=%p", this, accumulators_p);
+    // nothing to save without any accumulators
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::Meter::save_accumulators exit");
+}
+
+void AUDIOProcessor::Meter::queue_accumulated_result_data(const void *accumulators_p, ResultData &data, AUDIODecibels &decibels) const
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::Meter::queue_accumulated_result_data enter this=%p accumulators_p=%p data=%p decibels=%p", this, accumulators_p, &data, &decibels);
+    // never called on a meter without accumulators
+    memset(&data, 0, sizeof(data));
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::Meter::queue_accumulated_result_data exit");
+}
+
+bool AUDIOProcessor::Meter::is_fixed_point() const
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::Meter::is_fixed_point enter this=%p", this);
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::Meter::is_fixed_point exit");
+    return false;
+}
+
 AUDIOProcessor::PeakMeter::~PeakMeter()
 {
     LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::PeakMeter::~PeakMeter enter this=%p", this);
@@ -225,14 +561,16 @@ void AUDIOProcessor::PeakMeter::set_hold_time(uint32_t hold_time)
     LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::PeakMeter::set_hold_time exit");
 }
 
-AUDIOProcessor::PPMMeter::PPMMeter(AUDIOChannel *channel_p) :
+AUDIOProcessor::PPMMeter::PPMMeter(AUDIOChannel *channel_p, AUDIOBallistics::Standard standard) :
     AUDIOProcessor::PeakMeter::PeakMeter(channel_p)
 {
-    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::PPMMeter::PPMMeter enter this=%p channel_p=%p", this, channel_p);
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::PPMMeter::PPMMeter enter this=%p channel_p=%p standard=%d", this, channel_p, standard);
 
     // calculate the rise and fall factors
-    m_rise_factor = 1.0f - powf(PPM_TYPE_1_INTEGRATION_RISE_LEVEL, 1.0f / ((float)(channel_p->get_sample_rate()) * PPM_TYPE_1_INTEGRATION_RISE_TIME));
-    m_fall_factor = powf(PPM_TYPE_1_INTEGRATION_DROP_LEVEL, 1.0f / ((float)(channel_p->get_sample_rate()) * PPM_TYPE_1_INTEGRATION_DROP_TIME));
+    set_standard(standard);
+
+    // the channel's full scale only moves the level so work it out once
+    m_offset_in_db = 20.0f * log10f(channel_p->get_fullscale_voltage() / ZERO_DB_PEAK_VOLTAGE);
 
     LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::PPMMeter::PPMMeter exit");
 }
@@ -243,49 +581,83 @@ AUDIOProcessor::PPMMeter::~PPMMeter()
     LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::PPMMeter::~PPMMeter exit");
 }
 
+#ifdef AUDIO_FIXED_POINT
 void AUDIOProcessor::PPMMeter::process_samples(const size_t buffer_length, AUDIOChannel::Sample *buffer_p)
 {
     LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::PPMMeter::process_samples enter this=%p buffer_length=%d buffer_p=%p", this, buffer_length, buffer_p);
 
-    AUDIOChannel::Sample min = 1.0f;
-    AUDIOChannel::Sample max = AUDIO_CHANNEL_ZERO_LEVEL;
+    // weighted samples still come in as float
+    AUDIOChannel::Fixed samples[buffer_length];
+    AUDIOChannel::to_fixed(buffer_length, buffer_p, samples);
+    process_fixed_samples(buffer_length, samples);
 
-    // calculate the peak amplitude for the signal
-    for (int counter = 0; counter < buffer_length; counter++)
-    {
-        // take the absolute value
-        AUDIOChannel::Sample amplitude = fabs(buffer_p[counter]);
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::PPMMeter::process_samples exit");
+}
 
-        // calculate the min + max amplitude
-        min = std::min(amplitude, min);
-        max = std::max(amplitude, max);
+void AUDIOProcessor::PPMMeter::process_fixed_samples(const size_t buffer_length, const AUDIOChannel::Fixed *buffer_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::PPMMeter::process_fixed_samples enter this=%p buffer_length=%d buffer_p=%p", this, buffer_length, buffer_p);
 
-        // see if this sample is larger then the current peak
-        if (amplitude > get_peak())
-        {
-            // calculate the new peak
-            float new_peak = get_peak() + m_rise_factor * (amplitude - get_peak());
-            // set it 
-            set_peak(new_peak);
-        }
-        else
-        {
-            // attenuate
-            float new_peak = get_peak() * m_fall_factor; 
-            set_peak(new_peak);
-        }
-    }
+    // same integrator as the float path with the factors in Q31
+    process_ballistics<AUDIOBallistics::IntegratingAttack, AUDIOBallistics::ExponentialRelease>(buffer_length, buffer_p);
 
-    LOG_GENERATE_DEBUG(g_logger, "ppm min=%d max=%d", min, max);
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::PPMMeter::process_fixed_samples exit");
+}
+#else
+void AUDIOProcessor::PPMMeter::process_samples(const size_t buffer_length, AUDIOChannel::Sample *buffer_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::PPMMeter::process_samples enter this=%p buffer_length=%d buffer_p=%p", this, buffer_length, buffer_p);
+
+    // integrate up towards each louder sample, fall away otherwise
+    process_ballistics<AUDIOBallistics::IntegratingAttack, AUDIOBallistics::ExponentialRelease>(buffer_length, buffer_p);
 
     LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::PPMMeter::process_samples exit");
 }
+#endif
 
 AUDIOProcessor::ResultData AUDIOProcessor::PPMMeter::create_result_data()
 {
     LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::PPMMeter::create_result_data enter this=%p", this);
+    AUDIOProcessor::ResultData data = create_queued_result_data();
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::PPMMeter::create_result_data exit");
+    return data;
+}
+
+void AUDIOProcessor::PPMMeter::queue_result_data(ResultData &data, AUDIODecibels &decibels)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::PPMMeter::queue_result_data enter this=%p data=%p decibels=%p", this, &data, &decibels);
+
+    Accumulators accumulators;
+    save_accumulators(&accumulators);
+    queue_accumulated_result_data(&accumulators, data, decibels);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::PPMMeter::queue_result_data exit");
+}
+
+size_t AUDIOProcessor::PPMMeter::get_accumulators_size() const
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::PPMMeter::get_accumulators_size enter this=%p", this);
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::PPMMeter::get_accumulators_size exit");
+    return sizeof(Accumulators);
+}
+
+void AUDIOProcessor::PPMMeter::save_accumulators(void *accumulators_p) const
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::PPMMeter::save_accumulators enter this=%p accumulators_p=%p", this, accumulators_p);
+
+    Accumulators *saved_p = (Accumulators *)accumulators_p;
+    saved_p->peak = get_peak();
+    saved_p->hold = get_hold();
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::PPMMeter::save_accumulators exit");
+}
+
+void AUDIOProcessor::PPMMeter::queue_accumulated_result_data(const void *accumulators_p, ResultData &data, AUDIODecibels &decibels) const
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::PPMMeter::queue_accumulated_result_data enter this=%p accumulators_p=%p data=%p decibels=%p", this, accumulators_p, &data, &decibels);
+
+    const Accumulators *saved_p = (const Accumulators *)accumulators_p;
 
-    AUDIOProcessor::ResultData data;
     memset(&data, 0, sizeof(data));
 
     // populate the type
@@ -294,33 +666,15 @@ AUDIOProcessor::ResultData AUDIOProcessor::PPMMeter::create_result_data()
     // populate the channel
     data.channel = get_channel_p()->get_index();
 
-    // get the fullscale voltage
-    const float fullscale_voltage = get_channel_p()->get_fullscale_voltage();
-
-    // assume the levels are zero for now
-    data.values.peak.peakInDB = c_zero_level_in_db;
-    data.values.peak.holdInDB = c_zero_level_in_db;
-    // if this is zero then the level is dB is negative infinity
-    if (AUDIO_CHANNEL_ZERO_LEVEL != get_peak())
-    {
-        // convert the normalized sample to a voltage
-        float voltage = get_peak() * fullscale_voltage;
-        // do the voltage to dBu conversion 
-        data.values.peak.peakInDB = 20.f * log10f(voltage / ZERO_DB_PEAK_VOLTAGE);
-    }
-    if (AUDIO_CHANNEL_ZERO_LEVEL != get_hold())
-    {
-        // convert the normalized sample to a voltage
-        float voltage = get_hold() * fullscale_voltage;    
-        // do the voltage to dBu conversion 
-        data.values.peak.holdInDB = 20.f * log10f(voltage / ZERO_DB_PEAK_VOLTAGE);
-    }
-
-    LOG_GENERATE_DEBUG(g_logger, "ppm peak(dB)=%f hold(dB)=%f", data.values.peak.peakInDB, data.values.peak.holdInDB);
+    // the fullscale voltage to dBu step is already folded into the offset
+    const AUDIOChannel::Sample peak = level_to_sample(saved_p->peak);
+    const AUDIOChannel::Sample hold = level_to_sample(saved_p->hold);
+    decibels.add(peak, m_offset_in_db, c_zero_level_in_db, &data.values.peak.peakInDB);
+    decibels.add(hold, m_offset_in_db, c_zero_level_in_db, &data.values.peak.holdInDB);
 
+    LOG_GENERATE_DEBUG(g_logger, "ppm peak=%f hold=%f", peak, hold);
 
-    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::PPMMeter::create_result_data exit");
-    return data;
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::PPMMeter::queue_accumulated_result_data exit");
 }
 
 AUDIOProcessor::DigitalPeakMeter::DigitalPeakMeter(AUDIOChannel *channel_p) :
@@ -336,31 +690,51 @@ AUDIOProcessor::DigitalPeakMeter::~DigitalPeakMeter()
     LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::DigitalPeakMeter::~DigitalPeakMeter exit");
 }
 
+#ifdef AUDIO_FIXED_POINT
 void AUDIOProcessor::DigitalPeakMeter::process_samples(const size_t buffer_length, AUDIOChannel::Sample *buffer_p)
 {
     LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::DigitalPeakMeter::process_samples enter this=%p buffer_length=%d buffer_p=%p", this, buffer_length, buffer_p);
 
-    // calculate the peak amplitude for the signal
-    for (int counter = 0; counter < buffer_length; counter++)
-    {
-        // take the absolute value
-        AUDIOChannel::Sample amplitude = fabs(buffer_p[counter]);
-        // if this sample is larger then last one calculated for the channel then
-        // store it
-        if (amplitude > get_peak())
-        {
-            set_peak(amplitude);
-        }
-    }
+    // weighted samples still come in as float
+    AUDIOChannel::Fixed samples[buffer_length];
+    AUDIOChannel::to_fixed(buffer_length, buffer_p, samples);
+    process_fixed_samples(buffer_length, samples);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::DigitalPeakMeter::process_samples exit");
+}
+
+void AUDIOProcessor::DigitalPeakMeter::process_fixed_samples(const size_t buffer_length, const AUDIOChannel::Fixed *buffer_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::DigitalPeakMeter::process_fixed_samples enter this=%p buffer_length=%d buffer_p=%p", this, buffer_length, buffer_p);
+
+    process_ballistics<AUDIOBallistics::InstantAttack, AUDIOBallistics::NoRelease>(buffer_length, buffer_p);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::DigitalPeakMeter::process_fixed_samples exit");
+}
+#else
+void AUDIOProcessor::DigitalPeakMeter::process_samples(const size_t buffer_length, AUDIOChannel::Sample *buffer_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::DigitalPeakMeter::process_samples enter this=%p buffer_length=%d buffer_p=%p", this, buffer_length, buffer_p);
+
+    // the largest sample since the last read, it only drops when it's reported
+    process_ballistics<AUDIOBallistics::InstantAttack, AUDIOBallistics::NoRelease>(buffer_length, buffer_p);
 
     LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::DigitalPeakMeter::process_samples exit");
 }
+#endif
 
 AUDIOProcessor::ResultData AUDIOProcessor::DigitalPeakMeter::create_result_data()
 {
     LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::DigitalPeakMeter::create_result_data enter this=%p", this);
+    AUDIOProcessor::ResultData data = create_queued_result_data();
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::DigitalPeakMeter::create_result_data exit");
+    return data;
+}
+
+void AUDIOProcessor::DigitalPeakMeter::queue_result_data(ResultData &data, AUDIODecibels &decibels)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::DigitalPeakMeter::queue_result_data enter this=%p data=%p decibels=%p", this, &data, &decibels);
 
-    AUDIOProcessor::ResultData data;
     memset(&data, 0, sizeof(data));
 
     // populate the type
@@ -369,37 +743,34 @@ AUDIOProcessor::ResultData AUDIOProcessor::DigitalPeakMeter::create_result_data(
     // populate the channel
     data.channel = get_channel_p()->get_index();
 
-    // assume the levels are zero for now
-    data.values.peak.peakInDB = c_zero_level_in_db;
-    data.values.peak.holdInDB = c_zero_level_in_db;
-    // if this is zero then the level is dB is negative infinity
-    if (AUDIO_CHANNEL_ZERO_LEVEL != get_peak())
-    {
-        // do the voltage to dB conversion 
-        data.values.peak.peakInDB = 20.f * log10f(get_peak());
-    }
-    if (AUDIO_CHANNEL_ZERO_LEVEL != get_hold())
-    {
-        // do the voltage to dB conversion 
-        data.values.peak.holdInDB = 20.f * log10f(get_peak());
-    }
+    // digital levels are relative to full scale so there is no offset
+    const AUDIOChannel::Sample peak = level_to_sample(get_peak());
+    decibels.add(peak, 0.0f, c_zero_level_in_db, &data.values.peak.peakInDB);
+    decibels.add(peak, 0.0f, c_zero_level_in_db, &data.values.peak.holdInDB);
 
-    LOG_GENERATE_DEBUG(g_logger, "digital peak(dB)=%f hold(dB)=%f", data.values.peak.peakInDB, data.values.peak.holdInDB);
+    LOG_GENERATE_DEBUG(g_logger, "digital peak=%f", peak);
 
     // reset the peak
     set_peak(AUDIO_CHANNEL_ZERO_LEVEL);
 
-    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::DigitalPeakMeter::create_result_data exit");
-    return data;
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::DigitalPeakMeter::queue_result_data exit");
 }
 
 AUDIOProcessor::VUMeter::VUMeter(AUDIOChannel *channel_p) :
-    AUDIOProcessor::Meter(channel_p),
+    AUDIOProcessor::Meter(channel_p, VU_BANDWIDTH),
     m_sample_index(0),
-    m_sample_count(VU_NUMBER_OF_SAMPLES(channel_p->get_sample_rate()))
+    m_sample_count(VU_NUMBER_OF_SAMPLES(get_sample_rate()))
 {
     LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::VUMeter::VUMeter enter this=%p channel_p=%p", this, channel_p);
+    // full scale to dBm and dBm to VU where 4 dBm = 0VU are both fixed per channel
+    m_offset_in_db = (20.0f * log10f(channel_p->get_fullscale_voltage() / ZERO_DB_RMS_VOLTAGE)) - ZERO_VU_LEVEL_IN_DB;
+#ifdef AUDIO_FIXED_POINT
+    m_samples_p = (int16_t *)calloc(1, sizeof(int16_t) * m_sample_count);
+    m_sum_squares = 0;
+#else
     m_samples_p = (AUDIOChannel::Sample *)calloc(1, sizeof(AUDIOChannel::Sample) * m_sample_count);
+    m_sum_squares = 0.0;
+#endif
     LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::VUMeter::VUMeter exit");
 }
 
@@ -409,26 +780,114 @@ AUDIOProcessor::VUMeter::~VUMeter()
     LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::VUMeter::~VUMeter exit");
 }
 
+#ifdef AUDIO_FIXED_POINT
+void AUDIOProcessor::VUMeter::process_samples(const size_t buffer_length, AUDIOChannel::Sample *buffer_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::VUMeter::process_samples enter this=%p buffer_length=%d buffer_p=%p", this, buffer_length, buffer_p);
+
+    // weighted samples still come in as float
+    AUDIOChannel::Fixed samples[buffer_length];
+    AUDIOChannel::to_fixed(buffer_length, buffer_p, samples);
+    process_fixed_samples(buffer_length, samples);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::VUMeter::process_samples exit");
+}
+
+void AUDIOProcessor::VUMeter::process_fixed_samples(const size_t buffer_length, const AUDIOChannel::Fixed *buffer_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::VUMeter::process_fixed_samples enter this=%p buffer_length=%d buffer_p=%p", this, buffer_length, buffer_p);
+
+    for (size_t counter = 0; counter < buffer_length; counter++)
+    {
+        // integer sums are exact so the running total never drifts
+        const int32_t sample = buffer_p[counter] >> 16;
+        const int32_t oldest = m_samples_p[m_sample_index];
+        m_sum_squares += (int64_t)(sample * sample) - (int64_t)(oldest * oldest);
+        m_samples_p[m_sample_index] = (int16_t)sample;
+        // advance to the next sample position taking care to wrap
+        m_sample_index = (m_sample_index + 1) % m_sample_count;
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::VUMeter::process_fixed_samples exit");
+}
+#else
 void AUDIOProcessor::VUMeter::process_samples(const size_t buffer_length, AUDIOChannel::Sample *buffer_p)
 {
     LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::VUMeter::process_samples enter this=%p buffer_length=%d buffer_p=%p", this, buffer_length, buffer_p);
     // store the samples we've received
     for (int counter = 0; counter < buffer_length; counter++)
     {
-        // copy over the sample
-        m_samples_p[m_sample_index] = buffer_p[counter];
+        // swap the oldest sample's square for the new one's
+        const AUDIOChannel::Sample sample = buffer_p[counter];
+        const AUDIOChannel::Sample oldest = m_samples_p[m_sample_index];
+        m_sum_squares += (double)(sample * sample) - (double)(oldest * oldest);
+        m_samples_p[m_sample_index] = sample;
         // advance to the next sample position taking care to wrap
         m_sample_index = (m_sample_index + 1) % m_sample_count;
+        if (0 == m_sample_index)
+        {
+            // once per window, so any rounding left in the running sum goes with it
+            double sum_squares = 0.0;
+            for (unsigned int index = 0; index < m_sample_count; index++)
+            {
+                sum_squares += m_samples_p[index] * m_samples_p[index];
+            }
+            m_sum_squares = sum_squares;
+        }
     }
 
     LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::VUMeter::process_samples exit");
 }
+#endif
 
 AUDIOProcessor::ResultData AUDIOProcessor::VUMeter::create_result_data()
 {
     LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::VUMeter::create_result_data enter this=%p", this);
+    AUDIOProcessor::ResultData data = create_queued_result_data();
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::VUMeter::create_result_data exit");
+    return data;
+}
+
+void AUDIOProcessor::VUMeter::queue_result_data(ResultData &data, AUDIODecibels &decibels)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::VUMeter::queue_result_data enter this=%p data=%p decibels=%p", this, &data, &decibels);
+
+    Accumulators accumulators;
+    save_accumulators(&accumulators);
+    queue_accumulated_result_data(&accumulators, data, decibels);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::VUMeter::queue_result_data exit");
+}
+
+size_t AUDIOProcessor::VUMeter::get_accumulators_size() const
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::VUMeter::get_accumulators_size enter this=%p", this);
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::VUMeter::get_accumulators_size exit");
+    return sizeof(Accumulators);
+}
+
+void AUDIOProcessor::VUMeter::save_accumulators(void *accumulators_p) const
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::VUMeter::save_accumulators enter this=%p accumulators_p=%p", this, accumulators_p);
+
+    // the sum is kept as samples come in so only the scaling is left to do
+    Accumulators *saved_p = (Accumulators *)accumulators_p;
+#ifdef AUDIO_FIXED_POINT
+    const float scale = 1.0f / VU_FIXED_FULL_SCALE;
+    saved_p->sum_squares = (float)m_sum_squares * scale * scale;
+#else
+    saved_p->sum_squares = (float)m_sum_squares;
+#endif
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::VUMeter::save_accumulators exit");
+}
+
+void AUDIOProcessor::VUMeter::queue_accumulated_result_data(const void *accumulators_p, ResultData &data, AUDIODecibels &decibels) const
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::VUMeter::queue_accumulated_result_data enter this=%p accumulators_p=%p data=%p decibels=%p", this, accumulators_p, &data, &decibels);
+
+    const Accumulators *saved_p = (const Accumulators *)accumulators_p;
 
-    AUDIOProcessor::ResultData data;
     memset(&data, 0, sizeof(data));
 
     // populate the type
@@ -437,50 +896,74 @@ AUDIOProcessor::ResultData AUDIOProcessor::VUMeter::create_result_data()
     // populate the channel
     data.channel = get_channel_p()->get_index();
 
-    // get the fullscale voltage
-    const float fullscale_voltage = get_channel_p()->get_fullscale_voltage();
+    // round up to zero just in case some float weirdness resulted in a negative number
+    const float sum_squares = std::max(saved_p->sum_squares, 0.0f);
 
-    // assume for now that there is no signal
-    float voltageInDB = c_zero_level_in_db;
+    // finish the root-mean-squared (RMS) value of the 300ms of audio we have cached, the dBm to VU step is part of the offset too
+    float rms = sqrtf(sum_squares / m_sample_count);
+    decibels.add(rms, m_offset_in_db, c_zero_level_in_db - ZERO_VU_LEVEL_IN_DB, &data.values.vuInUnits);
 
-    // calculate the root-mean-squared (RMS) value of the 300ms of audio we have cached
-    float sum_squares = 0.0f;
-    for (int counter = 0; counter < m_sample_count; counter++)
-    {
-        // convert the normalized value into a voltage 
-        float voltage = m_samples_p[counter] * fullscale_voltage;
-        // square the voltage
-        sum_squares += voltage * voltage;
-    }
-    // round up to zero just in case some float weirdness resulted in a negative number
-    sum_squares = std::max(sum_squares, 0.0f);
+    LOG_GENERATE_DEBUG(g_logger, "vu rms=%f", rms);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::VUMeter::queue_accumulated_result_data exit");
+}
 
-    // only convert to DB if there was a signal
-    if (0.0f < sum_squares)
+///////////////////////////////////////////////////////////////////////////////
+// protected function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+AUDIOProcessor::Meter::Meter(AUDIOChannel *channel_p, unsigned int required_bandwidth) :
+    m_channel_p(channel_p),
+    m_weighting(WEIGHTING_Z),
+    m_decimation_stages(0),
+    m_cost(METER_COST_DEFAULT),
+    m_block_position(0)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::Meter::Meter enter this=%p channel_p=%p required_bandwidth=%d", this, channel_p, required_bandwidth);
+
+    // halve the rate for as long as the meter still gets the bandwidth it asked for
+    if (METER_BANDWIDTH_FULL != required_bandwidth)
     {
-        // finish the RMS calculation
-        float rms = sqrtf(sum_squares / m_sample_count);
-        voltageInDB = 20.0f * log10f(rms / ZERO_DB_RMS_VOLTAGE);
+        while ((METER_DECIMATION_MAXIMUM_STAGES > m_decimation_stages) &&
+                ((AUDIO_DECIMATOR_PASSBAND_RATIO * (channel_p->get_sample_rate() >> (m_decimation_stages + 1))) >= required_bandwidth))
+        {
+            m_decimation_stages++;
+        }
     }
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::Meter::Meter exit");
+}
 
-    // convert dBm to VU where 4 dBM = 0VU
-    data.values.vuInUnits = voltageInDB - ZERO_VU_LEVEL_IN_DB;
+AUDIOProcessor::ResultData AUDIOProcessor::Meter::create_queued_result_data()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::Meter::create_queued_result_data enter this=%p", this);
 
-    LOG_GENERATE_DEBUG(g_logger, "vu value(units)=%f", data.values.vuInUnits);
+    // a batch of one for callers outside the timer
+    AUDIODecibels decibels;
+    ResultData data;
+    queue_result_data(data, decibels);
+    decibels.convert();
 
-    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::VUMeter::create_result_data exit");
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::Meter::create_queued_result_data exit");
     return data;
 }
 
-///////////////////////////////////////////////////////////////////////////////
-// protected function implementations
-///////////////////////////////////////////////////////////////////////////////
+void AUDIOProcessor::Meter::add_linked_channel(AUDIOChannel *channel_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::Meter::add_linked_channel enter this=%p channel_p=%p", this, channel_p);
+
+    m_linked_channels.push_back(channel_p);
 
-AUDIOProcessor::Meter::Meter(AUDIOChannel *channel_p) :
-    m_channel_p(channel_p)
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::Meter::add_linked_channel exit");
+}
+
+void AUDIOProcessor::Meter::set_weighting(Weighting weighting)
 {
-    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::Meter::Meter enter this=%p channel_p=%p", this, channel_p);
-    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::Meter::Meter exit");
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::Meter::set_weighting enter this=%p weighting=%d", this, weighting);
+
+    ASSERT(METER_WEIGHTING_COUNT > weighting);
+    m_weighting = weighting;
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::Meter::set_weighting exit");
 }
 
 
@@ -489,15 +972,26 @@ AUDIOProcessor::PeakMeter::PeakMeter(AUDIOChannel *channel_p) :
     m_hold_time(METER_HOLD_TIME_INVALID),
     m_peak(AUDIO_CHANNEL_ZERO_LEVEL),
     m_hold(AUDIO_CHANNEL_ZERO_LEVEL),
-    m_last_timestamp(0)
+    m_last_timestamp(0),
+    m_standard(AUDIOBallistics::STANDARD_LEGACY)
 {
     LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::PeakMeter::PeakMeter enter this=%p channel_p=%p", this, channel_p);
+
+    // follow the signal straight up + down until a standard is set
+    m_coefficients.rise = 1.0f;
+    m_coefficients.fall = 1.0f;
+    m_coefficients.fixedRise = AUDIO_CHANNEL_FIXED_MAXIMUM;
+    m_coefficients.fixedFall = AUDIO_CHANNEL_FIXED_MAXIMUM;
     LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::PeakMeter::PeakMeter exit");
 }
 
-void AUDIOProcessor::PeakMeter::set_peak(AUDIOChannel::Sample peak)
+void AUDIOProcessor::PeakMeter::set_peak(Level peak)
 {
+#ifdef AUDIO_FIXED_POINT
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::PeakMeter::set_peak enter this=%p peak=%d", this, peak);
+#else
     LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::PeakMeter::set_peak enter this=%p peak=%f", this, peak);
+#endif
     // update the peak value
     m_peak = peak;
     // see if a hold time is set
@@ -519,6 +1013,16 @@ void AUDIOProcessor::PeakMeter::set_peak(AUDIOChannel::Sample peak)
     LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::PeakMeter::setpeak exit");
 }
 
+void AUDIOProcessor::PeakMeter::set_standard(AUDIOBallistics::Standard standard)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::PeakMeter::set_standard enter this=%p standard=%d", this, standard);
+
+    m_standard = standard;
+    AUDIOBallistics::calculate_coefficients(standard, get_sample_rate(), &m_coefficients);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::PeakMeter::set_standard exit");
+}
+
 
 ///////////////////////////////////////////////////////////////////////////////
 // private function implementations
@@ -531,33 +1035,75 @@ void AUDIOProcessor::timer_cb(EV_P_ ev_timer *w_p, int revents)
     // get the object
     AUDIOProcessor *processor_p = (AUDIOProcessor *)w_p->data;
 
+    // anything swapped out of the capture threads since the last tick can go once they've moved on
+    processor_p->reclaim_inline_versions(false);
+
     // we only call the handler if we have a handler
     if (NULL != processor_p->m_handler_p)
     {
-        // size the result array to the number of meters we have
+        // every block read since the last tick has to be through its meters first
+        processor_p->m_graph_p->wait();
+
+        // size the result array to the number of meters we have, with a spare so it's never empty
         const size_t channel_count = processor_p->m_meters_map.size();
-        // see if we have any active channels
-        if (0 < channel_count)
-        {
-            ResultData result_data[channel_count];
-        
-            // iterate through all meters
-            size_t index = 0;
-            for (std::map<AUDIOChannel::Index, Meter *>::iterator it = processor_p->m_meters_map.begin();
-                it != processor_p->m_meters_map.end();
-                it++)
+        ResultData result_data[channel_count + 1];
+        const size_t alarm_count = processor_p->m_alarm_meters_map.size();
+        ResultData alarm_data[alarm_count + 1];
+
+        // iterate through all meters
+        size_t index = 0;
+        for (std::map<AUDIOChannel::Index, Meter *>::iterator it = processor_p->m_meters_map.begin();
+            it != processor_p->m_meters_map.end();
+            it++)
+        {
+            // get the meter
+            Meter *meter_p = it->second;
+            InlineVersion *version_p = processor_p->find_inline_version(meter_p);
+            if (NULL != version_p)
+            {
+                // metered on its capture thread, it's left out until its first block
+                if (false == read_inline_accumulators(version_p))
+                {
+                    continue;
+                }
+                meter_p->queue_accumulated_result_data(version_p->read_p, result_data[index], *processor_p->m_decibels_p);
+            }
+            else
             {
-                // get the meter
-                Meter *meter_p = it->second;
-                // get the channel
-                const AUDIOChannel *channel_p = meter_p->get_channel_p();
-                // generate the result data
-                result_data[index] = meter_p->create_result_data();
-                index++;
+                // generate the result data, the levels are filled in below
+                meter_p->queue_result_data(result_data[index], *processor_p->m_decibels_p);
             }
+            result_data[index].weighting = meter_p->get_weighting();
+            index++;
+        }
+        const size_t result_count = index;
 
-            // call the handler
-            processor_p->m_handler_p->handle_results(channel_count, result_data);
+        // the rules only ever read their own meters, whatever the client has on the channel
+        index = 0;
+        for (std::map<AlarmMeterKey, Meter *>::iterator it = processor_p->m_alarm_meters_map.begin();
+            it != processor_p->m_alarm_meters_map.end();
+            it++)
+        {
+            it->second->queue_result_data(alarm_data[index], *processor_p->m_decibels_p);
+            alarm_data[index].weighting = it->second->get_weighting();
+            index++;
+        }
+
+        // every meter's dB conversion in one pass
+        processor_p->m_decibels_p->convert();
+
+        // call the handler, a client only after alarms can turn the levels off
+        if ((0 < result_count) && (true == processor_p->m_level_notifications))
+        {
+            processor_p->m_handler_p->handle_results(result_count, result_data);
+        }
+
+        // the rules still get a look with no meters running so they can clear
+        std::vector<AlarmData> alarms;
+        processor_p->m_alarm_engine_p->evaluate(alarm_count, alarm_data, alarms);
+        if (false == alarms.empty())
+        {
+            processor_p->m_handler_p->handle_alarms(alarms.size(), &alarms[0]);
         }
     }
 
@@ -579,3 +1125,372 @@ AUDIOProcessor::Meter *AUDIOProcessor::find_meter_by_channel_index(AUDIOChannel:
     LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::find_meter_by_channel_index exit meter_p=%p", meter_p);
     return meter_p;
 }
+
+void AUDIOProcessor::update_alarm_meters()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::update_alarm_meters enter this=%p", this);
+
+    // the configured + client rules are metered the same way, one meter per channel + type
+    std::set<AlarmMeterKey> wanted;
+    for (int set = 0; set < 2; set++)
+    {
+        const std::vector<AlarmRule> &rules = (0 == set) ? m_alarm_engine_p->get_configured_rules() : m_alarm_engine_p->get_client_rules();
+        for (std::vector<AlarmRule>::const_iterator it = rules.begin();
+                it != rules.end();
+                it++)
+        {
+            wanted.insert(std::make_pair(it->channel, it->type));
+        }
+    }
+
+    // a meter no rule reads any more can go once the workers are done with it
+    m_graph_p->wait();
+    bool changed = false;
+    std::map<AlarmMeterKey, Meter *>::iterator it = m_alarm_meters_map.begin();
+    while (it != m_alarm_meters_map.end())
+    {
+        if (0 == wanted.count(it->first))
+        {
+            delete it->second;
+            m_alarm_meters_map.erase(it++);
+            changed = true;
+        }
+        else
+        {
+            it++;
+        }
+    }
+
+    AUDIOMeterRegistry *registry_p = AUDIOMeterRegistry::get_instance();
+    for (std::set<AlarmMeterKey>::const_iterator key_it = wanted.begin();
+            key_it != wanted.end();
+            key_it++)
+    {
+        if (m_alarm_meters_map.end() != m_alarm_meters_map.find(*key_it))
+        {
+            continue;
+        }
+        AUDIOChannel *channel_p = AUDIOCaptureManager::get_instance()->find_channel(key_it->first);
+        if (NULL == channel_p)
+        {
+            LOG_GENERATE_WARN(g_logger, "alarm rules are for channel=%d, which isn't captured here", key_it->first);
+            continue;
+        }
+        const AUDIOMeterRegistry::Descriptor *descriptor_p = registry_p->find_meter(key_it->second);
+        AUDIOMeterRegistry::Parameters parameters;
+        AUDIOMeterRegistry::init_parameters(parameters);
+        Meter *meter_p = NULL;
+        if ((NULL == descriptor_p) || (RESULT_CODE_OK != registry_p->create_meter(descriptor_p, channel_p, parameters, &meter_p)))
+        {
+            // the paired meters need a channel the rule can't name
+            LOG_GENERATE_WARN(g_logger, "unable to create type=%d meter for alarm rules on channel=%d", key_it->second, key_it->first);
+            continue;
+        }
+        LOG_GENERATE_INFO(g_logger, "metering channel=%d with type=%d for alarm rules", key_it->first, key_it->second);
+        m_alarm_meters_map[*key_it] = meter_p;
+        changed = true;
+    }
+
+    if (true == changed)
+    {
+        rebuild();
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::update_alarm_meters exit count=%d", m_alarm_meters_map.size());
+}
+
+void AUDIOProcessor::install_meter(Meter *meter_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::install_meter enter this=%p meter_p=%p", this, meter_p);
+
+    // the meter being replaced may still be working through a block
+    m_graph_p->wait();
+
+    // release the existing meter (if it exists)
+    std::map<AUDIOChannel::Index, Meter *>::iterator it = m_meters_map.find(meter_p->get_channel_p()->get_index());
+    if (it != m_meters_map.end())
+    {
+        // erase it from the lookup
+        Meter *existing_p = it->second;
+        m_meters_map.erase(it);
+        // delete the meter
+        release_meter(existing_p);
+    }
+
+    // store the new meter
+    m_meters_map[meter_p->get_channel_p()->get_index()] = meter_p;
+
+    // the meter also wants the samples from any channels linked to it
+    const std::vector<AUDIOChannel *> &linked_channels = meter_p->get_linked_channels();
+    for (std::vector<AUDIOChannel *>::const_iterator link_it = linked_channels.begin();
+            link_it != linked_channels.end();
+            link_it++)
+    {
+        m_linked_meters_map.insert(std::make_pair((*link_it)->get_index(), meter_p));
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::install_meter exit");
+}
+
+void AUDIOProcessor::release_meter(Meter *meter_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::release_meter enter this=%p meter_p=%p", this, meter_p);
+
+    // remove any links to the meter
+    std::multimap<AUDIOChannel::Index, Meter *>::iterator it = m_linked_meters_map.begin();
+    while (it != m_linked_meters_map.end())
+    {
+        if (meter_p == it->second)
+        {
+            m_linked_meters_map.erase(it++);
+        }
+        else
+        {
+            it++;
+        }
+    }
+
+    // a meter on a capture thread is deleted with its version once that thread is clear of it
+    if (NULL == find_inline_version(meter_p))
+    {
+        delete meter_p;
+    }
+
+    // rewire without it, dropping any filters only it was using
+    rebuild();
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::release_meter exit");
+}
+
+void AUDIOProcessor::rebuild()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::rebuild enter this=%p", this);
+
+    // the meters running on the capture threads are left out of the loop's graph
+    std::multimap<AUDIOChannel::Index, Meter *> loop_meters_map;
+    for (std::map<AUDIOChannel::Index, Meter *>::iterator it = m_meters_map.begin();
+            it != m_meters_map.end();
+            it++)
+    {
+        if ((m_inline_slots_map.end() == m_inline_slots_map.find(it->first)) || (false == is_inline_capable(it->second)))
+        {
+            loop_meters_map.insert(*it);
+        }
+    }
+    // the alarm meters always run on the loop alongside the client's
+    for (std::map<AlarmMeterKey, Meter *>::iterator it = m_alarm_meters_map.begin();
+            it != m_alarm_meters_map.end();
+            it++)
+    {
+        loop_meters_map.insert(std::make_pair(it->first.first, it->second));
+    }
+    m_graph_p->build(loop_meters_map, m_linked_meters_map);
+
+    // a changed channel gets a whole new version, the capture thread never sees one half built
+    for (std::map<AUDIOChannel::Index, InlineSlot>::iterator it = m_inline_slots_map.begin();
+            it != m_inline_slots_map.end();
+            it++)
+    {
+        InlineVersion *current_p = it->second.version_p;
+        Meter *meter_p = find_meter_by_channel_index(it->first);
+        if ((NULL != meter_p) && (false == is_inline_capable(meter_p)))
+        {
+            meter_p = NULL;
+        }
+        if ((NULL == current_p) && (NULL == meter_p))
+        {
+            continue;
+        }
+        if ((NULL != current_p) && (current_p->meter_p == meter_p) && (current_p->weighting == meter_p->get_weighting()))
+        {
+            continue;
+        }
+
+        InlineVersion *version_p = (NULL == meter_p) ? NULL : create_inline_version(meter_p);
+        __atomic_store_n(&it->second.version_p, version_p, __ATOMIC_SEQ_CST);
+        if (NULL != current_p)
+        {
+            // a meter that's no longer the channel's has already left the meters map
+            retire_inline_version(current_p, (current_p->meter_p != meter_p) ? current_p->meter_p : NULL);
+        }
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::rebuild exit");
+}
+
+bool AUDIOProcessor::is_inline_capable(Meter *meter_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::is_inline_capable enter meter_p=%p", meter_p);
+
+    // only meters fed by their own channel that can hand over what their results are worked out from,
+    // the digital peak resets as it's read so it has nothing to hand over
+    const bool capable = (true == meter_p->get_linked_channels().empty()) && (0 != meter_p->get_accumulators_size());
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::is_inline_capable exit capable=%d", capable);
+    return capable;
+}
+
+AUDIOProcessor::InlineVersion *AUDIOProcessor::find_inline_version(const Meter *meter_p) const
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::find_inline_version enter this=%p meter_p=%p", this, meter_p);
+
+    // only the loop swaps the versions so it can look at them freely
+    InlineVersion *version_p = NULL;
+    std::map<AUDIOChannel::Index, InlineSlot>::const_iterator it = m_inline_slots_map.find(meter_p->get_channel_p()->get_index());
+    if ((m_inline_slots_map.end() != it) && (NULL != it->second.version_p) && (meter_p == it->second.version_p->meter_p))
+    {
+        version_p = it->second.version_p;
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::find_inline_version exit version_p=%p", version_p);
+    return version_p;
+}
+
+AUDIOProcessor::InlineVersion *AUDIOProcessor::create_inline_version(Meter *meter_p) const
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::create_inline_version enter this=%p meter_p=%p", this, meter_p);
+
+    // everything the capture thread needs is allocated here, it never allocates itself
+    InlineVersion *version_p = new InlineVersion;
+    version_p->meter_p = meter_p;
+    version_p->weighting = meter_p->get_weighting();
+    version_p->accumulator_words = (meter_p->get_accumulators_size() + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+    version_p->saved_p = (uint32_t *)calloc(version_p->accumulator_words, sizeof(uint32_t));
+    version_p->published_p = (uint32_t *)calloc(version_p->accumulator_words, sizeof(uint32_t));
+    version_p->read_p = (uint32_t *)calloc(version_p->accumulator_words, sizeof(uint32_t));
+    version_p->sequence = 0;
+
+    // a graph of its own, so its filters + decimators aren't shared with the loop
+    std::multimap<AUDIOChannel::Index, Meter *> meters_map;
+    meters_map.insert(std::make_pair(meter_p->get_channel_p()->get_index(), meter_p));
+    version_p->graph_p = new AUDIOGraph();
+    version_p->graph_p->build(meters_map, std::multimap<AUDIOChannel::Index, Meter *>());
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::create_inline_version exit version_p=%p", version_p);
+    return version_p;
+}
+
+void AUDIOProcessor::retire_inline_version(InlineVersion *version_p, Meter *meter_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::retire_inline_version enter this=%p version_p=%p meter_p=%p", this, version_p, meter_p);
+
+    // the epochs are read after the swap, once they've all moved on nothing can still hold the old version
+    RetiredVersion retired;
+    retired.version_p = version_p;
+    retired.meter_p = meter_p;
+    AUDIOCaptureManager::get_instance()->read_inline_epochs(retired.epochs);
+    m_retired_versions.push_back(retired);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::retire_inline_version exit");
+}
+
+void AUDIOProcessor::reclaim_inline_versions(bool wait)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::reclaim_inline_versions enter this=%p wait=%d count=%d", this, wait, m_retired_versions.size());
+
+    AUDIOCaptureManager *manager_p = AUDIOCaptureManager::get_instance();
+    std::list<RetiredVersion>::iterator it = m_retired_versions.begin();
+    while (it != m_retired_versions.end())
+    {
+        if (false == manager_p->has_inline_grace_passed(it->epochs))
+        {
+            if (false == wait)
+            {
+                // try again next tick
+                it++;
+                continue;
+            }
+            manager_p->synchronize_inline();
+        }
+
+        release_inline_version(it->version_p);
+        delete it->meter_p;
+        m_retired_versions.erase(it++);
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::reclaim_inline_versions exit count=%d", m_retired_versions.size());
+}
+
+void AUDIOProcessor::release_inline_version(InlineVersion *version_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::release_inline_version enter version_p=%p", version_p);
+
+    // the meter isn't the version's to delete
+    delete version_p->graph_p;
+    free(version_p->saved_p);
+    free(version_p->published_p);
+    free(version_p->read_p);
+    delete version_p;
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::release_inline_version exit");
+}
+
+void AUDIOProcessor::publish_inline_accumulators(InlineVersion *version_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::publish_inline_accumulators enter version_p=%p", version_p);
+
+    // only the capture thread writes the sequence, each word goes across on its own so a tick that
+    // reads during the copy just sees the sequence change + tries again
+    const uint32_t sequence = __atomic_load_n(&version_p->sequence, __ATOMIC_RELAXED);
+    __atomic_store_n(&version_p->sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    for (size_t counter = 0; counter < version_p->accumulator_words; counter++)
+    {
+        __atomic_store_n(&version_p->published_p[counter], version_p->saved_p[counter], __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&version_p->sequence, sequence + 2, __ATOMIC_RELEASE);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::publish_inline_accumulators exit");
+}
+
+bool AUDIOProcessor::read_inline_accumulators(InlineVersion *version_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::read_inline_accumulators enter version_p=%p", version_p);
+
+    // copy until the sequence is even + unchanged either side, the capture thread is never held up
+    bool published = false;
+    for (;;)
+    {
+        const uint32_t sequence = __atomic_load_n(&version_p->sequence, __ATOMIC_ACQUIRE);
+        if (0 == sequence)
+        {
+            break;
+        }
+        if (0 != (sequence & 1))
+        {
+            sched_yield();
+            continue;
+        }
+        for (size_t counter = 0; counter < version_p->accumulator_words; counter++)
+        {
+            version_p->read_p[counter] = __atomic_load_n(&version_p->published_p[counter], __ATOMIC_RELAXED);
+        }
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (sequence == __atomic_load_n(&version_p->sequence, __ATOMIC_RELAXED))
+        {
+            published = true;
+            break;
+        }
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOProcessor::read_inline_accumulators exit published=%d", published);
+    return published;
+}
+
+static AUDIOWorkerPool *create_worker_pool()
+{
+    LOG_GENERATE_TRACE(g_logger, "create_worker_pool enter");
+
+    // without any threads configured the meters run on the loop as they always have
+    float threads = WORKER_POOL_DEFAULT_THREADS;
+    Config::get_instance_p()->get_float_with_default(WORKER_POOL_CONFIG_SECTION, WORKER_POOL_THREADS_CONFIG_ITEM, WORKER_POOL_DEFAULT_THREADS, &threads);
+    AUDIOWorkerPool *pool_p = NULL;
+    if (1.0f <= threads)
+    {
+        pool_p = new AUDIOWorkerPool((size_t)threads);
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "create_worker_pool exit pool_p=%p", pool_p);
+    return pool_p;
+}
+
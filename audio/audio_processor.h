@@ -4,9 +4,12 @@
 #include "common.h"
 #include "audio_channel.h"
 #include "audio_capturemgr.h"
+#include "audio_ballistics.h"
 
 #include <ev.h>
+#include <list>
 #include <map>
+#include <vector>
 
 ///////////////////////////////////////////////////////////////////////////////
 // macros
@@ -15,17 +18,26 @@
 #define METER_HOLD_TIME_INVALID            (0)
 #define METER_HOLD_TIME_MINIMUM_IN_SECS    (1)
 #define METER_HOLD_TIME_MAXIMUM_IN_SECS    (10)
+#define METER_WEIGHTING_COUNT              (3)
+#define METER_DECIMATION_MAXIMUM_STAGES    (3)
+#define METER_BANDWIDTH_FULL               (0)
+#define METER_COST_DEFAULT                 (1)
+#define ZERO_DB_PEAK_VOLTAGE               (1.0f)
 
 ///////////////////////////////////////////////////////////////////////////////
 // forward declarations
 ///////////////////////////////////////////////////////////////////////////////
 
+class AUDIOGraph;
+class AUDIOWorkerPool;
+class AUDIOAlarmEngine;
+class AUDIODecibels;
 
 ///////////////////////////////////////////////////////////////////////////////
 // class definition
 ///////////////////////////////////////////////////////////////////////////////
 
-class AUDIOProcessor : public AUDIOCaptureManager::Handler
+class AUDIOProcessor : public AUDIOCaptureManager::Handler, public AUDIOCaptureManager::InlineHandler
 {
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -39,13 +51,46 @@ public:
         LEVEL_TYPE_NONE = 0,
         LEVEL_TYPE_DIGITALPEAK = 1,
         LEVEL_TYPE_PPM = 2,
-        LEVEL_TYPE_VU = 3
+        LEVEL_TYPE_VU = 3,
+        LEVEL_TYPE_LOUDNESS = 4,
+        LEVEL_TYPE_SPECTRUM = 5,
+        LEVEL_TYPE_CORRELATION = 6,
+        LEVEL_TYPE_TONE = 7,
+        LEVEL_TYPE_CREST = 8,
+        LEVEL_TYPE_DISTORTION = 9,
+        LEVEL_TYPE_NOISEFLOOR = 10,
+        LEVEL_TYPE_DELAY = 11,
+        LEVEL_TYPE_GROUP = 12,
+        LEVEL_TYPE_HISTOGRAM = 13,
+        // anything loaded through the meter registry, told apart by name
+        LEVEL_TYPE_PLUGIN = 14
     } LevelType;
 
+    typedef enum
+    {
+        WEIGHTING_Z = 0,
+        WEIGHTING_A = 1,
+        WEIGHTING_C = 2
+    } Weighting;
+
+    typedef struct
+    {
+        float frequency;
+        bool present;
+        float levelInDB;
+    } ToneData;
+
+    typedef struct
+    {
+        AUDIOChannel::Index channel;
+        float peakInDB;
+    } GroupMemberData;
+
     typedef struct
     {
         AUDIOChannel::Index channel;
         LevelType type;
+        Weighting weighting;
         union
         {
             float vuInUnits;
@@ -54,13 +99,124 @@ public:
                 float peakInDB;
                 float holdInDB;
             } peak;
+            struct
+            {
+                float momentaryInLUFS;
+                float shorttermInLUFS;
+                float integratedInLUFS;
+                float rangeInLU;
+            } loudness;
+            struct
+            {
+                uint8_t bandsPerOctave;
+                int8_t firstBand;
+                uint8_t bandCount;
+                const float *bandsInDB_p;
+            } spectrum;
+            struct
+            {
+                AUDIOChannel::Index pairedChannel;
+                float coefficient;
+                float balance;
+            } correlation;
+            struct
+            {
+                uint8_t toneCount;
+                const ToneData *tones_p;
+            } tone;
+            struct
+            {
+                float peakInDB;
+                float rmsInDB;
+                float crestInDB;
+                float rangeInDB;
+            } crest;
+            struct
+            {
+                // frequency is zero while there's no settled measurement
+                float frequency;
+                float levelInDB;
+                float thdnInDB;
+                float sinadInDB;
+            } distortion;
+            struct
+            {
+                float levelInDB;
+                float floorInDB;
+            } noisefloor;
+            struct
+            {
+                // positive when the paired channel lags this one
+                AUDIOChannel::Index pairedChannel;
+                float lagInSamples;
+                float lagInMs;
+                float confidence;
+            } delay;
+            struct
+            {
+                // the ballistics shared by the members, LEVEL_TYPE_PPM or LEVEL_TYPE_DIGITALPEAK
+                LevelType ballistics;
+                float peakInDB;
+                float holdInDB;
+                uint8_t memberCount;
+                const GroupMemberData *members_p;
+            } group;
+            struct
+            {
+                float levelInDB;
+                float p10InDB;
+                float p50InDB;
+                float p95InDB;
+            } histogram;
+            struct
+            {
+                // the name the plugin registered under, the values follow its schema
+                const char *name_p;
+                uint8_t valueCount;
+                const float *values_p;
+            } plugin;
         } values;
     } ResultData;
 
+    typedef enum
+    {
+        ALARM_COMPARISON_ABOVE = 0,
+        ALARM_COMPARISON_BELOW = 1
+    } AlarmComparison;
+
+    typedef struct
+    {
+        uint32_t id;
+        AUDIOChannel::Index channel;
+        // the rule only applies while a meter of this type runs on the channel
+        LevelType type;
+        AlarmComparison comparison;
+        // in the units of the meter's main reading, dB for most of them
+        float threshold;
+        float hysteresis;
+        uint32_t durationInMs;
+    } AlarmRule;
+
+    typedef struct
+    {
+        uint32_t id;
+        AUDIOChannel::Index channel;
+        bool active;
+        float value;
+    } AlarmData;
+
+#ifdef AUDIO_FIXED_POINT
+    // the level meters keep their state in Q31 so they never need the FPU
+    typedef AUDIOChannel::Fixed Level;
+#else
+    typedef AUDIOChannel::Sample Level;
+#endif
+
     class Handler
     {
     public:
         virtual ResultCode handle_results(const size_t num_results, const ResultData results[]) = 0;
+        virtual ResultCode handle_alarms(const size_t num_alarms, const AlarmData alarms[]) = 0;
     };
 
     class Meter
@@ -68,14 +224,39 @@ public:
     public:
         virtual ~Meter();
         virtual void process_samples(const size_t buffer_length, AUDIOChannel::Sample *buffer_p) = 0;
+        virtual void process_linked_samples(const AUDIOChannel *channel_p, const size_t buffer_length, AUDIOChannel::Sample *buffer_p);
+        virtual void process_fixed_samples(const size_t buffer_length, const AUDIOChannel::Fixed *buffer_p);
+        virtual bool is_fixed_point() const;
         virtual ResultData create_result_data() = 0;
+        virtual void queue_result_data(ResultData &data, AUDIODecibels &decibels);
+        // what the result is worked out from, copied out so the work can be done elsewhere, zero if it can't
+        virtual size_t get_accumulators_size() const;
+        virtual void save_accumulators(void *accumulators_p) const;
+        virtual void queue_accumulated_result_data(const void *accumulators_p, ResultData &data, AUDIODecibels &decibels) const;
         virtual LevelType get_level_type() = 0;
         inline const AUDIOChannel *get_channel_p() const;
+        inline const std::vector<AUDIOChannel *> &get_linked_channels() const;
+        void set_weighting(Weighting weighting);
+        inline Weighting get_weighting() const;
+        inline unsigned int get_decimation_stages() const;
+        inline unsigned int get_sample_rate() const;
+        inline unsigned int get_cost() const;
+        inline void set_cost(unsigned int cost);
+        inline void set_block_position(uint64_t position);
 
     protected:
-        Meter(AUDIOChannel *channel_p);
+        Meter(AUDIOChannel *channel_p, unsigned int required_bandwidth = METER_BANDWIDTH_FULL);
+        ResultData create_queued_result_data();
+        void add_linked_channel(AUDIOChannel *channel_p);
+        // the capture position of the block being processed, at the rate of the channel it came from
+        inline uint64_t get_block_position() const;
     private:
         AUDIOChannel *m_channel_p;
+        std::vector<AUDIOChannel *> m_linked_channels;
+        Weighting m_weighting;
+        unsigned int m_decimation_stages;
+        unsigned int m_cost;
+        uint64_t m_block_position;
     };
 
     class PeakMeter : public Meter
@@ -84,29 +265,48 @@ public:
         virtual ~PeakMeter();
         void set_hold_time(uint32_t hold_time_in_secs);
         inline uint32_t get_hold_time() const;
+        inline AUDIOBallistics::Standard get_standard() const;
     protected:
         PeakMeter(AUDIOChannel *channel_p);
-        inline AUDIOChannel::Sample get_peak() const;
-        void set_peak(AUDIOChannel::Sample peak);
-        inline AUDIOChannel::Sample get_hold() const;
+        inline Level get_peak() const;
+        void set_peak(Level peak);
+        inline Level get_hold() const;
+        void set_standard(AUDIOBallistics::Standard standard);
+        inline const AUDIOBallistics::Coefficients &get_coefficients() const;
+        template <class Attack, class Release> inline void process_ballistics(const size_t buffer_length, const Level *buffer_p);
     private:
-        AUDIOChannel::Sample m_peak;
-        AUDIOChannel::Sample m_hold;
+        Level m_peak;
+        Level m_hold;
         uint32_t m_hold_time;
         time_t m_last_timestamp;
+        AUDIOBallistics::Standard m_standard;
+        AUDIOBallistics::Coefficients m_coefficients;
     };
 
     class PPMMeter : public PeakMeter
     {
     public:
-        PPMMeter(AUDIOChannel *channel_p);
+        PPMMeter(AUDIOChannel *channel_p, AUDIOBallistics::Standard standard = AUDIOBallistics::STANDARD_LEGACY);
         virtual ~PPMMeter();
         void process_samples(const size_t buffer_length, AUDIOChannel::Sample *buffer_p);
         ResultData create_result_data();
+        void queue_result_data(ResultData &data, AUDIODecibels &decibels);
+        size_t get_accumulators_size() const;
+        void save_accumulators(void *accumulators_p) const;
+        void queue_accumulated_result_data(const void *accumulators_p, ResultData &data, AUDIODecibels &decibels) const;
         inline LevelType get_level_type();
+#ifdef AUDIO_FIXED_POINT
+        void process_fixed_samples(const size_t buffer_length, const AUDIOChannel::Fixed *buffer_p);
+        inline bool is_fixed_point() const;
+#endif
     private:
-        float m_rise_factor;
-        float m_fall_factor;
+        typedef struct
+        {
+            Level peak;
+            Level hold;
+        } Accumulators;
+
+        float m_offset_in_db;
     };
 
     class DigitalPeakMeter : public PeakMeter
@@ -116,7 +316,12 @@ public:
         virtual ~DigitalPeakMeter();
         void process_samples(const size_t buffer_length, AUDIOChannel::Sample *buffer_p);
         ResultData create_result_data();
+        void queue_result_data(ResultData &data, AUDIODecibels &decibels);
         inline LevelType get_level_type();
+#ifdef AUDIO_FIXED_POINT
+        void process_fixed_samples(const size_t buffer_length, const AUDIOChannel::Fixed *buffer_p);
+        inline bool is_fixed_point() const;
+#endif
     private:
     };  
 
@@ -127,11 +332,34 @@ public:
         virtual ~VUMeter();
         void process_samples(const size_t buffer_length, AUDIOChannel::Sample *buffer_p);
         ResultData create_result_data();
+        void queue_result_data(ResultData &data, AUDIODecibels &decibels);
+        size_t get_accumulators_size() const;
+        void save_accumulators(void *accumulators_p) const;
+        void queue_accumulated_result_data(const void *accumulators_p, ResultData &data, AUDIODecibels &decibels) const;
         inline LevelType get_level_type();
+#ifdef AUDIO_FIXED_POINT
+        void process_fixed_samples(const size_t buffer_length, const AUDIOChannel::Fixed *buffer_p);
+        inline bool is_fixed_point() const;
+#endif
     private:
+        typedef struct
+        {
+            // normalised to full scale
+            float sum_squares;
+        } Accumulators;
+
         unsigned int m_sample_count;
         unsigned int m_sample_index;
+        float m_offset_in_db;
+#ifdef AUDIO_FIXED_POINT
+        // Q15 is plenty for a VU and lets the sum of squares run exactly in 64 bits
+        int16_t *m_samples_p;
+        int64_t m_sum_squares;
+#else
         AUDIOChannel::Sample *m_samples_p;
+        // kept as the samples come in, summed afresh each time the ring wraps so it never drifts
+        double m_sum_squares;
+#endif
     };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -139,22 +367,80 @@ public:
 ///////////////////////////////////////////////////////////////////////////////
 
 public:
-    AUDIOProcessor();
+    // loop_p must be the loop the capture manager dispatches the samples on
+    AUDIOProcessor(struct ev_loop *loop_p);
     virtual ~AUDIOProcessor();
 
     void add_meter(Meter *meter_p);
+    // the meters the [meter-N] sections describe, added at startup + again whenever they're wanted back
+    void add_configured_meters();
     void clear_meter(AUDIOChannel *channel_p);
     const Meter *get_meter(const AUDIOChannel *channel_p) const;
+    ResultCode set_weighting(const AUDIOChannel *channel_p, Weighting weighting);
+    ResultCode set_alarm_rules(const std::vector<AlarmRule> &rules);
+    void set_level_notifications(bool enabled);
 
     void add_handler(Handler *handler_p);
     void remove_handler(Handler *handler_p);
 
+    static inline AUDIOChannel::Sample level_to_sample(Level level);
+    static inline Level sample_to_level(AUDIOChannel::Sample sample);
+
 ///////////////////////////////////////////////////////////////////////////////
 // AUDIOCaptureManager::Handler declarations
 ///////////////////////////////////////////////////////////////////////////////
 
 public:
     virtual ResultCode handle_samples(AUDIOChannel *channel_p, const size_t buffer_length, AUDIOChannel::Sample *buffer_p);
+    virtual ResultCode handle_fixed_samples(AUDIOChannel *channel_p, const size_t buffer_length, const AUDIOChannel::Fixed *fixed_p, AUDIOChannel::Sample *buffer_p);
+    virtual bool needs_samples(const AUDIOChannel *channel_p) const;
+
+///////////////////////////////////////////////////////////////////////////////
+// AUDIOCaptureManager::InlineHandler declarations
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+    virtual void handle_inline_samples(AUDIOChannel *channel_p, uint64_t position, const size_t buffer_length, AUDIOChannel::Sample *buffer_p, const AUDIOChannel::Fixed *fixed_p);
+
+///////////////////////////////////////////////////////////////////////////////
+// private type definitions
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+
+    // what a capture thread runs for one channel, never changed once it's published
+    typedef struct
+    {
+        Meter *meter_p;
+        Weighting weighting;
+        // a graph of its own so the capture thread never touches the loop's
+        AUDIOGraph *graph_p;
+        // the meter's accumulators, saved by the capture thread into its own copy + published word by word,
+        // the tick reads them back into its own copy + works the result out from that
+        size_t accumulator_words;
+        uint32_t *saved_p;
+        uint32_t *published_p;
+        uint32_t *read_p;
+        // seqlock around the published copy, odd while the capture thread writes it + zero until it first has
+        uint32_t sequence;
+    } InlineVersion;
+
+    typedef struct
+    {
+        // swapped by the loop, read by the capture thread
+        InlineVersion *version_p;
+    } InlineSlot;
+
+    typedef struct
+    {
+        InlineVersion *version_p;
+        // set when the meter went with the version
+        Meter *meter_p;
+        std::vector<uint32_t> epochs;
+    } RetiredVersion;
+
+    // the alarm rules share one meter per channel + type
+    typedef std::pair<AUDIOChannel::Index, LevelType> AlarmMeterKey;
 
 ///////////////////////////////////////////////////////////////////////////////
 // private function declarations
@@ -164,6 +450,19 @@ private:
     static void timer_cb(struct ev_loop *loop, struct ev_timer *w, int revents);
 
     Meter *find_meter_by_channel_index(AUDIOChannel::Index index) const;
+    void install_meter(Meter *meter_p);
+    void release_meter(Meter *meter_p);
+    void rebuild();
+    void update_alarm_meters();
+
+    static bool is_inline_capable(Meter *meter_p);
+    InlineVersion *find_inline_version(const Meter *meter_p) const;
+    InlineVersion *create_inline_version(Meter *meter_p) const;
+    void retire_inline_version(InlineVersion *version_p, Meter *meter_p);
+    void reclaim_inline_versions(bool wait);
+    static void release_inline_version(InlineVersion *version_p);
+    static void publish_inline_accumulators(InlineVersion *version_p);
+    static bool read_inline_accumulators(InlineVersion *version_p);
 
 ///////////////////////////////////////////////////////////////////////////////
 // private variable definitions
@@ -174,6 +473,19 @@ private:
     struct ev_timer m_timer;
     Handler *m_handler_p;
     std::map<AUDIOChannel::Index, Meter *> m_meters_map;
+    std::multimap<AUDIOChannel::Index, Meter *> m_linked_meters_map;
+    // NULL when the meters run inline on the loop
+    AUDIOWorkerPool *m_pool_p;
+    AUDIOGraph *m_graph_p;
+    AUDIOAlarmEngine *m_alarm_engine_p;
+    // the meters the alarm rules read, kept apart from the client's so they're never sent or replaced
+    std::map<AlarmMeterKey, Meter *> m_alarm_meters_map;
+    AUDIODecibels *m_decibels_p;
+    bool m_level_notifications;
+
+    // one slot per captured channel when metering inline, the map itself never changes after construction
+    std::map<AUDIOChannel::Index, InlineSlot> m_inline_slots_map;
+    std::list<RetiredVersion> m_retired_versions;
 
 };
 
@@ -181,26 +493,111 @@ private:
 // inline function implementations
 ///////////////////////////////////////////////////////////////////////////////
 
+inline AUDIOChannel::Sample AUDIOProcessor::level_to_sample(Level level)
+{
+#ifdef AUDIO_FIXED_POINT
+    return AUDIOChannel::to_sample(level);
+#else
+    return level;
+#endif
+}
+
+inline AUDIOProcessor::Level AUDIOProcessor::sample_to_level(AUDIOChannel::Sample sample)
+{
+#ifdef AUDIO_FIXED_POINT
+    return AUDIOChannel::to_fixed(sample);
+#else
+    return sample;
+#endif
+}
+
 inline const AUDIOChannel *AUDIOProcessor::Meter::get_channel_p() const
 {
     return m_channel_p;
 }
 
+inline const std::vector<AUDIOChannel *> &AUDIOProcessor::Meter::get_linked_channels() const
+{
+    return m_linked_channels;
+}
+
+inline AUDIOProcessor::Weighting AUDIOProcessor::Meter::get_weighting() const
+{
+    return m_weighting;
+}
+
+inline unsigned int AUDIOProcessor::Meter::get_decimation_stages() const
+{
+    return m_decimation_stages;
+}
+
+inline unsigned int AUDIOProcessor::Meter::get_sample_rate() const
+{
+    return m_channel_p->get_sample_rate() >> m_decimation_stages;
+}
+
+inline unsigned int AUDIOProcessor::Meter::get_cost() const
+{
+    return m_cost;
+}
+
+inline void AUDIOProcessor::Meter::set_cost(unsigned int cost)
+{
+    m_cost = cost;
+}
+
+inline void AUDIOProcessor::Meter::set_block_position(uint64_t position)
+{
+    m_block_position = position;
+}
+
+inline uint64_t AUDIOProcessor::Meter::get_block_position() const
+{
+    return m_block_position;
+}
+
 inline uint32_t AUDIOProcessor::PeakMeter::get_hold_time() const
 {
     return m_hold_time;
 }
 
-inline AUDIOChannel::Sample AUDIOProcessor::PeakMeter::get_peak() const
+inline AUDIOProcessor::Level AUDIOProcessor::PeakMeter::get_peak() const
 {
     return m_peak;
 }
 
-inline AUDIOChannel::Sample AUDIOProcessor::PeakMeter::get_hold() const
+inline AUDIOProcessor::Level AUDIOProcessor::PeakMeter::get_hold() const
 {
     return m_hold;
 }
 
+inline AUDIOBallistics::Standard AUDIOProcessor::PeakMeter::get_standard() const
+{
+    return m_standard;
+}
+
+inline const AUDIOBallistics::Coefficients &AUDIOProcessor::PeakMeter::get_coefficients() const
+{
+    return m_coefficients;
+}
+
+template <class Attack, class Release>
+inline void AUDIOProcessor::PeakMeter::process_ballistics(const size_t buffer_length, const Level *buffer_p)
+{
+    // the hold only needs the highest point of the block so it's updated once rather than per sample
+    Level highest = m_peak;
+    if (METER_HOLD_TIME_INVALID == m_hold_time)
+    {
+        set_peak(AUDIOBallistics::process<Attack, Release, AUDIOBallistics::NoHold>(m_peak, buffer_length, buffer_p, m_coefficients, &highest));
+    }
+    else
+    {
+        const Level peak = AUDIOBallistics::process<Attack, Release, AUDIOBallistics::TrackHold>(m_peak, buffer_length, buffer_p, m_coefficients, &highest);
+        set_peak(highest);
+        set_peak(peak);
+    }
+}
+
 inline AUDIOProcessor::LevelType AUDIOProcessor::PPMMeter::get_level_type() 
 {
     return LEVEL_TYPE_PPM;
@@ -216,4 +613,21 @@ inline AUDIOProcessor::LevelType AUDIOProcessor::VUMeter::get_level_type()
     return LEVEL_TYPE_VU;
 }
 
+#ifdef AUDIO_FIXED_POINT
+inline bool AUDIOProcessor::PPMMeter::is_fixed_point() const
+{
+    return true;
+}
+
+inline bool AUDIOProcessor::DigitalPeakMeter::is_fixed_point() const
+{
+    return true;
+}
+
+inline bool AUDIOProcessor::VUMeter::is_fixed_point() const
+{
+    return true;
+}
+#endif
+
 #endif
@@ -0,0 +1,202 @@
+
+#include "audio_spectrummeter.h"
+#include "log.h"
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+// ~100ms frames with 50% overlap
+#define SPECTRUM_FRAME_TIME_IN_MS           (100)
+#define SPECTRUM_REFERENCE_FREQUENCY        (1000.0)
+#define SPECTRUM_MINIMUM_FREQUENCY          (24.0)
+#define SPECTRUM_MAXIMUM_FREQUENCY          (20000.0)
+
+///////////////////////////////////////////////////////////////////////////////
+// type defintions
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// constants
+///////////////////////////////////////////////////////////////////////////////
+
+static const float c_zero_level_in_db = -96;
+
+///////////////////////////////////////////////////////////////////////////////
+// module variables
+///////////////////////////////////////////////////////////////////////////////
+
+static LogInstance g_logger("audio.spectrummeter");
+
+///////////////////////////////////////////////////////////////////////////////
+// private function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// public function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+AUDIOSpectrumMeter::AUDIOSpectrumMeter(AUDIOChannel *channel_p, unsigned int bands_per_octave) :
+    AUDIOProcessor::Meter(channel_p),
+    m_fft_p(AUDIOFFT::get_instance(AUDIOFFT::calculate_length(CALC_NUM_SAMPLES_FOR_MILLIS(SPECTRUM_FRAME_TIME_IN_MS, channel_p->get_sample_rate())))),
+    m_bands_per_octave(bands_per_octave),
+    m_frame_fill(0),
+    m_frame_count(0)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOSpectrumMeter::AUDIOSpectrumMeter enter this=%p channel_p=%p bands_per_octave=%d", this, channel_p, bands_per_octave);
+
+    ASSERT((SPECTRUM_BANDS_PER_OCTAVE_OCTAVE == bands_per_octave) || (SPECTRUM_BANDS_PER_OCTAVE_THIRD == bands_per_octave));
+
+    const size_t length = m_fft_p->get_length();
+    const double sample_rate = (double)channel_p->get_sample_rate();
+    const double bin_width = sample_rate / length;
+
+    // grab the working buffers up front so the audio path never allocates
+    m_scratch_p = m_fft_p->acquire_scratch();
+    m_frame.resize(length);
+    m_power.resize((length / 2) + 1);
+
+    // bands are centred on 1kHz * 2^(n/b), stop when the upper edge passes nyquist
+    const double half_band = pow(2.0, 1.0 / (2.0 * bands_per_octave));
+    m_first_band = (int)ceil(bands_per_octave * log2(SPECTRUM_MINIMUM_FREQUENCY / SPECTRUM_REFERENCE_FREQUENCY));
+    for (int band = m_first_band; SPECTRUM_MAXIMUM_BANDS > m_bands.size(); band++)
+    {
+        double centre = SPECTRUM_REFERENCE_FREQUENCY * pow(2.0, (double)band / bands_per_octave);
+        if ((SPECTRUM_MAXIMUM_FREQUENCY < centre) || ((sample_rate / 2.0) < (centre * half_band)))
+        {
+            break;
+        }
+
+        Band range;
+        range.first_bin = (size_t)ceil((centre / half_band) / bin_width);
+        range.last_bin = (size_t)ceil((centre * half_band) / bin_width);
+        // narrow bands at the bottom may fall between bins, use the nearest one
+        if (range.first_bin >= range.last_bin)
+        {
+            range.first_bin = (size_t)floor((centre / bin_width) + 0.5);
+            range.last_bin = range.first_bin + 1;
+        }
+        m_bands.push_back(range);
+    }
+    m_band_powers.resize(m_bands.size(), 0.0);
+    m_band_levels.resize(m_bands.size(), c_zero_level_in_db);
+
+    // scale so a full scale sine reads 0dB after the hann window
+    m_scale = 4.0f / (length * m_fft_p->get_window_power());
+
+    LOG_GENERATE_DEBUG(g_logger, "spectrum meter length=%d bands=%d first_band=%d", length, m_bands.size(), m_first_band);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOSpectrumMeter::AUDIOSpectrumMeter exit");
+}
+
+AUDIOSpectrumMeter::~AUDIOSpectrumMeter()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOSpectrumMeter::~AUDIOSpectrumMeter enter this=%p", this);
+
+    // give the scratch back to the pool
+    m_fft_p->release_scratch(m_scratch_p);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOSpectrumMeter::~AUDIOSpectrumMeter exit");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// AUDIOProcessor::Meter implementation
+///////////////////////////////////////////////////////////////////////////////
+
+void AUDIOSpectrumMeter::process_samples(const size_t buffer_length, AUDIOChannel::Sample *buffer_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOSpectrumMeter::process_samples enter this=%p buffer_length=%d buffer_p=%p", this, buffer_length, buffer_p);
+
+    size_t offset = 0;
+    while (offset < buffer_length)
+    {
+        // fill up as much of the frame as we can
+        size_t count = std::min(buffer_length - offset, m_frame.size() - m_frame_fill);
+        memcpy(&m_frame[m_frame_fill], buffer_p + offset, count * sizeof(AUDIOChannel::Sample));
+        m_frame_fill += count;
+        offset += count;
+
+        // transform once the frame is full
+        if (m_frame.size() == m_frame_fill)
+        {
+            process_frame();
+
+            // keep the second half for the next frame
+            const size_t hop = m_frame.size() / 2;
+            memmove(&m_frame[0], &m_frame[hop], hop * sizeof(AUDIOChannel::Sample));
+            m_frame_fill = hop;
+        }
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOSpectrumMeter::process_samples exit");
+}
+
+AUDIOProcessor::ResultData AUDIOSpectrumMeter::create_result_data()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOSpectrumMeter::create_result_data enter this=%p", this);
+
+    AUDIOProcessor::ResultData data;
+    memset(&data, 0, sizeof(data));
+
+    // populate the type
+    data.type = AUDIOProcessor::LEVEL_TYPE_SPECTRUM;
+
+    // populate the channel
+    data.channel = get_channel_p()->get_index();
+
+    // average the frames we've seen since the last update, otherwise repeat the last levels
+    if (0 < m_frame_count)
+    {
+        for (size_t band = 0; band < m_bands.size(); band++)
+        {
+            double power = (m_band_powers[band] * m_scale) / m_frame_count;
+            m_band_levels[band] = c_zero_level_in_db;
+            if (0.0 < power)
+            {
+                m_band_levels[band] = std::max((float)(10.0 * log10(power)), c_zero_level_in_db);
+            }
+            m_band_powers[band] = 0.0;
+        }
+        m_frame_count = 0;
+    }
+
+    // the levels stay owned by the meter, they're valid until the next call
+    data.values.spectrum.bandsPerOctave = m_bands_per_octave;
+    data.values.spectrum.firstBand = m_first_band;
+    data.values.spectrum.bandCount = m_band_levels.size();
+    data.values.spectrum.bandsInDB_p = &m_band_levels[0];
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOSpectrumMeter::create_result_data exit");
+    return data;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// private function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+void AUDIOSpectrumMeter::process_frame()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOSpectrumMeter::process_frame enter this=%p", this);
+
+    m_fft_p->transform_power(&m_frame[0], &m_power[0], m_scratch_p);
+
+    // sum the bins into the bands
+    for (size_t band = 0; band < m_bands.size(); band++)
+    {
+        double power = 0.0;
+        for (size_t bin = m_bands[band].first_bin; bin < m_bands[band].last_bin; bin++)
+        {
+            power += m_power[bin];
+        }
+        m_band_powers[band] += power;
+    }
+    m_frame_count++;
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOSpectrumMeter::process_frame exit");
+}
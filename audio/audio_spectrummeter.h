@@ -0,0 +1,96 @@
+#ifndef _AUDIO_SPECTRUMMETER_H_
+#define _AUDIO_SPECTRUMMETER_H_
+
+#include "common.h"
+#include "audio_channel.h"
+#include "audio_processor.h"
+#include "audio_fft.h"
+
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+#define SPECTRUM_BANDS_PER_OCTAVE_OCTAVE        (1)
+#define SPECTRUM_BANDS_PER_OCTAVE_THIRD         (3)
+#define SPECTRUM_MAXIMUM_BANDS                  (32)
+
+///////////////////////////////////////////////////////////////////////////////
+// forward declarations
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// class definition
+///////////////////////////////////////////////////////////////////////////////
+
+class AUDIOSpectrumMeter : public AUDIOProcessor::Meter
+{
+
+///////////////////////////////////////////////////////////////////////////////
+// type definitions
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+
+    typedef struct
+    {
+        size_t first_bin;
+        size_t last_bin;
+    } Band;
+
+///////////////////////////////////////////////////////////////////////////////
+// public function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+    AUDIOSpectrumMeter(AUDIOChannel *channel_p, unsigned int bands_per_octave);
+    virtual ~AUDIOSpectrumMeter();
+
+///////////////////////////////////////////////////////////////////////////////
+// AUDIOProcessor::Meter declarations
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+    void process_samples(const size_t buffer_length, AUDIOChannel::Sample *buffer_p);
+    AUDIOProcessor::ResultData create_result_data();
+    inline AUDIOProcessor::LevelType get_level_type();
+
+///////////////////////////////////////////////////////////////////////////////
+// private function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+    void process_frame();
+
+///////////////////////////////////////////////////////////////////////////////
+// private variable definitions
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+    AUDIOFFT *m_fft_p;
+    AUDIOFFT::Complex *m_scratch_p;
+    unsigned int m_bands_per_octave;
+    int m_first_band;
+    std::vector<Band> m_bands;
+    std::vector<AUDIOChannel::Sample> m_frame;
+    size_t m_frame_fill;
+    std::vector<float> m_power;
+    std::vector<double> m_band_powers;
+    unsigned int m_frame_count;
+    std::vector<float> m_band_levels;
+    float m_scale;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// inline function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+inline AUDIOProcessor::LevelType AUDIOSpectrumMeter::get_level_type()
+{
+    return AUDIOProcessor::LEVEL_TYPE_SPECTRUM;
+}
+
+#endif
+
@@ -0,0 +1,236 @@
+
+#include "audio_tonemeter.h"
+#include "config.h"
+#include "log.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+// 50ms blocks gives ~20Hz of resolution which is plenty to separate line-up + pilot tones
+#define TONE_BLOCK_TIME_IN_MS               (50)
+#define TONE_ZERO_DB_RMS_VOLTAGE            (0.775f)
+
+// a tone has to be loud enough and carry most of the energy in the block to count
+#define TONE_PRESENT_ON_LEVEL_IN_DBFS       (-60.0f)
+#define TONE_PRESENT_OFF_LEVEL_IN_DBFS      (-66.0f)
+#define TONE_PRESENT_ON_RATIO               (0.5f)
+#define TONE_PRESENT_OFF_RATIO              (0.25f)
+
+#define TONE_CONFIG_SECTION                 "tone-meter"
+#define TONE_FREQUENCIES_CONFIG_ITEM        "frequencies"
+#define TONE_DEFAULT_FREQUENCIES            "1000"
+
+///////////////////////////////////////////////////////////////////////////////
+// type defintions
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// constants
+///////////////////////////////////////////////////////////////////////////////
+
+static const float c_zero_level_in_db = -96;
+
+///////////////////////////////////////////////////////////////////////////////
+// module variables
+///////////////////////////////////////////////////////////////////////////////
+
+static LogInstance g_logger("audio.tonemeter");
+
+///////////////////////////////////////////////////////////////////////////////
+// private function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// public function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+AUDIOToneMeter::AUDIOToneMeter(AUDIOChannel *channel_p, const std::vector<float> &frequencies) :
+    AUDIOProcessor::Meter(channel_p),
+    m_tone_count(frequencies.size()),
+    m_block_length(CALC_NUM_SAMPLES_FOR_MILLIS(TONE_BLOCK_TIME_IN_MS, channel_p->get_sample_rate())),
+    m_block_fill(0),
+    m_block_sum_squares(0.0f)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOToneMeter::AUDIOToneMeter enter this=%p channel_p=%p tone_count=%d", this, channel_p, frequencies.size());
+
+    ASSERT((0 < m_tone_count) && (TONE_MAXIMUM_TONES >= m_tone_count));
+
+    // unused filters run with a zero coefficient, they're cheaper than a branch
+    memset(m_coefficients, 0, sizeof(m_coefficients));
+    memset(m_s1, 0, sizeof(m_s1));
+    memset(m_s2, 0, sizeof(m_s2));
+    memset(m_tones, 0, sizeof(m_tones));
+
+    for (size_t tone = 0; tone < m_tone_count; tone++)
+    {
+        m_coefficients[tone] = (float)(2.0 * cos((2.0 * M_PI * frequencies[tone]) / channel_p->get_sample_rate()));
+        m_tones[tone].frequency = frequencies[tone];
+        m_tones[tone].present = false;
+        m_tones[tone].levelInDB = c_zero_level_in_db;
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOToneMeter::AUDIOToneMeter exit");
+}
+
+AUDIOToneMeter::~AUDIOToneMeter()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOToneMeter::~AUDIOToneMeter enter this=%p", this);
+    LOG_GENERATE_TRACE(g_logger, "AUDIOToneMeter::~AUDIOToneMeter exit");
+}
+
+std::vector<float> AUDIOToneMeter::fetch_default_frequencies()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOToneMeter::fetch_default_frequencies enter");
+
+    // query the comma separated list of tones from the config
+    const char *value_p = NULL;
+    Config::get_instance_p()->get_string_with_default(TONE_CONFIG_SECTION, TONE_FREQUENCIES_CONFIG_ITEM, TONE_DEFAULT_FREQUENCIES, &value_p);
+
+    std::vector<float> frequencies;
+    const char *current_p = value_p;
+    while (('\0' != *current_p) && (TONE_MAXIMUM_TONES > frequencies.size()))
+    {
+        char *end_p = NULL;
+        float frequency = strtof(current_p, &end_p);
+        if (end_p == current_p)
+        {
+            LOG_GENERATE_ERROR(g_logger, "unable to parse tone frequencies=%s", value_p);
+            break;
+        }
+        if (0.0f < frequency)
+        {
+            frequencies.push_back(frequency);
+        }
+        // skip the separator
+        current_p = end_p;
+        while ((',' == *current_p) || (' ' == *current_p))
+        {
+            current_p++;
+        }
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOToneMeter::fetch_default_frequencies exit count=%d", frequencies.size());
+    return frequencies;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// AUDIOProcessor::Meter implementation
+///////////////////////////////////////////////////////////////////////////////
+
+void AUDIOToneMeter::process_samples(const size_t buffer_length, AUDIOChannel::Sample *buffer_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOToneMeter::process_samples enter this=%p buffer_length=%d buffer_p=%p", this, buffer_length, buffer_p);
+
+    for (int counter = 0; counter < buffer_length; counter++)
+    {
+        const AUDIOChannel::Sample sample = buffer_p[counter];
+        m_block_sum_squares += sample * sample;
+
+        // run the whole bank on the sample
+        for (int tone = 0; tone < TONE_MAXIMUM_TONES; tone++)
+        {
+            float s0 = sample + (m_coefficients[tone] * m_s1[tone]) - m_s2[tone];
+            m_s2[tone] = m_s1[tone];
+            m_s1[tone] = s0;
+        }
+
+        m_block_fill++;
+        if (m_block_length == m_block_fill)
+        {
+            complete_block();
+        }
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOToneMeter::process_samples exit");
+}
+
+AUDIOProcessor::ResultData AUDIOToneMeter::create_result_data()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOToneMeter::create_result_data enter this=%p", this);
+
+    AUDIOProcessor::ResultData data;
+    memset(&data, 0, sizeof(data));
+
+    // populate the type
+    data.type = AUDIOProcessor::LEVEL_TYPE_TONE;
+
+    // populate the channel
+    data.channel = get_channel_p()->get_index();
+
+    // the tones stay owned by the meter, they're valid until the next block completes
+    data.values.tone.toneCount = m_tone_count;
+    data.values.tone.tones_p = m_tones;
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOToneMeter::create_result_data exit");
+    return data;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// private function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+void AUDIOToneMeter::complete_block()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOToneMeter::complete_block enter this=%p", this);
+
+    const float fullscale_voltage = get_channel_p()->get_fullscale_voltage();
+    const float block_mean_square = m_block_sum_squares / m_block_length;
+
+    for (size_t tone = 0; tone < m_tone_count; tone++)
+    {
+        // squared magnitude at the tone frequency -> sine amplitude
+        float power = (m_s1[tone] * m_s1[tone]) + (m_s2[tone] * m_s2[tone]) - (m_coefficients[tone] * m_s1[tone] * m_s2[tone]);
+        float amplitude = (2.0f * sqrtf(std::max(power, 0.0f))) / m_block_length;
+        float tone_mean_square = 0.5f * amplitude * amplitude;
+
+        // work out how much of the block this tone accounts for
+        float ratio = 0.0f;
+        if (0.0f < block_mean_square)
+        {
+            ratio = tone_mean_square / block_mean_square;
+        }
+        float level_in_dbfs = c_zero_level_in_db;
+        m_tones[tone].levelInDB = c_zero_level_in_db;
+        if (0.0f < amplitude)
+        {
+            level_in_dbfs = 20.0f * log10f(amplitude);
+            // report the level as the tone's RMS voltage in dBu
+            float voltage = (amplitude * fullscale_voltage) / sqrtf(2.0f);
+            m_tones[tone].levelInDB = std::max(20.0f * log10f(voltage / TONE_ZERO_DB_RMS_VOLTAGE), c_zero_level_in_db);
+        }
+
+        // apply the hysteresis
+        if (false == m_tones[tone].present)
+        {
+            if ((TONE_PRESENT_ON_LEVEL_IN_DBFS <= level_in_dbfs) && (TONE_PRESENT_ON_RATIO <= ratio))
+            {
+                LOG_GENERATE_DEBUG(g_logger, "tone=%fHz detected on channel=%d", m_tones[tone].frequency, get_channel_p()->get_index());
+                m_tones[tone].present = true;
+            }
+        }
+        else
+        {
+            if ((TONE_PRESENT_OFF_LEVEL_IN_DBFS > level_in_dbfs) || (TONE_PRESENT_OFF_RATIO > ratio))
+            {
+                LOG_GENERATE_DEBUG(g_logger, "tone=%fHz lost on channel=%d", m_tones[tone].frequency, get_channel_p()->get_index());
+                m_tones[tone].present = false;
+            }
+        }
+    }
+
+    // start the next block
+    memset(m_s1, 0, sizeof(m_s1));
+    memset(m_s2, 0, sizeof(m_s2));
+    m_block_sum_squares = 0.0f;
+    m_block_fill = 0;
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOToneMeter::complete_block exit");
+}
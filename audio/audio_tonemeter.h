@@ -0,0 +1,83 @@
+#ifndef _AUDIO_TONEMETER_H_
+#define _AUDIO_TONEMETER_H_
+
+#include "common.h"
+#include "audio_channel.h"
+#include "audio_processor.h"
+
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+// the filter bank is always this wide so the inner loop has a fixed trip count
+#define TONE_MAXIMUM_TONES          (8)
+
+///////////////////////////////////////////////////////////////////////////////
+// forward declarations
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// class definition
+///////////////////////////////////////////////////////////////////////////////
+
+class AUDIOToneMeter : public AUDIOProcessor::Meter
+{
+
+///////////////////////////////////////////////////////////////////////////////
+// public function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+    AUDIOToneMeter(AUDIOChannel *channel_p, const std::vector<float> &frequencies);
+    virtual ~AUDIOToneMeter();
+
+    static std::vector<float> fetch_default_frequencies();
+
+///////////////////////////////////////////////////////////////////////////////
+// AUDIOProcessor::Meter declarations
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+    void process_samples(const size_t buffer_length, AUDIOChannel::Sample *buffer_p);
+    AUDIOProcessor::ResultData create_result_data();
+    inline AUDIOProcessor::LevelType get_level_type();
+
+///////////////////////////////////////////////////////////////////////////////
+// private function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+    void complete_block();
+
+///////////////////////////////////////////////////////////////////////////////
+// private variable definitions
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+    size_t m_tone_count;
+    unsigned int m_block_length;
+    unsigned int m_block_fill;
+    float m_block_sum_squares;
+
+    // goertzel state laid out per tone so the bank runs as one vector
+    float m_coefficients[TONE_MAXIMUM_TONES];
+    float m_s1[TONE_MAXIMUM_TONES];
+    float m_s2[TONE_MAXIMUM_TONES];
+
+    AUDIOProcessor::ToneData m_tones[TONE_MAXIMUM_TONES];
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// inline function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+inline AUDIOProcessor::LevelType AUDIOToneMeter::get_level_type()
+{
+    return AUDIOProcessor::LEVEL_TYPE_TONE;
+}
+
+#endif
+
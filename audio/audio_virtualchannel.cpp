@@ -0,0 +1,239 @@
+
+#include "audio_virtualchannel.h"
+#include "config.h"
+#include "log.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+#define SOURCES_CONFIG_ITEM             "sources"
+#define GAINS_CONFIG_ITEM               "gains"
+#define FULLSCALE_VOLTAGE_CONFIG_ITEM   "fullscale-voltage"
+#define ROLE_CONFIG_ITEM                "role"
+#define DEFAULT_GAIN                    (1.0f)
+
+///////////////////////////////////////////////////////////////////////////////
+// type defintions
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// constants
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// module variables
+///////////////////////////////////////////////////////////////////////////////
+
+static LogInstance g_logger("audio.virtualchannel");
+
+///////////////////////////////////////////////////////////////////////////////
+// private function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+static ResultCode parse_values(const char *value_p, std::vector<float> &values);
+
+///////////////////////////////////////////////////////////////////////////////
+// public function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+AUDIOVirtualChannel *AUDIOVirtualChannel::create_p(AUDIOCaptureManager *manager_p, const char *section_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOVirtualChannel::create_p enter manager_p=%p section_p=%s", manager_p, section_p);
+
+    AUDIOVirtualChannel *channel_p = NULL;
+
+    do
+    {
+        // the sources are required, the gains default to a plain sum
+        const char *sources_p = NULL;
+        const char *gains_p = NULL;
+        if (RESULT_CODE_OK != Config::get_instance_p()->get_string(section_p, SOURCES_CONFIG_ITEM, &sources_p))
+        {
+            break;
+        }
+        Config::get_instance_p()->get_string_with_default(section_p, GAINS_CONFIG_ITEM, "", &gains_p);
+
+        std::vector<float> indexes;
+        std::vector<float> gains;
+        if ((RESULT_CODE_OK != parse_values(sources_p, indexes)) || (RESULT_CODE_OK != parse_values(gains_p, gains)))
+        {
+            LOG_GENERATE_ERROR(g_logger, "unable to parse virtual channel section=%s", section_p);
+            break;
+        }
+        if ((true == indexes.empty()) || ((false == gains.empty()) && (gains.size() != indexes.size())))
+        {
+            LOG_GENERATE_ERROR(g_logger, "virtual channel section=%s has sources=%d gains=%d", section_p, indexes.size(), gains.size());
+            break;
+        }
+
+        // with shards the mix is built by the shard that has its first source
+        if (false == manager_p->owns_index((AUDIOChannel::Index)indexes[0]))
+        {
+            LOG_GENERATE_DEBUG(g_logger, "leaving virtual channel section=%s to the shard with source=%f", section_p, indexes[0]);
+            break;
+        }
+
+        // every source has to exist already + run at the same rate
+        std::vector<AUDIOGraph::MixerInput> sources;
+        AUDIOChannel *first_p = NULL;
+        for (size_t counter = 0; counter < indexes.size(); counter++)
+        {
+            if (false == manager_p->owns_index((AUDIOChannel::Index)indexes[counter]))
+            {
+                LOG_GENERATE_ERROR(g_logger, "virtual channel section=%s source=%f is on another shard, every source has to be on the same shard", section_p, indexes[counter]);
+                break;
+            }
+            AUDIOChannel *source_p = manager_p->find_channel((AUDIOChannel::Index)indexes[counter]);
+            if ((NULL == source_p) || ((float)source_p->get_index() != indexes[counter]))
+            {
+                LOG_GENERATE_ERROR(g_logger, "virtual channel section=%s has unknown source=%f", section_p, indexes[counter]);
+                break;
+            }
+            if ((NULL != first_p) && (first_p->get_sample_rate() != source_p->get_sample_rate()))
+            {
+                LOG_GENERATE_ERROR(g_logger, "virtual channel section=%s source=%d sample_rate=%d does not match sample_rate=%d", section_p, source_p->get_index(), source_p->get_sample_rate(), first_p->get_sample_rate());
+                break;
+            }
+            if (NULL == first_p)
+            {
+                first_p = source_p;
+            }
+
+            AUDIOGraph::MixerInput source;
+            source.channel_p = source_p;
+            source.gain = (true == gains.empty()) ? DEFAULT_GAIN : gains[counter];
+            sources.push_back(source);
+        }
+        if (sources.size() != indexes.size())
+        {
+            break;
+        }
+
+        // the mix is measured against the first source unless told otherwise
+        float voltage = 0.0f;
+        Config::get_instance_p()->get_float_with_default(section_p, FULLSCALE_VOLTAGE_CONFIG_ITEM, first_p->get_fullscale_voltage(), &voltage);
+
+        AUDIOChannel::Index index = manager_p->allocate_index();
+        if (CAPTURE_NO_CHANNEL_INDEX == index)
+        {
+            LOG_GENERATE_ERROR(g_logger, "no index left for virtual channel section=%s", section_p);
+            break;
+        }
+
+        LOG_GENERATE_INFO(g_logger, "using section=%s for virtual channel=%d with sources=%d", section_p, index, sources.size());
+
+        channel_p = new AUDIOVirtualChannel(manager_p, index, first_p->get_sample_rate(), voltage, sources);
+        channel_p->set_fullscale_level(first_p->get_fullscale_level());
+
+        // a downmix can stand in for a bus position too
+        const char *role_p = NULL;
+        if (RESULT_CODE_OK == Config::get_instance_p()->get_string(section_p, ROLE_CONFIG_ITEM, &role_p))
+        {
+            AUDIOChannel::Role role = AUDIOChannel::ROLE_UNKNOWN;
+            if (RESULT_CODE_OK == AUDIOChannel::find_role(role_p, &role))
+            {
+                channel_p->set_role(role);
+            }
+            else
+            {
+                LOG_GENERATE_WARN(g_logger, "ignoring unknown role=%s for virtual channel=%d", role_p, index);
+            }
+        }
+    }
+    while (false);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOVirtualChannel::create_p exit channel_p=%p", channel_p);
+    return channel_p;
+}
+
+AUDIOVirtualChannel::~AUDIOVirtualChannel()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOVirtualChannel::~AUDIOVirtualChannel enter this=%p", this);
+    LOG_GENERATE_TRACE(g_logger, "AUDIOVirtualChannel::~AUDIOVirtualChannel exit");
+}
+
+size_t AUDIOVirtualChannel::get_maximum_block_length() const
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOVirtualChannel::get_maximum_block_length enter this=%p", this);
+
+    // a source catching up can flush the whole pending window in one go
+    size_t length = CALC_NUM_SAMPLES_FOR_MILLIS(VIRTUAL_CHANNEL_PENDING_TIME_IN_MS, get_sample_rate());
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOVirtualChannel::get_maximum_block_length exit length=%d", length);
+    return length;
+}
+
+void AUDIOVirtualChannel::describe_mixer(AUDIOGraph::MixerDescription &mixer) const
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOVirtualChannel::describe_mixer enter this=%p", this);
+
+    mixer.channel_p = this;
+    mixer.inputs = m_inputs;
+    mixer.pendingLength = get_maximum_block_length();
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOVirtualChannel::describe_mixer exit inputs=%d", mixer.inputs.size());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// AUDIOGraph::Sink implementation
+///////////////////////////////////////////////////////////////////////////////
+
+void AUDIOVirtualChannel::handle_graph_samples(const AUDIOChannel *channel_p, uint64_t position, const size_t buffer_length, AUDIOChannel::Sample *buffer_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOVirtualChannel::handle_graph_samples enter this=%p channel_p=%p position=%llu buffer_length=%d buffer_p=%p", this, channel_p, (unsigned long long)position, buffer_length, buffer_p);
+
+    // the mix goes to the handlers exactly like a captured block
+    m_manager_p->dispatch_samples(this, buffer_length, buffer_p);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOVirtualChannel::handle_graph_samples exit");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// private function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+AUDIOVirtualChannel::AUDIOVirtualChannel(AUDIOCaptureManager *manager_p, Index index, unsigned int sample_rate, float fullscale_voltage, const std::vector<AUDIOGraph::MixerInput> &inputs) :
+    AUDIOChannel(index, sample_rate, fullscale_voltage, false),
+    m_manager_p(manager_p),
+    m_inputs(inputs)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOVirtualChannel::AUDIOVirtualChannel enter this=%p manager_p=%p index=%d sample_rate=%d fullscale_voltage=%f input_count=%d", this, manager_p, index, sample_rate, fullscale_voltage, inputs.size());
+    LOG_GENERATE_TRACE(g_logger, "AUDIOVirtualChannel::AUDIOVirtualChannel exit");
+}
+
+static ResultCode parse_values(const char *value_p, std::vector<float> &values)
+{
+    LOG_GENERATE_TRACE(g_logger, "parse_values enter value_p=%s", value_p);
+
+    ResultCode result_code = RESULT_CODE_OK;
+
+    // comma separated list of numbers
+    const char *current_p = value_p;
+    while ('\0' != *current_p)
+    {
+        char *end_p = NULL;
+        float value = strtof(current_p, &end_p);
+        if (end_p == current_p)
+        {
+            result_code = RESULT_CODE_ERROR;
+            break;
+        }
+        values.push_back(value);
+        // skip the separator
+        current_p = end_p;
+        while ((',' == *current_p) || (' ' == *current_p))
+        {
+            current_p++;
+        }
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "parse_values exit result_code=%d count=%d", result_code, values.size());
+    return result_code;
+}
+
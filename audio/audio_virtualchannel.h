@@ -0,0 +1,71 @@
+#ifndef _AUDIO_VIRTUALCHANNEL_H_
+#define _AUDIO_VIRTUALCHANNEL_H_
+
+#include "common.h"
+#include "audio_channel.h"
+#include "audio_capturemgr.h"
+#include "audio_graph.h"
+
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+// how far one source can run ahead of the others before the mix goes out without it
+#define VIRTUAL_CHANNEL_PENDING_TIME_IN_MS      (250)
+
+///////////////////////////////////////////////////////////////////////////////
+// forward declarations
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// class definition
+///////////////////////////////////////////////////////////////////////////////
+
+// the capture manager's graph does the mixing, the channel says what goes into it + sends the result on
+class AUDIOVirtualChannel : public AUDIOChannel, public AUDIOGraph::Sink
+{
+
+///////////////////////////////////////////////////////////////////////////////
+// public function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+
+    static AUDIOVirtualChannel *create_p(AUDIOCaptureManager *manager_p, const char *section_p);
+    virtual ~AUDIOVirtualChannel();
+
+    size_t get_maximum_block_length() const;
+    void describe_mixer(AUDIOGraph::MixerDescription &mixer) const;
+
+///////////////////////////////////////////////////////////////////////////////
+// AUDIOGraph::Sink declarations
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+
+    void handle_graph_samples(const AUDIOChannel *channel_p, uint64_t position, const size_t buffer_length, AUDIOChannel::Sample *buffer_p);
+
+///////////////////////////////////////////////////////////////////////////////
+// private function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+
+    AUDIOVirtualChannel(AUDIOCaptureManager *manager_p, Index index, unsigned int sample_rate, float fullscale_voltage, const std::vector<AUDIOGraph::MixerInput> &inputs);
+
+///////////////////////////////////////////////////////////////////////////////
+// private variable definitions
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+    AUDIOCaptureManager *m_manager_p;
+    // the terms of the linear combination
+    std::vector<AUDIOGraph::MixerInput> m_inputs;
+
+};
+
+#endif
+
@@ -0,0 +1,248 @@
+#include "audio_weighting.h"
+#include "log.h"
+
+#include <math.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+// reference: IEC 61672-1 pole frequencies, both curves are normalized to 0dB at 1kHz
+#define WEIGHTING_POLE_1_FREQUENCY          (20.598997)
+#define WEIGHTING_POLE_2_FREQUENCY          (107.65265)
+#define WEIGHTING_POLE_3_FREQUENCY          (737.86223)
+#define WEIGHTING_POLE_4_FREQUENCY          (12194.217)
+#define WEIGHTING_REFERENCE_FREQUENCY       (1000.0)
+#define WEIGHTING_MAXIMUM_PREWARP_RATIO     (0.4)
+
+///////////////////////////////////////////////////////////////////////////////
+// type defintions
+///////////////////////////////////////////////////////////////////////////////
+
+// a first order section as b0 + b1 z^-1 over a0 + a1 z^-1
+typedef struct
+{
+    double b0;
+    double b1;
+    double a0;
+    double a1;
+} FirstOrder;
+
+///////////////////////////////////////////////////////////////////////////////
+// constants
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// module variables
+///////////////////////////////////////////////////////////////////////////////
+
+static LogInstance g_logger("audio.weighting");
+
+std::map<AUDIOWeightingFilter::DesignKey, AUDIOWeightingFilter::Design> AUDIOWeightingFilter::g_designs;
+
+///////////////////////////////////////////////////////////////////////////////
+// private function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+static double calculate_prewarped(unsigned int sample_rate, double frequency);
+static FirstOrder create_highpass(unsigned int sample_rate, double frequency);
+static FirstOrder create_lowpass(unsigned int sample_rate, double frequency);
+static AUDIOBiquad::Coefficients combine(const FirstOrder &first, const FirstOrder &second);
+static double calculate_gain(const std::vector<AUDIOBiquad::Coefficients> &design, unsigned int sample_rate, double frequency);
+
+///////////////////////////////////////////////////////////////////////////////
+// public function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+AUDIOWeightingFilter::AUDIOWeightingFilter(AUDIOProcessor::Weighting weighting, unsigned int sample_rate) :
+    m_weighting(weighting)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOWeightingFilter::AUDIOWeightingFilter enter this=%p weighting=%d sample_rate=%d", this, weighting, sample_rate);
+
+    // every channel at the same rate shares the design, only the filter history is ours
+    const Design &design = get_design(weighting, sample_rate);
+    m_sections.resize(design.size());
+    for (size_t section = 0; section < design.size(); section++)
+    {
+        m_sections[section].set_coefficients(design[section]);
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOWeightingFilter::AUDIOWeightingFilter exit");
+}
+
+AUDIOWeightingFilter::~AUDIOWeightingFilter()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOWeightingFilter::~AUDIOWeightingFilter enter this=%p", this);
+    LOG_GENERATE_TRACE(g_logger, "AUDIOWeightingFilter::~AUDIOWeightingFilter exit");
+}
+
+void AUDIOWeightingFilter::process(const size_t buffer_length, const AUDIOChannel::Sample *buffer_p, AUDIOChannel::Sample *output_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOWeightingFilter::process enter this=%p buffer_length=%d buffer_p=%p output_p=%p", this, buffer_length, buffer_p, output_p);
+
+    // run each section over the whole block, the first one reads the input and the rest work in place
+    const AUDIOChannel::Sample *input_p = buffer_p;
+    for (std::vector<AUDIOBiquad>::iterator it = m_sections.begin();
+            it != m_sections.end();
+            it++)
+    {
+        AUDIOBiquad &section = *it;
+        for (size_t counter = 0; counter < buffer_length; counter++)
+        {
+            output_p[counter] = section.process(input_p[counter]);
+        }
+        input_p = output_p;
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOWeightingFilter::process exit");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// private function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+const AUDIOWeightingFilter::Design &AUDIOWeightingFilter::get_design(AUDIOProcessor::Weighting weighting, unsigned int sample_rate)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOWeightingFilter::get_design enter weighting=%d sample_rate=%d", weighting, sample_rate);
+
+    // only design each curve once for each sample rate
+    DesignKey key(weighting, sample_rate);
+    std::map<DesignKey, Design>::iterator it = g_designs.find(key);
+    if (g_designs.end() == it)
+    {
+        Design design;
+        const FirstOrder highpass_1 = create_highpass(sample_rate, WEIGHTING_POLE_1_FREQUENCY);
+        const FirstOrder lowpass_4 = create_lowpass(sample_rate, WEIGHTING_POLE_4_FREQUENCY);
+        switch (weighting)
+        {
+            case AUDIOProcessor::WEIGHTING_A:
+                // s^4 / ((s + w1)^2 (s + w2) (s + w3) (s + w4)^2)
+                design.push_back(combine(highpass_1, highpass_1));
+                design.push_back(combine(create_highpass(sample_rate, WEIGHTING_POLE_2_FREQUENCY), create_highpass(sample_rate, WEIGHTING_POLE_3_FREQUENCY)));
+                design.push_back(combine(lowpass_4, lowpass_4));
+                break;
+
+            case AUDIOProcessor::WEIGHTING_C:
+                // s^2 / ((s + w1)^2 (s + w4)^2)
+                design.push_back(combine(highpass_1, highpass_1));
+                design.push_back(combine(lowpass_4, lowpass_4));
+                break;
+
+            case AUDIOProcessor::WEIGHTING_Z:
+                // flat, there's nothing to do
+                break;
+        }
+
+        // fold the gain at the reference frequency into the first section
+        if (false == design.empty())
+        {
+            const float gain = (float)(1.0 / calculate_gain(design, sample_rate, WEIGHTING_REFERENCE_FREQUENCY));
+            design[0].b0 *= gain;
+            design[0].b1 *= gain;
+            design[0].b2 *= gain;
+        }
+
+        LOG_GENERATE_DEBUG(g_logger, "designed weighting=%d sample_rate=%d sections=%d", weighting, sample_rate, design.size());
+        it = g_designs.insert(std::make_pair(key, design)).first;
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOWeightingFilter::get_design exit");
+    return it->second;
+}
+
+static double calculate_prewarped(unsigned int sample_rate, double frequency)
+{
+    LOG_GENERATE_TRACE(g_logger, "calculate_prewarped enter sample_rate=%d frequency=%f", sample_rate, frequency);
+
+    // move the pole so the bilinear transform lands it back on the right frequency, poles that are
+    // too close to (or past) nyquist at low sample rates can't be placed so they're left alone
+    double w = 2.0 * M_PI * frequency;
+    if ((WEIGHTING_MAXIMUM_PREWARP_RATIO * sample_rate) > frequency)
+    {
+        w = 2.0 * sample_rate * tan((M_PI * frequency) / sample_rate);
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "calculate_prewarped exit w=%f", w);
+    return w;
+}
+
+static FirstOrder create_highpass(unsigned int sample_rate, double frequency)
+{
+    LOG_GENERATE_TRACE(g_logger, "create_highpass enter sample_rate=%d frequency=%f", sample_rate, frequency);
+
+    // bilinear transform of s / (s + w)
+    const double k = 2.0 * sample_rate;
+    const double w = calculate_prewarped(sample_rate, frequency);
+
+    FirstOrder section;
+    section.b0 = k;
+    section.b1 = -k;
+    section.a0 = k + w;
+    section.a1 = w - k;
+
+    LOG_GENERATE_TRACE(g_logger, "create_highpass exit");
+    return section;
+}
+
+static FirstOrder create_lowpass(unsigned int sample_rate, double frequency)
+{
+    LOG_GENERATE_TRACE(g_logger, "create_lowpass enter sample_rate=%d frequency=%f", sample_rate, frequency);
+
+    // bilinear transform of w / (s + w)
+    const double k = 2.0 * sample_rate;
+    const double w = calculate_prewarped(sample_rate, frequency);
+
+    FirstOrder section;
+    section.b0 = w;
+    section.b1 = w;
+    section.a0 = k + w;
+    section.a1 = w - k;
+
+    LOG_GENERATE_TRACE(g_logger, "create_lowpass exit");
+    return section;
+}
+
+static AUDIOBiquad::Coefficients combine(const FirstOrder &first, const FirstOrder &second)
+{
+    LOG_GENERATE_TRACE(g_logger, "combine enter first=%p second=%p", &first, &second);
+
+    // multiply the two first order polynomials out + normalize to a0 == 1
+    const double a0 = first.a0 * second.a0;
+
+    AUDIOBiquad::Coefficients coefficients;
+    coefficients.b0 = (float)((first.b0 * second.b0) / a0);
+    coefficients.b1 = (float)(((first.b0 * second.b1) + (first.b1 * second.b0)) / a0);
+    coefficients.b2 = (float)((first.b1 * second.b1) / a0);
+    coefficients.a1 = (float)(((first.a0 * second.a1) + (first.a1 * second.a0)) / a0);
+    coefficients.a2 = (float)((first.a1 * second.a1) / a0);
+
+    LOG_GENERATE_TRACE(g_logger, "combine exit");
+    return coefficients;
+}
+
+static double calculate_gain(const std::vector<AUDIOBiquad::Coefficients> &design, unsigned int sample_rate, double frequency)
+{
+    LOG_GENERATE_TRACE(g_logger, "calculate_gain enter sample_rate=%d frequency=%f", sample_rate, frequency);
+
+    // evaluate |H(e^jw)| for the whole cascade
+    const double w = (2.0 * M_PI * frequency) / sample_rate;
+    const double c1 = cos(w);
+    const double s1 = sin(w);
+    const double c2 = cos(2.0 * w);
+    const double s2 = sin(2.0 * w);
+    double gain = 1.0;
+    for (std::vector<AUDIOBiquad::Coefficients>::const_iterator it = design.begin();
+            it != design.end();
+            it++)
+    {
+        const double num_re = it->b0 + (it->b1 * c1) + (it->b2 * c2);
+        const double num_im = -((it->b1 * s1) + (it->b2 * s2));
+        const double den_re = 1.0 + (it->a1 * c1) + (it->a2 * c2);
+        const double den_im = -((it->a1 * s1) + (it->a2 * s2));
+        gain *= sqrt(((num_re * num_re) + (num_im * num_im)) / ((den_re * den_re) + (den_im * den_im)));
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "calculate_gain exit gain=%f", gain);
+    return gain;
+}
@@ -0,0 +1,81 @@
+#ifndef _AUDIO_WEIGHTING_H_
+#define _AUDIO_WEIGHTING_H_
+
+#include "common.h"
+#include "audio_channel.h"
+#include "audio_processor.h"
+#include "audio_biquad.h"
+
+#include <map>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// forward declarations
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// class definition
+///////////////////////////////////////////////////////////////////////////////
+
+class AUDIOWeightingFilter
+{
+
+///////////////////////////////////////////////////////////////////////////////
+// type definitions
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+
+    typedef std::pair<AUDIOProcessor::Weighting, unsigned int> DesignKey;
+    typedef std::vector<AUDIOBiquad::Coefficients> Design;
+
+///////////////////////////////////////////////////////////////////////////////
+// public function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+
+    AUDIOWeightingFilter(AUDIOProcessor::Weighting weighting, unsigned int sample_rate);
+    virtual ~AUDIOWeightingFilter();
+
+    inline AUDIOProcessor::Weighting get_weighting() const;
+
+    void process(const size_t buffer_length, const AUDIOChannel::Sample *buffer_p, AUDIOChannel::Sample *output_p);
+
+///////////////////////////////////////////////////////////////////////////////
+// private function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+
+    static const Design &get_design(AUDIOProcessor::Weighting weighting, unsigned int sample_rate);
+
+///////////////////////////////////////////////////////////////////////////////
+// private variable definitions
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+    static std::map<DesignKey, Design> g_designs;
+
+    AUDIOProcessor::Weighting m_weighting;
+    std::vector<AUDIOBiquad> m_sections;
+
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// inline function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+inline AUDIOProcessor::Weighting AUDIOWeightingFilter::get_weighting() const
+{
+    return m_weighting;
+}
+
+#endif
+
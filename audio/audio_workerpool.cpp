@@ -0,0 +1,278 @@
+#include "audio_workerpool.h"
+#include "log.h"
+
+#include <sched.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// type defintions
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// constants
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// module variables
+///////////////////////////////////////////////////////////////////////////////
+
+static LogInstance g_logger("audio.workerpool");
+
+///////////////////////////////////////////////////////////////////////////////
+// private function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// public function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+AUDIOWorkerPool::AUDIOWorkerPool(size_t worker_count) :
+    m_queued(0),
+    m_outstanding(0),
+    m_stopping(false)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOWorkerPool::AUDIOWorkerPool enter this=%p worker_count=%d", this, worker_count);
+
+    pthread_mutex_init(&m_mutex, NULL);
+    pthread_cond_init(&m_work_cond, NULL);
+    pthread_cond_init(&m_idle_cond, NULL);
+
+    // the queues all exist before any thread starts looking through them
+    for (size_t counter = 0; counter < worker_count; counter++)
+    {
+        Worker *worker_p = new Worker;
+        worker_p->pool_p = this;
+        worker_p->index = counter;
+        worker_p->load = 0;
+        pthread_mutex_init(&worker_p->mutex, NULL);
+        m_workers.push_back(worker_p);
+    }
+
+    // launch the processing threads
+    for (std::vector<Worker *>::iterator it = m_workers.begin();
+            it != m_workers.end();
+            it++)
+    {
+        if (0 != pthread_create(&(*it)->thread_id, NULL, thread_handler, (void *)*it))
+        {
+            LOG_GENERATE_ERROR(g_logger, "unable to create worker=%d", (*it)->index);
+        }
+    }
+
+    LOG_GENERATE_INFO(g_logger, "worker pool started workers=%d", m_workers.size());
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOWorkerPool::AUDIOWorkerPool exit");
+}
+
+AUDIOWorkerPool::~AUDIOWorkerPool()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOWorkerPool::~AUDIOWorkerPool enter this=%p", this);
+
+    // anything already queued still runs before the threads go
+    pthread_mutex_lock(&m_mutex);
+    m_stopping = true;
+    pthread_cond_broadcast(&m_work_cond);
+    pthread_mutex_unlock(&m_mutex);
+
+    for (std::vector<Worker *>::iterator it = m_workers.begin();
+            it != m_workers.end();
+            it++)
+    {
+        pthread_join((*it)->thread_id, NULL);
+        pthread_mutex_destroy(&(*it)->mutex);
+        delete *it;
+    }
+
+    pthread_cond_destroy(&m_idle_cond);
+    pthread_cond_destroy(&m_work_cond);
+    pthread_mutex_destroy(&m_mutex);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOWorkerPool::~AUDIOWorkerPool exit");
+}
+
+void AUDIOWorkerPool::submit(Task *task_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOWorkerPool::submit enter this=%p task_p=%p", this, task_p);
+
+    // counted before it's visible so a quick worker can't finish it ahead of the count
+    pthread_mutex_lock(&m_mutex);
+    m_outstanding++;
+    pthread_mutex_unlock(&m_mutex);
+
+    Worker *worker_p = m_workers[place_task(task_p)];
+    pthread_mutex_lock(&worker_p->mutex);
+    worker_p->tasks.push_back(task_p);
+    worker_p->load += task_p->get_cost();
+    pthread_mutex_unlock(&worker_p->mutex);
+
+    // any idle worker will do, if it isn't the owner it steals the task
+    pthread_mutex_lock(&m_mutex);
+    m_queued++;
+    pthread_cond_signal(&m_work_cond);
+    pthread_mutex_unlock(&m_mutex);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOWorkerPool::submit exit worker=%d", worker_p->index);
+}
+
+void AUDIOWorkerPool::wait()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOWorkerPool::wait enter this=%p", this);
+
+    pthread_mutex_lock(&m_mutex);
+    while (0 < m_outstanding)
+    {
+        pthread_cond_wait(&m_idle_cond, &m_mutex);
+    }
+    pthread_mutex_unlock(&m_mutex);
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOWorkerPool::wait exit");
+}
+
+AUDIOWorkerPool::Task::Task() :
+    m_last_worker(WORKER_POOL_NO_WORKER)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOWorkerPool::Task::Task enter this=%p", this);
+    LOG_GENERATE_TRACE(g_logger, "AUDIOWorkerPool::Task::Task exit");
+}
+
+AUDIOWorkerPool::Task::~Task()
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOWorkerPool::Task::~Task enter this=%p", this);
+    LOG_GENERATE_TRACE(g_logger, "AUDIOWorkerPool::Task::~Task exit");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// private function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+void *AUDIOWorkerPool::thread_handler(void *arg)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOWorkerPool::thread_handler enter arg=%p", arg);
+
+    // get the worker + the pool it belongs to
+    Worker *worker_p = (Worker *)arg;
+    AUDIOWorkerPool *pool_p = worker_p->pool_p;
+
+    for (;;)
+    {
+        // claim one of the queued tasks, or leave once they've all gone
+        pthread_mutex_lock(&pool_p->m_mutex);
+        while ((0 == pool_p->m_queued) && (false == pool_p->m_stopping))
+        {
+            pthread_cond_wait(&pool_p->m_work_cond, &pool_p->m_mutex);
+        }
+        if (0 == pool_p->m_queued)
+        {
+            pthread_mutex_unlock(&pool_p->m_mutex);
+            break;
+        }
+        pool_p->m_queued--;
+        pthread_mutex_unlock(&pool_p->m_mutex);
+
+        // the claim guarantees a task is sitting in one of the queues
+        Task *task_p = pool_p->take_task(worker_p);
+        while (NULL == task_p)
+        {
+            sched_yield();
+            task_p = pool_p->take_task(worker_p);
+        }
+
+        const unsigned int cost = task_p->get_cost();
+        task_p->m_last_worker = worker_p->index;
+        task_p->run(worker_p->index);
+
+        pthread_mutex_lock(&worker_p->mutex);
+        worker_p->load -= cost;
+        pthread_mutex_unlock(&worker_p->mutex);
+
+        // the last one out wakes anyone waiting on the tick
+        pthread_mutex_lock(&pool_p->m_mutex);
+        pool_p->m_outstanding--;
+        if (0 == pool_p->m_outstanding)
+        {
+            pthread_cond_broadcast(&pool_p->m_idle_cond);
+        }
+        pthread_mutex_unlock(&pool_p->m_mutex);
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOWorkerPool::thread_handler exit");
+    return NULL;
+}
+
+AUDIOWorkerPool::Task *AUDIOWorkerPool::take_task(Worker *worker_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOWorkerPool::take_task enter this=%p worker=%d", this, worker_p->index);
+
+    // the newest of our own is the most likely to still be in cache
+    Task *task_p = NULL;
+    pthread_mutex_lock(&worker_p->mutex);
+    if (false == worker_p->tasks.empty())
+    {
+        task_p = worker_p->tasks.back();
+        worker_p->tasks.pop_back();
+    }
+    pthread_mutex_unlock(&worker_p->mutex);
+
+    // otherwise steal the oldest from the next worker along that has any
+    for (size_t counter = 1; (NULL == task_p) && (counter < m_workers.size()); counter++)
+    {
+        Worker *victim_p = m_workers[(worker_p->index + counter) % m_workers.size()];
+        pthread_mutex_lock(&victim_p->mutex);
+        if (false == victim_p->tasks.empty())
+        {
+            task_p = victim_p->tasks.front();
+            victim_p->tasks.pop_front();
+            victim_p->load -= task_p->get_cost();
+        }
+        pthread_mutex_unlock(&victim_p->mutex);
+
+        // the work moves over with the task
+        if (NULL != task_p)
+        {
+            pthread_mutex_lock(&worker_p->mutex);
+            worker_p->load += task_p->get_cost();
+            pthread_mutex_unlock(&worker_p->mutex);
+        }
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOWorkerPool::take_task exit task_p=%p", task_p);
+    return task_p;
+}
+
+size_t AUDIOWorkerPool::place_task(const Task *task_p) const
+{
+    LOG_GENERATE_TRACE(g_logger, "AUDIOWorkerPool::place_task enter this=%p task_p=%p", this, task_p);
+
+    // the least loaded worker gets it, so the expensive meters end up spread out
+    std::vector<unsigned int> loads(m_workers.size(), 0);
+    size_t least = 0;
+    for (size_t counter = 0; counter < m_workers.size(); counter++)
+    {
+        pthread_mutex_lock(&m_workers[counter]->mutex);
+        loads[counter] = m_workers[counter]->load;
+        pthread_mutex_unlock(&m_workers[counter]->mutex);
+        if (loads[counter] < loads[least])
+        {
+            least = counter;
+        }
+    }
+
+    // unless where it ran last is no worse off for having it, as its state is still warm there
+    size_t index = least;
+    const size_t last = task_p->m_last_worker;
+    if ((WORKER_POOL_NO_WORKER != last) && (last < m_workers.size()) && (loads[last] <= loads[least] + task_p->get_cost()))
+    {
+        index = last;
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "AUDIOWorkerPool::place_task exit index=%d", index);
+    return index;
+}
+
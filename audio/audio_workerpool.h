@@ -0,0 +1,114 @@
+#ifndef _AUDIO_WORKERPOOL_H_
+#define _AUDIO_WORKERPOOL_H_
+
+#include "common.h"
+
+#include <pthread.h>
+#include <deque>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+#define WORKER_POOL_NO_WORKER       ((size_t)-1)
+
+///////////////////////////////////////////////////////////////////////////////
+// forward declarations
+///////////////////////////////////////////////////////////////////////////////
+
+
+///////////////////////////////////////////////////////////////////////////////
+// class definition
+///////////////////////////////////////////////////////////////////////////////
+
+class AUDIOWorkerPool
+{
+
+///////////////////////////////////////////////////////////////////////////////
+// type definitions
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+
+    class Task
+    {
+        friend class AUDIOWorkerPool;
+    public:
+        Task();
+        virtual ~Task();
+        // worker is the index of the thread running it, for anything kept per thread
+        virtual void run(size_t worker) = 0;
+        // the expected work, in the same units as the meter costs
+        virtual unsigned int get_cost() const = 0;
+    private:
+        // where it last ran, it goes back there while that worker isn't overloaded
+        size_t m_last_worker;
+    };
+
+private:
+
+    typedef struct
+    {
+        AUDIOWorkerPool *pool_p;
+        size_t index;
+        pthread_t thread_id;
+        // the owner takes from the back, thieves from the front
+        pthread_mutex_t mutex;
+        std::deque<Task *> tasks;
+        // the cost of everything queued on or running in this worker
+        unsigned int load;
+    } Worker;
+
+///////////////////////////////////////////////////////////////////////////////
+// public function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+    AUDIOWorkerPool(size_t worker_count);
+    virtual ~AUDIOWorkerPool();
+
+    void submit(Task *task_p);
+    void wait();
+
+    inline size_t get_worker_count() const;
+
+///////////////////////////////////////////////////////////////////////////////
+// private function declarations
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+    static void *thread_handler(void *arg);
+
+    Task *take_task(Worker *worker_p);
+    size_t place_task(const Task *task_p) const;
+
+///////////////////////////////////////////////////////////////////////////////
+// private variable definitions
+///////////////////////////////////////////////////////////////////////////////
+
+private:
+    std::vector<Worker *> m_workers;
+
+    // guards the counts below, the queues each have their own lock
+    pthread_mutex_t m_mutex;
+    pthread_cond_t m_work_cond;
+    pthread_cond_t m_idle_cond;
+    // tasks sitting in a queue that no worker has claimed yet
+    size_t m_queued;
+    // tasks submitted that haven't finished running
+    size_t m_outstanding;
+    bool m_stopping;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// inline function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+inline size_t AUDIOWorkerPool::get_worker_count() const
+{
+    return m_workers.size();
+}
+
+#endif
+
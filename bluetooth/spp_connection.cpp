@@ -45,7 +45,7 @@ static LogInstance g_logger("bluetooth.spp.connection");
 SPPConnection::SPPConnection(SPPServer *server_p, int socket, const bdaddr_t *remote_addr_p) :
     m_server_p(server_p),
     m_socket(socket),
-    m_loop_p(ev_default_loop(0)),
+    m_loop_p(server_p->m_loop_p),
     m_handler_p(APPManager::createSPPConnector(this))
 {
     LOG_GENERATE_TRACE(g_logger, "SPPConnection::SPPConnection enter this=%p server_p=%p socket=%d remote_addr_p=%p", 
@@ -178,6 +178,41 @@ ResultCode SPPConnection::send_notification(APPManager::Message **notification_p
     return RESULT_CODE_OK;
 }
 
+ResultCode SPPConnection::send_response(ResultCode result_code, APPManager::Message **response_pp)
+{
+    LOG_GENERATE_TRACE(g_logger, "SPPConnection::send_response enter this=%p result_code=%d response_pp=%p", this, result_code, response_pp);
+
+    if (RESULT_CODE_OK == result_code)
+    {
+        ASSERT(NULL != *response_pp);
+
+        LOG_GENERATE_DEBUG(g_logger, "SPPConnection::send_response request handler returned ok");
+
+        // use the notification send method to queue the message
+        send_notification(response_pp);
+    }
+    else
+    {
+        LOG_GENERATE_ERROR(g_logger, "SPPConnection::send_response request handler returned error=%d response_p=%p", result_code, *response_pp);
+        // send back the response if provided
+        if (NULL != *response_pp)
+        {
+            // use the notification send method to queue the message
+            send_notification(response_pp);
+        }
+        else
+        {
+            // disconnect, which deletes us
+            SPPConnection *connection_p = this;
+            disconnect(&connection_p);
+        }
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "SPPConnection::send_response exit");
+
+    return RESULT_CODE_OK;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // private function implementations
 ///////////////////////////////////////////////////////////////////////////////
@@ -259,32 +294,15 @@ void SPPConnection::receive_cb (EV_P_ ev_io *w_p, int revents)
 
                     // call the handler
                     ResultCode result_code = connection_p->m_handler_p->handle_request(receive_p->get_message_p(), &response_p);
-                    if (RESULT_CODE_OK == result_code)
-                    {
-                        ASSERT(NULL != response_p);
 
-                        LOG_GENERATE_DEBUG(g_logger, "SPPConnection::rx_message_cb request handler returned ok");
+                    // cleanup the receive buffer
+                    receive_p->clear();
 
-                        // use the notification send method to queue the message
-                        connection_p->send_notification(&response_p);
-                    }
-                    else
+                    // a pending request is answered through send_response once the processing loop has run it
+                    if (RESULT_CODE_PENDING != result_code)
                     {
-                        LOG_GENERATE_ERROR(g_logger, "SPPConnection::rx_message_cb request handler returned error=rc response_p=%p", result_code, response_p);
-                        // send back the response if provided
-                        if (NULL != response_p)
-                        {
-                            // use the notification send method to queue the message
-                            connection_p->send_notification(&response_p);
-                        }
-                        else 
-                        {
-                            // disconnect
-                            disconnect(&connection_p);
-                        }
+                        connection_p->send_response(result_code, &response_p);
                     }
-                    // cleanup the receive buffer
-                    receive_p->clear();
                 }
             }
         }
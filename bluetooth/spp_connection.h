@@ -74,6 +74,7 @@ public:
 public:
 
     ResultCode send_notification(APPManager::Message **notification_pp);
+    ResultCode send_response(ResultCode result_code, APPManager::Message **response_pp);
 
 
 ///////////////////////////////////////////////////////////////////////////////
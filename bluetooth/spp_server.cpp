@@ -52,11 +52,11 @@ static uint8_t allocate_channel(int sock, struct sockaddr_rc *sockaddr);
 // public function implementations
 ///////////////////////////////////////////////////////////////////////////////
 
-SPPServer::SPPServer(uuid_t uuid) :
-    m_uuid(uuid), m_session_p(NULL), m_loop_p(ev_default_loop(0)), m_socket(
+SPPServer::SPPServer(uuid_t uuid, struct ev_loop *loop_p) :
+    m_uuid(uuid), m_session_p(NULL), m_loop_p(loop_p), m_socket(
         0), m_connection_p(NULL)
 {
-    LOG_GENERATE_TRACE(g_logger, "SPPServer::SPPServer enter this=%d uuid=%d", this, uuid);
+    LOG_GENERATE_TRACE(g_logger, "SPPServer::SPPServer enter this=%d uuid=%d loop_p=%p", this, uuid, loop_p);
 
     // create the SPP socket
     m_socket = socket(AF_BLUETOOTH, SOCK_STREAM, BTPROTO_RFCOMM);
@@ -41,7 +41,7 @@ class SPPServer
 
 public:
 
-    SPPServer(uuid_t uuid);
+    SPPServer(uuid_t uuid, struct ev_loop *loop_p);
     virtual ~SPPServer();
 
 
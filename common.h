@@ -27,6 +27,8 @@ typedef enum
 {
     RESULT_CODE_OK = 0,
     RESULT_CODE_ERROR,
+    // the outcome is handed back later on the caller's loop
+    RESULT_CODE_PENDING,
 } ResultCode;
 
 ///////////////////////////////////////////////////////////////////////////////
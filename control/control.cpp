@@ -1,6 +1,10 @@
 
 #include "common.h"
 #include "control.h"
+#include "audio/audio_histogrammeter.h"
+#include "audio/audio_meterregistry.h"
+#include "audio/audio_overdetector.h"
+#include "audio/audio_alarmengine.h"
 #include "log.h"
 
 #include "proto/v1.pb.h"
@@ -35,6 +39,9 @@ static LogInstance g_logger("control.v1");
 ///////////////////////////////////////////////////////////////////////////////
 
 static APPManager::Message *populate_response(::google::protobuf::MessageLite& message);
+static ResultCode convert_level_type(v1::LevelType type, AUDIOProcessor::LevelType *type_p);
+static v1::LevelType convert_v1_level_type(AUDIOProcessor::LevelType type);
+static ResultCode populate_parameters(const v1::SetLevelRequest &setlevel, AUDIOMeterRegistry::Parameters &parameters);
 
 ///////////////////////////////////////////////////////////////////////////////
 // public function implementations
@@ -50,6 +57,7 @@ Control::Control(AUDIOProcessor *processor_p, APPManager::NotificationHandler *h
 
     // add ourselves as a handler
     m_processor_p->add_handler(this);
+    AUDIOCaptureManager::get_instance()->get_fault_detector()->add_handler(this);
 
     LOG_GENERATE_TRACE(g_logger, "Control::Control exit");
 }
@@ -59,6 +67,7 @@ Control::~Control()
     LOG_GENERATE_TRACE(g_logger, "Control::Contol enter this=%p", this);
 
     // remove ourselves as a handler
+    AUDIOCaptureManager::get_instance()->get_fault_detector()->remove_handler(this);
     m_processor_p->remove_handler(this);
 
     LOG_GENERATE_TRACE(g_logger, "Control::Contol exit");
@@ -126,55 +135,78 @@ ResultCode Control::handle_request(APPManager::Message *request_p, APPManager::M
                     result_code = RESULT_CODE_ERROR;
                     break;
                 }
-                // validate the requested level type
-                switch (setlevel.type())
+                // validate the weighting, meters run unweighted unless asked otherwise
+                AUDIOProcessor::Weighting weighting = AUDIOProcessor::WEIGHTING_Z;
+                if (true == setlevel.has_weighting())
                 {
-                    case v1::NONE:
-                        // remove the existing meter (if one exists)
-                        m_processor_p->clear_meter(channel_p);
-                        break;
-
-                    case v1::PPM:
+                    switch (setlevel.weighting())
                     {
-                        // create the meter
-                        AUDIOProcessor::PeakMeter *meter_p = new AUDIOProcessor::PPMMeter(channel_p);
-                        // add the hold time if it's been configured
-                        if (true == setlevel.has_holdtime())
-                        {
-                            meter_p->set_hold_time(setlevel.holdtime());
-                        }
-                        // add the meter
-                        m_processor_p->add_meter(meter_p);
+                        case v1::WEIGHTING_Z:
+                            weighting = AUDIOProcessor::WEIGHTING_Z;
+                            break;
+
+                        case v1::WEIGHTING_A:
+                            weighting = AUDIOProcessor::WEIGHTING_A;
+                            break;
+
+                        case v1::WEIGHTING_C:
+                            weighting = AUDIOProcessor::WEIGHTING_C;
+                            break;
+
+                        default:
+                            LOG_GENERATE_ERROR(g_logger, "invalid weighting=%d received from client", setlevel.weighting());
+                            result_code = RESULT_CODE_ERROR;
+                            break;
                     }
-                    break;
-
-                    case v1::DIGITALPEAK:
+                    if (RESULT_CODE_OK != result_code)
                     {
-                        // create the meter
-                        AUDIOProcessor::PeakMeter *meter_p = new AUDIOProcessor::DigitalPeakMeter(channel_p);
-                        // add the hold time if it's been configured
-                        if (true == setlevel.has_holdtime())
-                        {
-                            meter_p->set_hold_time(setlevel.holdtime());
-                        }
-                        // add the meter
-                        m_processor_p->add_meter(meter_p);
+                        break;
                     }
+                }
+                // no level means remove the existing meter (if one exists)
+                if (v1::NONE == setlevel.type())
+                {
+                    m_processor_p->clear_meter(channel_p);
+                    response_p->mutable_setlevel();
                     break;
-            
-                    case v1::VU:
-                    {
-                        // create the meter
-                        AUDIOProcessor::Meter *meter_p = new AUDIOProcessor::VUMeter(channel_p);
-                        m_processor_p->add_meter(meter_p);
-                    }
+                }
+                // the built in meters are found by type, the plugins by name
+                AUDIOMeterRegistry *registry_p = AUDIOMeterRegistry::get_instance();
+                const AUDIOMeterRegistry::Descriptor *descriptor_p = NULL;
+                AUDIOProcessor::LevelType type = AUDIOProcessor::LEVEL_TYPE_NONE;
+                if (v1::PLUGIN == setlevel.type())
+                {
+                    descriptor_p = registry_p->find_meter(setlevel.pluginname().c_str());
+                }
+                else if (RESULT_CODE_OK == convert_level_type(setlevel.type(), &type))
+                {
+                    descriptor_p = registry_p->find_meter(type);
+                }
+                if (NULL == descriptor_p)
+                {
+                    LOG_GENERATE_ERROR(g_logger, "invalid type=%d received from client", setlevel.type());
+                    result_code = RESULT_CODE_ERROR;
+                    break;
+                }
+                // pass on whatever the client set, the meter decides what it needs
+                AUDIOMeterRegistry::Parameters parameters;
+                AUDIOMeterRegistry::init_parameters(parameters);
+                result_code = populate_parameters(setlevel, parameters);
+                if (RESULT_CODE_OK != result_code)
+                {
                     break;
-
-                    default:
-                        LOG_GENERATE_ERROR(g_logger, "invalid type=%d received from client", setlevel.type());
-                        result_code = RESULT_CODE_ERROR;
-                        break;
                 }
+                // create + add the meter
+                AUDIOProcessor::Meter *meter_p = NULL;
+                result_code = registry_p->create_meter(descriptor_p, channel_p, parameters, &meter_p);
+                if (RESULT_CODE_OK != result_code)
+                {
+                    break;
+                }
+                m_processor_p->add_meter(meter_p);
+
+                // apply the weighting to the new meter
+                result_code = m_processor_p->set_weighting(channel_p, weighting);
                 // populate the response unless we've set an error code
                 if(RESULT_CODE_OK == result_code)
                 {
@@ -200,6 +232,178 @@ ResultCode Control::handle_request(APPManager::Message *request_p, APPManager::M
             }
             break;
 
+            case v1::QUERYMETERS:
+            {
+                LOG_GENERATE_INFO(g_logger, "processing QUERYMETERS request");
+
+                // the built in meters first, then any plugins in the order they loaded
+                v1::QueryMetersResponse *qm_p = response_p->mutable_querymeters();
+                AUDIOMeterRegistry *registry_p = AUDIOMeterRegistry::get_instance();
+                for (AUDIOMeterRegistry::DescriptorIterator it = registry_p->begin();
+                        it != registry_p->end();
+                        it++)
+                {
+                    const AUDIOMeterRegistry::Descriptor *descriptor_p = *it;
+                    v1::MeterRecord *meter_p = qm_p->add_meters();
+                    meter_p->set_type(convert_v1_level_type(descriptor_p->type));
+                    meter_p->set_name(descriptor_p->name_p);
+                    meter_p->set_cost(descriptor_p->cost);
+                    meter_p->set_minimumsamplerate(descriptor_p->minimumSampleRate);
+                    for (uint8_t value = 0; value < descriptor_p->valueCount; value++)
+                    {
+                        meter_p->add_valuenames(descriptor_p->valueNames_p[value]);
+                    }
+                }
+            }
+            break;
+
+            case v1::QUERYHISTOGRAM:
+            {
+                // get the request
+                const ::v1::QueryHistogramRequest &queryhistogram = request.queryhistogram();
+
+                LOG_GENERATE_INFO(g_logger, "processing QUERYHISTOGRAM request, channel=%d", queryhistogram.channel());
+
+                // the channel has to have a histogram meter running on it
+                const AUDIOHistogramMeter *meter_p = NULL;
+                AUDIOChannel *channel_p = AUDIOCaptureManager::get_instance()->find_channel((AUDIOChannel::Index)queryhistogram.channel());
+                if (NULL != channel_p)
+                {
+                    meter_p = dynamic_cast<const AUDIOHistogramMeter *>(m_processor_p->get_meter(channel_p));
+                }
+                if (NULL == meter_p)
+                {
+                    LOG_GENERATE_ERROR(g_logger, "no histogram for channel=%d received from client", queryhistogram.channel());
+                    result_code = RESULT_CODE_ERROR;
+                    break;
+                }
+
+                v1::QueryHistogramResponse *qh_p = response_p->mutable_queryhistogram();
+                qh_p->set_channel(queryhistogram.channel());
+                switch (meter_p->get_window())
+                {
+                    case AUDIOHistogramMeter::WINDOW_MINUTE:
+                        qh_p->set_histogramwindow(v1::HISTOGRAM_WINDOW_MINUTE);
+                        break;
+
+                    case AUDIOHistogramMeter::WINDOW_HOUR:
+                        qh_p->set_histogramwindow(v1::HISTOGRAM_WINDOW_HOUR);
+                        break;
+
+                    case AUDIOHistogramMeter::WINDOW_DAY:
+                        qh_p->set_histogramwindow(v1::HISTOGRAM_WINDOW_DAY);
+                        break;
+                }
+                qh_p->set_blockcount(meter_p->get_block_count());
+
+                // default to the usual spread if no percentiles were asked for
+                std::vector<float> percentiles;
+                for (int counter = 0; counter < queryhistogram.percentiles_size(); counter++)
+                {
+                    percentiles.push_back(queryhistogram.percentiles(counter));
+                }
+                if (true == percentiles.empty())
+                {
+                    percentiles.push_back(10.0f);
+                    percentiles.push_back(50.0f);
+                    percentiles.push_back(95.0f);
+                }
+                for (std::vector<float>::iterator it = percentiles.begin();
+                        it != percentiles.end();
+                        it++)
+                {
+                    qh_p->add_percentiles(*it);
+                    qh_p->add_levelsindb(meter_p->calculate_percentile(*it));
+                }
+            }
+            break;
+
+            case v1::QUERYOVERS:
+            {
+                // get the request
+                const ::v1::QueryOversRequest &queryovers = request.queryovers();
+
+                LOG_GENERATE_INFO(g_logger, "processing QUERYOVERS request, channel=%d reset=%d", queryovers.channel(), queryovers.reset());
+
+                // every channel is watched for overs, no meter needed
+                AUDIOCaptureManager *manager_p = AUDIOCaptureManager::get_instance();
+                AUDIOChannel *channel_p = manager_p->find_channel((AUDIOChannel::Index)queryovers.channel());
+                if (NULL == channel_p)
+                {
+                    LOG_GENERATE_ERROR(g_logger, "invalid channel=%d received from client", queryovers.channel());
+                    result_code = RESULT_CODE_ERROR;
+                    break;
+                }
+                AUDIOOverDetector *detector_p = manager_p->get_over_detector();
+                AUDIOOverDetector::Overs overs;
+                result_code = detector_p->query_overs(channel_p, &overs);
+                if (RESULT_CODE_OK != result_code)
+                {
+                    break;
+                }
+                // the reply carries the counts from before the reset
+                if (true == queryovers.reset())
+                {
+                    detector_p->reset_overs(channel_p);
+                }
+
+                v1::QueryOversResponse *qo_p = response_p->mutable_queryovers();
+                qo_p->set_channel(queryovers.channel());
+                qo_p->set_consecutivesamples(detector_p->get_consecutive_samples());
+                qo_p->set_position(overs.position);
+                qo_p->set_overcount(overs.over_count);
+                qo_p->set_clippedsamples(overs.clipped_count);
+                for (size_t counter = 0; counter < overs.event_count; counter++)
+                {
+                    v1::OverEventRecord *event_p = qo_p->add_events();
+                    event_p->set_position(overs.events[counter].position);
+                    event_p->set_length(overs.events[counter].length);
+                }
+            }
+            break;
+
+            case v1::SETALARMS:
+            {
+                // get the request
+                const ::v1::SetAlarmsRequest &setalarms = request.setalarms();
+
+                LOG_GENERATE_INFO(g_logger, "processing SETALARMS request, count=%d", setalarms.rules_size());
+
+                // the client's rules replace the ones it sent before
+                std::vector<AUDIOProcessor::AlarmRule> rules;
+                for (int counter = 0; (RESULT_CODE_OK == result_code) && (counter < setalarms.rules_size()); counter++)
+                {
+                    const ::v1::AlarmRuleRecord &record = setalarms.rules(counter);
+                    AUDIOProcessor::AlarmRule rule;
+                    rule.id = record.id();
+                    rule.channel = (AUDIOChannel::Index)record.channel();
+                    result_code = convert_level_type(record.type(), &rule.type);
+                    rule.comparison = (v1::ALARM_BELOW == record.comparison()) ? AUDIOProcessor::ALARM_COMPARISON_BELOW : AUDIOProcessor::ALARM_COMPARISON_ABOVE;
+                    rule.threshold = record.threshold();
+                    rule.hysteresis = record.has_hysteresis() ? record.hysteresis() : AUDIOAlarmEngine::get_default_hysteresis(rule.type);
+                    rule.durationInMs = record.durationinms();
+                    rules.push_back(rule);
+                }
+                if (RESULT_CODE_OK == result_code)
+                {
+                    result_code = m_processor_p->set_alarm_rules(rules);
+                }
+                if (RESULT_CODE_OK != result_code)
+                {
+                    LOG_GENERATE_ERROR(g_logger, "invalid alarm rules received from client");
+                    break;
+                }
+
+                // alarm only clients can drop the level stream at the same time
+                if (true == setalarms.has_levelnotifications())
+                {
+                    m_processor_p->set_level_notifications(setalarms.levelnotifications());
+                }
+                // an empty response is all the client needs
+                response_p->mutable_setalarms();
+            }
+            break;
+
             default:
                 LOG_GENERATE_ERROR(g_logger, "unknown request type=%d", request.type());
                 result_code = RESULT_CODE_ERROR;
@@ -250,6 +454,20 @@ ResultCode Control::handle_results(const size_t num_results, const AUDIOProcesso
         v1::LevelRecord* record_p = level_p->add_records();
         // populate the record
         record_p->set_channel(results[counter].channel);
+        switch (results[counter].weighting)
+        {
+            case AUDIOProcessor::WEIGHTING_Z:
+                record_p->set_weighting(v1::WEIGHTING_Z);
+                break;
+
+            case AUDIOProcessor::WEIGHTING_A:
+                record_p->set_weighting(v1::WEIGHTING_A);
+                break;
+
+            case AUDIOProcessor::WEIGHTING_C:
+                record_p->set_weighting(v1::WEIGHTING_C);
+                break;
+        }
         // fill the special stuff
         switch (results[counter].type)
         {
@@ -267,6 +485,91 @@ ResultCode Control::handle_results(const size_t num_results, const AUDIOProcesso
                 record_p->set_type(v1::VU);
                 record_p->set_vuinunits(results[counter].values.vuInUnits);
                 break;
+            case AUDIOProcessor::LEVEL_TYPE_LOUDNESS:
+                record_p->set_type(v1::LOUDNESS);
+                record_p->set_momentaryinlufs(results[counter].values.loudness.momentaryInLUFS);
+                record_p->set_shortterminlufs(results[counter].values.loudness.shorttermInLUFS);
+                record_p->set_integratedinlufs(results[counter].values.loudness.integratedInLUFS);
+                record_p->set_rangeinlu(results[counter].values.loudness.rangeInLU);
+                break;
+            case AUDIOProcessor::LEVEL_TYPE_SPECTRUM:
+                record_p->set_type(v1::SPECTRUM);
+                record_p->set_bandsperoctave(results[counter].values.spectrum.bandsPerOctave);
+                record_p->set_firstband(results[counter].values.spectrum.firstBand);
+                for (int band = 0; band < results[counter].values.spectrum.bandCount; band++)
+                {
+                    record_p->add_bandsindb(results[counter].values.spectrum.bandsInDB_p[band]);
+                }
+                break;
+            case AUDIOProcessor::LEVEL_TYPE_CORRELATION:
+                record_p->set_type(v1::CORRELATION);
+                record_p->set_pairedchannel(results[counter].values.correlation.pairedChannel);
+                record_p->set_correlation(results[counter].values.correlation.coefficient);
+                record_p->set_balance(results[counter].values.correlation.balance);
+                break;
+            case AUDIOProcessor::LEVEL_TYPE_TONE:
+                record_p->set_type(v1::TONE);
+                for (int tone = 0; tone < results[counter].values.tone.toneCount; tone++)
+                {
+                    v1::ToneRecord *tone_p = record_p->add_tones();
+                    tone_p->set_frequency(results[counter].values.tone.tones_p[tone].frequency);
+                    tone_p->set_present(results[counter].values.tone.tones_p[tone].present);
+                    tone_p->set_levelindb(results[counter].values.tone.tones_p[tone].levelInDB);
+                }
+                break;
+            case AUDIOProcessor::LEVEL_TYPE_CREST:
+                record_p->set_type(v1::CREST);
+                record_p->set_peakindb(results[counter].values.crest.peakInDB);
+                record_p->set_rmsindb(results[counter].values.crest.rmsInDB);
+                record_p->set_crestindb(results[counter].values.crest.crestInDB);
+                record_p->set_rangeindb(results[counter].values.crest.rangeInDB);
+                break;
+            case AUDIOProcessor::LEVEL_TYPE_DISTORTION:
+                record_p->set_type(v1::DISTORTION);
+                record_p->set_frequency(results[counter].values.distortion.frequency);
+                record_p->set_levelindb(results[counter].values.distortion.levelInDB);
+                record_p->set_thdnindb(results[counter].values.distortion.thdnInDB);
+                record_p->set_sinadindb(results[counter].values.distortion.sinadInDB);
+                break;
+            case AUDIOProcessor::LEVEL_TYPE_NOISEFLOOR:
+                record_p->set_type(v1::NOISEFLOOR);
+                record_p->set_levelindb(results[counter].values.noisefloor.levelInDB);
+                record_p->set_floorindb(results[counter].values.noisefloor.floorInDB);
+                break;
+            case AUDIOProcessor::LEVEL_TYPE_DELAY:
+                record_p->set_type(v1::DELAY);
+                record_p->set_pairedchannel(results[counter].values.delay.pairedChannel);
+                record_p->set_laginsamples(results[counter].values.delay.lagInSamples);
+                record_p->set_laginms(results[counter].values.delay.lagInMs);
+                record_p->set_confidence(results[counter].values.delay.confidence);
+                break;
+            case AUDIOProcessor::LEVEL_TYPE_GROUP:
+                record_p->set_type(v1::GROUP);
+                record_p->set_groupballistics((AUDIOProcessor::LEVEL_TYPE_DIGITALPEAK == results[counter].values.group.ballistics) ? v1::DIGITALPEAK : v1::PPM);
+                record_p->set_peakindb(results[counter].values.group.peakInDB);
+                record_p->set_holdindb(results[counter].values.group.holdInDB);
+                for (int member = 0; member < results[counter].values.group.memberCount; member++)
+                {
+                    v1::GroupMemberRecord *member_p = record_p->add_members();
+                    member_p->set_channel(results[counter].values.group.members_p[member].channel);
+                    member_p->set_peakindb(results[counter].values.group.members_p[member].peakInDB);
+                }
+                break;
+            case AUDIOProcessor::LEVEL_TYPE_HISTOGRAM:
+                record_p->set_type(v1::HISTOGRAM);
+                record_p->set_levelindb(results[counter].values.histogram.levelInDB);
+                record_p->set_p10indb(results[counter].values.histogram.p10InDB);
+                record_p->set_p50indb(results[counter].values.histogram.p50InDB);
+                record_p->set_p95indb(results[counter].values.histogram.p95InDB);
+                break;
+            case AUDIOProcessor::LEVEL_TYPE_PLUGIN:
+                record_p->set_type(v1::PLUGIN);
+                record_p->set_pluginname(results[counter].values.plugin.name_p);
+                for (int value = 0; value < results[counter].values.plugin.valueCount; value++)
+                {
+                    record_p->add_pluginvalues(results[counter].values.plugin.values_p[value]);
+                }
+                break;
             default:
                 LOG_GENERATE_ERROR(g_logger, "unknown level type=%d", results[counter].type);
                 return RESULT_CODE_ERROR;
@@ -293,6 +596,106 @@ ResultCode Control::handle_results(const size_t num_results, const AUDIOProcesso
 }
 
 
+ResultCode Control::handle_alarms(const size_t num_alarms, const AUDIOProcessor::AlarmData alarms[])
+{
+    LOG_GENERATE_TRACE(g_logger, "Control::handle_alarms enter this=%p num_alarms=%d alarms=%p", this, num_alarms, alarms);
+
+    // get the notification ready
+    v1::ResponseOrNotification responseornotification;
+    v1::Notification *notification_p = responseornotification.mutable_notification();
+    responseornotification.set_type(v1::ResponseOrNotification_ResponseOrNotificationType_NOTIFICATION);
+    notification_p->set_type(v1::ALARM);
+
+    // only the rules that changed state this tick
+    v1::AlarmNotification *alarm_p = notification_p->mutable_alarm();
+    for (size_t counter = 0; counter < num_alarms; counter++)
+    {
+        v1::AlarmRecord *record_p = alarm_p->add_records();
+        record_p->set_id(alarms[counter].id);
+        record_p->set_channel(alarms[counter].channel);
+        record_p->set_active(alarms[counter].active);
+        record_p->set_value(alarms[counter].value);
+    }
+
+    // encode the notification
+    APPManager::Message *message_p = populate_response(responseornotification);
+
+    // off she goes
+    ResultCode rc = m_handler_p->send_notification(&message_p);
+    if (RESULT_CODE_OK != rc)
+    {
+        LOG_GENERATE_ERROR(g_logger, "unable to send notification rc=%d", rc);
+        free(message_p);
+    }
+    else
+    {
+        ASSERT(NULL == message_p);
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "Control::handle_alarms exit rc=%d", rc);
+    return rc;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// AUDIOFaultDetector::Handler implementation
+///////////////////////////////////////////////////////////////////////////////
+
+ResultCode Control::handle_fault(const AUDIOFaultDetector::Fault &fault)
+{
+    LOG_GENERATE_TRACE(g_logger, "Control::handle_fault enter this=%p type=%d channel=%d active=%d", this, fault.type, fault.channel, fault.active);
+
+    // get the notification ready
+    v1::ResponseOrNotification responseornotification;
+    v1::Notification *notification_p = responseornotification.mutable_notification();
+    responseornotification.set_type(v1::ResponseOrNotification_ResponseOrNotificationType_NOTIFICATION);
+    notification_p->set_type(v1::FAULT);
+
+    // faults are rare so each one goes out on its own
+    v1::FaultRecord *record_p = notification_p->mutable_fault()->add_records();
+    record_p->set_channel(fault.channel);
+    switch (fault.type)
+    {
+        case AUDIOFaultDetector::FAULT_TYPE_SILENCE:
+            record_p->set_faulttype(v1::FAULT_SILENCE);
+            break;
+
+        case AUDIOFaultDetector::FAULT_TYPE_DROPOUT:
+            record_p->set_faulttype(v1::FAULT_DROPOUT);
+            break;
+
+        case AUDIOFaultDetector::FAULT_TYPE_DC_OFFSET:
+            record_p->set_faulttype(v1::FAULT_DC_OFFSET);
+            break;
+
+        case AUDIOFaultDetector::FAULT_TYPE_STUCK_BIT:
+            record_p->set_faulttype(v1::FAULT_STUCK_BIT);
+            break;
+    }
+    record_p->set_active(fault.active);
+    record_p->set_position(fault.position);
+    record_p->set_levelindb(fault.levelInDB);
+    record_p->set_stuckbits(fault.stuckBits);
+
+    // encode the notification
+    APPManager::Message *message_p = populate_response(responseornotification);
+
+    // off she goes
+    ResultCode rc = m_handler_p->send_notification(&message_p);
+    if (RESULT_CODE_OK != rc)
+    {
+        LOG_GENERATE_ERROR(g_logger, "unable to send notification rc=%d", rc);
+        free(message_p);
+    }
+    else
+    {
+        ASSERT(NULL == message_p);
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "Control::handle_fault exit rc=%d", rc);
+    return rc;
+}
+
 
 ///////////////////////////////////////////////////////////////////////////////
 // private function implementations
@@ -316,3 +719,257 @@ APPManager::Message *populate_response(::google::protobuf::MessageLite& message)
     return response_p;
 }
 
+static ResultCode convert_level_type(v1::LevelType type, AUDIOProcessor::LevelType *type_p)
+{
+    LOG_GENERATE_TRACE(g_logger, "convert_level_type enter type=%d type_p=%p", type, type_p);
+
+    ResultCode result_code = RESULT_CODE_OK;
+    switch (type)
+    {
+        case v1::DIGITALPEAK:
+            *type_p = AUDIOProcessor::LEVEL_TYPE_DIGITALPEAK;
+            break;
+
+        case v1::PPM:
+            *type_p = AUDIOProcessor::LEVEL_TYPE_PPM;
+            break;
+
+        case v1::VU:
+            *type_p = AUDIOProcessor::LEVEL_TYPE_VU;
+            break;
+
+        case v1::LOUDNESS:
+            *type_p = AUDIOProcessor::LEVEL_TYPE_LOUDNESS;
+            break;
+
+        case v1::SPECTRUM:
+            *type_p = AUDIOProcessor::LEVEL_TYPE_SPECTRUM;
+            break;
+
+        case v1::CORRELATION:
+            *type_p = AUDIOProcessor::LEVEL_TYPE_CORRELATION;
+            break;
+
+        case v1::TONE:
+            *type_p = AUDIOProcessor::LEVEL_TYPE_TONE;
+            break;
+
+        case v1::CREST:
+            *type_p = AUDIOProcessor::LEVEL_TYPE_CREST;
+            break;
+
+        case v1::DISTORTION:
+            *type_p = AUDIOProcessor::LEVEL_TYPE_DISTORTION;
+            break;
+
+        case v1::NOISEFLOOR:
+            *type_p = AUDIOProcessor::LEVEL_TYPE_NOISEFLOOR;
+            break;
+
+        case v1::DELAY:
+            *type_p = AUDIOProcessor::LEVEL_TYPE_DELAY;
+            break;
+
+        case v1::GROUP:
+            *type_p = AUDIOProcessor::LEVEL_TYPE_GROUP;
+            break;
+
+        case v1::HISTOGRAM:
+            *type_p = AUDIOProcessor::LEVEL_TYPE_HISTOGRAM;
+            break;
+
+        default:
+            LOG_GENERATE_ERROR(g_logger, "unsupported level type=%d", type);
+            result_code = RESULT_CODE_ERROR;
+            break;
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "convert_level_type exit result_code=%d", result_code);
+    return result_code;
+}
+
+static v1::LevelType convert_v1_level_type(AUDIOProcessor::LevelType type)
+{
+    LOG_GENERATE_TRACE(g_logger, "convert_v1_level_type enter type=%d", type);
+
+    v1::LevelType v1_type = v1::NONE;
+    switch (type)
+    {
+        case AUDIOProcessor::LEVEL_TYPE_DIGITALPEAK:
+            v1_type = v1::DIGITALPEAK;
+            break;
+
+        case AUDIOProcessor::LEVEL_TYPE_PPM:
+            v1_type = v1::PPM;
+            break;
+
+        case AUDIOProcessor::LEVEL_TYPE_VU:
+            v1_type = v1::VU;
+            break;
+
+        case AUDIOProcessor::LEVEL_TYPE_LOUDNESS:
+            v1_type = v1::LOUDNESS;
+            break;
+
+        case AUDIOProcessor::LEVEL_TYPE_SPECTRUM:
+            v1_type = v1::SPECTRUM;
+            break;
+
+        case AUDIOProcessor::LEVEL_TYPE_CORRELATION:
+            v1_type = v1::CORRELATION;
+            break;
+
+        case AUDIOProcessor::LEVEL_TYPE_TONE:
+            v1_type = v1::TONE;
+            break;
+
+        case AUDIOProcessor::LEVEL_TYPE_CREST:
+            v1_type = v1::CREST;
+            break;
+
+        case AUDIOProcessor::LEVEL_TYPE_DISTORTION:
+            v1_type = v1::DISTORTION;
+            break;
+
+        case AUDIOProcessor::LEVEL_TYPE_NOISEFLOOR:
+            v1_type = v1::NOISEFLOOR;
+            break;
+
+        case AUDIOProcessor::LEVEL_TYPE_DELAY:
+            v1_type = v1::DELAY;
+            break;
+
+        case AUDIOProcessor::LEVEL_TYPE_GROUP:
+            v1_type = v1::GROUP;
+            break;
+
+        case AUDIOProcessor::LEVEL_TYPE_HISTOGRAM:
+            v1_type = v1::HISTOGRAM;
+            break;
+
+        case AUDIOProcessor::LEVEL_TYPE_PLUGIN:
+            v1_type = v1::PLUGIN;
+            break;
+
+        default:
+            break;
+    }
+
+    LOG_GENERATE_TRACE(g_logger, "convert_v1_level_type exit v1_type=%d", v1_type);
+    return v1_type;
+}
+
+static ResultCode populate_parameters(const v1::SetLevelRequest &setlevel, AUDIOMeterRegistry::Parameters &parameters)
+{
+    LOG_GENERATE_TRACE(g_logger, "populate_parameters enter setlevel=%p parameters=%p", &setlevel, &parameters);
+
+    ResultCode result_code = RESULT_CODE_OK;
+
+    do
+    {
+        if (true == setlevel.has_holdtime())
+        {
+            parameters.holdTimeInSecs = setlevel.holdtime();
+        }
+        for (int counter = 0; counter < setlevel.linkedchannels_size(); counter++)
+        {
+            AUDIOChannel *linked_p = AUDIOCaptureManager::get_instance()->find_channel((AUDIOChannel::Index)setlevel.linkedchannels(counter));
+            if (NULL == linked_p)
+            {
+                LOG_GENERATE_ERROR(g_logger, "invalid linked channel=%d received from client", setlevel.linkedchannels(counter));
+                result_code = RESULT_CODE_ERROR;
+                break;
+            }
+            parameters.linkedChannels.push_back(linked_p);
+        }
+        if (RESULT_CODE_OK != result_code)
+        {
+            break;
+        }
+        for (int counter = 0; counter < setlevel.tonefrequencies_size(); counter++)
+        {
+            parameters.frequencies.push_back(setlevel.tonefrequencies(counter));
+        }
+        if (true == setlevel.has_bandsperoctave())
+        {
+            parameters.bandsPerOctave = setlevel.bandsperoctave();
+        }
+        // the request can override either edge of the configured bandwidth
+        if (true == setlevel.has_lowfrequency())
+        {
+            parameters.lowFrequency = setlevel.lowfrequency();
+        }
+        if (true == setlevel.has_highfrequency())
+        {
+            parameters.highFrequency = setlevel.highfrequency();
+        }
+        if (true == setlevel.has_groupballistics())
+        {
+            result_code = convert_level_type(setlevel.groupballistics(), &parameters.ballistics);
+            if (RESULT_CODE_OK != result_code)
+            {
+                break;
+            }
+        }
+        if (true == setlevel.has_ppmstandard())
+        {
+            switch (setlevel.ppmstandard())
+            {
+                case v1::PPM_STANDARD_IEC_TYPE_I:
+                    parameters.standard = AUDIOBallistics::STANDARD_IEC_TYPE_I;
+                    break;
+
+                case v1::PPM_STANDARD_IEC_TYPE_IIA:
+                    parameters.standard = AUDIOBallistics::STANDARD_IEC_TYPE_IIA;
+                    break;
+
+                case v1::PPM_STANDARD_NORDIC:
+                    parameters.standard = AUDIOBallistics::STANDARD_NORDIC;
+                    break;
+
+                case v1::PPM_STANDARD_EBU:
+                    parameters.standard = AUDIOBallistics::STANDARD_EBU;
+                    break;
+
+                case v1::PPM_STANDARD_DIN:
+                    parameters.standard = AUDIOBallistics::STANDARD_DIN;
+                    break;
+
+                default:
+                    LOG_GENERATE_ERROR(g_logger, "invalid ppm standard=%d received from client", setlevel.ppmstandard());
+                    result_code = RESULT_CODE_ERROR;
+                    break;
+            }
+            if (RESULT_CODE_OK != result_code)
+            {
+                break;
+            }
+        }
+        if (true == setlevel.has_histogramwindow())
+        {
+            switch (setlevel.histogramwindow())
+            {
+                case v1::HISTOGRAM_WINDOW_MINUTE:
+                    parameters.window = AUDIOHistogramMeter::WINDOW_MINUTE;
+                    break;
+
+                case v1::HISTOGRAM_WINDOW_HOUR:
+                    parameters.window = AUDIOHistogramMeter::WINDOW_HOUR;
+                    break;
+
+                case v1::HISTOGRAM_WINDOW_DAY:
+                    parameters.window = AUDIOHistogramMeter::WINDOW_DAY;
+                    break;
+
+                default:
+                    LOG_GENERATE_ERROR(g_logger, "invalid histogram window=%d received from client", setlevel.histogramwindow());
+                    result_code = RESULT_CODE_ERROR;
+                    break;
+            }
+        }
+    }
+    while (false);
+
+    LOG_GENERATE_TRACE(g_logger, "populate_parameters exit result_code=%d", result_code);
+    return result_code;
+}
@@ -10,6 +10,7 @@
 
 #include "app/app_mgr.h"
 #include "audio/audio_processor.h"
+#include "audio/audio_faultdetector.h"
 
 #include <google/protobuf/message_lite.h>
 
@@ -28,7 +29,7 @@
 // class definition
 ///////////////////////////////////////////////////////////////////////////////
 
-class Control : public APPManager::RequestHandler, public AUDIOProcessor::Handler
+class Control : public APPManager::RequestHandler, public AUDIOProcessor::Handler, public AUDIOFaultDetector::Handler
 {
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -59,7 +60,14 @@ public:
 
 public:
     ResultCode handle_results(const size_t num_results, const AUDIOProcessor::ResultData results[]);
+    ResultCode handle_alarms(const size_t num_alarms, const AUDIOProcessor::AlarmData alarms[]);
 
+///////////////////////////////////////////////////////////////////////////////
+// AUDIOFaultDetector::Handler declarations
+///////////////////////////////////////////////////////////////////////////////
+
+public:
+    ResultCode handle_fault(const AUDIOFaultDetector::Fault &fault);
 
 ///////////////////////////////////////////////////////////////////////////////
 // private function declarations
@@ -1,11 +1,16 @@
 
 #include "bluetooth/spp_server.h"
+#include "app/app_mgr.h"
+#include "app/app_shardsupervisor.h"
+#include "app/app_shardworker.h"
 #include "audio/audio_capturemgr.h"
+#include "audio/audio_meterregistry.h"
 #include "config.h"
 #include "log.h"
 
 #include <stdlib.h>
 #include <getopt.h>
+#include <pthread.h>
 #include <ev.h>
 
 #include <log4cxx/propertyconfigurator.h>
@@ -18,6 +23,14 @@
 #define DEFAULT_LOG_CONFIG_FILE "/etc/leveling-glass/log.cfg"
 #define DEFAULT_APP_CONFIG_FILE "/etc/leveling-glass/leveling-glass.ini"
 
+#define EVENT_LOOPS_CONFIG_SECTION          "event-loops"
+#define PROCESSING_THREAD_CONFIG_ITEM       "processing-thread"
+#define DEFAULT_PROCESSING_THREAD           (0)
+
+#define SHARDS_CONFIG_SECTION               "shards"
+#define SHARD_COUNT_CONFIG_ITEM             "count"
+#define DEFAULT_SHARD_COUNT                 (0)
+
 // make sure the version macro is defined
 #ifndef VERSION
     #define VERSION "INTERNAL"
@@ -50,6 +63,7 @@ static struct option g_options[] =
 {
     {"config", optional_argument, 0, 'c'},
     {"log", optional_argument, 0, 'l'},
+    {"shard", required_argument, 0, 's'},
     {0, 0, 0, 0}
 };
 
@@ -58,6 +72,7 @@ static struct option g_options[] =
 ///////////////////////////////////////////////////////////////////////////////
 
 static void kill_cb(struct ev_loop *loop_p, ev_signal *w_p, int revents);
+static void *processing_thread_handler(void *arg);
 static void populate_logpath(char *execpath_p, size_t path_length);
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -69,12 +84,14 @@ int main(int argc, char *argv[])
     // setup default parameters
     const char *app_config_p = g_default_app_config_p;
     const char *log_config_p = g_default_log_config_p;
+    // only set when the front started us as one of its shards
+    int shard = -1;
 
     // parse the command line
     while(true)
     {
         int option_index = 0;
-        int c = getopt_long(argc, argv, "dcl:", g_options, &option_index);
+        int c = getopt_long(argc, argv, "dcl:s:", g_options, &option_index);
         // detect end of options
         if (-1 == c)
         {
@@ -108,6 +125,9 @@ int main(int argc, char *argv[])
                 LOG_GENERATE_INFO(g_logger, "using log config file=%s", optarg);
                 log_config_p = optarg; 
                 break;
+            case 's':
+                shard = atoi(optarg);
+                break;
             default:
                 LOG_GENERATE_INFO(g_logger, "invalid option '%c'", c);
                 return -1;
@@ -127,16 +147,63 @@ int main(int argc, char *argv[])
         return -1;
     }
 
-    // create the UUID for our SPP server
-    sdp_uuid128_create(&g_uuid, &c_uuid_int);
-    // start the Bluetooth SPP server
-    g_server_p = new SPPServer(g_uuid);
+    // the clients are served on the default loop, which also takes the signals
+    struct ev_loop *loop_p = EV_DEFAULT;
 
-    // create the audio layer
-    AUDIOCaptureManager::get_instance();
+    // the audio can have a loop + thread of its own, so a burst of requests or a slow write doesn't hold up the metering
+    struct ev_loop *processing_loop_p = loop_p;
+    float processing_thread = DEFAULT_PROCESSING_THREAD;
+    Config::get_instance_p()->get_float_with_default(EVENT_LOOPS_CONFIG_SECTION, PROCESSING_THREAD_CONFIG_ITEM, DEFAULT_PROCESSING_THREAD, &processing_thread);
 
-    // setup the default event loop
-    struct ev_loop *loop_p = EV_DEFAULT;
+    // the cards can be split across processes, with this one left to serve the clients
+    float shard_count = DEFAULT_SHARD_COUNT;
+    Config::get_instance_p()->get_float_with_default(SHARDS_CONFIG_SECTION, SHARD_COUNT_CONFIG_ITEM, DEFAULT_SHARD_COUNT, &shard_count);
+
+    if (0 <= shard)
+    {
+        // a shard meters its own cards on the one loop + answers to the front rather than a client
+        if ((shard_count <= shard) || (NULL == AUDIOCaptureManager::create_instance(loop_p, shard, (unsigned int)shard_count)))
+        {
+            LOG_GENERATE_WTF(g_logger, "invalid shard=%d of count=%d, exiting", shard, (int)shard_count);
+            return -1;
+        }
+        AUDIOMeterRegistry::get_instance();
+        if (NULL == APPShardWorker::create_instance(loop_p, shard))
+        {
+            LOG_GENERATE_WTF(g_logger, "shard=%d was not started by the front, exiting", shard);
+            return -1;
+        }
+    }
+    else
+    {
+        if ((0.0f != processing_thread) && (0.0f == shard_count))
+        {
+            processing_loop_p = ev_loop_new(EVFLAG_AUTO);
+        }
+
+        if (0.0f == shard_count)
+        {
+            // create the audio layer
+            AUDIOCaptureManager::create_instance(processing_loop_p);
+
+            // load the meter plugins before any client can ask for one
+            AUDIOMeterRegistry::get_instance();
+        }
+
+        // everything passing between the two loops goes through the app layer
+        APPManager::init(loop_p, processing_loop_p);
+
+        if (0.0f != shard_count)
+        {
+            // the shards are started from here, the front never opens a card itself
+            APPShardSupervisor::create_instance(loop_p, (unsigned int)shard_count, app_config_p, log_config_p);
+        }
+
+        // create the UUID for our SPP server
+        sdp_uuid128_create(&g_uuid, &c_uuid_int);
+        // start the Bluetooth SPP server
+        g_server_p = new SPPServer(g_uuid, loop_p);
+    }
 
     // register signal handlers for the TERM + KILL signals
     ev_signal kill_watcher;
@@ -146,6 +213,18 @@ int main(int argc, char *argv[])
     ev_signal_init(&term_watcher, kill_cb, SIGTERM);
     ev_signal_start(loop_p, &term_watcher);
 
+    // everything is registered with the processing loop by now, so it can start
+    if (processing_loop_p != loop_p)
+    {
+        pthread_t thread_id;
+        if (0 != pthread_create(&thread_id, NULL, processing_thread_handler, (void *)processing_loop_p))
+        {
+            LOG_GENERATE_WTF(g_logger, "unable to create the processing thread, exiting");
+            return -1;
+        }
+        LOG_GENERATE_INFO(g_logger, "processing on its own thread");
+    }
+
     // notify that we're running
     LOG_GENERATE_INFO(g_logger, "%s running", NAME);
 
@@ -167,3 +246,13 @@ void kill_cb(struct ev_loop *loop_p, ev_signal *w_p, int revents)
     exit(1);
 }
 
+void *processing_thread_handler(void *arg)
+{
+    // the dispatcher's watcher keeps this running even with no channels
+    ev_run((struct ev_loop *)arg, 0);
+
+    // we should never get here
+    LOG_GENERATE_WTF(g_logger, "processing loop exited");
+    return NULL;
+}
+
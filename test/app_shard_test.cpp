@@ -0,0 +1,695 @@
+#include "app/app_shardlink.h"
+#include "app/app_shardsupervisor.h"
+#include "app/app_shardtable.h"
+#include "config.h"
+
+#include <ev.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+#define TEST_TABLE_PUBLISHES        (50000)
+// the writer is killed this many times to catch it part way through a publish
+#define TEST_TABLE_KILLS            (20)
+#define TEST_LINK_FRAMES            (3000)
+// enough frames between reads to back the transmit queue up, while staying under SHARD_LINK_MAX_QUEUED
+#define TEST_LINK_BURST             (15)
+#define TEST_LINK_MAX_PAYLOAD       (200000)
+#define TEST_STEP                   (0.05)
+// a shard that hangs before the watchdog has seen it beat is only killed once its startup grace is over
+#define TEST_RESTART_TIMEOUT        (SHARD_STARTUP_GRACE + 30.0)
+#define TEST_SHARD_BEAT             (0.1)
+#define TEST_SHARD_OPTION           "--shard="
+#define TEST_EXIT_REQUEST           "exit"
+#define TEST_HANG_REQUEST           "hang"
+#define TEST_STATE_REQUEST          "meter-1"
+
+///////////////////////////////////////////////////////////////////////////////
+// type defintions
+///////////////////////////////////////////////////////////////////////////////
+
+// keeps every frame the link hands over
+class Recorder : public APPShardLink::Handler
+{
+public:
+    Recorder() : m_closed(false) {}
+
+    void handle_frame(APPShardLink *link_p, const APPShardLink::Header &header, APPManager::Message **message_pp)
+    {
+        m_headers.push_back(header);
+        m_payloads.push_back((NULL == *message_pp) ? std::string() : std::string((const char *)(*message_pp)->get_data_p(), (*message_pp)->get_length()));
+    }
+
+    void handle_close(APPShardLink *link_p)
+    {
+        m_closed = true;
+    }
+
+    std::vector<APPShardLink::Header> m_headers;
+    std::vector<std::string> m_payloads;
+    bool m_closed;
+};
+
+// the far end of the echo test, every frame goes straight back
+class Echo : public APPShardLink::Handler
+{
+public:
+    Echo(struct ev_loop *loop_p) : m_loop_p(loop_p), m_link_p(NULL) {}
+
+    void handle_frame(APPShardLink *link_p, const APPShardLink::Header &header, APPManager::Message **message_pp)
+    {
+        m_link_p->send((APPShardLink::FrameType)header.type, header.id, (ResultCode)header.result, message_pp);
+    }
+
+    void handle_close(APPShardLink *link_p)
+    {
+        ev_break(m_loop_p, EVBREAK_ALL);
+    }
+
+    struct ev_loop *m_loop_p;
+    APPShardLink *m_link_p;
+};
+
+// what the harness runs as when the supervisor starts it, it publishes what it has been told so the front can see it
+class FakeShard : public APPShardLink::Handler
+{
+public:
+    FakeShard(struct ev_loop *loop_p, APPShardTable *table_p) : m_loop_p(loop_p), m_table_p(table_p), m_link_p(NULL), m_opens(0)
+    {
+        ev_timer_init(&m_beat_timer, beat_cb, TEST_SHARD_BEAT, TEST_SHARD_BEAT);
+        m_beat_timer.data = (void *)this;
+        ev_timer_start(m_loop_p, &m_beat_timer);
+    }
+
+    void handle_frame(APPShardLink *link_p, const APPShardLink::Header &header, APPManager::Message **message_pp)
+    {
+        if (APPShardLink::FRAME_TYPE_OPEN == header.type)
+        {
+            m_opens++;
+            publish();
+        }
+        else if (APPShardLink::FRAME_TYPE_REQUEST == header.type)
+        {
+            const std::string request = (NULL == *message_pp) ? std::string() : std::string((const char *)(*message_pp)->get_data_p(), (*message_pp)->get_length());
+            if (TEST_EXIT_REQUEST == request)
+            {
+                _exit(1);
+            }
+            if (TEST_HANG_REQUEST == request)
+            {
+                // the loop keeps going, it's only the heartbeat the watchdog sees stop
+                ev_timer_stop(m_loop_p, &m_beat_timer);
+            }
+            else
+            {
+                m_state = request;
+                publish();
+            }
+            m_link_p->send(APPShardLink::FRAME_TYPE_RESPONSE, header.id, RESULT_CODE_OK, NULL);
+        }
+    }
+
+    void handle_close(APPShardLink *link_p)
+    {
+        ev_break(m_loop_p, EVBREAK_ALL);
+    }
+
+    void publish()
+    {
+        char record[128];
+        snprintf(record, sizeof(record), "pid=%d opens=%d state=%s", getpid(), m_opens, m_state.c_str());
+        m_table_p->publish((const uint8_t *)record, strlen(record));
+    }
+
+    static void beat_cb(EV_P_ ev_timer *w_p, int revents)
+    {
+        ((FakeShard *)(w_p->data))->m_table_p->beat();
+    }
+
+    struct ev_loop *m_loop_p;
+    APPShardTable *m_table_p;
+    APPShardLink *m_link_p;
+    ev_timer m_beat_timer;
+    int m_opens;
+    std::string m_state;
+};
+
+// what the fake shard last published
+typedef struct
+{
+    int pid;
+    int opens;
+    char state[64];
+} Record;
+
+// the client's side of the restart test, it puts a new process back the way the connector does
+class Front : public APPShardSupervisor::Listener
+{
+public:
+    Front(APPShardSupervisor *supervisor_p) : m_supervisor_p(supervisor_p), m_sequence(0), m_ups(0), m_downs(0), m_responses(0) {}
+
+    void handle_shard_up(unsigned int shard)
+    {
+        m_ups++;
+        m_sequence = m_supervisor_p->get_sequence(shard);
+        m_supervisor_p->send(shard, APPShardLink::FRAME_TYPE_OPEN, 0, NULL);
+        if (false == m_state.empty())
+        {
+            send_request(0, m_state);
+        }
+    }
+
+    void handle_shard_down(unsigned int shard)
+    {
+        m_downs++;
+    }
+
+    void handle_shard_frame(unsigned int shard, const APPShardLink::Header &header, APPManager::Message **message_pp)
+    {
+        if (APPShardLink::FRAME_TYPE_RESPONSE == header.type)
+        {
+            m_responses++;
+        }
+    }
+
+    void send_request(uint32_t id, const std::string &request)
+    {
+        APPManager::Message *message_p = new APPManager::Message(request.size());
+        memcpy(message_p->get_data_p(), request.data(), request.size());
+        m_supervisor_p->send(0, APPShardLink::FRAME_TYPE_REQUEST, id, &message_p);
+    }
+
+    void set_state(const std::string &state)
+    {
+        m_state = state;
+        send_request(1, state);
+    }
+
+    // true once the table holds a record from a process other than not_pid
+    bool read_record(int not_pid, Record &record)
+    {
+        std::vector<uint8_t> levels;
+        if (true == m_supervisor_p->read_levels(0, &m_sequence, levels))
+        {
+            m_record.assign(levels.begin(), levels.end());
+        }
+        memset(&record, 0, sizeof(record));
+        return (3 == sscanf(m_record.c_str(), "pid=%d opens=%d state=%63s", &record.pid, &record.opens, record.state)) && (not_pid != record.pid);
+    }
+
+    APPShardSupervisor *m_supervisor_p;
+    uint32_t m_sequence;
+    std::string m_record;
+    std::string m_state;
+    int m_ups;
+    int m_downs;
+    int m_responses;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// module variables
+///////////////////////////////////////////////////////////////////////////////
+
+static int g_failures = 0;
+
+///////////////////////////////////////////////////////////////////////////////
+// private function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+static void check(bool passed, const char *what_p)
+{
+    printf("%s %s\n", (true == passed) ? "ok  " : "FAIL", what_p);
+    if (false == passed)
+    {
+        g_failures++;
+    }
+}
+
+static uint8_t pattern(uint32_t seed, size_t offset)
+{
+    return (uint8_t)((seed * 31) + (offset * 7));
+}
+
+static std::string make_pattern(uint32_t seed, size_t length)
+{
+    std::string data(length, '\0');
+    for (size_t offset = 0; offset < length; offset++)
+    {
+        data[offset] = (char)pattern(seed, offset);
+    }
+    return data;
+}
+
+// each publish has its own length so a torn copy shows up in the length as well as the bytes
+static size_t table_length(uint32_t seed)
+{
+    return sizeof(seed) + ((seed * 2654435761u) % 8000);
+}
+
+static size_t link_length(uint32_t id)
+{
+    return (0 == (id % 7)) ? 0 : (id * 2654435761u) % TEST_LINK_MAX_PAYLOAD;
+}
+
+static void append_frame(std::vector<uint8_t> &stream, uint32_t type, uint32_t id, uint32_t length)
+{
+    APPShardLink::Header header;
+    header.type = type;
+    header.id = id;
+    header.result = RESULT_CODE_OK;
+    header.length = length;
+    const uint8_t *header_p = (const uint8_t *)&header;
+    stream.insert(stream.end(), header_p, header_p + sizeof(header));
+    const std::string data = make_pattern(id, length);
+    stream.insert(stream.end(), data.begin(), data.end());
+}
+
+static void stop_cb(EV_P_ ev_timer *w_p, int revents)
+{
+    ev_break(EV_A_ EVBREAK_ONE);
+}
+
+static void run_for(struct ev_loop *loop_p, ev_tstamp seconds)
+{
+    ev_timer timer;
+    ev_timer_init(&timer, stop_cb, seconds, 0);
+    ev_timer_start(loop_p, &timer);
+    ev_run(loop_p, 0);
+    ev_timer_stop(loop_p, &timer);
+}
+
+static bool wait_for_record(struct ev_loop *loop_p, Front &front, int ups, int not_pid, Record &record)
+{
+    for (ev_tstamp waited = 0; waited < TEST_RESTART_TIMEOUT; waited += TEST_STEP)
+    {
+        if ((ups == front.m_ups) && (true == front.read_record(not_pid, record)) && (0 < record.opens))
+        {
+            return true;
+        }
+        run_for(loop_p, TEST_STEP);
+    }
+    return false;
+}
+
+// a writer in another process publishes as fast as it can while we read, no copy may be torn
+static void test_table_seqlock()
+{
+    APPShardTable *table_p = APPShardTable::create_p();
+    check(NULL != table_p, "table: created");
+    if (NULL == table_p)
+    {
+        return;
+    }
+
+    pid_t pid = fork();
+    if (0 == pid)
+    {
+        // mapped through the fd the way a shard does it
+        APPShardTable *writer_p = APPShardTable::attach_p(table_p->get_fd());
+        if (NULL == writer_p)
+        {
+            _exit(1);
+        }
+        static uint8_t levels[SHARD_TABLE_LEVELS_SIZE];
+        for (uint32_t seed = 1; seed <= TEST_TABLE_PUBLISHES; seed++)
+        {
+            const size_t length = table_length(seed);
+            memcpy(levels, &seed, sizeof(seed));
+            const std::string data = make_pattern(seed, length - sizeof(seed));
+            memcpy(levels + sizeof(seed), data.data(), data.size());
+            writer_p->publish(levels, length);
+            writer_p->beat();
+        }
+        // then the empty table a shard with nothing to meter publishes
+        writer_p->publish(NULL, 0);
+        _exit(0);
+    }
+
+    std::vector<uint8_t> levels;
+    uint32_t sequence = 0;
+    long good = 0;
+    long torn = 0;
+    bool ordered = true;
+    int status = 0;
+    while (0 == waitpid(pid, &status, WNOHANG))
+    {
+        uint32_t last = sequence;
+        if (false == table_p->read(&sequence, levels))
+        {
+            continue;
+        }
+        ordered = ordered && (0 == (sequence & 1)) && (sequence > last);
+        if (true == levels.empty())
+        {
+            continue;
+        }
+        uint32_t seed = 0;
+        if (sizeof(seed) <= levels.size())
+        {
+            memcpy(&seed, &levels[0], sizeof(seed));
+        }
+        if ((sizeof(seed) <= levels.size()) && (table_length(seed) == levels.size()) &&
+                (make_pattern(seed, levels.size() - sizeof(seed)) == std::string(levels.begin() + sizeof(seed), levels.end())))
+        {
+            good++;
+        }
+        else
+        {
+            torn++;
+        }
+    }
+    table_p->read(&sequence, levels);
+
+    printf("table: %ld whole copies, %ld torn\n", good, torn);
+    check((true == WIFEXITED(status)) && (0 == WEXITSTATUS(status)), "table: writer finished");
+    check((0 < good) && (0 == torn), "table: no torn copies under a concurrent writer");
+    check(true == ordered, "table: sequences read are even + only go forward");
+    check((2 * (TEST_TABLE_PUBLISHES + 1) == sequence) && (true == levels.empty()), "table: empty publish replaces the last levels");
+    check(TEST_TABLE_PUBLISHES == table_p->get_heartbeat(), "table: every beat is seen");
+
+    delete table_p;
+}
+
+// a shard killed part way through a publish leaves the sequence odd, the reader has to give up + reset has to recover
+static void test_table_restart()
+{
+    APPShardTable *table_p = APPShardTable::create_p();
+    if (NULL == table_p)
+    {
+        check(false, "table: created for restart");
+        return;
+    }
+
+    int odd = 0;
+    bool accepted = false;
+    bool reset = true;
+    for (int kill_count = 0; kill_count < TEST_TABLE_KILLS; kill_count++)
+    {
+        pid_t pid = fork();
+        if (0 == pid)
+        {
+            // the whole table each time, so most of the writer's time is spent inside a publish
+            APPShardTable *writer_p = APPShardTable::attach_p(table_p->get_fd());
+            static uint8_t levels[SHARD_TABLE_LEVELS_SIZE];
+            memset(levels, kill_count, sizeof(levels));
+            while (NULL != writer_p)
+            {
+                writer_p->publish(levels, sizeof(levels));
+                writer_p->beat();
+            }
+            _exit(1);
+        }
+        usleep(20000 + (kill_count * 1000));
+        kill(pid, SIGKILL);
+        waitpid(pid, NULL, 0);
+
+        if (0 != (table_p->get_sequence() & 1))
+        {
+            odd++;
+            uint32_t sequence = 0;
+            std::vector<uint8_t> levels;
+            accepted = accepted || table_p->read(&sequence, levels);
+        }
+
+        // what the supervisor does before it starts the next process
+        table_p->reset();
+        reset = reset && (0 == table_p->get_sequence()) && (0 == table_p->get_heartbeat());
+    }
+
+    printf("table: writer killed mid publish %d of %d times\n", odd, TEST_TABLE_KILLS);
+    check(0 < odd, "table: a writer was caught mid publish");
+    check(false == accepted, "table: a half written table is never read");
+    check(true == reset, "table: reset clears the sequence + heartbeat");
+
+    // the next process starts from the reset table + the front from its sequence
+    APPShardTable *writer_p = APPShardTable::attach_p(table_p->get_fd());
+    uint32_t sequence = table_p->get_sequence();
+    std::vector<uint8_t> levels;
+    const bool stale = table_p->read(&sequence, levels);
+    const std::string restarted = "restarted";
+    writer_p->publish((const uint8_t *)restarted.data(), restarted.size());
+    const bool fresh = table_p->read(&sequence, levels);
+    check((false == stale) && (true == fresh) && (restarted == std::string(levels.begin(), levels.end())), "table: first publish after a reset is read");
+
+    std::vector<uint8_t> oversized(SHARD_TABLE_LEVELS_SIZE + 1);
+    check((RESULT_CODE_OK != writer_p->publish(&oversized[0], oversized.size())) && (sequence == table_p->get_sequence()), "table: oversized publish is refused + leaves the table alone");
+
+    delete writer_p;
+    delete table_p;
+}
+
+// frames written a byte at a time are only handed over once they're whole
+static void test_link_partial()
+{
+    int sockets[2];
+    socketpair(AF_UNIX, SOCK_STREAM, 0, sockets);
+    // not the default loop, libev would reap the other tests' children from under them
+    struct ev_loop *loop_p = ev_loop_new(0);
+    Recorder recorder;
+    APPShardLink *link_p = new APPShardLink(loop_p, sockets[0], &recorder);
+
+    // an empty frame, one bigger than a read + a small one, back to back
+    std::vector<uint8_t> stream;
+    std::vector<size_t> ends;
+    append_frame(stream, APPShardLink::FRAME_TYPE_OPEN, 1, 0);
+    ends.push_back(stream.size());
+    append_frame(stream, APPShardLink::FRAME_TYPE_REQUEST, 2, (3 * SHARD_LINK_READ_SIZE) + 5);
+    ends.push_back(stream.size());
+    append_frame(stream, APPShardLink::FRAME_TYPE_CLOSE, 3, 7);
+    ends.push_back(stream.size());
+
+    bool early = false;
+    for (size_t offset = 0; offset < stream.size(); offset++)
+    {
+        if (1 != write(sockets[1], &stream[offset], 1))
+        {
+            early = true;
+            break;
+        }
+        ev_run(loop_p, EVRUN_NOWAIT);
+        size_t whole = 0;
+        while ((whole < ends.size()) && (ends[whole] <= offset + 1))
+        {
+            whole++;
+        }
+        early = early || (whole != recorder.m_headers.size());
+    }
+
+    bool intact = (3 == recorder.m_headers.size());
+    for (size_t counter = 0; (true == intact) && (counter < recorder.m_headers.size()); counter++)
+    {
+        const APPShardLink::Header &header = recorder.m_headers[counter];
+        intact = (counter + 1 == header.id) && (header.length == recorder.m_payloads[counter].size()) &&
+                (make_pattern(header.id, header.length) == recorder.m_payloads[counter]);
+    }
+    check(false == early, "link: frames arrive only once their last byte has");
+    check((true == intact) && (false == recorder.m_closed), "link: frames written a byte at a time come through whole + in order");
+
+    delete link_p;
+    close(sockets[1]);
+    ev_loop_destroy(loop_p);
+}
+
+// a header claiming more than the largest frame closes the link, the largest frame itself still gets through
+static void test_link_oversized()
+{
+    int sockets[2];
+    socketpair(AF_UNIX, SOCK_STREAM, 0, sockets);
+    struct ev_loop *loop_p = ev_loop_new(0);
+    Recorder recorder;
+    APPShardLink *link_p = new APPShardLink(loop_p, sockets[0], &recorder);
+
+    std::vector<uint8_t> stream;
+    append_frame(stream, APPShardLink::FRAME_TYPE_REQUEST, 1, SHARD_LINK_MAX_FRAME);
+    for (size_t offset = 0; offset < stream.size(); offset += SHARD_LINK_READ_SIZE)
+    {
+        const size_t length = std::min((size_t)SHARD_LINK_READ_SIZE, stream.size() - offset);
+        if ((ssize_t)length != write(sockets[1], &stream[offset], length))
+        {
+            break;
+        }
+        ev_run(loop_p, EVRUN_NOWAIT);
+    }
+    for (int counter = 0; (counter < 16) && (true == recorder.m_headers.empty()); counter++)
+    {
+        ev_run(loop_p, EVRUN_NOWAIT);
+    }
+    check((1 == recorder.m_headers.size()) && (SHARD_LINK_MAX_FRAME == recorder.m_payloads[0].size()) && (false == recorder.m_closed), "link: a frame of the largest size is accepted");
+
+    // only the header, the link mustn't wait for a megabyte more to arrive before it gives up
+    APPShardLink::Header header;
+    header.type = APPShardLink::FRAME_TYPE_REQUEST;
+    header.id = 2;
+    header.result = RESULT_CODE_OK;
+    header.length = SHARD_LINK_MAX_FRAME + 1;
+    if (sizeof(header) == write(sockets[1], &header, sizeof(header)))
+    {
+        ev_run(loop_p, EVRUN_NOWAIT);
+    }
+    check((true == recorder.m_closed) && (1 == recorder.m_headers.size()), "link: an oversized header closes the link without a frame");
+
+    delete link_p;
+    close(sockets[1]);
+    ev_loop_destroy(loop_p);
+}
+
+// thousands of frames to an echoing process in bursts that back the transmit queue up
+static void test_link_echo()
+{
+    int sockets[2];
+    socketpair(AF_UNIX, SOCK_STREAM, 0, sockets);
+
+    pid_t pid = fork();
+    if (0 == pid)
+    {
+        close(sockets[0]);
+        struct ev_loop *loop_p = ev_loop_new(0);
+        Echo echo(loop_p);
+        echo.m_link_p = new APPShardLink(loop_p, sockets[1], &echo);
+        ev_run(loop_p, 0);
+        _exit(0);
+    }
+    close(sockets[1]);
+
+    struct ev_loop *loop_p = ev_loop_new(0);
+    Recorder recorder;
+    APPShardLink *link_p = new APPShardLink(loop_p, sockets[0], &recorder);
+    bool queued = true;
+    uint32_t id = 0;
+    while ((id < TEST_LINK_FRAMES) && (false == recorder.m_closed))
+    {
+        for (int counter = 0; (counter < TEST_LINK_BURST) && (id < TEST_LINK_FRAMES); counter++, id++)
+        {
+            APPManager::Message *message_p = NULL;
+            const std::string data = make_pattern(id, link_length(id));
+            if (false == data.empty())
+            {
+                message_p = new APPManager::Message(data.size());
+                memcpy(message_p->get_data_p(), data.data(), data.size());
+            }
+            queued = queued && (RESULT_CODE_OK == link_p->send(APPShardLink::FRAME_TYPE_REQUEST, id, RESULT_CODE_OK, &message_p)) && (NULL == message_p);
+        }
+        // let most of the burst come back before the next
+        while ((recorder.m_headers.size() + TEST_LINK_BURST / 3 < id) && (false == recorder.m_closed))
+        {
+            ev_run(loop_p, EVRUN_ONCE);
+        }
+    }
+    while ((recorder.m_headers.size() < TEST_LINK_FRAMES) && (false == recorder.m_closed))
+    {
+        ev_run(loop_p, EVRUN_ONCE);
+    }
+
+    bool intact = (TEST_LINK_FRAMES == recorder.m_headers.size());
+    for (size_t counter = 0; (true == intact) && (counter < recorder.m_headers.size()); counter++)
+    {
+        intact = (counter == recorder.m_headers[counter].id) && (make_pattern(counter, link_length(counter)) == recorder.m_payloads[counter]);
+    }
+
+    // closing our end is what ends the echo process
+    delete link_p;
+    int status = 0;
+    waitpid(pid, &status, 0);
+    ev_loop_destroy(loop_p);
+
+    printf("link: %d frames echoed\n", (int)recorder.m_headers.size());
+    check(true == queued, "link: every frame was queued + taken");
+    check((true == intact) && (false == recorder.m_closed), "link: echoed frames come back whole + in order");
+    check((true == WIFEXITED(status)) && (0 == WEXITSTATUS(status)), "link: the far end sees the close");
+}
+
+// the supervisor runs this same executable as its shard, kills + restarts it, the front puts it back how it was
+static void test_restart(const char *config_p)
+{
+    // the child watchers need the default loop, every other child has been reaped by now
+    struct ev_loop *loop_p = ev_default_loop(0);
+    APPShardSupervisor *supervisor_p = APPShardSupervisor::create_instance(loop_p, 1, config_p, config_p);
+    Front front(supervisor_p);
+    supervisor_p->set_listener(&front);
+
+    // the first process was started before there was a listener, so it's opened the way a new client does it
+    supervisor_p->send(0, APPShardLink::FRAME_TYPE_OPEN, 0, NULL);
+    front.set_state(TEST_STATE_REQUEST);
+    Record first;
+    const bool started = wait_for_record(loop_p, front, 0, 0, first) && (0 == strcmp(TEST_STATE_REQUEST, first.state));
+    check(true == started, "restart: first shard is opened + publishes its state");
+    check(0 < front.m_responses, "restart: shard's responses reach the front");
+
+    // an exit is seen by the child watcher
+    front.send_request(2, TEST_EXIT_REQUEST);
+    Record second;
+    const bool exited = wait_for_record(loop_p, front, 1, first.pid, second);
+    check((true == exited) && (1 == front.m_downs), "restart: a shard that exits is restarted");
+    check((true == exited) && (1 == second.opens) && (0 == strcmp(TEST_STATE_REQUEST, second.state)), "restart: the new process is opened + given its state again");
+
+    // a hang is only seen by the watchdog
+    front.send_request(3, TEST_HANG_REQUEST);
+    Record third;
+    const bool hung = wait_for_record(loop_p, front, 2, second.pid, third);
+    check((true == hung) && (2 == front.m_downs), "restart: a shard that stops beating is killed + restarted");
+    check((true == hung) && (1 == third.opens) && (0 == strcmp(TEST_STATE_REQUEST, third.state)), "restart: the replacement is given its state again");
+
+    supervisor_p->set_listener(NULL);
+}
+
+// the process the supervisor starts, it finds the link + table where a real shard would
+static int run_shard()
+{
+    struct ev_loop *loop_p = ev_default_loop(0);
+    APPShardTable *table_p = APPShardTable::attach_p(SHARD_TABLE_FD);
+    if (NULL == table_p)
+    {
+        return 1;
+    }
+    FakeShard shard(loop_p, table_p);
+    shard.m_link_p = new APPShardLink(loop_p, SHARD_LINK_FD, &shard);
+    ev_run(loop_p, 0);
+    return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// public function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+// exercises the shard table's seqlock, the link's framing + the supervisor's restarts, prints each check and
+// PASS or FAIL at the end, the restart test takes the watchdog + restart delay from [shards] in the ini
+int main(int argc, char **argv)
+{
+    // the supervisor starts this same executable as its shard
+    for (int counter = 1; counter < argc; counter++)
+    {
+        if (0 == strncmp(argv[counter], TEST_SHARD_OPTION, strlen(TEST_SHARD_OPTION)))
+        {
+            return run_shard();
+        }
+    }
+
+    if ((2 != argc) || (RESULT_CODE_OK != Config::init(argv[1])))
+    {
+        fprintf(stderr, "usage: %s <config.ini>\n", argv[0]);
+        return -1;
+    }
+    // nothing printed may be left buffered when we fork
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    test_table_seqlock();
+    test_table_restart();
+    test_link_partial();
+    test_link_oversized();
+    test_link_echo();
+    test_restart(argv[1]);
+
+    printf("%s\n", (0 == g_failures) ? "PASS" : "FAIL");
+    return (0 == g_failures) ? 0 : 1;
+}
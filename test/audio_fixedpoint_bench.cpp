@@ -0,0 +1,132 @@
+#include "audio/audio_processor.h"
+#include "config.h"
+
+#include <ev.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+#define BENCH_SAMPLE_RATE       (48000)
+#define BENCH_BLOCK_LENGTH      (2400)
+#define BENCH_TONE_FREQUENCY    (997)
+#define BENCH_ACCURACY_BLOCKS   (40)
+// 600s of audio at 50ms a block
+#define BENCH_TIMING_BLOCKS     (12000)
+
+///////////////////////////////////////////////////////////////////////////////
+// constants
+///////////////////////////////////////////////////////////////////////////////
+
+static const double c_levels[] = { -1.0, -20.0, -40.0, -60.0, -80.0 };
+
+///////////////////////////////////////////////////////////////////////////////
+// private function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+// hand the same S16 block over the way the capture path would for this build
+static void feed(AUDIOProcessor &processor, AUDIOChannel &channel, const int16_t *raw_p, AUDIOChannel::Sample *buffer_p, AUDIOChannel::Fixed *fixed_p)
+{
+#ifdef AUDIO_FIXED_POINT
+    for (int counter = 0; counter < BENCH_BLOCK_LENGTH; counter++)
+    {
+        fixed_p[counter] = ((AUDIOChannel::Fixed)raw_p[counter]) << 16;
+    }
+    if (true == processor.needs_samples(&channel))
+    {
+        AUDIOChannel::to_samples(BENCH_BLOCK_LENGTH, fixed_p, buffer_p);
+    }
+    processor.handle_fixed_samples(&channel, BENCH_BLOCK_LENGTH, fixed_p, buffer_p);
+#else
+    for (int counter = 0; counter < BENCH_BLOCK_LENGTH; counter++)
+    {
+        buffer_p[counter] = raw_p[counter] / 32768.0f;
+    }
+    processor.handle_samples(&channel, BENCH_BLOCK_LENGTH, buffer_p);
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// public function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+// prints the PPM, digital peak + VU readings for a 997Hz tone at each level and then times 600s of audio through
+// all three, build it with and without -DFIXED_POINT=ON and compare the two outputs
+int main(int argc, char **argv)
+{
+    // the processor reads its threads from the same ini as the daemon
+    if ((2 != argc) || (RESULT_CODE_OK != Config::init(argv[1])))
+    {
+        fprintf(stderr, "usage: %s <config.ini>\n", argv[0]);
+        return -1;
+    }
+
+    int16_t raw[BENCH_BLOCK_LENGTH];
+    AUDIOChannel::Sample buffer[BENCH_BLOCK_LENGTH];
+    AUDIOChannel::Fixed fixed[BENCH_BLOCK_LENGTH];
+    // the loop is never run, the readings are taken straight from the meters
+    struct ev_loop *loop_p = ev_default_loop(0);
+
+    for (size_t level = 0; level < (sizeof(c_levels) / sizeof(c_levels[0])); level++)
+    {
+        AUDIOProcessor processor(loop_p);
+        AUDIOChannel ppm_channel(1, BENCH_SAMPLE_RATE, 1.0f, false);
+        AUDIOChannel peak_channel(2, BENCH_SAMPLE_RATE, 1.0f, false);
+        AUDIOChannel vu_channel(3, BENCH_SAMPLE_RATE, 1.0f, false);
+        AUDIOProcessor::PPMMeter *ppm_p = new AUDIOProcessor::PPMMeter(&ppm_channel);
+        AUDIOProcessor::DigitalPeakMeter *peak_p = new AUDIOProcessor::DigitalPeakMeter(&peak_channel);
+        AUDIOProcessor::VUMeter *vu_p = new AUDIOProcessor::VUMeter(&vu_channel);
+        processor.add_meter(ppm_p);
+        processor.add_meter(peak_p);
+        processor.add_meter(vu_p);
+
+        // the same 1 LSB of noise for both builds
+        const double amplitude = pow(10.0, c_levels[level] / 20.0);
+        srand(1);
+        long position = 0;
+        AUDIOProcessor::ResultData ppm_result;
+        AUDIOProcessor::ResultData peak_result;
+        AUDIOProcessor::ResultData vu_result;
+        for (int block = 0; block < BENCH_ACCURACY_BLOCKS; block++)
+        {
+            for (int counter = 0; counter < BENCH_BLOCK_LENGTH; counter++, position++)
+            {
+                raw[counter] = (int16_t)lrint((32767.0 * amplitude * sin(2.0 * M_PI * BENCH_TONE_FREQUENCY * position / BENCH_SAMPLE_RATE)) + ((rand() % 3) - 1));
+            }
+            feed(processor, ppm_channel, raw, buffer, fixed);
+            feed(processor, peak_channel, raw, buffer, fixed);
+            feed(processor, vu_channel, raw, buffer, fixed);
+            ppm_result = ppm_p->create_result_data();
+            peak_result = peak_p->create_result_data();
+            vu_result = vu_p->create_result_data();
+        }
+        printf("level=%.0f ppm=%.4f peak=%.4f vu=%.4f\n", c_levels[level], ppm_result.values.peak.peakInDB, peak_result.values.peak.peakInDB, vu_result.values.vuInUnits);
+    }
+
+    AUDIOProcessor processor(loop_p);
+    AUDIOChannel ppm_channel(1, BENCH_SAMPLE_RATE, 1.0f, false);
+    AUDIOChannel peak_channel(2, BENCH_SAMPLE_RATE, 1.0f, false);
+    AUDIOChannel vu_channel(3, BENCH_SAMPLE_RATE, 1.0f, false);
+    processor.add_meter(new AUDIOProcessor::PPMMeter(&ppm_channel));
+    processor.add_meter(new AUDIOProcessor::DigitalPeakMeter(&peak_channel));
+    processor.add_meter(new AUDIOProcessor::VUMeter(&vu_channel));
+    for (int counter = 0; counter < BENCH_BLOCK_LENGTH; counter++)
+    {
+        raw[counter] = (int16_t)(10000.0 * sin(counter * 0.13));
+    }
+
+    const clock_t start = clock();
+    for (int block = 0; block < BENCH_TIMING_BLOCKS; block++)
+    {
+        feed(processor, ppm_channel, raw, buffer, fixed);
+        feed(processor, peak_channel, raw, buffer, fixed);
+        feed(processor, vu_channel, raw, buffer, fixed);
+    }
+    printf("600s of audio through ppm+peak+vu took %.3fs\n", (double)(clock() - start) / CLOCKS_PER_SEC);
+
+    return 0;
+}
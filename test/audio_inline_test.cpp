@@ -0,0 +1,578 @@
+#include "audio/audio_capturemgr.h"
+#include "audio/audio_processor.h"
+#include "audio/audio_graph.h"
+#include "audio/audio_decibels.h"
+#include "audio/audio_loudnessmeter.h"
+#include "audio/audio_crestmeter.h"
+#include "audio/audio_distortionmeter.h"
+#include "audio/audio_noisefloormeter.h"
+#include "config.h"
+
+#include <ev.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <map>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+#define TEST_SAMPLE_RATE            (48000)
+// 50ms, the block a capture thread reads
+#define TEST_BLOCK_LENGTH           (2400)
+// one of each meter that can run inline + a digital peak that can't
+#define TEST_CHANNEL_COUNT          (8)
+// ticks the inline results are compared against meters run on the loop
+#define TEST_COMPARE_TICKS          (72)
+// the dB conversions are batched differently so they only have to be close
+#define TEST_TOLERANCE              (0.001f)
+#define TEST_CAPTURE_THREADS        (4)
+// the capture threads run well ahead of real time to give the tick more to race against
+#define TEST_CAPTURE_SLEEP_IN_US    (500)
+#define TEST_SWAP_TICKS             (120)
+// big enough that a copy racing the capture thread is likely to be caught part way through
+#define TEST_COUNTER_WORDS          (1024)
+
+///////////////////////////////////////////////////////////////////////////////
+// type defintions
+///////////////////////////////////////////////////////////////////////////////
+
+// keeps the results of the last tick
+class Recorder : public AUDIOProcessor::Handler
+{
+public:
+    Recorder() : m_ticks(0) {}
+
+    ResultCode handle_results(const size_t num_results, const AUDIOProcessor::ResultData results[])
+    {
+        m_results.assign(results, results + num_results);
+        m_ticks++;
+        return RESULT_CODE_OK;
+    }
+
+    ResultCode handle_alarms(const size_t num_alarms, const AUDIOProcessor::AlarmData alarms[])
+    {
+        return RESULT_CODE_OK;
+    }
+
+    std::vector<AUDIOProcessor::ResultData> m_results;
+    long m_ticks;
+};
+
+// every word of its accumulators holds the number of blocks it has seen, so a copy where they differ is torn
+class CounterMeter : public AUDIOProcessor::Meter
+{
+public:
+    CounterMeter(AUDIOChannel *channel_p) : AUDIOProcessor::Meter(channel_p), m_last(0)
+    {
+        memset(m_words, 0, sizeof(m_words));
+    }
+
+    void process_samples(const size_t buffer_length, AUDIOChannel::Sample *buffer_p)
+    {
+        const uint32_t blocks = m_words[0] + 1;
+        for (int counter = 0; counter < TEST_COUNTER_WORDS; counter++)
+        {
+            m_words[counter] = blocks;
+        }
+    }
+
+    AUDIOProcessor::ResultData create_result_data()
+    {
+        AUDIODecibels decibels;
+        AUDIOProcessor::ResultData data;
+        queue_accumulated_result_data(m_words, data, decibels);
+        return data;
+    }
+
+    size_t get_accumulators_size() const
+    {
+        return sizeof(m_words);
+    }
+
+    void save_accumulators(void *accumulators_p) const
+    {
+        memcpy(accumulators_p, m_words, sizeof(m_words));
+    }
+
+    void queue_accumulated_result_data(const void *accumulators_p, AUDIOProcessor::ResultData &data, AUDIODecibels &decibels) const;
+
+    AUDIOProcessor::LevelType get_level_type()
+    {
+        return AUDIOProcessor::LEVEL_TYPE_PLUGIN;
+    }
+
+private:
+    uint32_t m_words[TEST_COUNTER_WORDS];
+    // only ever touched by the loop
+    mutable uint32_t m_last;
+};
+
+// one capture thread's share of the channels
+typedef struct
+{
+    unsigned int thread;
+    std::vector<AUDIOChannel *> channels;
+} CaptureThread;
+
+///////////////////////////////////////////////////////////////////////////////
+// module variables
+///////////////////////////////////////////////////////////////////////////////
+
+static int g_failures = 0;
+
+// what the stand-in capture manager shares with the capture threads
+static AUDIOCaptureManager::InlineHandler *g_inline_handler_p = NULL;
+static uint32_t g_epochs[TEST_CAPTURE_THREADS];
+static bool g_stop = false;
+
+// the counter meters' reads, only ever touched by the loop
+static long g_counter_reads = 0;
+static long g_counter_torn = 0;
+static long g_counter_backwards = 0;
+
+///////////////////////////////////////////////////////////////////////////////
+// AUDIOCaptureManager stand-in
+///////////////////////////////////////////////////////////////////////////////
+
+// the processor only needs the channels, the handler registration + the epochs from the capture manager, this
+// stands in for it so the test runs without a card, the test's capture threads keep their epochs the same way
+// the capture instances do, odd for as long as they might hold on to anything the handler handed them
+
+AUDIOCaptureManager *AUDIOCaptureManager::g_instance_p = NULL;
+
+AUDIOCaptureManager *AUDIOCaptureManager::get_instance()
+{
+    if (NULL == g_instance_p)
+    {
+        g_instance_p = new AUDIOCaptureManager(ev_default_loop(0), 0, 1);
+    }
+    return g_instance_p;
+}
+
+AUDIOCaptureManager::AUDIOCaptureManager(struct ev_loop *loop_p, unsigned int shard, unsigned int shard_count) :
+    m_loop_p(loop_p),
+    m_inline_handler_p(NULL),
+    m_over_detector_p(NULL),
+    m_fault_detector_p(NULL),
+    m_graph_p(NULL),
+    m_channel_count(0),
+    m_index_base(0),
+    m_index_limit(TEST_CHANNEL_COUNT)
+{
+    for (AUDIOChannel::Index index = 1; index <= TEST_CHANNEL_COUNT; index++)
+    {
+        m_channels_map[index] = new AUDIOChannel(index, TEST_SAMPLE_RATE, 1.0f, true, loop_p);
+        m_channel_count++;
+    }
+}
+
+AUDIOCaptureManager::~AUDIOCaptureManager()
+{
+}
+
+void AUDIOCaptureManager::add_handler(Handler *handler_p)
+{
+    m_handlers.push_front(handler_p);
+}
+
+void AUDIOCaptureManager::remove_handler(Handler *handler_p)
+{
+    m_handlers.remove(handler_p);
+}
+
+void AUDIOCaptureManager::set_inline_handler(InlineHandler *handler_p)
+{
+    m_inline_handler_p = handler_p;
+    __atomic_store_n(&g_inline_handler_p, handler_p, __ATOMIC_SEQ_CST);
+    synchronize_inline();
+}
+
+void AUDIOCaptureManager::read_inline_epochs(std::vector<uint32_t> &epochs) const
+{
+    epochs.clear();
+    for (int counter = 0; counter < TEST_CAPTURE_THREADS; counter++)
+    {
+        epochs.push_back(__atomic_load_n(&g_epochs[counter], __ATOMIC_SEQ_CST));
+    }
+}
+
+bool AUDIOCaptureManager::has_inline_grace_passed(const std::vector<uint32_t> &epochs) const
+{
+    for (size_t counter = 0; counter < epochs.size(); counter++)
+    {
+        if ((0 != (epochs[counter] & 1)) && (epochs[counter] == __atomic_load_n(&g_epochs[counter], __ATOMIC_SEQ_CST)))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void AUDIOCaptureManager::synchronize_inline() const
+{
+    std::vector<uint32_t> epochs;
+    read_inline_epochs(epochs);
+    while (false == has_inline_grace_passed(epochs))
+    {
+        usleep(INLINE_GRACE_POLL_IN_US);
+    }
+}
+
+AUDIOChannel *AUDIOCaptureManager::find_channel(const AUDIOChannel::Index index)
+{
+    std::map<AUDIOChannel::Index, AUDIOChannel *>::iterator it = m_channels_map.find(index);
+    return (m_channels_map.end() == it) ? NULL : it->second;
+}
+
+bool AUDIOCaptureManager::owns_index(const AUDIOChannel::Index index) const
+{
+    return (index > m_index_base) && (index <= (m_index_base + m_index_limit));
+}
+
+ResultCode AUDIOCaptureManager::dispatch_samples(AUDIOChannel *channel_p, const size_t buffer_length, AUDIOChannel::Sample *buffer_p, const AUDIOChannel::Fixed *fixed_p)
+{
+    // the test hands the blocks to the processor itself
+    return RESULT_CODE_OK;
+}
+
+ResultCode AUDIOCaptureManager::Handler::handle_fixed_samples(AUDIOChannel *channel_p, const size_t buffer_length, const AUDIOChannel::Fixed *fixed_p, AUDIOChannel::Sample *buffer_p)
+{
+    return handle_samples(channel_p, buffer_length, buffer_p);
+}
+
+bool AUDIOCaptureManager::Handler::needs_samples(const AUDIOChannel *channel_p) const
+{
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// private function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+static void check(bool passed, const char *what_p)
+{
+    printf("%s %s\n", (true == passed) ? "ok  " : "FAIL", what_p);
+    if (false == passed)
+    {
+        g_failures++;
+    }
+}
+
+void CounterMeter::queue_accumulated_result_data(const void *accumulators_p, AUDIOProcessor::ResultData &data, AUDIODecibels &decibels) const
+{
+    const uint32_t *words_p = (const uint32_t *)accumulators_p;
+    bool torn = false;
+    for (int counter = 1; counter < TEST_COUNTER_WORDS; counter++)
+    {
+        torn = torn || (words_p[counter] != words_p[0]);
+    }
+    g_counter_reads++;
+    if (true == torn)
+    {
+        g_counter_torn++;
+    }
+    if (words_p[0] < m_last)
+    {
+        g_counter_backwards++;
+    }
+    m_last = words_p[0];
+
+    memset(&data, 0, sizeof(data));
+    data.type = AUDIOProcessor::LEVEL_TYPE_PLUGIN;
+    data.channel = get_channel_p()->get_index();
+    data.values.plugin.name_p = "counter";
+}
+
+// what a capture thread does with each block
+static void capture_block(unsigned int thread, AUDIOChannel *channel_p, uint64_t position, AUDIOChannel::Sample *buffer_p)
+{
+    // the epoch goes odd before the handler is looked at + even once we're clear of it
+    __atomic_fetch_add(&g_epochs[thread], 1, __ATOMIC_SEQ_CST);
+    AUDIOCaptureManager::InlineHandler *handler_p = __atomic_load_n(&g_inline_handler_p, __ATOMIC_SEQ_CST);
+    if (NULL != handler_p)
+    {
+        handler_p->handle_inline_samples(channel_p, position, TEST_BLOCK_LENGTH, buffer_p, NULL);
+    }
+    __atomic_fetch_add(&g_epochs[thread], 1, __ATOMIC_RELEASE);
+}
+
+// a different tone on each channel with a little noise on top, the distortion meter's channel gets a 1kHz tone with a 3rd harmonic
+static void fill_block(AUDIOChannel::Index index, uint64_t position, AUDIOChannel::Sample *buffer_p)
+{
+    for (int sample = 0; sample < TEST_BLOCK_LENGTH; sample++)
+    {
+        const double time = (double)(position + sample) / TEST_SAMPLE_RATE;
+        const float noise = 0.001f * ((int)(((position + sample) * 7919 + index * 104729) % 100) - 50);
+        buffer_p[sample] = (0.1f * index * sinf(2.0f * M_PI * (100 + (200 * index)) * time)) + noise;
+        if (6 == index)
+        {
+            buffer_p[sample] = (0.5f * sinf(2.0f * M_PI * 1000.0f * time)) + (0.005f * sinf(2.0f * M_PI * 3000.0f * time)) + noise;
+        }
+    }
+}
+
+static AUDIOProcessor::Meter *create_meter(int kind, AUDIOChannel *channel_p)
+{
+    AUDIOProcessor::Meter *meter_p = NULL;
+    switch (kind % TEST_CHANNEL_COUNT)
+    {
+        case 0:
+            meter_p = new AUDIOProcessor::PPMMeter(channel_p);
+            break;
+        case 1:
+            meter_p = new AUDIOProcessor::PPMMeter(channel_p);
+            meter_p->set_weighting(AUDIOProcessor::WEIGHTING_A);
+            break;
+        case 2:
+            meter_p = new AUDIOProcessor::VUMeter(channel_p);
+            break;
+        case 3:
+            meter_p = new AUDIOLoudnessMeter(channel_p);
+            break;
+        case 4:
+            meter_p = new AUDIOCrestMeter(channel_p);
+            break;
+        case 5:
+        {
+            float low_frequency = 0.0f;
+            float high_frequency = 0.0f;
+            AUDIODistortionMeter::fetch_default_bandwidth(&low_frequency, &high_frequency);
+            meter_p = new AUDIODistortionMeter(channel_p, low_frequency, high_frequency);
+            break;
+        }
+        case 6:
+            meter_p = new AUDIONoiseFloorMeter(channel_p);
+            break;
+        default:
+            // resets as it's read so it always runs on the loop
+            meter_p = new AUDIOProcessor::DigitalPeakMeter(channel_p);
+            break;
+    }
+    return meter_p;
+}
+
+static bool is_same_result(const AUDIOProcessor::ResultData &result, const AUDIOProcessor::ResultData &expected)
+{
+    if ((result.type != expected.type) || (result.channel != expected.channel))
+    {
+        return false;
+    }
+    // every meter compared here leads with at most four float readings
+    const float *values_p = (const float *)&result.values;
+    const float *expected_values_p = (const float *)&expected.values;
+    for (int counter = 0; counter < 4; counter++)
+    {
+        if ((values_p[counter] != expected_values_p[counter]) && (false == (fabsf(values_p[counter] - expected_values_p[counter]) <= TEST_TOLERANCE)))
+        {
+            printf("channel=%d type=%d reading=%d %f expected %f\n", result.channel, result.type, counter, values_p[counter], expected_values_p[counter]);
+            return false;
+        }
+    }
+    return true;
+}
+
+// the pipes share the loop with the timer so run it until the processor has ticked
+static void run_tick(struct ev_loop *loop_p, Recorder &recorder)
+{
+    const long ticks = recorder.m_ticks;
+    while (ticks == recorder.m_ticks)
+    {
+        ev_run(loop_p, EVRUN_ONCE);
+    }
+}
+
+static void *capture_thread(void *arg_p)
+{
+    CaptureThread *thread_p = (CaptureThread *)arg_p;
+    std::vector<uint64_t> positions(thread_p->channels.size(), 0);
+    AUDIOChannel::Sample buffer[TEST_BLOCK_LENGTH];
+    while (false == __atomic_load_n(&g_stop, __ATOMIC_SEQ_CST))
+    {
+        for (size_t counter = 0; counter < thread_p->channels.size(); counter++)
+        {
+            fill_block(thread_p->channels[counter]->get_index(), positions[counter], buffer);
+            capture_block(thread_p->thread, thread_p->channels[counter], positions[counter], buffer);
+            positions[counter] += TEST_BLOCK_LENGTH;
+        }
+        usleep(TEST_CAPTURE_SLEEP_IN_US);
+    }
+    return NULL;
+}
+
+// the same meters run inline + in a graph of our own on the loop, each tick's results have to match
+static void test_inline_matches_loop(struct ev_loop *loop_p)
+{
+    AUDIOCaptureManager *manager_p = AUDIOCaptureManager::get_instance();
+    AUDIOProcessor processor(loop_p);
+    Recorder recorder;
+    processor.add_handler(&recorder);
+    check(NULL != g_inline_handler_p, "compare: inline metering is enabled in the ini");
+
+    AUDIOChannel *channels_p[TEST_CHANNEL_COUNT];
+    AUDIOProcessor::Meter *expected_p[TEST_CHANNEL_COUNT];
+    std::multimap<AUDIOChannel::Index, AUDIOProcessor::Meter *> expected_map;
+    for (int counter = 0; counter < TEST_CHANNEL_COUNT; counter++)
+    {
+        channels_p[counter] = manager_p->find_channel(counter + 1);
+        processor.add_meter(create_meter(counter, channels_p[counter]));
+        expected_p[counter] = create_meter(counter, channels_p[counter]);
+        expected_map.insert(std::make_pair(channels_p[counter]->get_index(), expected_p[counter]));
+    }
+    AUDIOGraph expected_graph;
+    expected_graph.build(expected_map, std::multimap<AUDIOChannel::Index, AUDIOProcessor::Meter *>());
+
+    bool complete = true;
+    bool matched = true;
+    uint64_t position = 0;
+    for (int tick = 0; tick < TEST_COMPARE_TICKS; tick++)
+    {
+        // the capture thread, the pipe to the loop + our own graph each get their own copy of the block
+        for (int counter = 0; counter < TEST_CHANNEL_COUNT; counter++)
+        {
+            AUDIOChannel::Sample block[TEST_BLOCK_LENGTH];
+            AUDIOChannel::Sample buffer[TEST_BLOCK_LENGTH];
+            fill_block(channels_p[counter]->get_index(), position, block);
+            memcpy(buffer, block, sizeof(buffer));
+            capture_block(0, channels_p[counter], position, buffer);
+            memcpy(buffer, block, sizeof(buffer));
+            processor.handle_samples(channels_p[counter], TEST_BLOCK_LENGTH, buffer);
+            memcpy(buffer, block, sizeof(buffer));
+            expected_graph.run(channels_p[counter], position, TEST_BLOCK_LENGTH, buffer);
+        }
+        position += TEST_BLOCK_LENGTH;
+
+        recorder.m_results.clear();
+        run_tick(loop_p, recorder);
+
+        complete = complete && (TEST_CHANNEL_COUNT == recorder.m_results.size());
+        for (std::vector<AUDIOProcessor::ResultData>::iterator it = recorder.m_results.begin();
+                it != recorder.m_results.end();
+                it++)
+        {
+            const AUDIOProcessor::ResultData expected = expected_p[it->channel - 1]->create_result_data();
+            matched = matched && is_same_result(*it, expected);
+        }
+    }
+
+    check(true == complete, "compare: every meter reports each tick");
+    check(true == matched, "compare: inline results match the loop's");
+
+    processor.remove_handler(&recorder);
+    for (int counter = 0; counter < TEST_CHANNEL_COUNT; counter++)
+    {
+        delete expected_p[counter];
+    }
+}
+
+// capture threads meter flat out while the loop ticks + replaces, reweights + clears their meters
+static void test_inline_swaps(struct ev_loop *loop_p)
+{
+    AUDIOCaptureManager *manager_p = AUDIOCaptureManager::get_instance();
+    AUDIOProcessor *processor_p = new AUDIOProcessor(loop_p);
+    Recorder recorder;
+    processor_p->add_handler(&recorder);
+
+    AUDIOChannel *channels_p[TEST_CHANNEL_COUNT];
+    CaptureThread threads[TEST_CAPTURE_THREADS];
+    for (int counter = 0; counter < TEST_CAPTURE_THREADS; counter++)
+    {
+        threads[counter].thread = counter;
+    }
+    for (int counter = 0; counter < TEST_CHANNEL_COUNT; counter++)
+    {
+        channels_p[counter] = manager_p->find_channel(counter + 1);
+        processor_p->add_meter(new CounterMeter(channels_p[counter]));
+        threads[counter % TEST_CAPTURE_THREADS].channels.push_back(channels_p[counter]);
+    }
+
+    __atomic_store_n(&g_stop, false, __ATOMIC_SEQ_CST);
+    pthread_t thread_ids[TEST_CAPTURE_THREADS];
+    for (int counter = 0; counter < TEST_CAPTURE_THREADS; counter++)
+    {
+        pthread_create(&thread_ids[counter], NULL, capture_thread, &threads[counter]);
+    }
+
+    long results = 0;
+    long unreadable = 0;
+    for (int tick = 0; tick < TEST_SWAP_TICKS; tick++)
+    {
+        recorder.m_results.clear();
+        run_tick(loop_p, recorder);
+        results += recorder.m_results.size();
+        for (std::vector<AUDIOProcessor::ResultData>::iterator it = recorder.m_results.begin();
+                it != recorder.m_results.end();
+                it++)
+        {
+            const float *values_p = (const float *)&it->values;
+            if ((AUDIOProcessor::LEVEL_TYPE_PLUGIN != it->type) && ((0 == isfinite(values_p[0])) || (0 == isfinite(values_p[1]))))
+            {
+                unreadable++;
+            }
+        }
+
+        // the half of the channels left as counters keep checking the copies
+        AUDIOChannel *channel_p = channels_p[(tick % (TEST_CHANNEL_COUNT / 2)) * 2];
+        switch (tick % 4)
+        {
+            case 0:
+                processor_p->add_meter(create_meter(tick, channel_p));
+                break;
+            case 1:
+                processor_p->set_weighting(channel_p, (0 == (tick % 8)) ? AUDIOProcessor::WEIGHTING_Z : AUDIOProcessor::WEIGHTING_A);
+                processor_p->set_weighting(channels_p[1], (0 == (tick % 8)) ? AUDIOProcessor::WEIGHTING_Z : AUDIOProcessor::WEIGHTING_A);
+                break;
+            case 2:
+                processor_p->clear_meter(channel_p);
+                break;
+            default:
+                processor_p->add_meter(new CounterMeter(channel_p));
+                break;
+        }
+    }
+
+    __atomic_store_n(&g_stop, true, __ATOMIC_SEQ_CST);
+    for (int counter = 0; counter < TEST_CAPTURE_THREADS; counter++)
+    {
+        pthread_join(thread_ids[counter], NULL);
+    }
+    // whatever is still waiting on a grace period goes with the processor
+    delete processor_p;
+
+    printf("swaps: %ld results, %ld counter copies, %ld torn\n", results, g_counter_reads, g_counter_torn);
+    check(results >= (TEST_SWAP_TICKS * (TEST_CHANNEL_COUNT / 2)), "swaps: the untouched meters report every tick");
+    check(0 < g_counter_reads, "swaps: the counters are read");
+    check(0 == g_counter_torn, "swaps: no torn copies of the accumulators");
+    check(0 == g_counter_backwards, "swaps: no counter goes backwards");
+    check(0 == unreadable, "swaps: every level is a number");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// public function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+// runs the inline meters against the same meters on the loop, then under capture threads while the loop swaps
+// them, prints each check and PASS or FAIL at the end, the ini needs [inline-metering] enabled=1, build with
+// -DCMAKE_CXX_FLAGS=-fsanitize=thread to have the version handover + the accumulator copies checked as well
+int main(int argc, char **argv)
+{
+    if ((2 != argc) || (RESULT_CODE_OK != Config::init(argv[1])))
+    {
+        fprintf(stderr, "usage: %s <config.ini>\n", argv[0]);
+        return -1;
+    }
+
+    struct ev_loop *loop_p = ev_default_loop(0);
+    AUDIOCaptureManager::get_instance();
+
+    test_inline_matches_loop(loop_p);
+    test_inline_swaps(loop_p);
+
+    printf("%s\n", (0 == g_failures) ? "PASS" : "FAIL");
+    return (0 == g_failures) ? 0 : 1;
+}
@@ -0,0 +1,164 @@
+#include "audio/audio_processor.h"
+#include "audio/audio_loudnessmeter.h"
+#include "audio/audio_spectrummeter.h"
+#include "audio/audio_correlationmeter.h"
+#include "audio/audio_groupmeter.h"
+#include "config.h"
+
+#include <ev.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// macros
+///////////////////////////////////////////////////////////////////////////////
+
+#define BENCH_SAMPLE_RATE       (48000)
+#define BENCH_BLOCK_LENGTH      (2400)
+#define BENCH_CHANNEL_COUNT     (8)
+// the results are read every other block, as the 100ms tick would
+#define BENCH_CHECKSUM_BLOCKS   (400)
+// one minute of audio at 50ms a block
+#define BENCH_TIMING_BLOCKS     (1200)
+
+///////////////////////////////////////////////////////////////////////////////
+// private function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+static double get_seconds()
+{
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    return now.tv_sec + (now.tv_usec / 1000000.0);
+}
+
+// folds every reading into one number so runs with different thread counts can be compared
+static double sum_result(const AUDIOProcessor::ResultData &result)
+{
+    double sum = 0.0;
+    switch (result.type)
+    {
+        case AUDIOProcessor::LEVEL_TYPE_SPECTRUM:
+            for (unsigned int band = 0; band < result.values.spectrum.bandCount; band++)
+            {
+                sum += result.values.spectrum.bandsInDB_p[band] * (band + 1);
+            }
+            break;
+
+        case AUDIOProcessor::LEVEL_TYPE_GROUP:
+            sum += result.values.group.peakInDB + result.values.group.members_p[1].peakInDB;
+            break;
+
+        case AUDIOProcessor::LEVEL_TYPE_CORRELATION:
+            sum += result.values.correlation.coefficient;
+            break;
+
+        default:
+        {
+            // the first two readings of everything else are floats
+            const float *values_p = (const float *)&result.values;
+            for (int counter = 0; counter < 2; counter++)
+            {
+                if (0 != isfinite(values_p[counter]))
+                {
+                    sum += values_p[counter];
+                }
+            }
+            break;
+        }
+    }
+    return sum;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// public function implementations
+///////////////////////////////////////////////////////////////////////////////
+
+// runs 8 channels of loudness, spectrum, weighted PPM, VU, a linked group, DPM + correlation meters and prints a
+// checksum of the results and the time one minute of audio took, run it with [worker-pool] threads=0,1,2,...
+// in the ini, the checksum has to stay the same and the time shows the scaling on the machine it runs on
+int main(int argc, char **argv)
+{
+    // the processor reads its threads from the same ini as the daemon
+    if ((2 != argc) || (RESULT_CODE_OK != Config::init(argv[1])))
+    {
+        fprintf(stderr, "usage: %s <config.ini>\n", argv[0]);
+        return -1;
+    }
+
+    // the loop is never run, the readings are taken straight from the meters
+    AUDIOProcessor processor(ev_default_loop(0));
+    AUDIOChannel *channels_p[BENCH_CHANNEL_COUNT];
+    for (int counter = 0; counter < BENCH_CHANNEL_COUNT; counter++)
+    {
+        channels_p[counter] = new AUDIOChannel(counter + 1, BENCH_SAMPLE_RATE, 1.0f, false);
+    }
+
+    AUDIOProcessor::Meter *meters_p[BENCH_CHANNEL_COUNT];
+    meters_p[0] = new AUDIOLoudnessMeter(channels_p[0]);
+    meters_p[1] = new AUDIOSpectrumMeter(channels_p[1], 3);
+    meters_p[2] = new AUDIOProcessor::PPMMeter(channels_p[2]);
+    meters_p[2]->set_weighting(AUDIOProcessor::WEIGHTING_A);
+    meters_p[3] = new AUDIOProcessor::VUMeter(channels_p[3]);
+    AUDIOGroupMeter *group_p = new AUDIOGroupMeter(channels_p[4], AUDIOProcessor::LEVEL_TYPE_PPM);
+    group_p->add_channel(channels_p[5]);
+    meters_p[4] = group_p;
+    meters_p[5] = new AUDIOProcessor::DigitalPeakMeter(channels_p[5]);
+    meters_p[6] = new AUDIOCorrelationMeter(channels_p[6], channels_p[7]);
+    meters_p[7] = new AUDIOLoudnessMeter(channels_p[7]);
+    for (int counter = 0; counter < BENCH_CHANNEL_COUNT; counter++)
+    {
+        processor.add_meter(meters_p[counter]);
+    }
+
+    // a different tone on each channel with a little noise on top
+    static AUDIOChannel::Sample buffers[BENCH_CHANNEL_COUNT][BENCH_BLOCK_LENGTH];
+    long position = 0;
+    double checksum = 0.0;
+    srand(3);
+    for (int block = 0; block < BENCH_CHECKSUM_BLOCKS; block++)
+    {
+        for (int sample = 0; sample < BENCH_BLOCK_LENGTH; sample++, position++)
+        {
+            for (int counter = 0; counter < BENCH_CHANNEL_COUNT; counter++)
+            {
+                buffers[counter][sample] = (0.1f * (counter + 1) * sinf(2.0f * M_PI * (200 + (300 * counter)) * position / BENCH_SAMPLE_RATE)) + (0.001f * ((rand() % 100) - 50));
+            }
+        }
+        for (int counter = 0; counter < BENCH_CHANNEL_COUNT; counter++)
+        {
+            processor.handle_samples(channels_p[counter], BENCH_BLOCK_LENGTH, buffers[counter]);
+        }
+        if (0 != (block % 2))
+        {
+            // get_meter drains the pool the same way the tick does
+            processor.get_meter(channels_p[0]);
+            for (int counter = 0; counter < BENCH_CHANNEL_COUNT; counter++)
+            {
+                checksum += sum_result(meters_p[counter]->create_result_data());
+            }
+        }
+    }
+    processor.get_meter(channels_p[0]);
+    printf("checksum %.6f\n", checksum);
+
+    const double start = get_seconds();
+    for (int block = 0; block < BENCH_TIMING_BLOCKS; block++)
+    {
+        for (int counter = 0; counter < BENCH_CHANNEL_COUNT; counter++)
+        {
+            processor.handle_samples(channels_p[counter], BENCH_BLOCK_LENGTH, buffers[counter]);
+        }
+        if (0 != (block % 2))
+        {
+            processor.get_meter(channels_p[0]);
+        }
+    }
+    processor.get_meter(channels_p[0]);
+    const double elapsed = get_seconds() - start;
+    printf("60s of audio on %d channels took %.3fs, %.1fx realtime\n", BENCH_CHANNEL_COUNT, elapsed, 60.0 / elapsed);
+
+    return 0;
+}
@@ -0,0 +1,16 @@
+#!/bin/bash
+
+# runs the worker pool bench inline and with 1, 2 + 4 threads on the machine it's on, the checksum has to be the same
+# for every run + the times show the scaling, usage: workerpool_scaling.sh <path to audio-workerpool-bench>
+BENCH=${1:-./audio-workerpool-bench}
+INI=`mktemp`
+
+echo "cores: `nproc`"
+for THREADS in 0 1 2 4
+do
+    printf "[worker-pool]\nthreads=${THREADS}\n" > ${INI}
+    echo "threads=${THREADS}"
+    ${BENCH} ${INI}
+done
+
+rm -f ${INI}